@@ -7,6 +7,20 @@ include_directories(${CMAKE_CURRENT_LIST_DIR})
 # Add project sources
 set(LIBMPU9250_SOURCES
     ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_csma.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_filter.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_ring.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_txq.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_arq.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_agg.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_comp.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_mac.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_lowpan.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_nbr.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_dedup.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_manager.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_bus.c
+    ${CMAKE_CURRENT_LIST_DIR}/source/at86rf212_cmdq.c
 )
 
 # Create library
@@ -20,6 +20,7 @@ extern "C" {
 enum at86rf212_result_e {
     AT86RF212_RES_OK = 0,          //!< Indicates success
     AT86RF212_RES_DONE = 1,        //!< Indicates completion
+    AT86RF212_RES_REJECTED = 2,    //!< Indicates a received frame was rejected and not fetched
     AT86RF212_DRIVER_INVALID = -1, //!< Invalid driver object
     AT86RF212_ERROR_DRIVER = -2,   //!< Driver returned error (TODO: allow reporting of driver error code)
     AT86RF212_ERROR_COMMS = -3,    //!< Communication error (SPI failure)
@@ -27,15 +28,23 @@ enum at86rf212_result_e {
     AT86RF212_ERROR_RETRIES = -5,  //!< Command failed after AT86RF212_MAX_RETRIES
     AT86RF212_ERROR_PLL = -6,      //!< PLL locking error
     AT86RF212_ERROR_DVDD = -7,     //!< Digital voltage error
-    AT86RF212_ERROR_AVDD = -8      //!< Analogue voltage error
+    AT86RF212_ERROR_AVDD = -8,     //!< Analogue voltage error
+    AT86RF212_ERROR_CHANNEL_ACCESS = -9, //!< Channel access failure (channel busy after all CSMA backoffs)
+    AT86RF212_ERROR_STATE = -10,   //!< Operation not valid in the current radio state
+    AT86RF212_ERROR_FULL = -11,    //!< Queue or pool exhausted
+    AT86RF212_ERROR_TIMEOUT = -12  //!< Operation did not complete before its deadline
 };
 
 // SPI interaction function for dependency injection
 typedef int (*spi_transfer_f)(void* context, int len, uint8_t *data_out, uint8_t* data_in);
 typedef int (*gpio_set_f)(void* context, uint8_t val);
 typedef int (*gpio_get_f)(void* context, uint8_t *val);
+typedef int (*time_get_f)(void* context, uint32_t *time_us);
+typedef int (*fd_get_f)(void* context, int *fd);
 
 // Driver object for passing in to AT86RF212 object
+// Optional functions added later (the time source and IRQ file descriptor) are set on the device
+// with their own setters, so driver objects filled in one field at a time remain valid.
 struct at86rf212_driver_s {
     spi_transfer_f spi_transfer;    //!< SPI transfer function
     gpio_set_f set_reset;           //!< Reset pin control
@@ -45,12 +54,115 @@ struct at86rf212_driver_s {
     gpio_get_f get_dig2;            //!< Get DIG2 pin value
 };
 
+// Compile time bound driver
+// Defining AT86RF212_STATIC_DRIVER replaces the driver object with the at86rf212_port_* functions
+// below, called directly by the library (the driver arguments to at86rf212_init are then ignored).
+// Define AT86RF212_STATIC_DRIVER_HEADER as a header providing them, as static inline definitions to
+// inline them into the register helpers, otherwise they are declared here for linking.
+// at86rf212_port_get_time_us is only used when AT86RF212_STATIC_DRIVER_TIME is also defined, and
+// at86rf212_port_get_irq_fd when AT86RF212_STATIC_DRIVER_IRQ_FD is.
+#ifdef AT86RF212_STATIC_DRIVER
+#ifdef AT86RF212_STATIC_DRIVER_HEADER
+#include AT86RF212_STATIC_DRIVER_HEADER
+#else
+int at86rf212_port_spi_transfer(int len, uint8_t *data_out, uint8_t* data_in);
+int at86rf212_port_set_reset(uint8_t val);
+int at86rf212_port_set_slp_tr(uint8_t val);
+int at86rf212_port_get_irq(uint8_t *val);
+int at86rf212_port_get_time_us(uint32_t *time_us);
+int at86rf212_port_get_irq_fd(int *fd);
+#endif
+#endif
+
+// Masked register update
+struct at86rf212_reg_update_s {
+    uint8_t reg;                    //!< Register address
+    uint8_t mask;                   //!< Bits to update, 0xFF for a plain write
+    uint8_t value;                  //!< New value of the masked bits
+};
+
+// Radio configuration applied at initialisation
+// May be a static const (C) or constexpr (C++) profile, see AT86RF212_CONFIG_DEFAULT
+struct at86rf212_config_s {
+    uint8_t phy_mode;               //!< PHY mode (at86rf212_phy_mode_e)
+    uint8_t channel;                //!< Channel number
+    uint8_t cca_mode;               //!< Clear Channel Assessment mode (at86rf212_cca_mode_e)
+    uint8_t min_be;                 //!< CSMA-CA minimum backoff exponent
+    uint8_t max_be;                 //!< CSMA-CA maximum backoff exponent
+    uint8_t max_csma_backoffs;      //!< CSMA-CA backoffs before channel access failure
+    uint8_t max_frame_retries;      //!< Extended mode frame retries
+    uint8_t promiscuous;            //!< Promiscuous mode (receive all frames with extended operating modes)
+    uint8_t tx_power;               //!< PHY_TX_PWR register value
+    uint8_t irq_mask;               //!< Enabled interrupts (at86rf212_irq_e)
+    uint16_t short_address;         //!< Short address (0xFFFF for none)
+    uint16_t pan_id;                //!< PAN ID (0xFFFF for none)
+};
+
+// Configuration matching the previous fixed initialisation
+#define AT86RF212_CONFIG_DEFAULT { \
+    AT86RF212_DEFAULT_PHY_MODE, \
+    AT86RF212_DEFAULT_CHANNEL, \
+    AT86RF212_DEFAULT_CCA_MODE, \
+    AT86RF212_DEFAULT_MINBE, \
+    AT86RF212_DEFAULT_MAXBE, \
+    AT86RF212_DEFAULT_MAX_CSMA_BACKOFFS, \
+    AT86RF212_DEFAULT_MAX_FRAME_RETRIES, \
+    1, \
+    AT86RF212_DEFAULT_TX_POWER, \
+    AT86RF212_IRQ_2_RX_START | AT86RF212_IRQ_3_TRX_END, \
+    0xFFFF, \
+    0xFFFF \
+}
+
+// Maximum length of a configuration program
+#define AT86RF212_CONFIG_PROGRAM_MAX    12
+
+// Frame buffer patch for partial frame updates
+struct at86rf212_patch_s {
+    uint8_t offset;                 //!< Offset into the PSDU
+    uint8_t length;                 //!< Number of bytes to write
+    uint8_t *data;                  //!< Replacement data
+};
+
+// Received frame with decoded metadata
+// The payload is a view into the caller supplied buffer, so the frame is only valid while that buffer is.
+struct at86rf212_rx_frame_s {
+    uint8_t *payload;               //!< PSDU (including the CRC field)
+    uint8_t length;                 //!< PSDU length
+    uint8_t lqi;                    //!< Link quality indication
+    uint8_t ed;                     //!< Energy detect level
+    uint8_t rx_status;              //!< Raw RX_STATUS byte
+    uint8_t crc_valid;              //!< Indicates the frame CRC is valid
+    uint32_t timestamp;             //!< Time TRX_END was observed in microseconds (0 without a time source)
+};
+
 /****       Initialization           ****/
 
 // Create an at86rf212 device
 // Note that the device and driver objects must continue to exist outside this scope.
 int at86rf212_init(struct at86rf212_s *device, struct at86rf212_driver_s *driver, void* driver_ctx);
 
+// Create an at86rf212 device with the provided configuration
+// at86rf212_init applies AT86RF212_CONFIG_DEFAULT.
+int at86rf212_init_config(struct at86rf212_s *device, struct at86rf212_driver_s *driver, void* driver_ctx,
+                          const struct at86rf212_config_s *config);
+
+// Attach a free running microsecond time source, used for RX pacing, timestamps and queue latency
+// Optional, call after at86rf212_init (which detaches it), get_time_us is called with context.
+// Returns AT86RF212_DRIVER_INVALID with AT86RF212_STATIC_DRIVER (see AT86RF212_STATIC_DRIVER_TIME).
+int at86rf212_set_time_source(struct at86rf212_s *device, time_get_f get_time_us, void* context);
+
+// Attach a source for a file descriptor that is readable while an IRQ is signalled
+// Optional, call after at86rf212_init (which detaches it), get_irq_fd is called with context.
+// Returns AT86RF212_DRIVER_INVALID with AT86RF212_STATIC_DRIVER (see AT86RF212_STATIC_DRIVER_IRQ_FD).
+int at86rf212_set_irq_fd_source(struct at86rf212_s *device, fd_get_f get_irq_fd, void* context);
+
+// Build the register write program for a configuration
+// Registers are written whole, starting from their power on reset values, and registers that would
+// keep their reset value are omitted. Program must have space for AT86RF212_CONFIG_PROGRAM_MAX entries.
+// Returns the number of entries (one SPI transaction each)
+uint8_t at86rf212_config_program(const struct at86rf212_config_s *config, struct at86rf212_reg_update_s *program);
+
 // Close an at86rf212 device
 int at86rf212_close(struct at86rf212_s *device);
 
@@ -62,25 +174,75 @@ int at86rf212_get_state(struct at86rf212_s *device, uint8_t *state);
 // Channel functions
 int at86rf212_set_channel(struct at86rf212_s *device, uint8_t channel);
 int at86rf212_get_channel(struct at86rf212_s *device, uint8_t *channel);
+// Set Clear Channel Assessment mode (at86rf212_cca_mode_e)
+int at86rf212_set_cca_mode(struct at86rf212_s *device, uint8_t mode);
 
 int at86rf212_set_power_raw(struct at86rf212_s *device, uint8_t power);
 
+// PHY mode functions
+// Set modulation and data rate (at86rf212_phy_mode_e)
+int at86rf212_set_phy_mode(struct at86rf212_s *device, uint8_t mode);
+// Fetch the PHY bit rate in bits per second for a given mode
+uint32_t at86rf212_get_bit_rate(uint8_t mode);
+// Fetch the on air duration in microseconds of a frame with the given PSDU length (including CRC)
+// High data rate modes send the SHR and PHR at the base rate of the band.
+uint32_t at86rf212_airtime_us(uint8_t mode, uint8_t psdu_len);
+// Fetch the RSSI base value in dBm for a given mode, the received power is base + 1.03 * ED
+int8_t at86rf212_get_rssi_base(uint8_t mode);
+
 // Address and filtering functions
 int at86rf212_set_short_address(struct at86rf212_s *device, uint16_t address);
 int at86rf212_set_pan_id(struct at86rf212_s *device, uint16_t pan_id);
 
+// Clear Channel Assessment (CCA) functions
+// Perform a CCA measurement using the configured CCA mode, device must be in RX_ON
+// Clear is set to 1 if the channel is idle, 0 if busy
+int at86rf212_cca(struct at86rf212_s *device, uint8_t *clear);
+
+// Random functions
+// Read the two hardware random bits (PHY_RSSI.RND_VALUE), device must be in RX_ON
+int at86rf212_get_rnd_bits(struct at86rf212_s *device, uint8_t *bits);
+// Fetch random bytes from the device random pool, fetching more bits from the radio as required
+// Returns AT86RF212_ERROR_STATE if the pool is exhausted and the receiver is not on
+int at86rf212_get_random(struct at86rf212_s *device, uint8_t *data, uint8_t length);
+// Load the hardware CSMA_SEED registers from the random pool
+int at86rf212_seed_csma(struct at86rf212_s *device);
+// Fetch random pool statistics
+// Harvest rate (bits/s) can be derived by sampling these counters over time
+int at86rf212_get_random_stats(struct at86rf212_s *device, struct at86rf212_random_stats_s *stats);
+
 // IRQ functions
 int at86rf212_set_irq_mask(struct at86rf212_s *device, uint8_t mask);
 int at86rf212_get_irq_status(struct at86rf212_s *device, uint8_t *status);
 
+// Fetch the pollable IRQ file descriptor (at86rf212_set_irq_fd_source)
+// Returns AT86RF212_DRIVER_INVALID if no source is attached.
+int at86rf212_get_irq_fd(struct at86rf212_s *device, int *fd);
+
 // Transmit functions
     
 // Start packet transmission
 int at86rf212_start_tx(struct at86rf212_s *device, uint8_t length, uint8_t* data);
+// Upload a frame and leave the radio in PLL_ON without transmitting, start with at86rf212_resend
+int at86rf212_load_tx(struct at86rf212_s *device, uint8_t length, uint8_t* data);
+// Start packet transmission from PLL_ON or RX_ON without waiting, keeping the PLL locked
+// From other states this falls back to at86rf212_start_tx. The radio returns to PLL_ON once sent.
+// Returns AT86RF212_RES_REJECTED without transmitting if a received frame is waiting in the frame
+// buffer, the radio is left in PLL_ON with at86rf212_check_rx reporting it, drain it and retry.
+int at86rf212_start_tx_fast(struct at86rf212_s *device, uint8_t length, uint8_t* data);
+// Start transmission of a frame already laid out for upload, without copying
+// The buffer layout matches at86rf212_get_rx_frame: a byte reserved for the SPI command, one for the
+// PHR, then the PSDU with space for the CRC field, so an AT86RF212_RX_BUFFER_LEN buffer suffices.
+// Length excludes the CRC, the reserved bytes and CRC field are overwritten.
+int at86rf212_start_tx_buffer(struct at86rf212_s *device, uint8_t length, uint8_t* buffer);
 // Check for transmission complete
 // Returns at86rf212_result_e, values: AT86RF212_RES_DONE when complete, AT86RF212_RES_OK while transmitting
 int at86rf212_check_tx(struct at86rf212_s *device);
 
+// Retransmit the frame held in the frame buffer, patching only the changed bytes (ie. sequence number)
+// Must follow a transmission, with the radio in PLL_ON (after TX) or RX_ON with no frame received since
+int at86rf212_resend(struct at86rf212_s *device, uint8_t count, struct at86rf212_patch_s *patches);
+
 // Receive functions
     
 // Enter receive mode
@@ -90,6 +252,30 @@ int at86rf212_start_rx(struct at86rf212_s *device);
 int at86rf212_check_rx(struct at86rf212_s *device);
 // Fetch a received packet from the radio
 int at86rf212_get_rx(struct at86rf212_s *device, uint8_t* length, uint8_t* data);
+// Discard a received frame without downloading it
+// Clears a latched TRX_END and reads only the PHR, as any frame buffer read releases the buffer
+// protection (RX_SAFE_MODE) so the next frame can be received. Every fetch path that does not
+// download the frame must finish with this.
+int at86rf212_discard_rx(struct at86rf212_s *device);
+// Fetch a received packet with decoded metadata
+// Buffer must be AT86RF212_RX_BUFFER_LEN bytes, and the frame is read into it in a single burst after
+// the PHR. CRC validity is taken from the status byte of the PHR read, so frames with a bad CRC are
+// rejected (AT86RF212_RES_REJECTED) before download unless accept_bad_crc is set.
+int at86rf212_get_rx_frame(struct at86rf212_s *device, struct at86rf212_rx_frame_s *frame,
+                           uint8_t *buffer, uint8_t accept_bad_crc);
+// Check for the start of packet receipt (RX_START)
+// Returns at86rf212_result_e, values: AT86RF212_RES_DONE when reception has started, AT86RF212_RES_OK otherwise
+int at86rf212_check_rx_start(struct at86rf212_s *device);
+// Fetch a packet while it is being received, call once RX_START has been observed
+// The frame buffer is streamed in chunks paced by the PHY data rate, so the frame is available
+// shortly after TRX_END rather than after a full download. Data buffer and length are as for get_rx,
+// with the ED from PHY_ED_LEVEL and only RX_CRC_VALID set in the RX_STATUS byte. LQI is not available
+// in SRAM for maximum length frames and is reported as 0.
+int at86rf212_get_rx_early(struct at86rf212_s *device, uint8_t* length, uint8_t* data);
+// Fetch the rest of a received frame whose PHR and first fetched PSDU bytes were read from SRAM
+// (at86rf212_read_sram), completing data as for get_rx and releasing the frame buffer.
+int at86rf212_get_rx_remainder(struct at86rf212_s *device, uint8_t frame_len, uint8_t fetched,
+                               uint8_t* length, uint8_t* data);
 
 // Register functions
 // Read a value from a device register
@@ -98,6 +284,16 @@ int at86rf212_read_reg(struct at86rf212_s *device, uint8_t reg, uint8_t* val);
 int at86rf212_write_reg(struct at86rf212_s *device, uint8_t reg, uint8_t val);
 // Update a particular masked value in a device register
 int at86rf212_update_reg(struct at86rf212_s *device, uint8_t reg, uint8_t mask, uint8_t val);
+// Apply a sequence of register updates (see AT86RF212_UPDATEn in at86rf212_regs.h)
+// Each entry is one read-modify-write, or a plain write where the mask covers the whole register
+int at86rf212_update_regs(struct at86rf212_s *device, uint8_t count, const struct at86rf212_reg_update_s *updates);
+
+// Frame buffer SRAM functions
+// Addresses are frame buffer addresses, the PHR is at address 0 and the PSDU follows
+// Read data from the frame buffer starting at the provided address
+int at86rf212_read_sram(struct at86rf212_s *device, uint8_t addr, uint8_t length, uint8_t* data);
+// Write data to the frame buffer starting at the provided address
+int at86rf212_write_sram(struct at86rf212_s *device, uint8_t addr, uint8_t length, uint8_t* data);
 
 #ifdef __cplusplus
 }
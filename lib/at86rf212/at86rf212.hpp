@@ -7,6 +7,8 @@
 #pragma once
 
 #include "at86rf212_if.hpp"
+#include "at86rf212_regs.hpp"
+#include "at86rf212_frame.hpp"
 
 namespace AT86RF212
 {
@@ -28,7 +30,26 @@ public:
     int init(AT86RF212::DriverInterface* driver_ctx)
     {
         struct at86rf212_driver_s *driver = AT86RF212::DriverWrapper::GetWrapper();
-        return at86rf212_init(&(this->device), driver, (void*)driver_ctx);
+        int res = at86rf212_init(&(this->device), driver, (void*)driver_ctx);
+        if (res >= 0) {
+            at86rf212_set_irq_fd_source(&(this->device), at86rf212_get_irq_fd_adaptor, (void*)driver_ctx);
+        }
+        return res;
+    }
+
+    // Init with a configuration profile
+    int init(struct at86rf212_driver_s *driver, void *driver_ctx, const struct at86rf212_config_s& config)
+    {
+        return at86rf212_init_config(&(this->device), driver, driver_ctx, &config);
+    }
+    int init(AT86RF212::DriverInterface* driver_ctx, const struct at86rf212_config_s& config)
+    {
+        struct at86rf212_driver_s *driver = AT86RF212::DriverWrapper::GetWrapper();
+        int res = at86rf212_init_config(&(this->device), driver, (void*)driver_ctx, &config);
+        if (res >= 0) {
+            at86rf212_set_irq_fd_source(&(this->device), at86rf212_get_irq_fd_adaptor, (void*)driver_ctx);
+        }
+        return res;
     }
 
     // Close device
@@ -36,6 +57,18 @@ public:
     {
         return at86rf212_close(&(this->device));
     }
+
+    // Attach an optional microsecond time source, after init
+    int set_time_source(time_get_f get_time_us, void* context)
+    {
+        return at86rf212_set_time_source(&(this->device), get_time_us, context);
+    }
+
+    // IRQ file descriptor from DriverInterface::get_irq_fd (for at86rf212_manager)
+    int get_irq_fd(int *fd)
+    {
+        return at86rf212_get_irq_fd(&(this->device), fd);
+    }
     int set_short_address(uint16_t address)
     {
         return at86rf212_set_short_address(&(this->device), address);
@@ -73,6 +106,10 @@ public:
     {
         return at86rf212_check_tx(&(this->device));
     }
+    int resend(uint8_t count, struct at86rf212_patch_s *patches)
+    {
+        return at86rf212_resend(&(this->device), count, patches);
+    }
 
     int start_rx()
     {
@@ -86,6 +123,41 @@ public:
     {
         return at86rf212_get_rx(&(this->device), length, data);
     }
+    // Receive into, or transmit and release, a pooled frame (at86rf212_frame.hpp)
+    int get_rx(Frame& frame, bool accept_bad_crc = false)
+    {
+        return AT86RF212::get_rx(&(this->device), frame, accept_bad_crc);
+    }
+    int start_tx(Frame&& frame)
+    {
+        return AT86RF212::start_tx(&(this->device), static_cast<Frame&&>(frame));
+    }
+    int get_rx_frame(struct at86rf212_rx_frame_s *frame, uint8_t *buffer, bool accept_bad_crc = false)
+    {
+        return at86rf212_get_rx_frame(&(this->device), frame, buffer, accept_bad_crc ? 1 : 0);
+    }
+    int check_rx_start()
+    {
+        return at86rf212_check_rx_start(&(this->device));
+    }
+    int get_rx_early(uint8_t* length, uint8_t* data)
+    {
+        return at86rf212_get_rx_early(&(this->device), length, data);
+    }
+
+    int set_phy_mode(uint8_t mode)
+    {
+        return at86rf212_set_phy_mode(&(this->device), mode);
+    }
+
+    int get_random(uint8_t *data, uint8_t length)
+    {
+        return at86rf212_get_random(&(this->device), data, length);
+    }
+    int get_random_stats(struct at86rf212_random_stats_s *stats)
+    {
+        return at86rf212_get_random_stats(&(this->device), stats);
+    }
 
     int read_reg(uint8_t reg, uint8_t* val)
     {
@@ -95,6 +167,31 @@ public:
     {
         return at86rf212_write_reg(&(this->device), reg, val);
     }
+    int update_reg(uint8_t reg, uint8_t mask, uint8_t val)
+    {
+        return at86rf212_update_reg(&(this->device), reg, mask, val);
+    }
+    // Apply a combined field update (see at86rf212_regs.hpp)
+    template <uint8_t Reg>
+    int update(Regs::Update<Reg> u)
+    {
+        const struct at86rf212_reg_update_s entry = u;
+        return at86rf212_update_regs(&(this->device), 1, &entry);
+    }
+    int read_sram(uint8_t addr, uint8_t length, uint8_t* data)
+    {
+        return at86rf212_read_sram(&(this->device), addr, length, data);
+    }
+    int write_sram(uint8_t addr, uint8_t length, uint8_t* data)
+    {
+        return at86rf212_write_sram(&(this->device), addr, length, data);
+    }
+
+    // C device, for the rest of the at86rf212_* API
+    struct at86rf212_s* c_device()
+    {
+        return &(this->device);
+    }
 
 private:
     struct at86rf212_s device;
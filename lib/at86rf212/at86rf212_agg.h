@@ -0,0 +1,87 @@
+/*
+ * at86rf212 small message aggregation
+ * Coalesces short messages into a single PSDU to amortise the PHY, MAC and state transition
+ * overhead of each frame, and splits received aggregates back into messages.
+ *
+ * Aggregate layout: AT86RF212_AGG_TYPE, then for each message a one byte length and the message.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_AGG_H
+#define AT86RF212_AGG_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AT86RF212_AGG_TYPE          0xA3    //!< Aggregate frame type (first payload byte)
+#define AT86RF212_AGG_HEADER_LEN    1       //!< Aggregate header length
+#define AT86RF212_AGG_SUB_HEADER_LEN 1      //!< Per message header length
+#define AT86RF212_AGG_MAX_PAYLOAD   (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN)
+
+// Aggregate send callback, returns AT86RF212_RES_OK if the frame was accepted for transmission
+typedef int (*at86rf212_agg_send_f)(void* context, uint8_t length, uint8_t* data);
+
+// Aggregator configuration
+struct at86rf212_agg_config_s {
+    uint8_t max_length;             //!< Largest aggregate payload (<= AT86RF212_AGG_MAX_PAYLOAD, less any MAC header)
+    uint32_t max_hold_us;           //!< Longest a message is held waiting for others
+};
+
+// Aggregator statistics
+struct at86rf212_agg_stats_s {
+    uint32_t messages;              //!< Messages sent
+    uint32_t frames;                //!< Aggregate frames sent
+    uint32_t bytes;                 //!< Aggregate bytes sent, including headers
+    uint32_t timeouts;              //!< Aggregates sent because the hold time expired
+};
+
+// Transmit side aggregator
+struct at86rf212_agg_s {
+    struct at86rf212_agg_config_s config;
+    at86rf212_agg_send_f send;
+    void* send_ctx;
+    uint8_t buffer[AT86RF212_AGG_MAX_PAYLOAD];
+    uint8_t length;                 //!< Bytes in buffer
+    uint8_t count;                  //!< Messages in buffer
+    uint32_t first_time;            //!< Time the oldest buffered message was added
+    struct at86rf212_agg_stats_s stats;
+};
+
+// Load the default configuration
+void at86rf212_agg_default_config(struct at86rf212_agg_config_s *config);
+
+// Initialise an aggregator
+int at86rf212_agg_init(struct at86rf212_agg_s *agg, const struct at86rf212_agg_config_s *config,
+                       at86rf212_agg_send_f send, void* send_ctx);
+
+// Add a message, sending the current aggregate first if the message does not fit
+// Returns AT86RF212_RES_DONE if an aggregate was sent. An error means the message was not added,
+// a failure to send the aggregate it completed is left to the next poll.
+int at86rf212_agg_push(struct at86rf212_agg_s *agg, uint32_t now_us, uint8_t length, const uint8_t* data);
+
+// Send the current aggregate if the oldest message has been held for max_hold_us, or if it is full
+// Returns AT86RF212_RES_DONE if an aggregate was sent.
+int at86rf212_agg_poll(struct at86rf212_agg_s *agg, uint32_t now_us);
+
+// Send the current aggregate immediately
+// Returns AT86RF212_RES_DONE if an aggregate was sent, AT86RF212_RES_OK if empty.
+int at86rf212_agg_flush(struct at86rf212_agg_s *agg);
+
+// Receive side: iterate the messages in an aggregate payload
+// Offset starts at 0 and is advanced on each call. Returns AT86RF212_RES_DONE with a message,
+// AT86RF212_RES_OK at the end of the aggregate, AT86RF212_RES_REJECTED for non aggregate frames
+// or AT86RF212_ERROR_LEN for a malformed aggregate.
+int at86rf212_agg_next(uint8_t length, const uint8_t* data, uint8_t* offset,
+                       uint8_t* message_length, const uint8_t** message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
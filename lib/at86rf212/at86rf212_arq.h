@@ -0,0 +1,134 @@
+/*
+ * at86rf212 reliable transfer layer
+ * Segments a byte stream into frames and delivers it in order using selective-repeat ARQ with
+ * cumulative and bitmap acknowledgements and adaptive retransmission timeouts.
+ *
+ * The layer is transport agnostic, frames are sent through a callback and received frames are
+ * passed in, so it can sit on the raw frame API, a transmit queue or a MAC layer.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_ARQ_H
+#define AT86RF212_ARQ_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+
+// The stream buffers are held in the ARQ state, so their size is fixed for the library build (at86rf212_build.h)
+#if defined(AT86RF212_ARQ_BUFFER_SIZE) && !defined(AT86RF212_BUILD_H)
+#error "AT86RF212_ARQ_BUFFER_SIZE must be set in at86rf212_build.h"
+#endif
+#include "at86rf212_build.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AT86RF212_ARQ_MAX_WINDOW        32      //!< Maximum window (segments in flight)
+#define AT86RF212_ARQ_DATA_HEADER_LEN   2       //!< Type and sequence number
+#define AT86RF212_ARQ_ACK_LEN           6       //!< Type, cumulative ack and 32 bit selective ack bitmap
+#define AT86RF212_ARQ_MAX_SEGMENT       (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN - AT86RF212_ARQ_DATA_HEADER_LEN)
+
+// ARQ frame types (first PSDU byte)
+#define AT86RF212_ARQ_TYPE_DATA         0xA1
+#define AT86RF212_ARQ_TYPE_ACK          0xA2
+
+// Frame send callback, returns AT86RF212_RES_OK if the frame was accepted for transmission
+typedef int (*at86rf212_arq_send_f)(void* context, uint8_t length, uint8_t* data);
+
+// ARQ configuration
+struct at86rf212_arq_config_s {
+    uint8_t window;                 //!< Segments in flight (1 for stop and wait, <= AT86RF212_ARQ_MAX_WINDOW)
+    uint8_t segment_len;            //!< Stream bytes per frame (<= AT86RF212_ARQ_MAX_SEGMENT)
+    uint32_t rto_initial_us;        //!< Retransmission timeout before any round trip is measured
+    uint32_t rto_min_us;            //!< Lower bound on the retransmission timeout
+    uint32_t rto_max_us;            //!< Upper bound on the retransmission timeout
+};
+
+// ARQ statistics
+struct at86rf212_arq_stats_s {
+    uint32_t segments_sent;         //!< Data frames sent, including retransmissions
+    uint32_t retransmissions;       //!< Data frames resent after a timeout
+    uint32_t acks_sent;             //!< Acknowledgement frames sent
+    uint32_t duplicates;            //!< Data frames received more than once
+    uint32_t bytes_acked;           //!< Stream bytes acknowledged by the peer
+    uint32_t bytes_received;        //!< Stream bytes delivered in order
+};
+
+// Send side segment record
+struct at86rf212_arq_segment_s {
+    uint32_t offset;                //!< Stream offset of the first byte
+    uint8_t length;                 //!< Stream bytes in the segment
+    uint8_t acked;                  //!< Indicates the segment has been acknowledged
+    uint8_t retries;                //!< Number of retransmissions
+    uint32_t sent_time;             //!< Time of the latest transmission
+};
+
+// Receive side reorder slot
+struct at86rf212_arq_slot_s {
+    uint8_t valid;                  //!< Indicates the slot holds a segment awaiting delivery
+    uint8_t length;
+    uint8_t data[AT86RF212_ARQ_MAX_SEGMENT];
+};
+
+// ARQ endpoint (one direction of a stream is sent, the other received)
+struct at86rf212_arq_s {
+    struct at86rf212_arq_config_s config;
+    at86rf212_arq_send_f send;
+    void* send_ctx;
+
+    // Send stream, bytes [tx_head, tx_tail) are unacknowledged or unsent
+    uint8_t tx_buffer[AT86RF212_ARQ_BUFFER_SIZE];
+    uint32_t tx_head;
+    uint32_t tx_tail;
+    uint32_t tx_next;               //!< Stream offset of the next new segment
+    uint8_t base_seq;               //!< Oldest unacknowledged sequence number
+    uint8_t next_seq;               //!< Next new sequence number
+    struct at86rf212_arq_segment_s segments[AT86RF212_ARQ_MAX_WINDOW];
+
+    // Round trip estimation (microseconds)
+    uint32_t srtt;
+    uint32_t rttvar;
+    uint32_t rto;
+
+    // Receive stream, bytes [rx_head, rx_tail) are waiting to be read
+    uint8_t rx_buffer[AT86RF212_ARQ_BUFFER_SIZE];
+    uint32_t rx_head;
+    uint32_t rx_tail;
+    uint8_t rx_next;                //!< Next sequence number to deliver
+    uint8_t ack_pending;            //!< Indicates an acknowledgement should be sent
+    struct at86rf212_arq_slot_s slots[AT86RF212_ARQ_MAX_WINDOW];
+
+    struct at86rf212_arq_stats_s stats;
+};
+
+// Load the default configuration
+void at86rf212_arq_default_config(struct at86rf212_arq_config_s *config);
+
+// Initialise an ARQ endpoint
+int at86rf212_arq_init(struct at86rf212_arq_s *arq, const struct at86rf212_arq_config_s *config,
+                       at86rf212_arq_send_f send, void* send_ctx);
+
+// Queue stream data for sending, returns the number of bytes accepted
+uint32_t at86rf212_arq_write(struct at86rf212_arq_s *arq, const uint8_t* data, uint32_t length);
+
+// Read in order stream data, returns the number of bytes read
+uint32_t at86rf212_arq_read(struct at86rf212_arq_s *arq, uint8_t* data, uint32_t length);
+
+// Handle a received frame (PSDU excluding CRC), frames that are not ARQ frames are ignored
+int at86rf212_arq_input(struct at86rf212_arq_s *arq, uint32_t now_us, uint8_t length, const uint8_t* data);
+
+// Send at most one pending frame (acknowledgement, retransmission or new segment)
+// Call whenever the transport is free. Returns AT86RF212_RES_DONE if a frame was sent.
+int at86rf212_arq_poll(struct at86rf212_arq_s *arq, uint32_t now_us);
+
+// Number of sent bytes not yet acknowledged (including bytes not yet sent)
+uint32_t at86rf212_arq_unacked(struct at86rf212_arq_s *arq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
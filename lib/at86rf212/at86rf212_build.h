@@ -0,0 +1,21 @@
+/*
+ * at86rf212 library build configuration
+ * Sizes that change the layout of library structures. The library and every translation unit
+ * using it must agree on these, so they are set here for the whole build rather than defined
+ * before including individual headers.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_BUILD_H
+#define AT86RF212_BUILD_H
+
+#define AT86RF212_RING_SLOTS            16      //!< Frame slots per receive ring, must be a power of two
+#define AT86RF212_TXQ_DEPTH             16      //!< Frames held across all classes, must be a power of two
+#define AT86RF212_ARQ_BUFFER_SIZE       4096    //!< Send and receive stream buffer size, must be a power of two
+#define AT86RF212_LOWPAN_REASM_SLOTS    2       //!< Concurrent reassemblies
+#define AT86RF212_NBR_SLOTS             64      //!< Neighbour table slots, must be a power of two
+#define AT86RF212_DEDUP_SETS            32      //!< Duplicate filter sets, must be a power of two
+#define AT86RF212_MANAGER_MAX_RADIOS    8       //!< Radios per manager
+
+#endif
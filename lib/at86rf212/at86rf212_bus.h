@@ -0,0 +1,147 @@
+/*
+ * at86rf212 shared SPI bus arbiter
+ * Schedules the SPI transfers of several radios sharing one bus, so a long configuration sequence
+ * on one radio cannot hold off draining a full frame buffer on another. Each radio is attached
+ * through a bus port, which provides the radio's driver object, and transfers are queued by
+ * priority (classified from the SPI command byte) and executed one at a time, re-arbitrating
+ * between transfers. When the backend supports batched transfers, queued transfers are
+ * coalesced into a single backend call.
+ *
+ * Priorities are strict: a lower priority transfer only runs once no higher priority transfer is
+ * queued, so sustained receive or control traffic on any radio holds off configuration transfers
+ * on all of them indefinitely. Receive traffic is paced by frame arrival, so this is bounded in
+ * practice, but applications polling at a high rate should not expect configuration latency to
+ * be bounded under load.
+ *
+ * Thread safe, radios on a bus may be driven from any number of threads. POSIX only (pthreads).
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_BUS_H
+#define AT86RF212_BUS_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "at86rf212.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef AT86RF212_BUS_BATCH_MAX
+#define AT86RF212_BUS_BATCH_MAX     8       //!< Transfers per backend batch
+#endif
+#ifndef AT86RF212_BUS_BATCH_BYTES
+#define AT86RF212_BUS_BATCH_BYTES   AT86RF212_RX_BUFFER_LEN     //!< Bytes per batch, so a batch holds the bus no longer than a frame read
+#endif
+
+// Transfer priorities, lower values are scheduled first
+enum at86rf212_bus_prio_e {
+    AT86RF212_BUS_PRIO_RX = 0,          //!< Frame buffer and SRAM reads (draining received frames)
+    AT86RF212_BUS_PRIO_CONTROL = 1,     //!< Frame buffer writes and TRX_STATE / IRQ_STATUS accesses (TX trigger, IRQ service)
+    AT86RF212_BUS_PRIO_CONFIG = 2,      //!< Other register accesses and SRAM writes (configuration and statistics)
+    AT86RF212_BUS_PRIOS = 3
+};
+
+// Single transfer in a batch, each asserts its own chip select
+struct at86rf212_bus_xfer_s {
+    uint8_t cs;                         //!< Chip select of the radio
+    int len;
+    uint8_t *data_out;
+    uint8_t *data_in;
+};
+
+// Physical bus backend
+typedef int (*at86rf212_bus_transfer_f)(void* context, uint8_t cs, int len, uint8_t *data_out, uint8_t* data_in);
+typedef int (*at86rf212_bus_batch_f)(void* context, int count, struct at86rf212_bus_xfer_s *xfers);
+
+struct at86rf212_bus_backend_s {
+    at86rf212_bus_transfer_f transfer;  //!< Single transfer
+    at86rf212_bus_batch_f batch;        //!< Batched transfers, all completed or failed together (optional)
+};
+
+struct at86rf212_bus_port_s;
+
+// Queued transfer (internal, lives on the stack of the calling thread)
+struct at86rf212_bus_op_s {
+    struct at86rf212_bus_port_s *port;
+    int len;
+    uint8_t *data_out;
+    uint8_t *data_in;
+    uint8_t priority;
+    uint8_t done;
+    int result;
+    uint64_t queued_ns;
+    struct at86rf212_bus_op_s *next;
+};
+
+// Per-port statistics for one priority
+struct at86rf212_bus_stats_s {
+    uint32_t transfers;                 //!< Transfers completed
+    uint32_t bytes;                     //!< Bytes transferred
+    uint64_t wait_us;                   //!< Total time spent waiting for the bus
+    uint32_t max_wait_us;               //!< Longest wait for the bus
+};
+
+// Bus statistics
+struct at86rf212_bus_totals_s {
+    uint32_t batches;                   //!< Backend calls
+    uint32_t coalesced;                 //!< Transfers executed in a batch with others
+    uint32_t max_pending;               //!< Most transfers queued at once
+};
+
+// Shared bus
+struct at86rf212_bus_s {
+    pthread_mutex_t lock;
+    pthread_cond_t complete;            //!< Signalled when a batch completes
+    const struct at86rf212_bus_backend_s *backend;
+    void* backend_ctx;
+    uint8_t busy;                       //!< A thread is executing transfers
+    uint32_t pending;                   //!< Transfers queued
+    struct at86rf212_bus_op_s *head[AT86RF212_BUS_PRIOS];
+    struct at86rf212_bus_op_s *tail[AT86RF212_BUS_PRIOS];
+    struct at86rf212_bus_totals_s stats;
+};
+
+// Radio attached to a bus
+// The port driver passes SPI transfers to the bus and the remaining functions to the radio driver.
+struct at86rf212_bus_port_s {
+    struct at86rf212_bus_s *bus;
+    uint8_t cs;                         //!< Chip select passed to the backend
+    struct at86rf212_driver_s driver;   //!< Driver object for at86rf212_init (with the port as context)
+    struct at86rf212_driver_s *radio_driver;
+    void* radio_ctx;
+    struct at86rf212_bus_stats_s stats[AT86RF212_BUS_PRIOS];
+};
+
+// Initialise a bus with a backend
+int at86rf212_bus_init(struct at86rf212_bus_s *bus, const struct at86rf212_bus_backend_s *backend, void* backend_ctx);
+
+// Attach a radio to the bus with its chip select, and the driver providing its GPIO (and optional)
+// functions. The radio is then initialised with at86rf212_init(device, &port->driver, port).
+int at86rf212_bus_port_init(struct at86rf212_bus_s *bus, struct at86rf212_bus_port_s *port, uint8_t cs,
+                            struct at86rf212_driver_s *radio_driver, void* radio_ctx);
+
+// Transfer through the bus (spi_transfer_f with a port as the context)
+// Blocks until the transfer has been scheduled and completed.
+int at86rf212_bus_spi_transfer(void* context, int len, uint8_t *data_out, uint8_t* data_in);
+
+// Priority of a transfer from its command bytes
+uint8_t at86rf212_bus_classify(int len, const uint8_t *data_out);
+
+// Copy the statistics of a port (AT86RF212_BUS_PRIOS entries)
+void at86rf212_bus_port_stats(struct at86rf212_bus_port_s *port, struct at86rf212_bus_stats_s *stats);
+
+// Number of transfers waiting for the bus
+uint32_t at86rf212_bus_pending(struct at86rf212_bus_s *bus);
+
+// Release bus resources, no transfers may be in progress
+void at86rf212_bus_close(struct at86rf212_bus_s *bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
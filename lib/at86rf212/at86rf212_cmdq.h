@@ -0,0 +1,128 @@
+/*
+ * at86rf212 command submission queue
+ * Allows any number of threads to submit commands (transmissions, configuration changes and
+ * status reads) for a device, which are executed in submission order by the single context
+ * owning the device. Submission is lock free (one atomic exchange), commands are caller allocated
+ * and complete through a callback or by polling.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_CMDQ_H
+#define AT86RF212_CMDQ_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+#include "at86rf212_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Command types
+enum at86rf212_cmd_type_e {
+    AT86RF212_CMDQ_TX = 0,              //!< Start transmission of a frame (at86rf212_start_tx)
+    AT86RF212_CMDQ_SET_CHANNEL = 1,     //!< Set the channel
+    AT86RF212_CMDQ_SET_POWER = 2,       //!< Set the raw PHY_TX_PWR value
+    AT86RF212_CMDQ_UPDATE_REGS = 3,     //!< Apply masked register updates (at86rf212_update_regs)
+    AT86RF212_CMDQ_READ_REG = 4,        //!< Read a register, the result is the value
+    AT86RF212_CMDQ_RANDOM_STATS = 5,    //!< Copy the random pool statistics
+    AT86RF212_CMDQ_CALL = 6             //!< Call a function with the device
+};
+
+struct at86rf212_cmd_s;
+
+// Completion callback, called from the owner context
+typedef void (*at86rf212_cmd_done_f)(void* context, struct at86rf212_cmd_s *cmd, int result);
+// Function executed by AT86RF212_CMDQ_CALL, returns the command result
+typedef int (*at86rf212_cmd_call_f)(struct at86rf212_s *device, void* context);
+// Owner wakeup callback, called when the queue may need servicing (usually from a submitting thread)
+typedef void (*at86rf212_cmdq_notify_f)(void* context);
+
+// Command
+// Owned by the submitter, which must keep it (and any buffers it refers to) valid until completion.
+struct at86rf212_cmd_s {
+    struct at86rf212_cmd_s *next;       //!< Queue link (internal)
+    uint8_t type;                       //!< Command type (at86rf212_cmd_type_e)
+    union {
+        struct {
+            uint8_t length;
+            uint8_t *data;
+        } tx;
+        uint8_t value;                  //!< Channel or power
+        struct {
+            uint8_t count;
+            const struct at86rf212_reg_update_s *updates;
+        } regs;
+        uint8_t reg;                    //!< Register to read
+        struct at86rf212_random_stats_s *stats;
+        struct {
+            at86rf212_cmd_call_f fn;
+            void* ctx;
+        } call;
+    } args;
+    at86rf212_cmd_done_f done;          //!< Completion callback (optional)
+    void* done_ctx;
+    int result;                         //!< Command result, valid once complete
+    uint8_t complete;                   //!< Set (with release ordering) once the command has executed
+};
+
+// Queue statistics
+struct at86rf212_cmdq_stats_s {
+    uint32_t submitted;                 //!< Commands submitted
+    uint32_t executed;                  //!< Commands executed
+    uint32_t notifies;                  //!< Owner wakeups requested
+    uint32_t max_batch;                 //!< Most commands executed in one at86rf212_cmdq_run
+};
+
+// Multiple producer, single consumer queue of commands for one device
+// Producers link commands with an atomic exchange on head, the owner consumes from tail.
+struct at86rf212_cmdq_s {
+    struct at86rf212_s *device;
+    struct at86rf212_cmd_s *head;       //!< Most recently submitted command (producers)
+    struct at86rf212_cmd_s *tail;       //!< Next command to execute (owner)
+    struct at86rf212_cmd_s stub;        //!< Placeholder keeping the list non-empty
+    uint8_t signalled;                  //!< Owner wakeup requested since the last run
+    at86rf212_cmdq_notify_f notify;
+    void* notify_ctx;
+    struct at86rf212_cmdq_stats_s stats;
+};
+
+// Initialise a queue for a device, notify is called on the first submission after each run, and by a
+// run that stops at max with commands left (optional)
+void at86rf212_cmdq_init(struct at86rf212_cmdq_s *queue, struct at86rf212_s *device,
+                         at86rf212_cmdq_notify_f notify, void* notify_ctx);
+
+// Submit a command from any thread, the command type and arguments must be set
+void at86rf212_cmdq_submit(struct at86rf212_cmdq_s *queue, struct at86rf212_cmd_s *cmd);
+
+// Owner: execute up to max queued commands in submission order, returns the number executed
+// A command whose submission is still in progress ends the run, and is executed by the next one.
+int at86rf212_cmdq_run(struct at86rf212_cmdq_s *queue, int max);
+
+// Owner: indicates commands are queued (or being submitted) for the next run
+int at86rf212_cmdq_pending(struct at86rf212_cmdq_s *queue);
+
+// Owner: complete every queued command with result without executing it, returns the number cancelled
+// Used when tearing down a device, submissions must have stopped.
+int at86rf212_cmdq_cancel(struct at86rf212_cmdq_s *queue, int result);
+
+// Indicates a submitted command has executed (for polling from the submitting thread)
+int at86rf212_cmd_complete(struct at86rf212_cmd_s *cmd);
+
+// Command initialisers
+// These clear the command, so the completion callback (done, done_ctx) is set afterwards.
+void at86rf212_cmd_tx(struct at86rf212_cmd_s *cmd, uint8_t length, uint8_t *data);
+void at86rf212_cmd_set_channel(struct at86rf212_cmd_s *cmd, uint8_t channel);
+void at86rf212_cmd_set_power(struct at86rf212_cmd_s *cmd, uint8_t power);
+void at86rf212_cmd_update_regs(struct at86rf212_cmd_s *cmd, uint8_t count, const struct at86rf212_reg_update_s *updates);
+void at86rf212_cmd_read_reg(struct at86rf212_cmd_s *cmd, uint8_t reg);
+void at86rf212_cmd_random_stats(struct at86rf212_cmd_s *cmd, struct at86rf212_random_stats_s *stats);
+void at86rf212_cmd_call(struct at86rf212_cmd_s *cmd, at86rf212_cmd_call_f fn, void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * at86rf212 thread safe device handle
+ * CommandQueue wraps the command submission queue (at86rf212_cmdq.h) with futures, so any thread
+ * can issue operations against a device while a single owner context executes them by calling
+ * run(), for example from its receive loop or an event loop wakeup.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+#include <functional>
+#include <future>
+#include <memory>
+
+#include "at86rf212.h"
+#include "at86rf212_cmdq.h"
+
+namespace AT86RF212
+{
+
+// Destroyed by the owner once submissions have stopped, commands still queued then complete with
+// AT86RF212_ERROR_STATE without executing
+class CommandQueue
+{
+public:
+    // Notify (optional) is called when the owner should call run()
+    explicit CommandQueue(struct at86rf212_s* device, at86rf212_cmdq_notify_f notify = nullptr, void* notify_ctx = nullptr)
+    {
+        at86rf212_cmdq_init(&queue, device, notify, notify_ctx);
+    }
+
+    ~CommandQueue()
+    {
+        at86rf212_cmdq_cancel(&queue, AT86RF212_ERROR_STATE);
+    }
+
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    // Start transmission of a frame, the data is copied on submission
+    // Frames too long to send (length excludes the CRC) complete immediately with AT86RF212_ERROR_LEN
+    std::future<int> send(uint8_t length, const uint8_t* data)
+    {
+        if (length > (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN)) {
+            std::promise<int> rejected;
+            rejected.set_value(AT86RF212_ERROR_LEN);
+            return rejected.get_future();
+        }
+
+        std::unique_ptr<Pending> p(new Pending());
+        memcpy(p->data, data, length);
+        at86rf212_cmd_tx(&p->cmd, length, p->data);
+        return submit(std::move(p));
+    }
+
+    std::future<int> set_channel(uint8_t channel)
+    {
+        std::unique_ptr<Pending> p(new Pending());
+        at86rf212_cmd_set_channel(&p->cmd, channel);
+        return submit(std::move(p));
+    }
+
+    std::future<int> set_power_raw(uint8_t power)
+    {
+        std::unique_ptr<Pending> p(new Pending());
+        at86rf212_cmd_set_power(&p->cmd, power);
+        return submit(std::move(p));
+    }
+
+    // Read a register, the future holds the value or an error code
+    std::future<int> read_reg(uint8_t reg)
+    {
+        std::unique_ptr<Pending> p(new Pending());
+        at86rf212_cmd_read_reg(&p->cmd, reg);
+        return submit(std::move(p));
+    }
+
+    // Run a function against the device in the owner context
+    std::future<int> call(std::function<int(struct at86rf212_s*)> fn)
+    {
+        std::unique_ptr<Pending> p(new Pending());
+        p->fn = std::move(fn);
+        at86rf212_cmd_call(&p->cmd, invoke, p.get());
+        return submit(std::move(p));
+    }
+
+    // Owner: execute queued commands, returns the number executed
+    int run(int max = INT_MAX)
+    {
+        return at86rf212_cmdq_run(&queue, max);
+    }
+
+    const struct at86rf212_cmdq_stats_s& stats() const
+    {
+        return queue.stats;
+    }
+
+    // Underlying queue, for C command submission
+    struct at86rf212_cmdq_s* c_queue()
+    {
+        return &queue;
+    }
+
+private:
+    struct Pending {
+        struct at86rf212_cmd_s cmd;
+        std::promise<int> promise;
+        std::function<int(struct at86rf212_s*)> fn;
+        uint8_t data[AT86RF212_MAX_LENGTH];
+    };
+
+    std::future<int> submit(std::unique_ptr<Pending> p)
+    {
+        std::future<int> result = p->promise.get_future();
+        p->cmd.done = done;
+        p->cmd.done_ctx = p.get();
+        at86rf212_cmdq_submit(&queue, &p.release()->cmd);
+        return result;
+    }
+
+    static void done(void* context, struct at86rf212_cmd_s* cmd, int result)
+    {
+        std::unique_ptr<Pending> p(static_cast<Pending*>(context));
+        p->promise.set_value(result);
+    }
+
+    static int invoke(struct at86rf212_s* device, void* context)
+    {
+        return static_cast<Pending*>(context)->fn(device);
+    }
+
+    struct at86rf212_cmdq_s queue;
+};
+
+};
@@ -0,0 +1,84 @@
+/*
+ * at86rf212 payload compression
+ * Byte oriented LZ77 tuned for payloads under 127 bytes. Matches may reference a shared static
+ * dictionary, the previous frame on the link (delta encoding) and the current payload, using a
+ * 9 bit distance into the concatenation of the three.
+ *
+ * Compressed payload layout:
+ *  type (AT86RF212_COMP_TYPE_*), sequence, [reference sequence for delta frames], tokens
+ * Tokens:
+ *  0nnnnnnn            literal run of n + 1 bytes follows
+ *  1lllllld dddddddd   match of l + 3 bytes at distance d + 1
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_COMP_H
+#define AT86RF212_COMP_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AT86RF212_COMP_TYPE_RAW         0xA4    //!< Payload stored uncompressed
+#define AT86RF212_COMP_TYPE_LZ          0xA5    //!< Compressed against the dictionary
+#define AT86RF212_COMP_TYPE_DELTA       0xA6    //!< Compressed against the dictionary and previous frame
+
+#define AT86RF212_COMP_MAX_DICT         256     //!< Maximum shared dictionary length
+#define AT86RF212_COMP_MAX_PAYLOAD      (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN)
+#define AT86RF212_COMP_MAX_HEADER       3       //!< Largest compressed payload header
+#define AT86RF212_COMP_MAX_INPUT        (AT86RF212_COMP_MAX_PAYLOAD - 2)    //!< Largest payload that can always be sent
+#define AT86RF212_COMP_MIN_MATCH        3
+#define AT86RF212_COMP_MAX_MATCH        (AT86RF212_COMP_MIN_MATCH + 63)
+#define AT86RF212_COMP_MAX_DISTANCE     512
+
+// Compression statistics
+struct at86rf212_comp_stats_s {
+    uint32_t frames;                //!< Frames processed
+    uint32_t bytes_in;              //!< Uncompressed bytes
+    uint32_t bytes_out;             //!< Compressed bytes (including headers)
+    uint32_t raw_frames;            //!< Frames stored uncompressed
+    uint32_t delta_frames;          //!< Frames coded against the previous frame
+    uint32_t errors;                //!< Frames that could not be decoded
+};
+
+// Link compression context, one per direction per link
+// Compressor and decompressor contexts must share the dictionary.
+struct at86rf212_comp_s {
+    const uint8_t* dict;            //!< Shared static dictionary
+    uint16_t dict_len;
+    uint8_t key_interval;           //!< Send a frame without delta encoding every n frames (0 for never)
+    uint8_t seq;                    //!< Sequence number of the next (compressor) or last (decompressor) frame
+    uint8_t prev_valid;             //!< Indicates prev holds the previous frame
+    uint8_t prev_seq;
+    uint8_t prev_len;
+    uint8_t prev[AT86RF212_COMP_MAX_PAYLOAD];
+    struct at86rf212_comp_stats_s stats;
+};
+
+// Initialise a compression context
+// Delta encoding assumes the peer received the previous frame, so over lossy links without
+// retransmission a key interval bounds the run of undecodable frames after a loss.
+int at86rf212_comp_init(struct at86rf212_comp_s *comp, const uint8_t* dict, uint16_t dict_len, uint8_t key_interval);
+
+// Compress a payload of up to AT86RF212_COMP_MAX_INPUT bytes
+// Output must have room for AT86RF212_COMP_MAX_PAYLOAD bytes, the output length is returned in out_len.
+int at86rf212_comp_compress(struct at86rf212_comp_s *comp, uint8_t in_len, const uint8_t* in,
+                            uint8_t* out_len, uint8_t* out);
+
+// Decompress a payload, without allocation
+// Output must have room for AT86RF212_COMP_MAX_PAYLOAD bytes. Returns AT86RF212_ERROR_STATE for
+// delta frames whose reference frame was not received, AT86RF212_RES_REJECTED for frames that
+// are not compressed payloads, and AT86RF212_ERROR_LEN for malformed payloads.
+int at86rf212_comp_decompress(struct at86rf212_comp_s *comp, uint8_t in_len, const uint8_t* in,
+                              uint8_t* out_len, uint8_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,613 @@
+/*
+ * at86rf212 c++20 coroutine interface
+ * Awaitable send, receive and energy detect operations, resumed from the radio IRQ rather
+ * than by polling, so any number of logical transactions on any number of radios can share
+ * one thread:
+ *
+ *   Coro::Task ping(Coro::Radio& radio, uint8_t* frame)
+ *   {
+ *       int res = co_await radio.send(10, frame);
+ *       if (res < 0) {
+ *           co_return res;
+ *       }
+ *       co_return co_await radio.receive(10000, &length, buffer);
+ *   }
+ *
+ * Operations on a radio are queued and run in order, one at a time. The application calls
+ * on_irq() when the radio IRQ line is asserted and on_timer() when next_deadline() passes, and
+ * may sleep in between. Times are in the units of the clock passed to the Radio and to these
+ * calls.
+ *
+ * Coroutines taking a Radio& as their first argument allocate their frames from that radio's
+ * arena, so no heap allocation occurs once running. Other coroutines use the heap.
+ *
+ * Requires C++20 (the rest of the library only requires C++11).
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "at86rf212_coro.hpp requires C++20 coroutine support"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <coroutine>
+#include <exception>
+#include <new>
+
+#include "at86rf212.h"
+#include "at86rf212_defs.h"
+#include "at86rf212_regs.h"
+
+namespace AT86RF212
+{
+
+namespace Coro
+{
+
+// Arena statistics
+struct ArenaStats {
+    uint32_t allocations;           //!< Frames allocated from the arena
+    uint32_t failures;              //!< Frames larger than a block, or with the arena exhausted
+    uint32_t in_use;                //!< Blocks currently allocated
+    uint32_t peak;                  //!< Maximum blocks allocated at once
+};
+
+// Fixed block allocator for coroutine frames
+// Blocks carry a header recording the owning arena, so frames are freed without knowing where
+// they were allocated. Frames from the heap have a null owner.
+class Arena
+{
+public:
+    void* allocate(size_t size) noexcept
+    {
+        if ((size > block_size - header_size) || (free_list == nullptr)) {
+            stats.failures ++;
+            return nullptr;
+        }
+
+        Block* block = free_list;
+        free_list = block->next;
+        block->owner = this;
+
+        stats.allocations ++;
+        stats.in_use ++;
+        if (stats.in_use > stats.peak) {
+            stats.peak = stats.in_use;
+        }
+
+        return (uint8_t*)block + header_size;
+    }
+
+    // Allocate a frame from the heap, with the same header layout
+    static void* allocate_heap(size_t size) noexcept
+    {
+        Block* block = (Block*) ::operator new(size + header_size, std::nothrow);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        block->owner = nullptr;
+        return (uint8_t*)block + header_size;
+    }
+
+    static void release(void* ptr) noexcept
+    {
+        Block* block = (Block*)((uint8_t*)ptr - header_size);
+        Arena* owner = block->owner;
+
+        if (owner == nullptr) {
+            ::operator delete(block);
+            return;
+        }
+
+        block->next = owner->free_list;
+        owner->free_list = block;
+        owner->stats.in_use --;
+    }
+
+    ArenaStats stats;
+
+protected:
+    Arena(uint8_t* storage, size_t block_size, size_t blocks) :
+        stats(), storage(storage), block_size(block_size), blocks(blocks), free_list(nullptr) {}
+
+    // Thread all blocks onto the free list
+    void reset()
+    {
+        free_list = nullptr;
+        for (size_t i = blocks; i > 0; i--) {
+            Block* block = (Block*)(storage + (i - 1) * block_size);
+            block->next = free_list;
+            free_list = block;
+        }
+    }
+
+private:
+    union Block {
+        Arena* owner;               //!< Owning arena while allocated
+        Block* next;                //!< Next free block
+    };
+
+    static constexpr size_t header_size = alignof(max_align_t);
+    static_assert(sizeof(Block) <= header_size, "Block header must fit in the frame alignment");
+
+    uint8_t* storage;
+    size_t block_size;
+    size_t blocks;
+    Block* free_list;
+};
+
+// Arena with inline storage for Blocks frames of up to BlockSize bytes (including a 16 byte header)
+template <size_t BlockSize, size_t Blocks>
+class StaticArena : public Arena
+{
+    static_assert((BlockSize % alignof(max_align_t)) == 0, "Block size must be a multiple of the frame alignment");
+
+public:
+    StaticArena() : Arena(storage, BlockSize, Blocks)
+    {
+        reset();
+    }
+
+    StaticArena(const StaticArena&) = delete;
+    StaticArena& operator=(const StaticArena&) = delete;
+
+private:
+    alignas(max_align_t) uint8_t storage[BlockSize * Blocks];
+};
+
+class Radio;
+
+// Coroutine returning an at86rf212_result_e (or application defined) int
+// Tasks start suspended, and run when awaited or started with start().
+class Task
+{
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        int result = 0;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() noexcept
+        {
+            return Task(Handle::from_promise(*this));
+        }
+        static Task get_return_object_on_allocation_failure() noexcept
+        {
+            return Task();
+        }
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+        FinalAwaiter final_suspend() const noexcept
+        {
+            return {};
+        }
+        void return_value(int value) noexcept
+        {
+            result = value;
+        }
+        void unhandled_exception() const noexcept
+        {
+            std::terminate();
+        }
+
+        // Frames of coroutines taking a Radio& first come from the radio arena
+        template <typename... Args>
+        static void* operator new(size_t size, Radio& radio, Args&...) noexcept;
+        static void* operator new(size_t size) noexcept
+        {
+            return Arena::allocate_heap(size);
+        }
+        static void operator delete(void* ptr, size_t) noexcept
+        {
+            Arena::release(ptr);
+        }
+    };
+
+    Task() : handle() {}
+    explicit Task(Handle handle) : handle(handle) {}
+    Task(Task&& other) noexcept : handle(other.handle)
+    {
+        other.handle = nullptr;
+    }
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            handle = other.handle;
+            other.handle = nullptr;
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        destroy();
+    }
+
+    // Frame allocation failed
+    bool valid() const
+    {
+        return (bool)handle;
+    }
+
+    // Run until the first suspension point
+    // Returns AT86RF212_ERROR_FULL if the frame could not be allocated
+    int start()
+    {
+        if (!handle) {
+            return AT86RF212_ERROR_FULL;
+        }
+        handle.resume();
+        return AT86RF212_RES_OK;
+    }
+
+    bool done() const
+    {
+        return !handle || handle.done();
+    }
+
+    // Value passed to co_return, AT86RF212_ERROR_FULL if the frame could not be allocated
+    int result() const
+    {
+        return handle ? handle.promise().result : AT86RF212_ERROR_FULL;
+    }
+
+    // Await completion from another coroutine
+    struct Awaiter {
+        Handle handle;
+
+        bool await_ready() const noexcept
+        {
+            return !handle || handle.done();
+        }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+        int await_resume() const noexcept
+        {
+            return handle ? handle.promise().result : AT86RF212_ERROR_FULL;
+        }
+    };
+    Awaiter operator co_await() const noexcept
+    {
+        return Awaiter{handle};
+    }
+
+private:
+    void destroy()
+    {
+        if (handle) {
+            handle.destroy();
+            handle = nullptr;
+        }
+    }
+
+    Handle handle;
+};
+
+// Radio operation, held in the frame of the awaiting coroutine while queued
+class Operation
+{
+public:
+    enum Type {
+        SEND,
+        RECEIVE,
+        ED_SCAN
+    };
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    bool await_suspend(std::coroutine_handle<> awaiting) noexcept;
+    int await_resume() const noexcept
+    {
+        return result;
+    }
+
+private:
+    friend class Radio;
+
+    Operation(Radio* radio, Type type) :
+        radio(radio), type(type), length(0), data(nullptr), out(nullptr), timeout(0), deadline(0),
+        result(AT86RF212_RES_OK), handle(), next(nullptr) {}
+
+    Radio* radio;
+    Type type;
+    uint8_t length;                 //!< Send length, or ED scan channel
+    uint8_t* data;                  //!< Frame to send, or receive buffer
+    uint8_t* out;                   //!< Received length, or ED level
+    uint32_t timeout;
+    uint32_t deadline;
+    int result;
+    std::coroutine_handle<> handle;
+    Operation* next;
+};
+
+// Radio statistics
+struct RadioStats {
+    uint32_t operations;            //!< Operations completed
+    uint32_t queued;                //!< Operations that waited behind another
+    uint32_t timeouts;              //!< Receive operations that timed out
+    uint32_t irqs;                  //!< on_irq calls
+};
+
+// Coroutine operation scheduler for one initialised device
+class Radio
+{
+public:
+    // Current time, read when a receive operation starts listening
+    typedef uint32_t (*Clock)(void* context);
+
+    Radio(struct at86rf212_s* device, Arena& arena, Clock clock, void* clock_context) :
+        stats(), device(device), frame_arena(arena), clock(clock), clock_context(clock_context),
+        current(nullptr), head(nullptr), tail(nullptr) {}
+
+    Radio(const Radio&) = delete;
+    Radio& operator=(const Radio&) = delete;
+
+    // Enable the interrupts used to resume operations
+    int init()
+    {
+        return at86rf212_set_irq_mask(device, AT86RF212_IRQ_3_TRX_END | AT86RF212_IRQ_4_CCA_ED_DONE);
+    }
+
+    // Transmit a frame (length excludes the CRC), resumes once transmission has completed
+    Operation send(uint8_t length, uint8_t* data)
+    {
+        Operation op(this, Operation::SEND);
+        op.length = length;
+        op.data = data;
+        return op;
+    }
+
+    // Receive a frame into data (as for at86rf212_get_rx)
+    // Resumes with AT86RF212_ERROR_TIMEOUT if no frame arrives within timeout of starting to listen
+    Operation receive(uint32_t timeout, uint8_t* length, uint8_t* data)
+    {
+        Operation op(this, Operation::RECEIVE);
+        op.timeout = timeout;
+        op.out = length;
+        op.data = data;
+        return op;
+    }
+
+    // Measure the energy level on a channel (PHY_ED_LEVEL)
+    Operation ed_scan(uint8_t channel, uint8_t* level)
+    {
+        Operation op(this, Operation::ED_SCAN);
+        op.length = channel;
+        op.out = level;
+        return op;
+    }
+
+    // Call when the IRQ line is asserted, resumes the coroutine awaiting the current operation
+    void on_irq()
+    {
+        uint8_t irq;
+
+        stats.irqs ++;
+
+        if (at86rf212_get_irq_status(device, &irq) < 0) {
+            if (current != nullptr) {
+                complete(AT86RF212_ERROR_DRIVER);
+            }
+            return;
+        }
+        if (current == nullptr) {
+            return;
+        }
+
+        switch (current->type) {
+        case Operation::SEND:
+            if ((irq & AT86RF212_IRQ_3_TRX_END) != 0) {
+                complete(AT86RF212_RES_OK);
+            }
+            break;
+        case Operation::RECEIVE:
+            if ((irq & AT86RF212_IRQ_3_TRX_END) != 0) {
+                complete(at86rf212_get_rx(device, current->out, current->data));
+            }
+            break;
+        case Operation::ED_SCAN:
+            if ((irq & AT86RF212_IRQ_4_CCA_ED_DONE) != 0) {
+                complete(at86rf212_read_reg(device, AT86RF212_REG_PHY_ED_LEVEL, current->out));
+            }
+            break;
+        }
+    }
+
+    // Call when the time returned by next_deadline passes
+    void on_timer(uint32_t time)
+    {
+        if ((current != nullptr) && (current->type == Operation::RECEIVE)
+            && ((int32_t)(time - current->deadline) >= 0)) {
+            stats.timeouts ++;
+            complete(AT86RF212_ERROR_TIMEOUT);
+        }
+    }
+
+    // Time at which on_timer must next be called, returns false if there is none
+    bool next_deadline(uint32_t* time) const
+    {
+        if ((current == nullptr) || (current->type != Operation::RECEIVE)) {
+            return false;
+        }
+        *time = current->deadline;
+        return true;
+    }
+
+    // Operation in progress or queued
+    bool busy() const
+    {
+        return current != nullptr;
+    }
+
+    struct at86rf212_s* c_device()
+    {
+        return device;
+    }
+
+    Arena& arena()
+    {
+        return frame_arena;
+    }
+
+    RadioStats stats;
+
+private:
+    friend class Operation;
+
+    // Queue an operation, returns false if it completed (failed) without suspending
+    bool submit(Operation* op)
+    {
+        if (current != nullptr) {
+            op->next = nullptr;
+            if (tail != nullptr) {
+                tail->next = op;
+            } else {
+                head = op;
+            }
+            tail = op;
+            stats.queued ++;
+            return true;
+        }
+
+        if (start(op)) {
+            current = op;
+            return true;
+        }
+        stats.operations ++;
+        return false;
+    }
+
+    // Start an operation on the radio, returns false with the result set on failure
+    bool start(Operation* op)
+    {
+        int res;
+
+        switch (op->type) {
+        case Operation::SEND:
+            res = at86rf212_start_tx(device, op->length, op->data);
+            break;
+        case Operation::RECEIVE:
+            res = at86rf212_start_rx(device);
+            op->deadline = clock(clock_context) + op->timeout;
+            break;
+        case Operation::ED_SCAN:
+            res = at86rf212_set_channel(device, op->length);
+            if (res >= 0) {
+                res = at86rf212_start_rx(device);
+            }
+            if (res >= 0) {
+                // Any write to PHY_ED_LEVEL in RX_ON starts a manual measurement
+                res = at86rf212_write_reg(device, AT86RF212_REG_PHY_ED_LEVEL, 0);
+            }
+            break;
+        default:
+            res = AT86RF212_ERROR_STATE;
+            break;
+        }
+
+        if (res < 0) {
+            op->result = res;
+            return false;
+        }
+        return true;
+    }
+
+    // Complete the current operation, start the next queued one and resume the awaiting coroutine
+    void complete(int res)
+    {
+        Operation* done = current;
+
+        done->result = (res < 0) ? res : AT86RF212_RES_OK;
+        current = nullptr;
+        stats.operations ++;
+
+        // Coroutines are only resumed once the queue is consistent, so operations they submit
+        // queue behind the ones already waiting
+        Operation* failed = advance();
+        done->handle.resume();
+        while (failed != nullptr) {
+            Operation* op = failed;
+            failed = op->next;
+            op->handle.resume();
+        }
+    }
+
+    // Start queued operations until one is running, returns the list of those that failed to start
+    Operation* advance()
+    {
+        Operation* failed = nullptr;
+        Operation** failed_tail = &failed;
+
+        while ((current == nullptr) && (head != nullptr)) {
+            Operation* op = head;
+            head = op->next;
+            if (head == nullptr) {
+                tail = nullptr;
+            }
+
+            if (start(op)) {
+                current = op;
+            } else {
+                stats.operations ++;
+                op->next = nullptr;
+                *failed_tail = op;
+                failed_tail = &op->next;
+            }
+        }
+
+        return failed;
+    }
+
+    struct at86rf212_s* device;
+    Arena& frame_arena;
+    Clock clock;
+    void* clock_context;
+    Operation* current;
+    Operation* head;
+    Operation* tail;
+};
+
+inline bool Operation::await_suspend(std::coroutine_handle<> awaiting) noexcept
+{
+    handle = awaiting;
+    return radio->submit(this);
+}
+
+template <typename... Args>
+inline void* Task::promise_type::operator new(size_t size, Radio& radio, Args&...) noexcept
+{
+    return radio.arena().allocate(size);
+}
+
+};
+
+};
@@ -0,0 +1,104 @@
+/*
+ * at86rf212 software CSMA-CA engine
+ * Host side channel access for basic mode transmission, with pluggable backoff policies.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_CSMA_H
+#define AT86RF212_CSMA_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AT86RF212_CSMA_DEFAULT_UNIT_BACKOFF_US  1000    //!< aUnitBackoffPeriod (20 symbols) at BPSK-20
+#define AT86RF212_CSMA_DEFAULT_PERSISTENCE      64      //!< Default p-persistent transmit probability (of 256)
+#define AT86RF212_CSMA_MAX_ASSESSMENTS          64      //!< Upper bound on CCAs per frame for persistent policies
+#define AT86RF212_CSMA_BUSY_RATIO_ONE           256     //!< Fixed point one for the busy ratio estimate
+
+// CSMA decision results
+enum at86rf212_csma_action_e {
+    AT86RF212_CSMA_TRANSMIT = 0,    //!< Channel acquired, transmit now
+    AT86RF212_CSMA_BACKOFF = 1,     //!< Wait for the returned number of unit backoff periods and reassess
+    AT86RF212_CSMA_FAIL = 2         //!< Channel access failure
+};
+
+struct at86rf212_csma_s;
+
+// Backoff policy object for passing in to the CSMA engine
+// Policies are handed 8 random bits per decision, from the device random pool or a simulated source
+struct at86rf212_csma_policy_s {
+    const char* name;               //!< Policy name for reporting
+    // Called at the start of each frame, returns the initial backoff in unit backoff periods
+    uint16_t (*begin)(struct at86rf212_csma_s *csma, uint8_t rnd);
+    // Called after each CCA, returns an at86rf212_csma_action_e and sets the next backoff
+    int (*decide)(struct at86rf212_csma_s *csma, uint8_t clear, uint8_t rnd, uint16_t *backoff);
+};
+
+// Standard 802.15.4 binary exponential backoff
+extern const struct at86rf212_csma_policy_s at86rf212_csma_policy_beb;
+// p-persistent, transmits on an idle slot with probability persistence / 256
+extern const struct at86rf212_csma_policy_s at86rf212_csma_policy_persistent;
+// Binary exponential backoff with the exponent driven by the observed channel busy ratio
+extern const struct at86rf212_csma_policy_s at86rf212_csma_policy_adaptive;
+
+// CSMA engine configuration
+struct at86rf212_csma_config_s {
+    const struct at86rf212_csma_policy_s *policy;   //!< Backoff policy
+    uint8_t min_be;                 //!< Minimum backoff exponent
+    uint8_t max_be;                 //!< Maximum backoff exponent (<= 8)
+    uint8_t max_backoffs;           //!< Maximum number of busy assessments before failure
+    uint8_t persistence;            //!< Transmit probability (of 256) for the p-persistent policy
+    uint16_t unit_backoff_us;       //!< Unit backoff period in microseconds (PHY mode dependent)
+};
+
+// CSMA engine statistics
+struct at86rf212_csma_stats_s {
+    uint32_t frames;                //!< Frames submitted
+    uint32_t sent;                  //!< Frames that acquired the channel
+    uint32_t failures;              //!< Frames dropped with a channel access failure
+    uint32_t assessments;           //!< CCA measurements performed
+    uint32_t busy;                  //!< CCA measurements reporting a busy channel
+    uint32_t backoff_periods;       //!< Total unit backoff periods waited
+};
+
+// CSMA engine instance
+struct at86rf212_csma_s {
+    struct at86rf212_s *device;             //!< Radio, may be NULL when driven by a simulation
+    struct at86rf212_csma_config_s config;  //!< Engine configuration
+    uint8_t nb;                             //!< Busy assessments for the current frame
+    uint8_t be;                             //!< Current backoff exponent
+    uint8_t assessments;                    //!< Assessments for the current frame
+    uint16_t busy_ratio;                    //!< EWMA of the CCA busy ratio, out of AT86RF212_CSMA_BUSY_RATIO_ONE
+    struct at86rf212_csma_stats_s stats;    //!< Engine statistics
+};
+
+// Fill a configuration with defaults matching the hardware CSMA settings applied in init
+void at86rf212_csma_default_config(struct at86rf212_csma_config_s *config);
+
+// Create a CSMA engine, config is copied
+int at86rf212_csma_init(struct at86rf212_csma_s *csma, struct at86rf212_s *device,
+                        const struct at86rf212_csma_config_s *config);
+
+// Decision core, independent of the radio so it can be driven by a simulated medium
+// Start a new frame, returns the initial backoff in unit backoff periods
+uint16_t at86rf212_csma_begin(struct at86rf212_csma_s *csma, uint8_t rnd);
+// Feed a CCA result, returns an at86rf212_csma_action_e and sets the next backoff
+int at86rf212_csma_step(struct at86rf212_csma_s *csma, uint8_t clear, uint8_t rnd, uint16_t *backoff);
+
+// Transmit a frame using the CSMA engine (blocking for the duration of channel access)
+// The frame is uploaded first and the radio waits in PLL_ON between assessments, moving to RX_ON
+// only for each CCA. Returns AT86RF212_ERROR_CHANNEL_ACCESS if the channel could not be acquired,
+// leaving the radio in PLL_ON.
+int at86rf212_csma_start_tx(struct at86rf212_csma_s *csma, uint8_t length, uint8_t* data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * at86rf212 duplicate frame suppression
+ * Bounded cache of recently received (source address, sequence number) pairs, optionally
+ * qualified by a hash of the frame length and leading PSDU bytes. Checked against the frame
+ * header before the payload is downloaded, so retransmitted and relayed duplicates are dropped
+ * for the cost of a short SRAM read.
+ *
+ * The cache is set associative with one 64 byte set per lookup, entries age out after a
+ * configurable lifetime and the oldest entry in a set is replaced on insertion.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_DEDUP_H
+#define AT86RF212_DEDUP_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+#include "at86rf212_mac.h"
+
+// The set count sizes the filter table, so is fixed for the library build (at86rf212_build.h)
+#if defined(AT86RF212_DEDUP_SETS) && !defined(AT86RF212_BUILD_H)
+#error "AT86RF212_DEDUP_SETS must be set in at86rf212_build.h"
+#endif
+#include "at86rf212_build.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (AT86RF212_DEDUP_SETS & (AT86RF212_DEDUP_SETS - 1)) != 0
+#error "AT86RF212_DEDUP_SETS must be a power of two"
+#endif
+
+#define AT86RF212_DEDUP_WAYS        4       //!< Entries per set (one 64 byte cache line)
+#define AT86RF212_DEDUP_FETCH_LEN   32      //!< PSDU bytes fetched for the header check and hash
+
+// Cache entry (16 bytes)
+struct at86rf212_dedup_entry_s {
+    uint64_t addr;                  //!< Source address, short addresses in the low 16 bits
+    uint32_t time;                  //!< Time the frame was first seen
+    uint16_t hash;                  //!< Frame hash (0 when hashing is disabled)
+    uint8_t seq;                    //!< MAC sequence number
+    uint8_t mode;                   //!< Source addressing mode (at86rf212_mac_addr_mode_e), 0 for an empty entry
+};
+
+// Duplicate filter statistics
+struct at86rf212_dedup_stats_s {
+    uint32_t lookups;               //!< Frames checked
+    uint32_t duplicates;            //!< Frames identified as duplicates
+    uint32_t untracked;             //!< Frames without a source address or sequence number (passed)
+    uint32_t evictions;             //!< Live entries replaced before their lifetime expired
+    uint32_t bytes_saved;           //!< Frame buffer download bytes avoided for duplicates
+};
+
+// Duplicate filter
+struct at86rf212_dedup_s {
+    struct at86rf212_dedup_entry_s sets[AT86RF212_DEDUP_SETS][AT86RF212_DEDUP_WAYS];
+    uint32_t lifetime;              //!< Entry lifetime, in the units of the times passed in
+    uint8_t use_hash;               //!< Qualify entries with a hash of the frame
+    struct at86rf212_dedup_stats_s stats;
+};
+
+// Initialise an empty filter
+// Lifetime should cover the longest retry / relay window, use_hash guards against sequence
+// number reuse within the lifetime.
+void at86rf212_dedup_init(struct at86rf212_dedup_s *dedup, uint32_t lifetime, uint8_t use_hash);
+
+// Check a (source, sequence number, hash) key, recording it if it has not been seen
+// Returns 1 for a duplicate, 0 otherwise
+int at86rf212_dedup_check(struct at86rf212_dedup_s *dedup, uint8_t mode, uint64_t addr,
+                          uint8_t seq, uint16_t hash, uint32_t now);
+
+// Check the header of a MAC frame (PSDU without the CRC field)
+// header must contain at least min(length, AT86RF212_DEDUP_FETCH_LEN) bytes.
+// Returns 1 for a duplicate, 0 otherwise (including frames that can not be tracked)
+int at86rf212_dedup_check_header(struct at86rf212_dedup_s *dedup, uint8_t length,
+                                 const uint8_t* header, uint32_t now);
+
+// Fetch a received frame unless it is a duplicate
+// Only the PHR and leading PSDU bytes are read for duplicates, returns AT86RF212_RES_REJECTED for these
+// Data buffer and length are as for at86rf212_get_rx
+int at86rf212_get_rx_dedup(struct at86rf212_s *device, struct at86rf212_dedup_s *dedup, uint32_t now,
+                           uint8_t* length, uint8_t* data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
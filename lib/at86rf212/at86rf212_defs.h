@@ -24,6 +24,15 @@ extern "C" {
 #define AT86RF212_LEN_FIELD_LEN      1      //!< Length of the PDSU length field
 #define AT86RF212_CRC_LEN            2      //!< Length of the CRC field
 #define AT86RF212_FRAME_RX_OVERHEAD  3      //!< Number of additional bytes read from frame buffer on RX
+#define AT86RF212_SRAM_SIZE          128    //!< Size of the frame buffer SRAM
+#define AT86RF212_SHR_LEN            5      //!< Length of the synchronisation header (preamble and SFD)
+#define AT86RF212_RX_BUFFER_LEN      (1 + AT86RF212_LEN_FIELD_LEN + AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD)  //!< Buffer for at86rf212_get_rx_frame (status, PHR, PSDU, LQI, ED, RX_STATUS)
+
+// RX_STATUS byte appended to frame buffer reads
+#define AT86RF212_RX_STATUS_CRC_VALID_MASK      0x80
+#define AT86RF212_RX_STATUS_CRC_VALID_SHIFT     7
+#define AT86RF212_RX_STATUS_TRAC_STATUS_MASK    0x70
+#define AT86RF212_RX_STATUS_TRAC_STATUS_SHIFT   4
 
 
 /** Enumerations */
@@ -101,6 +110,18 @@ enum at86rf212_oqpsk_data_rate_e {
     ATRF86212_OQPSK_DATA_RATE_0_NA_1_500K       = 3     //!< Data rate where SUB_MODE 0 NA, 1 500K
 };
 
+// PHY mode, TRX_CTRL_2 BPSK_OQPSK, SUB_MODE and OQPSK_DATA_RATE fields
+enum at86rf212_phy_mode_e {
+    AT86RF212_PHY_BPSK_20                   = 0x00, //!< BPSK 20 kb/s (868.3 MHz)
+    AT86RF212_PHY_BPSK_40                   = 0x04, //!< BPSK 40 kb/s (915 MHz)
+    AT86RF212_PHY_OQPSK_100                 = 0x08, //!< OQPSK 100 kb/s (868.3 MHz)
+    AT86RF212_PHY_OQPSK_200                 = 0x09, //!< OQPSK 200 kb/s (868.3 MHz, high data rate)
+    AT86RF212_PHY_OQPSK_400                 = 0x0A, //!< OQPSK 400 kb/s (868.3 MHz, high data rate)
+    AT86RF212_PHY_OQPSK_250                 = 0x0C, //!< OQPSK 250 kb/s (915 MHz)
+    AT86RF212_PHY_OQPSK_500                 = 0x0D, //!< OQPSK 500 kb/s (915 MHz, high data rate)
+    AT86RF212_PHY_OQPSK_1000                = 0x0E  //!< OQPSK 1000 kb/s (915 MHz, high data rate)
+};
+
 // IRQ flags
 enum at86rf212_irq_e {
     AT86RF212_IRQ_NONE                          = 0x00,
@@ -114,6 +135,14 @@ enum at86rf212_irq_e {
     AT86RF212_IRQ_7_BAT_LOW                     = 0x80,
 };
 
+// SPI status byte contents (TRX_CTRL_1.SPI_CMD_MODE)
+enum at86rf212_spi_cmd_mode_e {
+    AT86RF212_SPI_CMD_MODE_EMPTY                = 0x00,   //!< First byte of each transfer is 0x00
+    AT86RF212_SPI_CMD_MODE_TRX_STATUS           = 0x01,   //!< First byte of each transfer is TRX_STATUS
+    AT86RF212_SPI_CMD_MODE_PHY_RSSI             = 0x02,   //!< First byte of each transfer is PHY_RSSI
+    AT86RF212_SPI_CMD_MODE_IRQ_STATUS           = 0x03    //!< First byte of each transfer is IRQ_STATUS
+};
+
 enum at86rf212_clkm_rate_e {
     AT86RF212_CLKM_RATE_NONE                    = 0x00,
     AT86RF212_CLKM_RATE_1MHZ                    = 0x01,
@@ -132,18 +161,54 @@ enum at86rf212_clkm_rate_e {
 #define AT86RF212_DEFAULT_MINBE                 3
 #define AT86RF212_DEFAULT_MAXBE                 5
 #define AT86RF212_DEFAULT_MAX_CSMA_BACKOFFS     4
+#define AT86RF212_DEFAULT_MAX_FRAME_RETRIES     3
+#define AT86RF212_DEFAULT_TX_POWER              0x60    //!< PHY_TX_PWR reset value (GC_PA 3, TX_PWR 0)
+#define AT86RF212_DEFAULT_SPI_CMD_MODE          AT86RF212_SPI_CMD_MODE_PHY_RSSI
+#define AT86RF212_DEFAULT_PHY_MODE              AT86RF212_PHY_BPSK_40  //!< TRX_CTRL_2 power on value, so unconfigured nodes interoperate
+#define AT86RF212_EARLY_RX_CHUNK                8   //!< Minimum bytes per frame buffer read when streaming RX
 
 #define AT86RF212_PLL_LOCK_RETRIES              10
 #define AT86RF212_STATE_CHANGE_RETRIES          10
 
 
+// Random number pool statistics
+// Bits are harvested passively from the SPI status byte of every transfer made while
+// listening, and fetched explicitly by reading PHY_RSSI when the pool runs dry.
+struct at86rf212_random_stats_s {
+    uint32_t bits_harvested;            //!< Random bits collected from status bytes of existing transfers
+    uint32_t bits_fetched;              //!< Random bits collected by explicit PHY_RSSI reads
+    uint32_t bits_discarded;            //!< Random bits dropped because the pool was full
+    uint32_t bytes_served;              //!< Random bytes returned by at86rf212_get_random
+    uint32_t fetch_bus_bytes;           //!< SPI bytes spent on explicit fetches
+};
+
 // AT86RF212 object for internal library use
 struct at86rf212_s {
     int open;                           //!< Indicates whether the device is open
+#ifndef AT86RF212_STATIC_DRIVER
     struct at86rf212_driver_s* driver;  //!< Driver function object
     void* driver_ctx;                   //!< Driver context
+    int (*get_time_us)(void* context, uint32_t *time_us);   //!< Time source (optional, at86rf212_set_time_source)
+    void* time_ctx;                     //!< Time source context
+    int (*get_irq_fd)(void* context, int *fd);              //!< IRQ descriptor source (optional, at86rf212_set_irq_fd_source)
+    void* irq_fd_ctx;                   //!< IRQ descriptor source context
+#endif
+    uint8_t rx_on;                      //!< Indicates the receiver is on (random bits are valid)
+    uint8_t rx_on_requested;            //!< Receive state commanded, rx_on is set once TRX_STATUS confirms it
+    uint8_t csma_seeded;                //!< Indicates CSMA_SEED has been loaded from the random pool
+    uint8_t phy_mode;                   //!< Current PHY mode (at86rf212_phy_mode_e)
+    uint8_t rx_end_pending;             //!< TRX_END observed (and cleared) while checking for RX_START
+    uint32_t rx_end_time;               //!< Time TRX_END was observed (from the time source)
+    uint8_t rnd_bits;                   //!< Number of valid bits in the random pool
+    uint32_t rnd_pool;                  //!< Random bit pool
+    struct at86rf212_random_stats_s rnd_stats;  //!< Random pool statistics
 };
 
+// Receiver state and random pool tracking, shared with the statically bound C++ device
+void at86rf212_harvest_rnd(struct at86rf212_s *device, uint8_t phy_rssi, uint32_t *counter);
+void at86rf212_track_state(struct at86rf212_s *device, uint8_t state);
+void at86rf212_confirm_state(struct at86rf212_s *device, uint8_t status);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,289 @@
+/*
+ * at86rf212 statically bound c++ driver
+ * Device<Driver> calls the SPI and GPIO methods of a concrete driver class directly, so register
+ * and SRAM accesses compile down to the driver call with no function pointer or virtual dispatch.
+ * The remainder of the C core is available through c_device(), bound to the same driver object
+ * with one (non-virtual) indirect call per transfer.
+ *
+ * Driver must provide (DriverInterface subclasses qualify, and are called non-virtually when
+ * the concrete type is used as the template argument):
+ *   int spi_transfer(int len, uint8_t* data_out, uint8_t* data_in);
+ *   int set_sdn(uint8_t val);
+ *   int set_slp_tr(uint8_t val);
+ *   int get_irq(uint8_t* val);
+ * and optionally, for at86rf212_manager:
+ *   int get_irq_fd(int* fd);
+ *
+ * For runtime polymorphism use At86rf212 with a DriverInterface (at86rf212.hpp).
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "at86rf212.h"
+#include "at86rf212_defs.h"
+#include "at86rf212_regs.h"
+#include "at86rf212_regs.hpp"
+#include "at86rf212_frame.hpp"
+
+namespace AT86RF212
+{
+
+// Detects an optional get_irq_fd method on a driver class
+template <typename Driver>
+class HasIrqFd
+{
+    template <typename T> static char test(decltype(&T::get_irq_fd));
+    template <typename T> static long test(...);
+
+public:
+    static const bool value = (sizeof(test<Driver>(0)) == sizeof(char));
+};
+
+// C driver adaptor for a concrete driver class
+// Each Driver type gets its own at86rf212_driver_s, the driver object is passed as the context
+template <typename Driver>
+class DriverAdaptor
+{
+public:
+    static struct at86rf212_driver_s* GetDriver()
+    {
+        static struct at86rf212_driver_s driver = Create();
+        return &driver;
+    }
+
+    // Source for at86rf212_set_irq_fd_source, NULL if the driver class does not provide get_irq_fd
+    static fd_get_f GetIrqFdSource()
+    {
+        return irq_fd_hook(std::integral_constant<bool, HasIrqFd<Driver>::value>());
+    }
+
+private:
+    // Optional functions the driver class does not provide are left NULL
+    static struct at86rf212_driver_s Create()
+    {
+        struct at86rf212_driver_s driver = {};
+
+        driver.spi_transfer = spi_transfer;
+        driver.set_reset = set_sdn;
+        driver.set_slp_tr = set_slp_tr;
+        driver.get_irq = get_irq;
+        return driver;
+    }
+
+    static fd_get_f irq_fd_hook(std::true_type)
+    {
+        return get_irq_fd;
+    }
+    static fd_get_f irq_fd_hook(std::false_type)
+    {
+        return NULL;
+    }
+
+    static int spi_transfer(void* context, int len, uint8_t* data_out, uint8_t* data_in)
+    {
+        return static_cast<Driver*>(context)->spi_transfer(len, data_out, data_in);
+    }
+    static int set_sdn(void* context, uint8_t val)
+    {
+        return static_cast<Driver*>(context)->set_sdn(val);
+    }
+    static int set_slp_tr(void* context, uint8_t val)
+    {
+        return static_cast<Driver*>(context)->set_slp_tr(val);
+    }
+    static int get_irq(void* context, uint8_t* val)
+    {
+        return static_cast<Driver*>(context)->get_irq(val);
+    }
+    static int get_irq_fd(void* context, int* fd)
+    {
+        return static_cast<Driver*>(context)->get_irq_fd(fd);
+    }
+};
+
+template <typename Driver>
+class Device
+{
+public:
+    explicit Device(Driver* driver) : driver(driver), device() {}
+
+    // Initialise the device through the C core
+    int init()
+    {
+        int res = at86rf212_init(&(this->device), DriverAdaptor<Driver>::GetDriver(), (void*) this->driver);
+        if (res >= 0) {
+            at86rf212_set_irq_fd_source(&(this->device), DriverAdaptor<Driver>::GetIrqFdSource(), (void*) this->driver);
+        }
+        return res;
+    }
+
+    // Initialise the device with a configuration profile
+    int init(const struct at86rf212_config_s& config)
+    {
+        int res = at86rf212_init_config(&(this->device), DriverAdaptor<Driver>::GetDriver(), (void*) this->driver, &config);
+        if (res >= 0) {
+            at86rf212_set_irq_fd_source(&(this->device), DriverAdaptor<Driver>::GetIrqFdSource(), (void*) this->driver);
+        }
+        return res;
+    }
+
+    // Close device
+    int close()
+    {
+        return at86rf212_close(&(this->device));
+    }
+
+    // C device bound to this driver, for the rest of the at86rf212_* API
+    struct at86rf212_s* c_device()
+    {
+        return &(this->device);
+    }
+
+    int read_reg(uint8_t reg, uint8_t* val)
+    {
+        uint8_t data_out[2] = {(uint8_t)(reg | AT86RF212_REG_READ_FLAG), 0x00};
+        uint8_t data_in[2];
+
+        int res = this->driver->spi_transfer(2, data_out, data_in);
+        if (res >= 0) {
+            *val = data_in[1];
+            harvest_rnd(data_in[0]);
+        }
+        return res;
+    }
+
+    int write_reg(uint8_t reg, uint8_t val)
+    {
+        uint8_t data_out[2] = {(uint8_t)(reg | AT86RF212_REG_WRITE_FLAG), val};
+        uint8_t data_in[2];
+
+        int res = this->driver->spi_transfer(2, data_out, data_in);
+        if (res >= 0) {
+            harvest_rnd(data_in[0]);
+        }
+        return res;
+    }
+
+    int update_reg(uint8_t reg, uint8_t mask, uint8_t val)
+    {
+        uint8_t data = 0;
+
+        int res = read_reg(reg, &data);
+        if (res < 0) {
+            return res;
+        }
+        return write_reg(reg, (data & ~mask) | (mask & val));
+    }
+
+    // Apply a combined field update, whole register updates skip the read
+    template <uint8_t Reg>
+    int update(Regs::Update<Reg> u)
+    {
+        if (u.mask == 0xFF) {
+            return write_reg(Reg, u.value);
+        }
+        return update_reg(Reg, u.mask, u.value);
+    }
+
+    int read_sram(uint8_t addr, uint8_t length, uint8_t* data)
+    {
+        uint8_t data_out[AT86RF212_SRAM_SIZE + 2] = {AT86RF212_SRAM_READ_FLAG, addr};
+        uint8_t data_in[AT86RF212_SRAM_SIZE + 2];
+
+        if ((addr + length) > AT86RF212_SRAM_SIZE) {
+            return AT86RF212_ERROR_LEN;
+        }
+
+        int res = this->driver->spi_transfer(length + 2, data_out, data_in);
+        if (res >= 0) {
+            for (int i = 0; i < length; i++) {
+                data[i] = data_in[i + 2];
+            }
+            harvest_rnd(data_in[0]);
+        }
+        return res;
+    }
+
+    int write_sram(uint8_t addr, uint8_t length, const uint8_t* data)
+    {
+        uint8_t data_out[AT86RF212_SRAM_SIZE + 2] = {AT86RF212_SRAM_WRITE_FLAG, addr};
+        uint8_t data_in[AT86RF212_SRAM_SIZE + 2];
+
+        if ((addr + length) > AT86RF212_SRAM_SIZE) {
+            return AT86RF212_ERROR_LEN;
+        }
+
+        for (int i = 0; i < length; i++) {
+            data_out[i + 2] = data[i];
+        }
+        int res = this->driver->spi_transfer(length + 2, data_out, data_in);
+        if (res >= 0) {
+            harvest_rnd(data_in[0]);
+        }
+        return res;
+    }
+
+    // Receive into, or transmit and release, a pooled frame (at86rf212_frame.hpp)
+    int get_rx(Frame& frame, bool accept_bad_crc = false)
+    {
+        return AT86RF212::get_rx(&(this->device), frame, accept_bad_crc);
+    }
+    int start_tx(Frame&& frame)
+    {
+        return AT86RF212::start_tx(&(this->device), static_cast<Frame&&>(frame));
+    }
+
+    int set_state(uint8_t state)
+    {
+        at86rf212_track_state(&(this->device), state);
+        return update(Regs::TRX_STATE_TRX_CMD(state));
+    }
+
+    int get_state(uint8_t* state)
+    {
+        uint8_t state_int = 0;
+
+        int res = read_reg(AT86RF212_REG_TRX_STATE, &state_int);
+        *state = state_int & AT86RF212_TRX_STATUS_TRX_STATUS_MASK;
+        return res;
+    }
+
+    int get_irq_status(uint8_t* status)
+    {
+        return read_reg(AT86RF212_REG_IRQ_STATUS, status);
+    }
+
+    int get_irq(uint8_t* val)
+    {
+        return this->driver->get_irq(val);
+    }
+
+    // AT86RF212_DRIVER_INVALID unless Driver provides get_irq_fd
+    int get_irq_fd(int* fd)
+    {
+        return at86rf212_get_irq_fd(&(this->device), fd);
+    }
+
+    int set_slp_tr(uint8_t val)
+    {
+        return this->driver->set_slp_tr(val);
+    }
+
+private:
+    // The PHY_RSSI status byte of each transfer feeds the random pool while receiving, as in the C core
+    void harvest_rnd(uint8_t phy_rssi)
+    {
+        at86rf212_harvest_rnd(&(this->device), phy_rssi, &(this->device.rnd_stats.bits_harvested));
+    }
+
+    Driver* driver;
+    struct at86rf212_s device;
+};
+
+};
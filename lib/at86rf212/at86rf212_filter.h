@@ -0,0 +1,89 @@
+/*
+ * at86rf212 header-first receive filtering
+ * Fetches only the PHR and MAC header of a received frame, evaluates a compiled filter on those
+ * bytes, and only downloads frames that pass.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_FILTER_H
+#define AT86RF212_FILTER_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+#include "at86rf212_mac.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AT86RF212_FILTER_MAX_ADDRESSES  8       //!< Maximum number of source addresses in a filter
+#define AT86RF212_FILTER_MAX_MATCHES    8       //!< Maximum number of user byte mask/match conditions
+#define AT86RF212_FILTER_MAX_CONDS      (AT86RF212_FILTER_MAX_MATCHES + 5)
+#define AT86RF212_FILTER_MAX_HEADER     23      //!< Largest MAC header examined (FCF, seq, PANs, extended addresses)
+#define AT86RF212_FILTER_BROADCAST      0xFFFF  //!< Broadcast short address
+
+// Byte mask/match condition, offset is into the PSDU
+struct at86rf212_filter_match_s {
+    uint8_t offset;                 //!< PSDU offset
+    uint8_t mask;                   //!< Bits to compare
+    uint8_t value;                  //!< Expected value of the masked bits
+};
+
+// Filter specification, zeroed fields are not filtered on
+struct at86rf212_filter_spec_s {
+    uint8_t frame_types;            //!< Bitmap of accepted frame types (1 << at86rf212_frame_type_e), 0 for any
+    uint8_t match_dest_pan;         //!< Require the destination PAN ID to match dest_pan
+    uint16_t dest_pan;              //!< Destination PAN ID
+    uint8_t match_dest_addr;        //!< Require the destination short address to match dest_addr
+    uint16_t dest_addr;             //!< Destination short address
+    uint8_t accept_broadcast;       //!< Also accept the broadcast destination address
+    uint8_t num_sources;            //!< Number of accepted short source addresses, 0 for any
+    uint16_t sources[AT86RF212_FILTER_MAX_ADDRESSES];   //!< Accepted short source addresses
+    uint8_t num_matches;            //!< Number of user byte mask/match conditions
+    struct at86rf212_filter_match_s matches[AT86RF212_FILTER_MAX_MATCHES];  //!< User conditions
+};
+
+// Filter statistics
+struct at86rf212_filter_stats_s {
+    uint32_t frames;                //!< Frames evaluated
+    uint32_t accepted;              //!< Frames that passed the filter
+    uint32_t rejected;              //!< Frames rejected on the header
+    uint32_t bytes_fetched;         //!< Frame buffer bytes transferred (headers and accepted frames)
+};
+
+// Compiled filter
+// The spec is flattened into a table of masked byte comparisons at fixed offsets plus address
+// sets, so evaluation is a straight pass over the table accumulating mismatches.
+struct at86rf212_filter_s {
+    uint8_t header_len;             //!< PSDU bytes fetched for evaluation
+    uint8_t cond_len;               //!< Minimum PSDU length covering the fixed offset conditions
+    uint8_t type_map;               //!< Bitmap of accepted frame types
+    uint8_t num_conds;              //!< Number of entries in conds
+    struct at86rf212_filter_match_s conds[AT86RF212_FILTER_MAX_CONDS];
+    uint8_t num_dests;              //!< Number of entries in dests, 0 for any
+    uint16_t dests[2];              //!< Accepted destination short addresses
+    uint8_t num_sources;            //!< Number of entries in sources, 0 for any
+    uint16_t sources[AT86RF212_FILTER_MAX_ADDRESSES];
+    struct at86rf212_filter_stats_s stats;  //!< Filter statistics
+};
+
+// Compile a filter specification
+int at86rf212_filter_compile(struct at86rf212_filter_s *filter, const struct at86rf212_filter_spec_s *spec);
+
+// Evaluate a compiled filter against a PSDU header
+// Returns 1 if the frame should be accepted, 0 otherwise
+int at86rf212_filter_match(const struct at86rf212_filter_s *filter, uint8_t frame_len, const uint8_t *header);
+
+// Fetch a received frame if it passes the filter
+// Only the PHR and header bytes are read for rejected frames, returns AT86RF212_RES_REJECTED for these
+// Data buffer and length are as for at86rf212_get_rx
+int at86rf212_get_rx_filtered(struct at86rf212_s *device, struct at86rf212_filter_s *filter,
+                              uint8_t* length, uint8_t* data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,346 @@
+/*
+ * at86rf212 pooled frame type
+ * Frame is a move-only handle to a fixed capacity frame buffer taken from a FramePool. The buffer
+ * layout is the SPI transfer layout used by at86rf212_get_rx_frame and at86rf212_start_tx_buffer,
+ * so frames are received into and transmitted from the pooled buffer without copying, and
+ * ownership passes between layers (and threads) by moving the handle.
+ *
+ * Pools are lock free (a tagged index stack), so frames may be acquired and released from any
+ * thread, including the release performed when a Frame is destroyed.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+
+#include "at86rf212.h"
+#include "at86rf212_defs.h"
+#include "at86rf212_mac.h"
+
+namespace AT86RF212
+{
+
+// Non-owning view of a contiguous range
+template <typename T>
+class Span
+{
+public:
+    Span() : ptr(nullptr), len(0) {}
+    Span(T* ptr, size_t len) : ptr(ptr), len(len) {}
+
+    T* data() const
+    {
+        return ptr;
+    }
+    size_t size() const
+    {
+        return len;
+    }
+    bool empty() const
+    {
+        return len == 0;
+    }
+    T* begin() const
+    {
+        return ptr;
+    }
+    T* end() const
+    {
+        return ptr + len;
+    }
+    T& operator[](size_t i) const
+    {
+        return ptr[i];
+    }
+
+private:
+    T* ptr;
+    size_t len;
+};
+
+// Pooled frame storage
+struct FrameBuffer {
+    uint8_t raw[AT86RF212_RX_BUFFER_LEN];   //!< SPI status / command, PHR, PSDU, LQI, ED, RX_STATUS
+    struct at86rf212_rx_frame_s rx;         //!< Metadata of a received frame
+    uint8_t length;                         //!< MAC frame length, excluding the CRC field
+    uint8_t header_len;                     //!< MAC header length, FRAME_HEADER_UNKNOWN until parsed or set
+};
+
+#define AT86RF212_FRAME_PSDU_OFFSET     (1 + AT86RF212_LEN_FIELD_LEN)
+#define AT86RF212_FRAME_HEADER_UNKNOWN  0xFF
+
+class FramePoolBase;
+
+class Frame
+{
+public:
+    enum {
+        capacity = AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN     //!< Maximum MAC frame length
+    };
+
+    Frame() noexcept : pool(nullptr), buffer(nullptr) {}
+    // Moves are noexcept so containers move rather than copy (copying is deleted) when growing
+    Frame(Frame&& other) noexcept : pool(other.pool), buffer(other.buffer)
+    {
+        other.pool = nullptr;
+        other.buffer = nullptr;
+    }
+    Frame& operator=(Frame&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            pool = other.pool;
+            buffer = other.buffer;
+            other.pool = nullptr;
+            other.buffer = nullptr;
+        }
+        return *this;
+    }
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+    ~Frame()
+    {
+        release();
+    }
+
+    // Frame holds a buffer (acquisition from an exhausted pool returns an empty frame)
+    bool valid() const
+    {
+        return buffer != nullptr;
+    }
+    explicit operator bool() const
+    {
+        return valid();
+    }
+
+    // MAC frame (PSDU without the CRC field)
+    uint8_t* data()
+    {
+        return buffer->raw + AT86RF212_FRAME_PSDU_OFFSET;
+    }
+    const uint8_t* data() const
+    {
+        return buffer->raw + AT86RF212_FRAME_PSDU_OFFSET;
+    }
+    uint8_t length() const
+    {
+        return buffer->length;
+    }
+    // Set the MAC frame length, returns false if it exceeds capacity
+    bool resize(uint8_t length)
+    {
+        if (length > capacity) {
+            return false;
+        }
+        buffer->length = length;
+        buffer->header_len = AT86RF212_FRAME_HEADER_UNKNOWN;
+        return true;
+    }
+    Span<uint8_t> bytes()
+    {
+        return Span<uint8_t>(data(), buffer->length);
+    }
+
+    // MAC header, parsed on first use unless set by the frame builder
+    // Empty for frames that do not parse.
+    Span<uint8_t> header()
+    {
+        return Span<uint8_t>(data(), header_length());
+    }
+    // Bytes following the MAC header (including any payload IEs and MIC)
+    Span<uint8_t> payload()
+    {
+        uint8_t header_len = header_length();
+        return Span<uint8_t>(data() + header_len, buffer->length - header_len);
+    }
+    void set_header_length(uint8_t length)
+    {
+        buffer->header_len = length;
+    }
+
+    // Metadata of a received frame
+    uint8_t lqi() const
+    {
+        return buffer->rx.lqi;
+    }
+    uint8_t ed() const
+    {
+        return buffer->rx.ed;
+    }
+    bool crc_valid() const
+    {
+        return buffer->rx.crc_valid != 0;
+    }
+    uint32_t timestamp() const
+    {
+        return buffer->rx.timestamp;
+    }
+
+    // Underlying buffer, for use with the C API
+    FrameBuffer* raw()
+    {
+        return buffer;
+    }
+
+private:
+    friend class FramePoolBase;
+
+    Frame(FramePoolBase* pool, FrameBuffer* buffer) : pool(pool), buffer(buffer)
+    {
+        buffer->length = 0;
+        buffer->header_len = AT86RF212_FRAME_HEADER_UNKNOWN;
+    }
+
+    uint8_t header_length()
+    {
+        if (buffer->header_len == AT86RF212_FRAME_HEADER_UNKNOWN) {
+            struct at86rf212_mac_frame_s mac;
+            int res = at86rf212_mac_parse(&mac, buffer->length, data());
+            buffer->header_len = (res < 0) ? 0 : mac.header_len;
+        }
+        return buffer->header_len;
+    }
+
+    inline void release() noexcept;
+
+    FramePoolBase* pool;
+    FrameBuffer* buffer;
+};
+
+// Lock free pool of frame buffers
+// The free list head packs a 16 bit index with a 16 bit modification tag, so a pop racing with a
+// pop and push of the same buffer fails its compare and swap rather than corrupting the list.
+class FramePoolBase
+{
+public:
+    enum {
+        empty = 0xFFFF                      //!< Free list terminator
+    };
+
+    // Take a frame from the pool, returns an empty (invalid) frame if none are available
+    Frame acquire()
+    {
+        uint32_t old_head = head.load(std::memory_order_acquire);
+
+        while (true) {
+            uint16_t index = old_head & 0xFFFF;
+            if (index == empty) {
+                exhausted.fetch_add(1, std::memory_order_relaxed);
+                return Frame();
+            }
+            uint32_t new_head = ((old_head + 0x10000) & 0xFFFF0000) | links[index].load(std::memory_order_relaxed);
+            if (head.compare_exchange_weak(old_head, new_head, std::memory_order_acquire, std::memory_order_acquire)) {
+                return Frame(this, &buffers[index]);
+            }
+        }
+    }
+
+    // Number of failed acquisitions
+    uint32_t exhausted_count() const
+    {
+        return exhausted.load(std::memory_order_relaxed);
+    }
+
+    uint16_t size() const
+    {
+        return count;
+    }
+
+protected:
+    FramePoolBase(FrameBuffer* buffers, std::atomic<uint16_t>* links, uint16_t count) :
+        head(empty), exhausted(0), buffers(buffers), links(links), count(count) {}
+
+    // Place every buffer on the free list, must not be called with frames outstanding
+    void reset()
+    {
+        for (uint16_t i = 0; i < count; i++) {
+            links[i].store((i + 1 < count) ? i + 1 : empty, std::memory_order_relaxed);
+        }
+        head.store((count > 0) ? 0 : empty, std::memory_order_release);
+    }
+
+private:
+    friend class Frame;
+
+    void release(FrameBuffer* buffer) noexcept
+    {
+        uint16_t index = buffer - buffers;
+        uint32_t old_head = head.load(std::memory_order_relaxed);
+        uint32_t new_head;
+
+        do {
+            links[index].store(old_head & 0xFFFF, std::memory_order_relaxed);
+            new_head = ((old_head + 0x10000) & 0xFFFF0000) | index;
+        } while (!head.compare_exchange_weak(old_head, new_head, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> exhausted;
+    FrameBuffer* buffers;
+    std::atomic<uint16_t>* links;
+    uint16_t count;
+};
+
+// Pool of Count frame buffers, typically one per device
+template <uint16_t Count>
+class FramePool : public FramePoolBase
+{
+    static_assert(Count < (uint16_t)FramePoolBase::empty, "Frame pool too large");
+
+public:
+    FramePool() : FramePoolBase(buffers, links, Count)
+    {
+        reset();
+    }
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+private:
+    FrameBuffer buffers[Count];
+    std::atomic<uint16_t> links[Count];
+};
+
+inline void Frame::release() noexcept
+{
+    if (buffer != nullptr) {
+        pool->release(buffer);
+        pool = nullptr;
+        buffer = nullptr;
+    }
+}
+
+// Receive a frame into a pooled buffer, see at86rf212_get_rx_frame
+inline int get_rx(struct at86rf212_s* device, Frame& frame, bool accept_bad_crc = false)
+{
+    if (!frame) {
+        return AT86RF212_ERROR_FULL;
+    }
+
+    FrameBuffer* buffer = frame.raw();
+    int res = at86rf212_get_rx_frame(device, &buffer->rx, buffer->raw, accept_bad_crc ? 1 : 0);
+    if (res < 0) {
+        return res;
+    }
+
+    frame.resize((buffer->rx.length > AT86RF212_CRC_LEN) ? buffer->rx.length - AT86RF212_CRC_LEN : 0);
+    return res;
+}
+
+// Transmit a frame from its pooled buffer, the frame is released once uploaded
+inline int start_tx(struct at86rf212_s* device, Frame&& frame)
+{
+    Frame sending(static_cast<Frame&&>(frame));
+
+    if (!sending) {
+        return AT86RF212_ERROR_FULL;
+    }
+    return at86rf212_start_tx_buffer(device, sending.length(), sending.raw()->raw);
+}
+
+};
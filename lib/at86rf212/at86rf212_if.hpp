@@ -20,53 +20,71 @@ public:
     virtual int set_sdn(uint8_t val) = 0;
     virtual int set_slp_tr(uint8_t val) = 0;
     virtual int get_irq(uint8_t *val) = 0;
+    // Optional, a file descriptor readable while an IRQ is signalled (see at86rf212_manager.h)
+    virtual int get_irq_fd(int *fd)
+    {
+        (void)fd;
+        return AT86RF212_DRIVER_INVALID;
+    }
 };
 
 // Adaptor functions, allows c++ object to be called from c(ish) context
-int at86rf212_transfer_data_adaptor(void* context, int len, uint8_t* data_out, uint8_t* data_in)
+// Inline so the header can be included from multiple translation units
+inline int at86rf212_transfer_data_adaptor(void* context, int len, uint8_t* data_out, uint8_t* data_in)
 {
     AT86RF212::DriverInterface *driver = (AT86RF212::DriverInterface*) context;
     return driver->spi_transfer(len, data_out, data_in);
 }
 
-int at86rf212_set_sdn_adaptor(void* context, uint8_t val)
+inline int at86rf212_set_sdn_adaptor(void* context, uint8_t val)
 {
     AT86RF212::DriverInterface *driver = (AT86RF212::DriverInterface*) context;
     return driver->set_sdn(val);
 }
 
-int at86rf212_set_slp_tr_adaptor(void* context, uint8_t val)
+inline int at86rf212_set_slp_tr_adaptor(void* context, uint8_t val)
 {
     AT86RF212::DriverInterface *driver = (AT86RF212::DriverInterface*) context;
     return driver->set_slp_tr(val);
 }
 
-int at86rf212_get_irq_adaptor(void* context, uint8_t* val)
+inline int at86rf212_get_irq_adaptor(void* context, uint8_t* val)
 {
     AT86RF212::DriverInterface *driver = (AT86RF212::DriverInterface*) context;
     return driver->get_irq(val);
 }
 
+inline int at86rf212_get_irq_fd_adaptor(void* context, int* fd)
+{
+    AT86RF212::DriverInterface *driver = (AT86RF212::DriverInterface*) context;
+    return driver->get_irq_fd(fd);
+}
+
 // SPI Driver wrapper object
 // Adapts C++ driver object for use in C based library
 // Note that this can be static as driver context is passed separately to the driver
+// For statically dispatched drivers see AT86RF212::Device (at86rf212_device.hpp)
 class DriverWrapper
 {
 public:
     static struct at86rf212_driver_s* GetWrapper()
     {
+        static struct at86rf212_driver_s driver = Create();
         return &driver;
     }
 
 private:
-    static struct at86rf212_driver_s driver;
-};
+    // Optional hooks not provided by DriverInterface are left NULL
+    static struct at86rf212_driver_s Create()
+    {
+        struct at86rf212_driver_s driver = {};
 
-struct at86rf212_driver_s DriverWrapper::driver = {
-    at86rf212_transfer_data_adaptor,
-    at86rf212_set_sdn_adaptor,
-    at86rf212_set_slp_tr_adaptor,
-    at86rf212_get_irq_adaptor
+        driver.spi_transfer = at86rf212_transfer_data_adaptor;
+        driver.set_reset = at86rf212_set_sdn_adaptor;
+        driver.set_slp_tr = at86rf212_set_slp_tr_adaptor;
+        driver.get_irq = at86rf212_get_irq_adaptor;
+        return driver;
+    }
 };
 
 
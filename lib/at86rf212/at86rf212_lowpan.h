@@ -0,0 +1,140 @@
+/*
+ * at86rf212 6LoWPAN adaptation layer
+ * IPv6 over IEEE 802.15.4 (RFC 4944) with IPHC and NHC-UDP header compression (RFC 6282).
+ * Packets are compressed once and fragmented on the fly straight into the caller's frame
+ * buffer, received fragments are reassembled into a fixed pool of preallocated buffers.
+ *
+ * Link layer addresses use the MAC codec addressing modes, with short addresses in the low
+ * 16 bits of the address.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_LOWPAN_H
+#define AT86RF212_LOWPAN_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+#include "at86rf212_mac.h"
+
+// Reassembly slots are held in the adaptation layer state, so their count is fixed for the library build (at86rf212_build.h)
+#if defined(AT86RF212_LOWPAN_REASM_SLOTS) && !defined(AT86RF212_BUILD_H)
+#error "AT86RF212_LOWPAN_REASM_SLOTS must be set in at86rf212_build.h"
+#endif
+#include "at86rf212_build.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AT86RF212_LOWPAN_MTU            1280    //!< IPv6 minimum MTU, largest packet handled
+#define AT86RF212_LOWPAN_IPV6_HEADER    40
+#define AT86RF212_LOWPAN_UDP_HEADER     8
+#define AT86RF212_LOWPAN_FRAG1_LEN      4       //!< FRAG1 header length
+#define AT86RF212_LOWPAN_FRAGN_LEN      5       //!< FRAGN header length
+#define AT86RF212_LOWPAN_MAX_IPHC       (2 + 4 + 1 + 1 + 16 + 16 + 7)   //!< Largest compressed header
+
+// Dispatch values
+#define AT86RF212_LOWPAN_DISPATCH_IPV6  0x41    //!< Uncompressed IPv6
+#define AT86RF212_LOWPAN_DISPATCH_IPHC  0x60    //!< 011xxxxx
+#define AT86RF212_LOWPAN_DISPATCH_FRAG1 0xC0    //!< 11000xxx
+#define AT86RF212_LOWPAN_DISPATCH_FRAGN 0xE0    //!< 11100xxx
+
+// Link layer address
+struct at86rf212_lowpan_ll_s {
+    uint8_t mode;                   //!< Addressing mode (at86rf212_mac_addr_mode_e)
+    uint64_t addr;                  //!< Address, short addresses in the low 16 bits
+};
+
+// Configuration
+struct at86rf212_lowpan_config_s {
+    uint32_t reasm_timeout_us;      //!< Reassembly timeout
+    uint8_t context_valid;          //!< Context 0 prefix is configured
+    uint8_t context[8];             //!< Context 0 (/64 prefix) for stateful address compression
+};
+
+// Statistics
+struct at86rf212_lowpan_stats_s {
+    uint32_t packets_tx;            //!< Packets sent
+    uint32_t fragments_tx;          //!< Fragmented frames sent
+    uint32_t packets_rx;            //!< Packets delivered
+    uint32_t fragments_rx;          //!< Fragments received
+    uint32_t duplicates;            //!< Fragments already received
+    uint32_t timeouts;              //!< Reassemblies discarded on timeout
+    uint32_t dropped;               //!< Frames dropped (malformed or no reassembly buffer)
+    uint32_t reasm_bytes;           //!< Reassembly buffer bytes currently reserved
+    uint32_t reasm_high_water;      //!< Largest value of reasm_bytes observed
+};
+
+// Reassembly buffer
+struct at86rf212_lowpan_reasm_s {
+    uint8_t state;                  //!< Free, active or complete
+    struct at86rf212_lowpan_ll_s src;
+    struct at86rf212_lowpan_ll_s dst;
+    uint16_t tag;                   //!< Datagram tag
+    uint16_t size;                  //!< Datagram size
+    uint16_t received;              //!< Bytes received
+    uint32_t start_time;            //!< Time the first fragment arrived
+    uint32_t map[(AT86RF212_LOWPAN_MTU / 8 + 31) / 32];   //!< Received 8 byte units
+    uint8_t buffer[AT86RF212_LOWPAN_MTU];
+};
+
+// 6LoWPAN instance
+struct at86rf212_lowpan_s {
+    struct at86rf212_lowpan_config_s config;
+    uint16_t tag;                   //!< Next datagram tag
+    struct at86rf212_lowpan_reasm_s reasm[AT86RF212_LOWPAN_REASM_SLOTS];
+    struct at86rf212_lowpan_stats_s stats;
+};
+
+// Outgoing packet, the packet buffer must remain valid until sent
+struct at86rf212_lowpan_tx_s {
+    const uint8_t* packet;
+    uint16_t length;                //!< Packet (datagram) length
+    uint16_t offset;                //!< Uncompressed offset of the next byte to send
+    uint16_t consumed;              //!< Uncompressed header bytes covered by the compressed header
+    uint16_t tag;
+    uint8_t header_len;
+    uint8_t header[AT86RF212_LOWPAN_MAX_IPHC];  //!< Compressed header
+};
+
+// Load the default configuration
+void at86rf212_lowpan_default_config(struct at86rf212_lowpan_config_s *config);
+
+// Initialise a 6LoWPAN instance
+int at86rf212_lowpan_init(struct at86rf212_lowpan_s *lowpan, const struct at86rf212_lowpan_config_s *config);
+
+// Start sending an IPv6 packet, compressing its header against the link layer addresses
+// Returns AT86RF212_RES_OK or AT86RF212_ERROR_LEN for oversized or malformed packets.
+int at86rf212_lowpan_tx_start(struct at86rf212_lowpan_s *lowpan, struct at86rf212_lowpan_tx_s *tx,
+                              const struct at86rf212_lowpan_ll_s *src, const struct at86rf212_lowpan_ll_s *dst,
+                              uint16_t length, const uint8_t* packet);
+
+// Write the next frame payload (after the MAC header) into a frame buffer with max_length bytes free
+// Returns the number of bytes written, 0 once the packet has been sent, or AT86RF212_ERROR_LEN if
+// max_length is too small to make progress.
+int at86rf212_lowpan_tx_next(struct at86rf212_lowpan_s *lowpan, struct at86rf212_lowpan_tx_s *tx,
+                             uint8_t max_length, uint8_t* data);
+
+// Process a received frame payload
+// Returns AT86RF212_RES_DONE with a complete packet, which remains valid until the next call to
+// at86rf212_lowpan_input, AT86RF212_RES_OK if a fragment was absorbed, AT86RF212_RES_REJECTED
+// for non 6LoWPAN payloads, AT86RF212_ERROR_LEN for malformed payloads and AT86RF212_ERROR_FULL
+// if no reassembly buffer is available.
+int at86rf212_lowpan_input(struct at86rf212_lowpan_s *lowpan, uint32_t now_us,
+                           const struct at86rf212_lowpan_ll_s *src, const struct at86rf212_lowpan_ll_s *dst,
+                           uint8_t length, const uint8_t* data,
+                           uint16_t* packet_length, const uint8_t** packet);
+
+// Discard reassemblies that have timed out
+void at86rf212_lowpan_poll(struct at86rf212_lowpan_s *lowpan, uint32_t now_us);
+
+// Load a link layer address from a parsed MAC frame address view
+void at86rf212_lowpan_ll_addr(uint8_t mode, const uint8_t* addr, struct at86rf212_lowpan_ll_s *ll);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * at86rf212 IEEE 802.15.4 MAC frame codec
+ * Parses received frames in place into views over the receive buffer, and builds frame headers
+ * directly into the transmit buffer. Supports all addressing modes, PAN ID compression for
+ * 2003/2006 and 2015 frames, the auxiliary security header and header/payload IEs.
+ *
+ * Lengths passed to the codec are MAC frame lengths excluding the FCS, which is appended by the
+ * radio on transmit.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_MAC_H
+#define AT86RF212_MAC_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// IEEE 802.15.4 frame types
+enum at86rf212_frame_type_e {
+    AT86RF212_FRAME_TYPE_BEACON     = 0,    //!< Beacon frame
+    AT86RF212_FRAME_TYPE_DATA       = 1,    //!< Data frame
+    AT86RF212_FRAME_TYPE_ACK        = 2,    //!< Acknowledgement frame
+    AT86RF212_FRAME_TYPE_MAC_CMD    = 3     //!< MAC command frame
+};
+
+// Addressing modes
+enum at86rf212_mac_addr_mode_e {
+    AT86RF212_MAC_ADDR_NONE         = 0,    //!< Address not present
+    AT86RF212_MAC_ADDR_SHORT        = 2,    //!< 16 bit short address
+    AT86RF212_MAC_ADDR_EXTENDED     = 3     //!< 64 bit extended address
+};
+
+// Frame versions
+enum at86rf212_mac_version_e {
+    AT86RF212_MAC_VERSION_2003      = 0,
+    AT86RF212_MAC_VERSION_2006      = 1,
+    AT86RF212_MAC_VERSION_2015      = 2
+};
+
+// Frame control field
+#define AT86RF212_MAC_FCF_TYPE_MASK         0x0007
+#define AT86RF212_MAC_FCF_SECURITY          0x0008  //!< Security enabled
+#define AT86RF212_MAC_FCF_PENDING           0x0010  //!< Frame pending
+#define AT86RF212_MAC_FCF_ACK_REQ           0x0020  //!< Acknowledgement request
+#define AT86RF212_MAC_FCF_PAN_COMP          0x0040  //!< PAN ID compression
+#define AT86RF212_MAC_FCF_SEQ_SUPPRESS      0x0100  //!< Sequence number suppression (2015)
+#define AT86RF212_MAC_FCF_IE_PRESENT        0x0200  //!< Information elements present (2015)
+#define AT86RF212_MAC_FCF_DST_MODE_SHIFT    10
+#define AT86RF212_MAC_FCF_VERSION_SHIFT     12
+#define AT86RF212_MAC_FCF_SRC_MODE_SHIFT    14
+
+// Auxiliary security header control field
+#define AT86RF212_MAC_SEC_LEVEL_MASK        0x07
+#define AT86RF212_MAC_SEC_KEY_MODE_MASK     0x18
+#define AT86RF212_MAC_SEC_KEY_MODE_SHIFT    3
+#define AT86RF212_MAC_SEC_FC_SUPPRESS       0x20    //!< Frame counter suppression (2015)
+#define AT86RF212_MAC_SEC_ASN_NONCE         0x40    //!< ASN in nonce (2015)
+
+// Information element descriptors
+#define AT86RF212_MAC_IE_DESC_LEN           2
+#define AT86RF212_MAC_IE_TYPE_PAYLOAD       0x8000
+#define AT86RF212_MAC_HIE_LEN_MASK          0x007F
+#define AT86RF212_MAC_HIE_ID_SHIFT          7
+#define AT86RF212_MAC_PIE_LEN_MASK          0x07FF
+#define AT86RF212_MAC_PIE_GROUP_SHIFT       11
+#define AT86RF212_MAC_HIE_TERM_PAYLOAD      0x7E    //!< Header termination 1, payload IEs follow
+#define AT86RF212_MAC_HIE_TERM_NO_PAYLOAD   0x7F    //!< Header termination 2, payload follows
+#define AT86RF212_MAC_PIE_TERM              0x0F    //!< Payload IE termination group
+
+#define AT86RF212_MAC_MAX_FRAME             (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN)
+#define AT86RF212_MAC_SHORT_ADDR_LEN        2
+#define AT86RF212_MAC_EXT_ADDR_LEN          8
+#define AT86RF212_MAC_BROADCAST             0xFFFF
+
+// Auxiliary security header
+struct at86rf212_mac_security_s {
+    uint8_t level;                  //!< Security level
+    uint8_t key_id_mode;            //!< Key identifier mode
+    uint8_t fc_suppress;            //!< Frame counter not present (2015 only)
+    uint8_t asn_nonce;              //!< ASN used in the nonce
+    uint32_t frame_counter;
+    uint8_t key_source[8];          //!< Key source (0, 4 or 8 bytes by key identifier mode)
+    uint8_t key_index;
+};
+
+// Parsed frame, pointers reference the buffer the frame was parsed from
+struct at86rf212_mac_frame_s {
+    uint16_t fcf;                   //!< Frame control field
+    uint8_t type;                   //!< Frame type (at86rf212_frame_type_e)
+    uint8_t version;                //!< Frame version (at86rf212_mac_version_e)
+    uint8_t seq_present;
+    uint8_t seq;
+    uint8_t dest_mode;              //!< Destination addressing mode (at86rf212_mac_addr_mode_e)
+    uint8_t dest_pan_present;
+    uint16_t dest_pan;
+    const uint8_t* dest_addr;       //!< Destination address (little endian), NULL if not present
+    uint8_t src_mode;               //!< Source addressing mode (at86rf212_mac_addr_mode_e)
+    uint8_t src_pan_present;
+    uint16_t src_pan;               //!< Source PAN, set to the destination PAN when compressed
+    const uint8_t* src_addr;        //!< Source address (little endian), NULL if not present
+    const uint8_t* security;        //!< Auxiliary security header, NULL if not present
+    uint8_t security_len;
+    uint8_t mic_len;                //!< MIC length at the end of the payload
+    const uint8_t* header_ies;      //!< Header IEs, including any termination
+    uint8_t header_ies_len;
+    const uint8_t* payload_ies;     //!< Payload IEs (unsecured frames only)
+    uint8_t payload_ies_len;
+    uint8_t header_len;             //!< Length of the MAC header (up to the payload IEs)
+    const uint8_t* payload;         //!< MAC payload, excluding payload IEs and MIC
+    uint8_t payload_len;
+};
+
+// Frame header description for building frames
+struct at86rf212_mac_header_s {
+    uint8_t type;                   //!< Frame type (at86rf212_frame_type_e)
+    uint8_t version;                //!< Frame version (at86rf212_mac_version_e)
+    uint8_t pending;                //!< Frame pending
+    uint8_t ack_req;                //!< Acknowledgement request
+    uint8_t pan_comp;               //!< PAN ID compression
+    uint8_t seq_suppress;           //!< Sequence number suppression (2015 only)
+    uint8_t seq;
+    uint8_t dest_mode;              //!< Destination addressing mode (at86rf212_mac_addr_mode_e)
+    uint16_t dest_pan;
+    uint64_t dest_addr;             //!< Destination address, short addresses in the low 16 bits
+    uint8_t src_mode;               //!< Source addressing mode (at86rf212_mac_addr_mode_e)
+    uint16_t src_pan;
+    uint64_t src_addr;              //!< Source address, short addresses in the low 16 bits
+    uint8_t security_enabled;
+    struct at86rf212_mac_security_s security;
+    const uint8_t* header_ies;      //!< Encoded header IEs (2015 only), NULL for none
+    uint8_t header_ies_len;
+    const uint8_t* payload_ies;     //!< Encoded payload IEs (2015 only), NULL for none
+    uint8_t payload_ies_len;
+};
+
+// Information element view
+struct at86rf212_mac_ie_s {
+    uint8_t payload;                //!< Payload IE (group ID in id) rather than header IE
+    uint8_t id;                     //!< Element ID or group ID
+    uint16_t length;
+    const uint8_t* content;
+};
+
+// Determine which PAN IDs are present for a frame control field
+void at86rf212_mac_pan_presence(uint16_t fcf, uint8_t* dest_pan, uint8_t* src_pan);
+
+// Parse a frame in place
+// Returns AT86RF212_RES_OK, or AT86RF212_ERROR_LEN for truncated or malformed frames.
+int at86rf212_mac_parse(struct at86rf212_mac_frame_s *frame, uint8_t length, const uint8_t* data);
+
+// Build a frame header (and any payload IEs) into a transmit buffer
+// Returns the number of bytes written, the payload follows, or AT86RF212_ERROR_LEN if the header
+// does not fit in max_length.
+int at86rf212_mac_build(const struct at86rf212_mac_header_s *header, uint8_t max_length, uint8_t* data);
+
+// Iterate IEs, offset starts at 0 and is advanced on each call
+// Returns AT86RF212_RES_DONE with an IE, AT86RF212_RES_OK at the end of the IEs (or at a termination IE)
+// or AT86RF212_ERROR_LEN for malformed IEs.
+int at86rf212_mac_ie_next(uint8_t length, const uint8_t* data, uint8_t payload, uint8_t* offset,
+                          struct at86rf212_mac_ie_s *ie);
+
+// Encode an IE descriptor and content, returns the number of bytes written or AT86RF212_ERROR_LEN
+int at86rf212_mac_ie_put(uint8_t payload, uint8_t id, uint16_t length, const uint8_t* content,
+                         uint8_t max_length, uint8_t* data);
+
+// Read a short address from a parsed frame view
+static inline uint16_t at86rf212_mac_short_addr(const uint8_t* addr)
+{
+    return addr[0] | (addr[1] << 8);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
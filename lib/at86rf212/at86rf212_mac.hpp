@@ -0,0 +1,157 @@
+/*
+ * at86rf212 compile time MAC frame layouts
+ * Fixed header layouts for common frame formats. All offsets are constants, so building a header
+ * folds to a handful of stores and parsing to a frame control comparison and fixed offset loads.
+ * Frames that do not match a layout can be handled with the generic codec in at86rf212_mac.h.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "at86rf212_mac.h"
+
+namespace AT86RF212
+{
+
+namespace MacDetail
+{
+
+constexpr uint8_t addr_len(uint8_t mode)
+{
+    return (mode == AT86RF212_MAC_ADDR_SHORT) ? AT86RF212_MAC_SHORT_ADDR_LEN :
+           (mode == AT86RF212_MAC_ADDR_EXTENDED) ? AT86RF212_MAC_EXT_ADDR_LEN : 0;
+}
+
+// Compile time equivalent of at86rf212_mac_pan_presence
+constexpr bool dest_pan_present(uint8_t version, uint8_t dest, uint8_t src, bool pan_comp)
+{
+    return (version < AT86RF212_MAC_VERSION_2015) ? (dest != AT86RF212_MAC_ADDR_NONE) :
+           ((dest == AT86RF212_MAC_ADDR_NONE) && (src == AT86RF212_MAC_ADDR_NONE)) ? pan_comp :
+           (src == AT86RF212_MAC_ADDR_NONE) ? !pan_comp :
+           (dest == AT86RF212_MAC_ADDR_NONE) ? false :
+           ((dest == AT86RF212_MAC_ADDR_EXTENDED) && (src == AT86RF212_MAC_ADDR_EXTENDED)) ? !pan_comp : true;
+}
+
+constexpr bool src_pan_present(uint8_t version, uint8_t dest, uint8_t src, bool pan_comp)
+{
+    return (version < AT86RF212_MAC_VERSION_2015) ? ((src != AT86RF212_MAC_ADDR_NONE) && !pan_comp) :
+           (src == AT86RF212_MAC_ADDR_NONE) ? false :
+           (dest == AT86RF212_MAC_ADDR_NONE) ? !pan_comp :
+           ((dest == AT86RF212_MAC_ADDR_EXTENDED) && (src == AT86RF212_MAC_ADDR_EXTENDED)) ? false : !pan_comp;
+}
+
+template <unsigned N>
+inline void put_le(uint8_t* data, uint64_t value)
+{
+    for (unsigned i = 0; i < N; i++) {
+        data[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+template <unsigned N>
+inline uint64_t get_le(const uint8_t* data)
+{
+    uint64_t value = 0;
+    for (unsigned i = 0; i < N; i++) {
+        value |= (uint64_t)data[i] << (i * 8);
+    }
+    return value;
+}
+
+};
+
+// Fixed MAC header layout
+// Unsecured frames without IEs, with a sequence number. Addresses are passed and returned as
+// integers with short addresses in the low 16 bits.
+template <uint8_t Type, uint8_t DestMode, uint8_t SrcMode, bool PanComp = true, bool AckReq = false,
+          uint8_t Version = AT86RF212_MAC_VERSION_2003>
+class MacLayout
+{
+public:
+    enum : uint16_t {
+        fcf = (Type & AT86RF212_MAC_FCF_TYPE_MASK)
+              | (AckReq ? AT86RF212_MAC_FCF_ACK_REQ : 0)
+              | (PanComp ? AT86RF212_MAC_FCF_PAN_COMP : 0)
+              | (DestMode << AT86RF212_MAC_FCF_DST_MODE_SHIFT)
+              | (Version << AT86RF212_MAC_FCF_VERSION_SHIFT)
+              | (SrcMode << AT86RF212_MAC_FCF_SRC_MODE_SHIFT)
+    };
+
+    enum : uint8_t {
+        dest_pan_len = MacDetail::dest_pan_present(Version, DestMode, SrcMode, PanComp) ? 2 : 0,
+        src_pan_len = MacDetail::src_pan_present(Version, DestMode, SrcMode, PanComp) ? 2 : 0,
+        dest_addr_len = MacDetail::addr_len(DestMode),
+        src_addr_len = MacDetail::addr_len(SrcMode),
+        seq_offset = 2,
+        dest_pan_offset = 3,
+        dest_addr_offset = dest_pan_offset + dest_pan_len,
+        src_pan_offset = dest_addr_offset + dest_addr_len,
+        src_addr_offset = src_pan_offset + src_pan_len,
+        header_len = src_addr_offset + src_addr_len
+    };
+
+    static_assert((DestMode != 1) && (SrcMode != 1), "Reserved addressing mode");
+    static_assert(Version <= AT86RF212_MAC_VERSION_2015, "Unsupported frame version");
+
+    // Write the header, returns the payload offset
+    static inline uint8_t build(uint8_t* data, uint8_t seq, uint16_t dest_pan, uint64_t dest_addr,
+                                uint16_t src_pan = 0, uint64_t src_addr = 0)
+    {
+        MacDetail::put_le<2>(data, fcf);
+        data[seq_offset] = seq;
+        MacDetail::put_le<dest_pan_len>(&data[dest_pan_offset], dest_pan);
+        MacDetail::put_le<dest_addr_len>(&data[dest_addr_offset], dest_addr);
+        MacDetail::put_le<src_pan_len>(&data[src_pan_offset], src_pan);
+        MacDetail::put_le<src_addr_len>(&data[src_addr_offset], src_addr);
+        return header_len;
+    }
+
+    // Check whether a received frame has this layout
+    static inline bool matches(uint8_t length, const uint8_t* data)
+    {
+        return (length >= header_len) && (MacDetail::get_le<2>(data) == fcf);
+    }
+
+    // Field accessors for frames that match this layout
+    static inline uint8_t seq(const uint8_t* data)
+    {
+        return data[seq_offset];
+    }
+    static inline uint16_t dest_pan(const uint8_t* data)
+    {
+        return MacDetail::get_le<dest_pan_len>(&data[dest_pan_offset]);
+    }
+    static inline uint64_t dest_addr(const uint8_t* data)
+    {
+        return MacDetail::get_le<dest_addr_len>(&data[dest_addr_offset]);
+    }
+    static inline uint16_t src_pan(const uint8_t* data)
+    {
+        return src_pan_len ? MacDetail::get_le<src_pan_len>(&data[src_pan_offset]) : dest_pan(data);
+    }
+    static inline uint64_t src_addr(const uint8_t* data)
+    {
+        return MacDetail::get_le<src_addr_len>(&data[src_addr_offset]);
+    }
+    static inline const uint8_t* payload(const uint8_t* data)
+    {
+        return &data[header_len];
+    }
+};
+
+// Data frame, PAN ID compression, short addresses
+typedef MacLayout<AT86RF212_FRAME_TYPE_DATA, AT86RF212_MAC_ADDR_SHORT, AT86RF212_MAC_ADDR_SHORT> MacDataShort;
+
+// Data frame, PAN ID compression, short addresses, acknowledgement requested
+typedef MacLayout<AT86RF212_FRAME_TYPE_DATA, AT86RF212_MAC_ADDR_SHORT, AT86RF212_MAC_ADDR_SHORT, true, true> MacDataShortAck;
+
+// Data frame, PAN ID compression, extended addresses
+typedef MacLayout<AT86RF212_FRAME_TYPE_DATA, AT86RF212_MAC_ADDR_EXTENDED, AT86RF212_MAC_ADDR_EXTENDED> MacDataExtended;
+
+// Immediate acknowledgement
+typedef MacLayout<AT86RF212_FRAME_TYPE_ACK, AT86RF212_MAC_ADDR_NONE, AT86RF212_MAC_ADDR_NONE, false> MacAck;
+
+};
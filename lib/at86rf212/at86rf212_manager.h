@@ -0,0 +1,131 @@
+/*
+ * at86rf212 multi-radio manager
+ * Owns a set of radios and services them all from one epoll based event loop, so a gateway with
+ * several radios needs neither a thread nor a polling loop per device. Each radio's IRQ line is
+ * passed in as a pollable file descriptor (such as a GPIO line event descriptor), and each
+ * radio has a receive ring and a priority transmit queue serviced from the loop.
+ *
+ * Linux only (epoll).
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_MANAGER_H
+#define AT86RF212_MANAGER_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+#include "at86rf212_defs.h"
+
+// The radio limit sizes the manager structure, so is fixed for the library build (at86rf212_build.h)
+// Checked before the ring and queue headers pull in the build configuration
+#if defined(AT86RF212_MANAGER_MAX_RADIOS) && !defined(AT86RF212_BUILD_H)
+#error "AT86RF212_MANAGER_MAX_RADIOS must be set in at86rf212_build.h"
+#endif
+#include "at86rf212_build.h"
+#include "at86rf212_ring.h"
+#include "at86rf212_txq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef AT86RF212_MANAGER_RX_BUDGET
+#define AT86RF212_MANAGER_RX_BUDGET     4       //!< Frames delivered per radio per loop pass
+#endif
+
+// Received frame callback, the frame is only valid for the duration of the call
+typedef void (*at86rf212_manager_rx_f)(void* context, uint8_t radio, struct at86rf212_rx_frame_s *frame);
+// Transmit completion callback, result is AT86RF212_RES_DONE or an error code
+typedef void (*at86rf212_manager_tx_f)(void* context, uint8_t radio, int handle, int result);
+
+// Radio states
+enum at86rf212_manager_state_e {
+    AT86RF212_MANAGER_RX = 0,           //!< Listening
+    AT86RF212_MANAGER_TX = 1            //!< Transmitting from the queue
+};
+
+// Per-radio statistics
+struct at86rf212_manager_radio_stats_s {
+    uint32_t irqs;                      //!< IRQ events serviced
+    uint32_t spurious;                  //!< IRQ events without a frame or transmission to complete
+    uint32_t errors;                    //!< Driver errors while servicing the radio
+};
+
+// Managed radio
+struct at86rf212_manager_radio_s {
+    struct at86rf212_s device;
+    struct at86rf212_ring_s ring;
+    struct at86rf212_txq_s txq;
+    struct at86rf212_manager_s *manager;
+    uint8_t index;                      //!< Radio index passed to callbacks
+    uint8_t state;                      //!< Radio state (at86rf212_manager_state_e)
+    uint8_t irq_pending;                //!< IRQ signalled and not yet serviced
+    int irq_fd;                         //!< IRQ file descriptor (owned by the caller)
+    struct at86rf212_manager_radio_stats_s stats;
+};
+
+// Manager statistics
+struct at86rf212_manager_stats_s {
+    uint32_t wakeups;                   //!< Loop passes woken by at least one IRQ
+    uint32_t events;                    //!< IRQ file descriptor events
+    uint32_t max_events;                //!< Most IRQ events handled in one wakeup
+    uint32_t rx_frames;                 //!< Frames delivered to the receive callback
+    uint32_t tx_frames;                 //!< Transmissions completed (including failures)
+};
+
+// Radio manager
+// Not thread safe, every call must be made from the thread running the loop (including from callbacks).
+struct at86rf212_manager_s {
+    int epoll_fd;
+    uint8_t count;                      //!< Radios added
+    uint8_t next;                       //!< Radio serviced first in the next pass
+    at86rf212_manager_rx_f rx;          //!< Receive callback (frames are discarded without one)
+    void* rx_ctx;
+    at86rf212_manager_tx_f tx;          //!< Transmit completion callback (optional)
+    void* tx_ctx;
+    struct at86rf212_manager_radio_s radios[AT86RF212_MANAGER_MAX_RADIOS];
+    struct at86rf212_manager_stats_s stats;
+};
+
+// Initialise a manager with no radios
+// Returns AT86RF212_ERROR_DRIVER if the epoll instance cannot be created.
+int at86rf212_manager_init(struct at86rf212_manager_s *manager,
+                           at86rf212_manager_rx_f rx, void* rx_ctx,
+                           at86rf212_manager_tx_f tx, void* tx_ctx);
+
+// Initialise a radio with the provided configuration and add it to the manager in receive mode
+// irq_fd must become readable when the IRQ line is raised and be cleared by a read (for example a
+// GPIO line event descriptor or an eventfd signalled from an interrupt handler), with C++ drivers it
+// can be fetched with get_irq_fd. Interrupts other than TRX_END are masked regardless of the configuration.
+// Returns the radio index, AT86RF212_DRIVER_INVALID for a negative irq_fd, AT86RF212_ERROR_FULL if
+// the manager is full, or an error code.
+int at86rf212_manager_add(struct at86rf212_manager_s *manager, struct at86rf212_driver_s *driver, void* driver_ctx,
+                          int irq_fd, const struct at86rf212_config_s *config);
+
+// Queue a frame for transmission on a radio, returns a transmit queue handle (>= 0) or an error code
+// Transmission starts from the loop, completion is reported through the transmit callback.
+int at86rf212_manager_send(struct at86rf212_manager_s *manager, uint8_t radio, uint8_t tx_class,
+                           uint8_t length, uint8_t* data);
+
+// Run one pass of the event loop
+// Waits up to timeout_ms (-1 for no limit) for an IRQ unless work is outstanding, then services
+// every radio once, starting from a different radio each pass. Servicing completes or starts
+// transmissions, drains received frames into the radio's ring, and delivers up to
+// AT86RF212_MANAGER_RX_BUDGET frames to the receive callback.
+// Returns the number of IRQ events handled or an error code. Errors on individual radios are
+// counted in the radio statistics and do not stop the others being serviced.
+int at86rf212_manager_run(struct at86rf212_manager_s *manager, int timeout_ms);
+
+// Device object for a radio, for the rest of the at86rf212_* API
+struct at86rf212_s* at86rf212_manager_device(struct at86rf212_manager_s *manager, uint8_t radio);
+
+// Close every radio and the epoll instance, IRQ descriptors remain owned by the drivers
+int at86rf212_manager_close(struct at86rf212_manager_s *manager);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
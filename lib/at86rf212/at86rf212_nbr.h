@@ -0,0 +1,96 @@
+/*
+ * at86rf212 neighbour link quality table
+ * Fixed capacity open addressed (linear probing) table of neighbours keyed by short or extended
+ * address, tracking smoothed RSSI and LQI, packet reception ratio estimated from MAC sequence
+ * number gaps, and the time each neighbour was last heard.
+ *
+ * Averages are exponentially weighted with a weight of 1/8 per frame. RSSI and LQI are held in
+ * 1/16 units and PRR in 1/65536 units so updates are integer only.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_NBR_H
+#define AT86RF212_NBR_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+#include "at86rf212_mac.h"
+
+// The slot count sizes the neighbour table, so is fixed for the library build (at86rf212_build.h)
+#if defined(AT86RF212_NBR_SLOTS) && !defined(AT86RF212_BUILD_H)
+#error "AT86RF212_NBR_SLOTS must be set in at86rf212_build.h"
+#endif
+#include "at86rf212_build.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (AT86RF212_NBR_SLOTS & (AT86RF212_NBR_SLOTS - 1)) != 0
+#error "AT86RF212_NBR_SLOTS must be a power of two"
+#endif
+
+#define AT86RF212_NBR_MAX_ENTRIES   (AT86RF212_NBR_SLOTS * 3 / 4)   //!< Load limit, keeps probe sequences short
+#define AT86RF212_NBR_EWMA_SHIFT    3       //!< EWMA weight 1/8
+#define AT86RF212_NBR_PRR_ONE       65535   //!< PRR of 1.0
+
+// Neighbour entry (32 bytes)
+struct at86rf212_nbr_s {
+    uint64_t addr;                  //!< Address, short addresses in the low 16 bits
+    uint32_t last_seen;             //!< Time the last frame was received
+    uint32_t frames;                //!< Frames received
+    uint32_t missed;                //!< Frames missed (sequence number gaps)
+    int16_t rssi;                   //!< Smoothed RSSI (dBm * 16)
+    uint16_t lqi;                   //!< Smoothed LQI (* 16)
+    uint16_t prr;                   //!< Smoothed packet reception ratio (/ 65535)
+    uint8_t mode;                   //!< Addressing mode (at86rf212_mac_addr_mode_e), 0 for an empty slot
+    uint8_t last_seq;               //!< Last MAC sequence number
+};
+
+// Neighbour table
+struct at86rf212_nbr_table_s {
+    struct at86rf212_nbr_s slots[AT86RF212_NBR_SLOTS];
+    uint16_t count;                 //!< Entries in use
+    int8_t rssi_base;               //!< RSSI base value for the PHY mode (at86rf212_get_rssi_base)
+    uint32_t evictions;             //!< Entries replaced because the table was full
+};
+
+// Initialise an empty table for a PHY mode
+void at86rf212_nbr_init(struct at86rf212_nbr_table_s *table, uint8_t phy_mode);
+
+// Look up a neighbour, NULL if not present
+struct at86rf212_nbr_s* at86rf212_nbr_find(struct at86rf212_nbr_table_s *table, uint8_t mode, uint64_t addr);
+
+// Record a received frame, adding the neighbour if required
+// When the table is full the least recently seen neighbour is replaced.
+struct at86rf212_nbr_s* at86rf212_nbr_update(struct at86rf212_nbr_table_s *table, uint8_t mode, uint64_t addr,
+                                             uint8_t seq, uint8_t lqi, uint8_t ed, uint32_t now);
+
+// Record a received frame from its MAC view and receive metadata (timestamp used as the time)
+// Returns NULL for frames without a source address or sequence number.
+struct at86rf212_nbr_s* at86rf212_nbr_update_rx(struct at86rf212_nbr_table_s *table,
+                                                const struct at86rf212_mac_frame_s *mac,
+                                                const struct at86rf212_rx_frame_s *rx);
+
+// Remove a neighbour, entries may move so pointers into the table are invalidated
+void at86rf212_nbr_remove(struct at86rf212_nbr_table_s *table, struct at86rf212_nbr_s *nbr);
+
+// Remove neighbours not heard for max_age, returns the number removed
+uint16_t at86rf212_nbr_expire(struct at86rf212_nbr_table_s *table, uint32_t now, uint32_t max_age);
+
+// Iterate neighbours, index starts at 0 and is advanced on each call, returns NULL at the end
+struct at86rf212_nbr_s* at86rf212_nbr_next(struct at86rf212_nbr_table_s *table, uint16_t* index);
+
+// Smoothed RSSI in whole dBm
+static inline int16_t at86rf212_nbr_rssi_dbm(const struct at86rf212_nbr_s *nbr)
+{
+    return nbr->rssi / 16;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,6 +7,8 @@
 #ifndef AT86RF212_REGS_H
 #define AT86RF212_REGS_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -67,6 +69,7 @@ enum at86rf212_reg_e {
     AT86RF212_REG_CSMA_SEED_0     = 0x2D,   //!< CSMA_SEED_0 register address
     AT86RF212_REG_CSMA_SEED_1     = 0x2E,   //!< CSMA_SEED_1 register address
     AT86RF212_REG_CSMA_BE         = 0x2F,   //!< CSMA_BE register address
+    AT86RF212_REG_COUNT           = 0x40    //!< Size of the register address space
 };
 
 // Register template to speed up addition of new registers
@@ -88,140 +91,123 @@ enum at86rf212_reg_e {
 #define AT86RF212_8_MASK       0x80
 #define AT86RF212_8_SHIFT      7
 
-// TRX_STATUS register
-#define AT86RF212_TRX_STATUS_TRX_STATUS_MASK            0x1F
-#define AT86RF212_TRX_STATUS_CCA_STATUS_MASK            0x40
-#define AT86RF212_TRX_STATUS_CCA_DONE_MASK              0x80
-
-// TRX_STATE register
-#define AT86RF212_TRX_STATE_TRX_CMD_MASK                0x1F
-#define AT86RF212_TRX_STATE_TRX_CMD_SHIFT               0
-#define AT86RF212_TRX_STATE_TRAC_STATUS_MASK            0xA0
-#define AT86RF212_TRX_STATE_TRAC_STATUS_SHIFT           5
-
-// TRX_CTRL0
-#define AT86RF212_TRX_CTRL0_CLKM_CTRL_MASK              0x07
-#define AT86RF212_TRX_CTRL0_CLKM_CTRL_SHIFT             0
-#define AT86RF212_TRX_CTRL0_CLKM_SHA_SEL_MASK           0x08
-#define AT86RF212_TRX_CTRL0_CLKM_SHA_SEL_SHIFT          3
-#define AT86RF212_TRX_CTRL0_PAD_IO_CLKM_MASK            0x30
-#define AT86RF212_TRX_CTRL0_PAD_IO_CLKM_SHIFT           4
-#define AT86RF212_TRX_CTRL0_PAD_IO_MASK                 0xC0
-#define AT86RF212_TRX_CTRL0_PAD_IO_SHIFT                6
-
-// TRX_CTRL1
-#define AT86RF212_TRX_CTRL1_IRQ_POLARITY_MASK           0x01
-#define AT86RF212_TRX_CTRL1_IRQ_POLARITY_SHIFT          0
-#define AT86RF212_TRX_CTRL1_IRQ_MASK_MODE_MASK          0x02
-#define AT86RF212_TRX_CTRL1_IRQ_MASK_MODE_SHIFT         1
-#define AT86RF212_TRX_CTRL1_SPI_CMD_MODE_MASK           0x0C
-#define AT86RF212_TRX_CTRL1_SPI_CMD_MODE_SHIFT          2
-#define AT86RF212_TRX_CTRL1_RX_BL_CTRL_MASK             0x10
-#define AT86RF212_TRX_CTRL1_RX_BL_CTRL_SHIFT            4
-#define AT86RF212_TRX_CTRL1_TX_AUTO_CRC_ON_MASK         0x20
-#define AT86RF212_TRX_CTRL1_TX_AUTO_CRC_ON_SHIFT        5
-#define AT86RF212_TRX_CTRL1_IRQ_2_EXT_EN_MASK           0x40
-#define AT86RF212_TRX_CTRL1_IRQ_2_EXT_EN_SHIFT          6
-#define AT86RF212_TRX_CTRL1_PA_EXT_EN_MASK              0x80
-#define AT86RF212_TRX_CTRL1_PA_EXT_EN_SHIFT             7
-
-// TRX_CTRL2
-#define AT86RF212_TRX_CTRL2_OQPSK_DATA_RATE_MASK        0x02
-#define AT86RF212_TRX_CTRL2_OQPSK_DATA_RATE_SHIFT       0
-#define AT86RF212_TRX_CTRL2_SUB_MODE_MASK               0x04
-#define AT86RF212_TRX_CTRL2_SUB_MODE_SHIFT              2
-#define AT86RF212_TRX_CTRL2_BPSK_OQPSK_MASK             0x08
-#define AT86RF212_TRX_CTRL2_BPSK_OQPSK_SHIFT            3
-#define AT86RF212_TRX_CTRL2_ALT_SPECTRUM_MASK           0x10
-#define AT86RF212_TRX_CTRL2_ALT_SPECTRUM_SHIFT          4
-#define AT86RF212_TRX_CTRL2_OQPSK_SCRAM_EN_MASK         0x20
-#define AT86RF212_TRX_CTRL2_OQPSK_SCRAM_EN_SHIFT        5
-#define AT86RF212_TRX_CTRL2_TRX_OFF_AVDD_EN_MASK        0x40
-#define AT86RF212_TRX_CTRL2_TRX_OFF_AVDD_EN_SHIFT       6
-#define AT86RF212_TRX_CTRL2_RX_SAFE_MODE_MASK           0x80
-#define AT86RF212_TRX_CTRL2_RX_SAFE_MODE_SHIFT          7
-
-
-// PHY_CC_CCA
-#define AT86RF212_PHY_CC_CCA_CHANNEL_MASK               0x1F
-#define AT86RF212_PHY_CC_CCA_CHANNEL_SHIFT              0
-#define AT86RF212_PHY_CC_CCA_CCA_MODE_MASK              0x40
-#define AT86RF212_PHY_CC_CCA_CCA_MODE_SHIFT             5
-#define AT86RF212_PHY_CC_CCA_CCA_REQ_MASK               0x80
-#define AT86RF212_PHY_CC_CCA_CCA_REQ_SHIFT              7
-
-// IRQ_STATUS
-#define AT86RF212_IRQ_STATUS_IRQ_0_PLL_LOCK_MASK        0x01
-#define AT86RF212_IRQ_STATUS_IRQ_0_PLL_LOCK_SHIFT       0
-#define AT86RF212_IRQ_STATUS_IRQ_1_PLL_UNLOCK_MASK      0x02
-#define AT86RF212_IRQ_STATUS_IRQ_1_PLL_UNLOCK_SHIFT     1
-#define AT86RF212_IRQ_STATUS_IRQ_2_RX_START_MASK        0x04
-#define AT86RF212_IRQ_STATUS_IRQ_2_RX_START_SHIFT       2
-#define AT86RF212_IRQ_STATUS_IRQ_3_TRX_END_MASK         0x08
-#define AT86RF212_IRQ_STATUS_IRQ_3_TRX_END_SHIFT        3
-#define AT86RF212_IRQ_STATUS_IRQ_4_CCA_ED_DONE_MASK     0x10
-#define AT86RF212_IRQ_STATUS_IRQ_4_CCA_ED_DONE_SHIFT    4
-#define AT86RF212_IRQ_STATUS_IRQ_5_AMI_MASK             0x20
-#define AT86RF212_IRQ_STATUS_IRQ_5_AMI_SHIFT            5
-#define AT86RF212_IRQ_STATUS_IRQ_6_TRX_UR_MASK          0x40
-#define AT86RF212_IRQ_STATUS_IRQ_6_TRX_UR_SHIFT         6
-#define AT86RF212_IRQ_STATUS_IRQ_7_BAT_LOW_MASK         0x80
-#define AT86RF212_IRQ_STATUS_IRQ_7_BAT_LOW_SHIFT        7
-
-
-// CSMA_BE
-#define AT86RF212_CSMA_BE_MIN_MASK                      0x0F
-#define AT86RF212_CSMA_BE_MIN_SHIFT                     0
-#define AT86RF212_CSMA_BE_MAX_MASK                      0xF0
-#define AT86RF212_CSMA_BE_MAX_SHIFT                     4
-
-// XAH_CTRL_0
-#define AT86RF212_XAH_CTRL_SLOTTED_OPERATION_MASK       0x01
-#define AT86RF212_XAH_CTRL_SLOTTED_OPERATION_SHIFT      0
-#define AT86RF212_XAH_CTRL_MAX_CSMA_RETRIES_MASK        0x0E
-#define AT86RF212_XAH_CTRL_MAX_CSMA_RETRIES_SHIFT       1
-#define AT86RF212_XAH_CTRL_MAX_FRAME_RETRIES_MASK       0xF0
-#define AT86RF212_XAH_CTRL_MAX_FRAME_RETRIES_SHIFT      4
-
-// XAH_CTRL_1
-#define AT86RF212_XAH_CTRL_1_AACK_PROM_MODE_MASK        0x02
-#define AT86RF212_XAH_CTRL_1_AACK_PROM_MODE_SHIFT       1
-#define AT86RF212_XAH_CTRL_1_AACK_ACK_TIME_MASK         0x04
-#define AT86RF212_XAH_CTRL_1_AACK_ACK_TIME_SHIFT        2
-#define AT86RF212_XAH_CTRL_1_AACK_UPLD_RES_FT_MASK      0x10
-#define AT86RF212_XAH_CTRL_1_AACK_UPLD_RES_FT_SHIFT     4
-#define AT86RF212_XAH_CTRL_1_AACK_FLTR_RES_FT_MASK      0x20
-#define AT86RF212_XAH_CTRL_1_AACK_FLTR_RES_FT_SHIFT     5
-#define AT86RF212_XAH_CTRL_1_CSMA_LBT_MODE_MASK         0x40
-#define AT86RF212_XAH_CTRL_1_CSMA_LBT_MODE_SHIFT        6
-
-// VREG_CTRL
-#define AT86RF212_VREG_CTRL_DVDD_OK_MASK                0x04
-#define AT86RF212_VREG_CTRL_DVDD_OK_SHIFT               2
-#define AT86RF212_VREG_CTRL_DVREG_EXT_MASK              0x08
-#define AT86RF212_VREG_CTRL_DVREG_EXT_SHIFT             3
-#define AT86RF212_VREG_CTRL_AVDD_OK_MASK                0x40
-#define AT86RF212_VREG_CTRL_AVDD_OK_SHIFT               6
-#define AT86RF212_VREG_CTRL_AVREG_EXT_MASK              0x80
-#define AT86RF212_VREG_CTRL_AVREG_EXT_SHIFT             7
-
-// BATMON
-#define AT86RF212_BATMON_BATMON_VTH_MASK                0x0F
-#define AT86RF212_BATMON_BATMON_VTH_SHIFT               0
-#define AT86RF212_BATMON_BATMON_HR_MASK                 0x10
-#define AT86RF212_BATMON_BATMON_HR_SHIFT                4
-#define AT86RF212_BATMON_BATMON_OK_MASK                 0x20
-#define AT86RF212_BATMON_BATMON_OK_SHIFT                5
-#define AT86RF212_BATMON_PLL_LOCK_MASK                  0x80
-#define AT86RF212_BATMON_PLL_LOCK_SHIFT                 7
-
-// PHY_TX_PWR
-#define AT86RF212_PHY_TX_PWR_TX_PWR_MASK                0x1F
-#define AT86RF212_PHY_TX_PWR_TX_PWR_SHIFT               0
-#define AT86RF212_PHY_TX_PWR_GC_PA_MASK                 0x60
-#define AT86RF212_PHY_TX_PWR_GC_PA_SHIFT                5
-#define AT86RF212_PHY_TX_PWR_PA_BOOST_MASK              0x80
-#define AT86RF212_PHY_TX_PWR_PA_BOOST_SHIFT             7
+// Register field descriptors
+// X(field, register, mask) for every field, expanded below into AT86RF212_<field>_MASK, _SHIFT and
+// _REG constants. Shifts are derived from the masks so the two can not disagree.
+#define AT86RF212_FIELDS(X) \
+    /* TRX_STATUS register */ \
+    X(TRX_STATUS_TRX_STATUS,                         TRX_STATUS,    0x1F) \
+    X(TRX_STATUS_CCA_STATUS,                         TRX_STATUS,    0x40) \
+    X(TRX_STATUS_CCA_DONE,                           TRX_STATUS,    0x80) \
+    /* TRX_STATE register */ \
+    X(TRX_STATE_TRX_CMD,                             TRX_STATE,     0x1F) \
+    X(TRX_STATE_TRAC_STATUS,                         TRX_STATE,     0xE0) \
+    /* TRX_CTRL0 */ \
+    X(TRX_CTRL0_CLKM_CTRL,                           TRX_CTRL_0,    0x07) \
+    X(TRX_CTRL0_CLKM_SHA_SEL,                        TRX_CTRL_0,    0x08) \
+    X(TRX_CTRL0_PAD_IO_CLKM,                         TRX_CTRL_0,    0x30) \
+    X(TRX_CTRL0_PAD_IO,                              TRX_CTRL_0,    0xC0) \
+    /* TRX_CTRL1 */ \
+    X(TRX_CTRL1_IRQ_POLARITY,                        TRX_CTRL_1,    0x01) \
+    X(TRX_CTRL1_IRQ_MASK_MODE,                       TRX_CTRL_1,    0x02) \
+    X(TRX_CTRL1_SPI_CMD_MODE,                        TRX_CTRL_1,    0x0C) \
+    X(TRX_CTRL1_RX_BL_CTRL,                          TRX_CTRL_1,    0x10) \
+    X(TRX_CTRL1_TX_AUTO_CRC_ON,                      TRX_CTRL_1,    0x20) \
+    X(TRX_CTRL1_IRQ_2_EXT_EN,                        TRX_CTRL_1,    0x40) \
+    X(TRX_CTRL1_PA_EXT_EN,                           TRX_CTRL_1,    0x80) \
+    /* TRX_CTRL2 */ \
+    X(TRX_CTRL2_OQPSK_DATA_RATE,                     TRX_CTRL_2,    0x03) \
+    X(TRX_CTRL2_SUB_MODE,                            TRX_CTRL_2,    0x04) \
+    X(TRX_CTRL2_BPSK_OQPSK,                          TRX_CTRL_2,    0x08) \
+    X(TRX_CTRL2_ALT_SPECTRUM,                        TRX_CTRL_2,    0x10) \
+    X(TRX_CTRL2_OQPSK_SCRAM_EN,                      TRX_CTRL_2,    0x20) \
+    X(TRX_CTRL2_TRX_OFF_AVDD_EN,                     TRX_CTRL_2,    0x40) \
+    X(TRX_CTRL2_RX_SAFE_MODE,                        TRX_CTRL_2,    0x80) \
+    X(TRX_CTRL2_PHY_MODE,                            TRX_CTRL_2,    0x0F) /* Combined BPSK_OQPSK, SUB_MODE and OQPSK_DATA_RATE */ \
+    /* PHY_RSSI */ \
+    X(PHY_RSSI_RSSI,                                 PHY_RSSI,      0x1F) \
+    X(PHY_RSSI_RND_VALUE,                            PHY_RSSI,      0x60) \
+    X(PHY_RSSI_RX_CRC_VALID,                         PHY_RSSI,      0x80) \
+    /* PHY_CC_CCA */ \
+    X(PHY_CC_CCA_CHANNEL,                            PHY_CC_CCA,    0x1F) \
+    X(PHY_CC_CCA_CCA_MODE,                           PHY_CC_CCA,    0x60) \
+    X(PHY_CC_CCA_CCA_REQ,                            PHY_CC_CCA,    0x80) \
+    /* IRQ_STATUS */ \
+    X(IRQ_STATUS_IRQ_0_PLL_LOCK,                     IRQ_STATUS,    0x01) \
+    X(IRQ_STATUS_IRQ_1_PLL_UNLOCK,                   IRQ_STATUS,    0x02) \
+    X(IRQ_STATUS_IRQ_2_RX_START,                     IRQ_STATUS,    0x04) \
+    X(IRQ_STATUS_IRQ_3_TRX_END,                      IRQ_STATUS,    0x08) \
+    X(IRQ_STATUS_IRQ_4_CCA_ED_DONE,                  IRQ_STATUS,    0x10) \
+    X(IRQ_STATUS_IRQ_5_AMI,                          IRQ_STATUS,    0x20) \
+    X(IRQ_STATUS_IRQ_6_TRX_UR,                       IRQ_STATUS,    0x40) \
+    X(IRQ_STATUS_IRQ_7_BAT_LOW,                      IRQ_STATUS,    0x80) \
+    /* CSMA_BE */ \
+    X(CSMA_BE_MIN,                                   CSMA_BE,       0x0F) \
+    X(CSMA_BE_MAX,                                   CSMA_BE,       0xF0) \
+    /* XAH_CTRL_0 */ \
+    X(XAH_CTRL_SLOTTED_OPERATION,                    XAH_CTRL_0,    0x01) \
+    X(XAH_CTRL_MAX_CSMA_RETRIES,                     XAH_CTRL_0,    0x0E) \
+    X(XAH_CTRL_MAX_FRAME_RETRIES,                    XAH_CTRL_0,    0xF0) \
+    /* CSMA_SEED_1 */ \
+    X(CSMA_SEED_1_CSMA_SEED_1,                       CSMA_SEED_1,   0x07) \
+    /* XAH_CTRL_1 */ \
+    X(XAH_CTRL_1_AACK_PROM_MODE,                     XAH_CTRL_1,    0x02) \
+    X(XAH_CTRL_1_AACK_ACK_TIME,                      XAH_CTRL_1,    0x04) \
+    X(XAH_CTRL_1_AACK_UPLD_RES_FT,                   XAH_CTRL_1,    0x10) \
+    X(XAH_CTRL_1_AACK_FLTR_RES_FT,                   XAH_CTRL_1,    0x20) \
+    X(XAH_CTRL_1_CSMA_LBT_MODE,                      XAH_CTRL_1,    0x40) \
+    /* VREG_CTRL */ \
+    X(VREG_CTRL_DVDD_OK,                             VREG_CTRL,     0x04) \
+    X(VREG_CTRL_DVREG_EXT,                           VREG_CTRL,     0x08) \
+    X(VREG_CTRL_AVDD_OK,                             VREG_CTRL,     0x40) \
+    X(VREG_CTRL_AVREG_EXT,                           VREG_CTRL,     0x80) \
+    /* BATMON */ \
+    X(BATMON_BATMON_VTH,                             BATMON,        0x0F) \
+    X(BATMON_BATMON_HR,                              BATMON,        0x10) \
+    X(BATMON_BATMON_OK,                              BATMON,        0x20) \
+    X(BATMON_PLL_LOCK,                               BATMON,        0x80) \
+    /* PHY_TX_PWR */ \
+    X(PHY_TX_PWR_TX_PWR,                             PHY_TX_PWR,    0x1F) \
+    X(PHY_TX_PWR_GC_PA,                              PHY_TX_PWR,    0x60) \
+    X(PHY_TX_PWR_PA_BOOST,                           PHY_TX_PWR,    0x80)
+
+// Position of the lowest set bit of a field mask
+#define AT86RF212_MASK_SHIFT(mask) \
+    (((mask) & 0x01) ? 0 : ((mask) & 0x02) ? 1 : ((mask) & 0x04) ? 2 : ((mask) & 0x08) ? 3 : \
+     ((mask) & 0x10) ? 4 : ((mask) & 0x20) ? 5 : ((mask) & 0x40) ? 6 : 7)
+
+#define AT86RF212_FIELD_CONSTANTS(field, reg, mask) \
+    AT86RF212_##field##_MASK = (mask), \
+    AT86RF212_##field##_SHIFT = AT86RF212_MASK_SHIFT(mask), \
+    AT86RF212_##field##_REG = AT86RF212_REG_##reg,
+
+enum at86rf212_field_e {
+    AT86RF212_FIELDS(AT86RF212_FIELD_CONSTANTS)
+};
+
+// Field helpers, field is the name without the AT86RF212_ prefix (eg. PHY_CC_CCA_CHANNEL)
+#define AT86RF212_FIELD_REG(field)          AT86RF212_##field##_REG
+#define AT86RF212_FIELD_MASK(field)         AT86RF212_##field##_MASK
+// Value positioned and masked for the field
+#define AT86RF212_FIELD_VAL(field, value)   ((uint8_t)(((value) << AT86RF212_##field##_SHIFT) & AT86RF212_##field##_MASK))
+// Field value extracted from a register value
+#define AT86RF212_FIELD_GET(field, reg_val) (((reg_val) & AT86RF212_##field##_MASK) >> AT86RF212_##field##_SHIFT)
+
+// Compile time check that two fields share a register, evaluates to 0
+#define AT86RF212_SAME_REG(a, b)            (0 * sizeof(char[(AT86RF212_##a##_REG == AT86RF212_##b##_REG) ? 1 : -1]))
+
+// struct at86rf212_reg_update_s initialisers combining field writes to one register into a single update
+// Fields in different registers fail to compile.
+#define AT86RF212_UPDATE1(f1, v1) \
+    {AT86RF212_FIELD_REG(f1), AT86RF212_FIELD_MASK(f1), AT86RF212_FIELD_VAL(f1, v1)}
+#define AT86RF212_UPDATE2(f1, v1, f2, v2) \
+    {(uint8_t)(AT86RF212_FIELD_REG(f1) + AT86RF212_SAME_REG(f1, f2)), \
+     AT86RF212_FIELD_MASK(f1) | AT86RF212_FIELD_MASK(f2), \
+     (uint8_t)(AT86RF212_FIELD_VAL(f1, v1) | AT86RF212_FIELD_VAL(f2, v2))}
+#define AT86RF212_UPDATE3(f1, v1, f2, v2, f3, v3) \
+    {(uint8_t)(AT86RF212_FIELD_REG(f1) + AT86RF212_SAME_REG(f1, f2) + AT86RF212_SAME_REG(f1, f3)), \
+     AT86RF212_FIELD_MASK(f1) | AT86RF212_FIELD_MASK(f2) | AT86RF212_FIELD_MASK(f3), \
+     (uint8_t)(AT86RF212_FIELD_VAL(f1, v1) | AT86RF212_FIELD_VAL(f2, v2) | AT86RF212_FIELD_VAL(f3, v3))}
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,75 @@
+/*
+ * at86rf212 typed register field descriptors
+ * Field objects generated from the AT86RF212_FIELDS table in at86rf212_regs.h. Applying a value
+ * to a field produces an Update for its register, updates to the same register combine with |
+ * into a single masked write, and combining fields of different registers does not compile.
+ *
+ *   dev.update(Regs::TRX_CTRL1_TX_AUTO_CRC_ON(1) | Regs::TRX_CTRL1_SPI_CMD_MODE(1));
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+#include "at86rf212_regs.h"
+
+namespace AT86RF212
+{
+
+namespace Regs
+{
+
+// Masked update of register Reg
+template <uint8_t Reg>
+struct Update {
+    uint8_t mask;
+    uint8_t value;
+
+    constexpr Update operator|(Update other) const
+    {
+        return Update{(uint8_t)(mask | other.mask), (uint8_t)((value & ~other.mask) | other.value)};
+    }
+
+    // Entry for the C update list (at86rf212_update_regs)
+    constexpr operator at86rf212_reg_update_s() const
+    {
+        return at86rf212_reg_update_s{Reg, mask, value};
+    }
+};
+
+constexpr uint8_t mask_shift(uint8_t mask)
+{
+    return ((mask & 0x01) != 0) ? 0 : 1 + mask_shift(mask >> 1);
+}
+
+// Field of register Reg covering the bits in Mask
+template <uint8_t Reg, uint8_t Mask>
+struct Field {
+    static_assert(Mask != 0, "Field mask must not be empty");
+
+    static constexpr uint8_t reg = Reg;
+    static constexpr uint8_t mask = Mask;
+    static constexpr uint8_t shift = mask_shift(Mask);
+
+    constexpr Update<Reg> operator()(uint8_t value) const
+    {
+        return Update<Reg>{Mask, (uint8_t)((value << shift) & Mask)};
+    }
+
+    static constexpr uint8_t get(uint8_t reg_val)
+    {
+        return (reg_val & Mask) >> shift;
+    }
+};
+
+#define AT86RF212_FIELD_OBJECT(field, reg, mask) \
+    constexpr Field<AT86RF212_REG_##reg, mask> field{};
+AT86RF212_FIELDS(AT86RF212_FIELD_OBJECT)
+#undef AT86RF212_FIELD_OBJECT
+
+};
+
+};
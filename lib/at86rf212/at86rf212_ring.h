@@ -0,0 +1,87 @@
+/*
+ * at86rf212 receive frame ring
+ * Preallocated pool of frame slots with single-producer/single-consumer lock-free queues, so
+ * frames can be drained from the radio in IRQ or I/O context and processed elsewhere without
+ * allocation or copying.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_RING_H
+#define AT86RF212_RING_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+
+// The slot count sizes the ring structure, so is fixed for the library build (at86rf212_build.h)
+#if defined(AT86RF212_RING_SLOTS) && !defined(AT86RF212_BUILD_H)
+#error "AT86RF212_RING_SLOTS must be set in at86rf212_build.h"
+#endif
+#include "at86rf212_build.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (AT86RF212_RING_SLOTS & (AT86RF212_RING_SLOTS - 1)) != 0
+#error "AT86RF212_RING_SLOTS must be a power of two"
+#endif
+
+// Frame slot, the frame must be the first member (slots are recovered from frame pointers)
+struct at86rf212_rx_slot_s {
+    struct at86rf212_rx_frame_s frame;  //!< Frame metadata, payload points into buffer
+    uint8_t buffer[AT86RF212_RX_BUFFER_LEN];
+};
+
+// Single-producer/single-consumer queue of slot indices
+// Head and tail are free running, and are only written by the consumer and producer respectively.
+struct at86rf212_spsc_s {
+    uint32_t head;                      //!< Next index to consume
+    uint32_t tail;                      //!< Next index to produce
+    uint8_t slots[AT86RF212_RING_SLOTS];
+};
+
+// Ring statistics, written by the producer
+struct at86rf212_ring_stats_s {
+    uint32_t received;                  //!< Frames queued
+    uint32_t dropped;                   //!< Frames discarded because no slot was free
+    uint32_t rejected;                  //!< Frames discarded for a bad CRC
+    uint32_t high_watermark;            //!< Largest number of queued frames observed
+};
+
+// Receive ring
+// The producer (at86rf212_ring_drain) fills empty slots and queues them to ready, the consumer
+// (at86rf212_ring_get / at86rf212_ring_release) processes ready slots and returns them to empty.
+struct at86rf212_ring_s {
+    struct at86rf212_rx_slot_s pool[AT86RF212_RING_SLOTS];
+    struct at86rf212_spsc_s ready;      //!< Filled slots, producer to consumer
+    struct at86rf212_spsc_s empty;      //!< Empty slots, consumer to producer
+    int16_t spare;                      //!< Slot held by the producer (-1 for none)
+    struct at86rf212_ring_stats_s stats;
+};
+
+// Initialise a ring with every slot free
+void at86rf212_ring_init(struct at86rf212_ring_s *ring);
+
+// Producer: drain a received frame from the radio into the ring
+// Call when TRX_END has been observed (at86rf212_check_rx or IRQ).
+// Returns AT86RF212_RES_DONE when a frame was queued, AT86RF212_RES_REJECTED if it was
+// dropped or failed CRC, or an error code.
+int at86rf212_ring_drain(struct at86rf212_s *device, struct at86rf212_ring_s *ring);
+
+// Consumer: fetch the oldest queued frame, NULL if the ring is empty
+// The frame remains owned by the consumer until returned with at86rf212_ring_release.
+struct at86rf212_rx_frame_s* at86rf212_ring_get(struct at86rf212_ring_s *ring);
+
+// Consumer: return a frame slot to the pool
+void at86rf212_ring_release(struct at86rf212_ring_s *ring, struct at86rf212_rx_frame_s *frame);
+
+// Number of frames queued for the consumer
+uint32_t at86rf212_ring_count(struct at86rf212_ring_s *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * at86rf212 priority transmit queue
+ * Non-blocking frame submission with priority classes, a scheduler that starts the next frame
+ * as soon as the radio completes the previous one, and per-class latency statistics.
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_TXQ_H
+#define AT86RF212_TXQ_H
+
+#include <stdint.h>
+
+#include "at86rf212.h"
+
+// The queue depth sizes the queue structures, so is fixed for the library build (at86rf212_build.h)
+#if defined(AT86RF212_TXQ_DEPTH) && !defined(AT86RF212_BUILD_H)
+#error "AT86RF212_TXQ_DEPTH must be set in at86rf212_build.h"
+#endif
+#include "at86rf212_build.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AT86RF212_TXQ_HIST_BUCKETS  24      //!< Latency histogram buckets (log2 microseconds)
+
+// Priority classes, lower values are sent first
+enum at86rf212_tx_class_e {
+    AT86RF212_TX_CLASS_CONTROL = 0,     //!< Control and acknowledgement traffic
+    AT86RF212_TX_CLASS_HIGH = 1,        //!< Latency sensitive data
+    AT86RF212_TX_CLASS_NORMAL = 2,      //!< Default data
+    AT86RF212_TX_CLASS_BULK = 3,        //!< Background transfers
+    AT86RF212_TX_CLASSES = 4
+};
+
+// Completion callback, result is AT86RF212_RES_DONE or an error code
+typedef void (*at86rf212_tx_done_f)(void* context, int handle, int result);
+
+// Queued frame
+struct at86rf212_txq_entry_s {
+    int handle;                     //!< Handle returned from submit, -1 when the entry is free
+    uint8_t tx_class;               //!< Priority class
+    uint8_t length;                 //!< Frame length (excluding CRC)
+    int8_t state;                   //!< Entry state (internal)
+    int result;                     //!< Completion result for polling
+    uint32_t submit_time;           //!< Submission time (from the device time source)
+    uint8_t data[AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN];
+};
+
+// Per-class FIFO of entry indices
+struct at86rf212_txq_fifo_s {
+    uint16_t head;
+    uint16_t tail;
+    uint8_t entries[AT86RF212_TXQ_DEPTH];
+};
+
+// Per-class statistics
+struct at86rf212_txq_class_stats_s {
+    uint32_t submitted;             //!< Frames accepted
+    uint32_t sent;                  //!< Frames completed
+    uint32_t failed;                //!< Frames completed with an error
+    uint32_t bytes;                 //!< Frame bytes completed
+    uint32_t latency[AT86RF212_TXQ_HIST_BUCKETS];  //!< Submit to completion latency, bucket n is [2^n, 2^(n+1)) us
+};
+
+// Transmit queue
+// Not thread safe, submission and at86rf212_txq_run must be called from the same context.
+struct at86rf212_txq_s {
+    struct at86rf212_s *device;
+    at86rf212_tx_done_f done;       //!< Completion callback (optional, poll with at86rf212_txq_status otherwise)
+    void* done_ctx;
+    struct at86rf212_txq_entry_s entries[AT86RF212_TXQ_DEPTH];
+    struct at86rf212_txq_fifo_s fifos[AT86RF212_TX_CLASSES];
+    int active;                     //!< Entry being transmitted, -1 when the radio is idle
+    int next_handle;
+    uint8_t started;                //!< Indicates start_time is valid
+    uint32_t start_time;            //!< Time of the first submission (for throughput)
+    uint32_t last_time;             //!< Time of the latest completion (for throughput)
+    struct at86rf212_txq_class_stats_s stats[AT86RF212_TX_CLASSES];
+};
+
+// Initialise a transmit queue for a device
+void at86rf212_txq_init(struct at86rf212_txq_s *txq, struct at86rf212_s *device,
+                        at86rf212_tx_done_f done, void* done_ctx);
+
+// Queue a frame for transmission, returns a handle (>= 0) or an error code
+// The frame is copied, so the data buffer may be reused immediately.
+int at86rf212_txq_submit(struct at86rf212_txq_s *txq, uint8_t tx_class, uint8_t length, uint8_t* data);
+
+// Service the queue, call from the main loop or on radio IRQ
+// Completes the active frame if TRX_END is set and immediately starts the next highest priority frame.
+// Frames start from PLL_ON or RX_ON without waiting (at86rf212_start_tx_fast), and the radio stays in
+// PLL_ON between them.
+// Returns AT86RF212_RES_DONE when the queue is idle and empty, AT86RF212_RES_REJECTED when a received
+// frame must be drained (at86rf212_check_rx) before the next frame can start, AT86RF212_RES_OK otherwise.
+int at86rf212_txq_run(struct at86rf212_txq_s *txq);
+
+// Poll a frame submitted without a completion callback
+// Returns AT86RF212_RES_OK while pending, then the completion result once (releasing the handle).
+int at86rf212_txq_status(struct at86rf212_txq_s *txq, int handle);
+
+// Number of frames queued or in flight
+uint32_t at86rf212_txq_depth(struct at86rf212_txq_s *txq);
+
+// Latency percentile for a class in microseconds (upper bound of the histogram bucket)
+uint32_t at86rf212_txq_latency_percentile(struct at86rf212_txq_s *txq, uint8_t tx_class, uint8_t percent);
+
+// Completed frame bytes per second across all classes
+uint32_t at86rf212_txq_throughput(struct at86rf212_txq_s *txq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -13,38 +13,33 @@
 
 #include "at86rf212/at86rf212_regs.h"
 
-//#define DEBUG_AT86RF212
-
-// Automagically define PLATFORM_SLEEP_MS and _US on unix-like platforms
-#ifndef PLATFORM_SLEEP_MS
-#if (defined __linux__ || defined __APPLE__ || defined __unix__)
-#include <unistd.h>
-#define PLATFORM_SLEEP_MS(a)    usleep(a * 1000);
-#define PLATFORM_SLEEP_US(a)    usleep(a);
-#else
-#warning "PLATFORM_SLEEP_MS undefined and platform not recognised"
-#define PLATFORM_SLEEP_MS(a) for (volatile uint32_t i = 0; i < 1000000; i++);
-#define PLATFORM_SLEEP_US(a) for (volatile uint32_t i = 0; i < 1000; i++);
-#endif
-
-#else
-extern void PLATFORM_SLEEP_MS(uint32_t);
-extern void PLATFORM_SLEEP_US(uint32_t);
-#endif
-
-// Wrap debug outputs
-#ifdef DEBUG_AT86RF212
-#include <stdio.h>
-#define AT86RF212_DEBUG_PRINT(...) printf(__VA_ARGS__)
-#else
-#define AT86RF212_DEBUG_PRINT(...)
-#endif
+#include "at86rf212_platform.h"
 
 #define AT86RF212_MAX_RETRIES       1000
 
 
 /***        Internal Functions          ***/
 
+// Harvest random bits from a PHY_RSSI value
+// The status byte of every transfer carries PHY_RSSI (see AT86RF212_DEFAULT_SPI_CMD_MODE),
+// so while the receiver is on each bus transaction adds to the random pool for free.
+void at86rf212_harvest_rnd(struct at86rf212_s *device, uint8_t phy_rssi, uint32_t *counter)
+{
+    if (device->rx_on == 0) {
+        return;
+    }
+
+    if (device->rnd_bits > (sizeof(device->rnd_pool) * 8 - 2)) {
+        device->rnd_stats.bits_discarded += 2;
+        return;
+    }
+
+    device->rnd_pool = (device->rnd_pool << 2)
+                       | ((phy_rssi & AT86RF212_PHY_RSSI_RND_VALUE_MASK) >> AT86RF212_PHY_RSSI_RND_VALUE_SHIFT);
+    device->rnd_bits += 2;
+    *counter += 2;
+}
+
 // Read a single register from the device
 int at86rf212_read_reg(struct at86rf212_s *device, uint8_t reg, uint8_t* val)
 {
@@ -55,10 +50,11 @@ int at86rf212_read_reg(struct at86rf212_s *device, uint8_t reg, uint8_t* val)
     data_out[0] = reg | AT86RF212_REG_READ_FLAG;
     data_out[1] = 0x00;
 
-    res = device->driver->spi_transfer(device->driver_ctx, 2, data_out, data_in);
+    res = AT86RF212_SPI_TRANSFER(device, 2, data_out, data_in);
 
     if (res >= 0) {
         *val = data_in[1];
+        at86rf212_harvest_rnd(device, data_in[0], &device->rnd_stats.bits_harvested);
     }
 
     return res;
@@ -75,7 +71,11 @@ int at86rf212_write_reg(struct at86rf212_s *device, uint8_t reg, uint8_t val)
     data_out[0] = reg | AT86RF212_REG_WRITE_FLAG;
     data_out[1] = val;
 
-    res = device->driver->spi_transfer(device->driver_ctx, 2, data_out, data_in);
+    res = AT86RF212_SPI_TRANSFER(device, 2, data_out, data_in);
+
+    if (res >= 0) {
+        at86rf212_harvest_rnd(device, data_in[0], &device->rnd_stats.bits_harvested);
+    }
 
     return res;
 }
@@ -101,6 +101,24 @@ int at86rf212_update_reg(struct at86rf212_s *device, uint8_t reg, uint8_t mask,
     return at86rf212_write_reg(device, reg, data);
 }
 
+int at86rf212_update_regs(struct at86rf212_s *device, uint8_t count, const struct at86rf212_reg_update_s *updates)
+{
+    int res;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (updates[i].mask == 0xFF) {
+            res = at86rf212_write_reg(device, updates[i].reg, updates[i].value);
+        } else {
+            res = at86rf212_update_reg(device, updates[i].reg, updates[i].mask, updates[i].value);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    return AT86RF212_RES_OK;
+}
+
 // Write a subregister on the device
 // Implemented for compatibility with atmel supplied subregister headers (if you want to use those)
 int at86rf212_write_subreg(struct at86rf212_s *device, uint8_t reg, uint8_t mask, uint8_t shift, uint8_t val)
@@ -120,12 +138,13 @@ static int at86rf212_read_frame(struct at86rf212_s *device, uint8_t length, uint
         data_out[i + 1] = 0x00;
     }
 
-    res = device->driver->spi_transfer(device->driver_ctx, length + 1, data_out, data_in);
+    res = AT86RF212_SPI_TRANSFER(device, length + 1, data_out, data_in);
 
     if (res >= 0) {
         for (int i = 0; i < length; i++) {
             data[i] = data_in[i + 1];
         }
+        at86rf212_harvest_rnd(device, data_in[0], &device->rnd_stats.bits_harvested);
     }
 
     return res;
@@ -142,16 +161,163 @@ static int at86rf212_write_frame(struct at86rf212_s *device, uint8_t length, uin
         data_out[i + 1] = data[i];
     }
 
-    return device->driver->spi_transfer(device->driver_ctx, length + 1, data_out, data_in);
+    int res = AT86RF212_SPI_TRANSFER(device, length + 1, data_out, data_in);
+
+    if (res >= 0) {
+        at86rf212_harvest_rnd(device, data_in[0], &device->rnd_stats.bits_harvested);
+    }
+
+    return res;
+}
+
+// Read from the frame buffer SRAM, also returning the SPI status byte (PHY_RSSI)
+static int at86rf212_read_sram_status(struct at86rf212_s *device, uint8_t addr, uint8_t length, uint8_t* data, uint8_t* status)
+{
+    uint8_t data_out[length + 2];
+    uint8_t data_in[length + 2];
+    int res;
+
+    if ((addr + length) > AT86RF212_SRAM_SIZE) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    data_out[0] = AT86RF212_SRAM_READ_FLAG;
+    data_out[1] = addr;
+    for (int i = 0; i < length; i++) {
+        data_out[i + 2] = 0x00;
+    }
+
+    res = AT86RF212_SPI_TRANSFER(device, length + 2, data_out, data_in);
+
+    if (res >= 0) {
+        for (int i = 0; i < length; i++) {
+            data[i] = data_in[i + 2];
+        }
+        *status = data_in[0];
+        at86rf212_harvest_rnd(device, data_in[0], &device->rnd_stats.bits_harvested);
+    }
+
+    return res;
+}
+
+int at86rf212_read_sram(struct at86rf212_s *device, uint8_t addr, uint8_t length, uint8_t* data)
+{
+    uint8_t status;
+
+    return at86rf212_read_sram_status(device, addr, length, data, &status);
+}
+
+int at86rf212_write_sram(struct at86rf212_s *device, uint8_t addr, uint8_t length, uint8_t* data)
+{
+    uint8_t data_out[length + 2];
+    uint8_t data_in[length + 2];
+    int res;
+
+    if ((addr + length) > AT86RF212_SRAM_SIZE) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    data_out[0] = AT86RF212_SRAM_WRITE_FLAG;
+    data_out[1] = addr;
+    for (int i = 0; i < length; i++) {
+        data_out[i + 2] = data[i];
+    }
+
+    res = AT86RF212_SPI_TRANSFER(device, length + 2, data_out, data_in);
+
+    if (res >= 0) {
+        at86rf212_harvest_rnd(device, data_in[0], &device->rnd_stats.bits_harvested);
+    }
+
+    return res;
 }
 
 /***        External Functions          ***/
 
+static const struct at86rf212_config_s at86rf212_config_default = AT86RF212_CONFIG_DEFAULT;
+
+// Power on reset values of the registers written by configuration programs
+static const uint8_t at86rf212_por_values[AT86RF212_REG_COUNT] = {
+    [AT86RF212_REG_TRX_CTRL_1] = 0x20,
+    [AT86RF212_REG_PHY_TX_PWR] = 0x60,
+    [AT86RF212_REG_PHY_CC_CCA] = 0x21,
+    [AT86RF212_REG_TRX_CTRL_2] = 0x24,
+    [AT86RF212_REG_IRQ_MASK] = 0x00,
+    [AT86RF212_REG_XAH_CTRL_1] = 0x00,
+    [AT86RF212_REG_SHORT_ADDR_0] = 0xFF,
+    [AT86RF212_REG_SHORT_ADDR_1] = 0xFF,
+    [AT86RF212_REG_PAN_ID_0] = 0xFF,
+    [AT86RF212_REG_PAN_ID_1] = 0xFF,
+    [AT86RF212_REG_XAH_CTRL_0] = 0x38,
+    [AT86RF212_REG_CSMA_BE] = 0x53,
+};
+
+uint8_t at86rf212_config_program(const struct at86rf212_config_s *config, struct at86rf212_reg_update_s *program)
+{
+    // Settings in write order
+    // The SPI status byte mode is set first so every later transfer harvests random bits, PHY mode
+    // before the channel and power settings that depend on it, and interrupts are unmasked last.
+    const struct at86rf212_reg_update_s settings[AT86RF212_CONFIG_PROGRAM_MAX] = {
+        // Auto CRC for TX
+        // IRQ_MASK_MODE, enabled interrupts cause IRQ assert, all interrupts can be read from IRQ_STATUS
+        // PHY_RSSI as the status byte of each SPI transfer, this provides RX_CRC_VALID and random bits
+        // without additional register reads
+        AT86RF212_UPDATE3(TRX_CTRL1_TX_AUTO_CRC_ON, 1,
+                          TRX_CTRL1_IRQ_MASK_MODE, 1,
+                          TRX_CTRL1_SPI_CMD_MODE, AT86RF212_DEFAULT_SPI_CMD_MODE),
+        // PHY mode, with dynamic frame buffer protection
+        AT86RF212_UPDATE2(TRX_CTRL2_PHY_MODE, config->phy_mode,
+                          TRX_CTRL2_RX_SAFE_MODE, 1),
+        // Channel and Clear Channel Assessment (CCA) mode
+        AT86RF212_UPDATE2(PHY_CC_CCA_CHANNEL, config->channel,
+                          PHY_CC_CCA_CCA_MODE, config->cca_mode),
+        {AT86RF212_REG_PHY_TX_PWR, 0xFF, config->tx_power},
+        // CSMA-CA binary exponentials and retries
+        AT86RF212_UPDATE2(CSMA_BE_MIN, config->min_be,
+                          CSMA_BE_MAX, config->max_be),
+        AT86RF212_UPDATE2(XAH_CTRL_MAX_CSMA_RETRIES, config->max_csma_backoffs,
+                          XAH_CTRL_MAX_FRAME_RETRIES, config->max_frame_retries),
+        // Promiscuous mode Auto Ack
+        AT86RF212_UPDATE1(XAH_CTRL_1_AACK_PROM_MODE, config->promiscuous ? 1 : 0),
+        // Addressing
+        {AT86RF212_REG_SHORT_ADDR_0, 0xFF, config->short_address & 0xFF},
+        {AT86RF212_REG_SHORT_ADDR_1, 0xFF, config->short_address >> 8},
+        {AT86RF212_REG_PAN_ID_0, 0xFF, config->pan_id & 0xFF},
+        {AT86RF212_REG_PAN_ID_1, 0xFF, config->pan_id >> 8},
+        // Interrupt sources
+        {AT86RF212_REG_IRQ_MASK, 0xFF, config->irq_mask},
+    };
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < AT86RF212_CONFIG_PROGRAM_MAX; i++) {
+        uint8_t por = at86rf212_por_values[settings[i].reg];
+        uint8_t val = (por & ~settings[i].mask) | (settings[i].value & settings[i].mask);
+
+        if (val != por) {
+            program[count].reg = settings[i].reg;
+            program[count].mask = 0xFF;
+            program[count].value = val;
+            count ++;
+        }
+    }
+
+    return count;
+}
+
 int at86rf212_init(struct at86rf212_s *device, struct at86rf212_driver_s *driver, void* driver_ctx)
+{
+    return at86rf212_init_config(device, driver, driver_ctx, &at86rf212_config_default);
+}
+
+int at86rf212_init_config(struct at86rf212_s *device, struct at86rf212_driver_s *driver, void* driver_ctx,
+                          const struct at86rf212_config_s *config)
 {
     int res;
     uint8_t val;
+    uint8_t count;
+    struct at86rf212_reg_update_s program[AT86RF212_CONFIG_PROGRAM_MAX];
 
+#ifndef AT86RF212_STATIC_DRIVER
     // Check driver functions exist
     if (driver->spi_transfer == NULL) {
         return AT86RF212_DRIVER_INVALID;
@@ -165,17 +331,38 @@ int at86rf212_init(struct at86rf212_s *device, struct at86rf212_driver_s *driver
     // Save driver pointers
     device->driver = driver;
     device->driver_ctx = driver_ctx;
+    device->get_time_us = NULL;
+    device->time_ctx = NULL;
+    device->get_irq_fd = NULL;
+    device->irq_fd_ctx = NULL;
+#else
+    // Driver functions are bound at compile time
+    (void)driver;
+    (void)driver_ctx;
+#endif
+
+    device->phy_mode = config->phy_mode;
+    device->rx_end_pending = 0;
+    device->rx_end_time = 0;
+
+    // Reset random pool
+    device->rx_on = 0;
+    device->rx_on_requested = 0;
+    device->csma_seeded = 0;
+    device->rnd_bits = 0;
+    device->rnd_pool = 0;
+    memset(&device->rnd_stats, 0, sizeof(device->rnd_stats));
 
     // Initialize device
 
     // Set pins
-    device->driver->set_reset(device->driver_ctx, 1);
-    device->driver->set_slp_tr(device->driver_ctx, 0);
+    AT86RF212_SET_RESET(device, 1);
+    AT86RF212_SET_SLP_TR(device, 0);
 
     // Send reset pulse
-    device->driver->set_reset(device->driver_ctx, 0);
+    AT86RF212_SET_RESET(device, 0);
     PLATFORM_SLEEP_MS(1);
-    device->driver->set_reset(device->driver_ctx, 1);
+    AT86RF212_SET_RESET(device, 1);
 
     // Give device time to reset
     PLATFORM_SLEEP_MS(10);
@@ -196,8 +383,6 @@ int at86rf212_init(struct at86rf212_s *device, struct at86rf212_driver_s *driver
 
     //AT86RF212_DEBUG_PRINT("Device identified\r\n");
 
-    // TODO: Configure
-
     // Disable TRX
     res = at86rf212_set_state_blocking(device, AT86RF212_CMD_TRX_OFF);
     if (res < 0) {
@@ -212,92 +397,14 @@ int at86rf212_init(struct at86rf212_s *device, struct at86rf212_driver_s *driver
         return AT86RF212_ERROR_DVDD;
     }
 
-    // Set channel
-    res = at86rf212_set_channel(device, AT86RF212_DEFAULT_CHANNEL);
-    if (res < 0) {
-        AT86RF212_DEBUG_PRINT("Channel set error: %d\r\n", res);
-        return AT86RF212_ERROR_DRIVER;
-    }
-
-    // Set Clear Channel Assessment (CCA) mode
-    res = at86rf212_update_reg(device, AT86RF212_REG_PHY_CC_CCA,
-                               AT86RF212_PHY_CC_CCA_CCA_MODE_MASK,
-                               AT86RF212_DEFAULT_CCA_MODE << AT86RF212_PHY_CC_CCA_CCA_MODE_SHIFT);
-    if (res < 0) {
-        AT86RF212_DEBUG_PRINT("CCA mode set error: %d\r\n", res);
-        return AT86RF212_ERROR_DRIVER;
-    }
-
-    // Enable CSMA-CA
-    // Set Binary Exponentials
-    res = at86rf212_write_reg(device, AT86RF212_REG_CSMA_BE,
-                              (AT86RF212_DEFAULT_MINBE << AT86RF212_CSMA_BE_MIN_SHIFT)
-                              | (AT86RF212_DEFAULT_MAXBE << AT86RF212_CSMA_BE_MAX_SHIFT));
+    // Apply configuration, the registers still hold their reset values so each is a single write
+    count = at86rf212_config_program(config, program);
+    res = at86rf212_update_regs(device, count, program);
     if (res < 0) {
-        AT86RF212_DEBUG_PRINT("CSMA exponential set error: %d\r\n", res);
+        AT86RF212_DEBUG_PRINT("Configuration error: %d\r\n", res);
         return AT86RF212_ERROR_DRIVER;
     }
 
-    // Set max CSMA backoffs
-    res = at86rf212_update_reg(device, AT86RF212_REG_XAH_CTRL_0,
-                               AT86RF212_XAH_CTRL_MAX_CSMA_RETRIES_MASK,
-                               AT86RF212_DEFAULT_MAX_CSMA_BACKOFFS << AT86RF212_XAH_CTRL_MAX_CSMA_RETRIES_SHIFT);
-    if (res < 0) {
-        AT86RF212_DEBUG_PRINT("CSMA max backoff set error: %d\r\n", res);
-        return AT86RF212_ERROR_DRIVER;
-    }
-
-    // Enable promiscuous mode Auto Ack
-    res = at86rf212_update_reg(device, AT86RF212_REG_XAH_CTRL_1,
-                               AT86RF212_XAH_CTRL_1_AACK_PROM_MODE_MASK,
-                               1 << AT86RF212_XAH_CTRL_1_AACK_PROM_MODE_SHIFT);
-    if (res < 0) {
-        AT86RF212_DEBUG_PRINT("Promiscuous mode set error: %d\r\n", res);
-        return AT86RF212_ERROR_DRIVER;
-    }
-
-    // Enable auto CRC for TX
-    res = at86rf212_update_reg(device, AT86RF212_REG_TRX_CTRL_1,
-                               AT86RF212_TRX_CTRL1_TX_AUTO_CRC_ON_MASK,
-                               1 << AT86RF212_TRX_CTRL1_TX_AUTO_CRC_ON_SHIFT);
-    if (res < 0) {
-        AT86RF212_DEBUG_PRINT("Auto CRC set error: %d\r\n", res);
-        return AT86RF212_ERROR_DRIVER;
-    }
-
-    // Set IRQ_MASK_MODE to 1
-    // This means enabled interrupts will cause IRQ assert, all interrupts
-    // can be read from IRQ_STATUS
-    res = at86rf212_update_reg(device, AT86RF212_REG_TRX_CTRL_1,
-                               AT86RF212_TRX_CTRL1_IRQ_MASK_MODE_MASK,
-                               1 << AT86RF212_TRX_CTRL1_IRQ_MASK_MODE_SHIFT);
-    if (res < 0) {
-        AT86RF212_DEBUG_PRINT("IRQ mask set error: %d\r\n", res);
-        return AT86RF212_ERROR_DRIVER;
-    }
-
-    // Enable dynamic frame buffer protection
-    res = at86rf212_update_reg(device, AT86RF212_REG_TRX_CTRL_2,
-                               AT86RF212_TRX_CTRL2_RX_SAFE_MODE_MASK,
-                               1 << AT86RF212_TRX_CTRL2_RX_SAFE_MODE_SHIFT);
-    if (res < 0) {
-        AT86RF212_DEBUG_PRINT("frame buffer protection set error: %d\r\n", res);
-        return AT86RF212_ERROR_DRIVER;
-    }
-
-    // Enable interrupt pin
-    res = at86rf212_set_irq_mask(device, AT86RF212_IRQ_2_RX_START | AT86RF212_IRQ_3_TRX_END);
-    if (res < 0) {
-        AT86RF212_DEBUG_PRINT("error: %d enabling interrupts\r\n", res);
-        return AT86RF212_ERROR_DRIVER;
-    }
-
-    //res = at86rf212_set_short_address(device, 0xcafe);
-
-    //res = at86rf212_set_pan_id(device, 0x0100);
-
-    res = at86rf212_set_power_raw(device, 0xC0);
-
     device->open = 1;
 
     return AT86RF212_RES_OK;
@@ -307,17 +414,85 @@ int at86rf212_close(struct at86rf212_s *device)
 {
     // TODO: shutdown
 
+#ifndef AT86RF212_STATIC_DRIVER
     // Clear driver pointer
     device->driver = NULL;
     device->driver_ctx = NULL;
+    device->get_time_us = NULL;
+    device->time_ctx = NULL;
+    device->get_irq_fd = NULL;
+    device->irq_fd_ctx = NULL;
+#endif
 
     device->open = 0;
 
     return AT86RF212_RES_OK;
 }
 
+int at86rf212_set_time_source(struct at86rf212_s *device, time_get_f get_time_us, void* context)
+{
+#ifndef AT86RF212_STATIC_DRIVER
+    device->get_time_us = get_time_us;
+    device->time_ctx = context;
+
+    return AT86RF212_RES_OK;
+#else
+    // Bound at compile time with AT86RF212_STATIC_DRIVER_TIME
+    (void)device;
+    (void)get_time_us;
+    (void)context;
+
+    return AT86RF212_DRIVER_INVALID;
+#endif
+}
+
+int at86rf212_set_irq_fd_source(struct at86rf212_s *device, fd_get_f get_irq_fd, void* context)
+{
+#ifndef AT86RF212_STATIC_DRIVER
+    device->get_irq_fd = get_irq_fd;
+    device->irq_fd_ctx = context;
+
+    return AT86RF212_RES_OK;
+#else
+    // Bound at compile time with AT86RF212_STATIC_DRIVER_IRQ_FD
+    (void)device;
+    (void)get_irq_fd;
+    (void)context;
+
+    return AT86RF212_DRIVER_INVALID;
+#endif
+}
+
+// Track whether the receiver is on, random bits are only valid while listening
+// A receive command only counts once TRX_STATUS confirms it (at86rf212_confirm_state)
+void at86rf212_track_state(struct at86rf212_s *device, uint8_t state)
+{
+    device->rx_on = 0;
+    device->rx_on_requested = ((state == AT86RF212_CMD_RX_ON) || (state == AT86RF212_CMD_RX_AACK_ON)) ? 1 : 0;
+}
+
+// Update the receiver state from a TRX_STATUS value
+void at86rf212_confirm_state(struct at86rf212_s *device, uint8_t status)
+{
+    switch (status & AT86RF212_TRX_STATUS_TRX_STATUS_MASK) {
+    case AT86RF212_RX_ON:
+    case AT86RF212_BUSY_RX:
+    case AT86RF212_RX_AACK_ON:
+    case AT86RF212_BUSY_RX_AACK:
+        device->rx_on = device->rx_on_requested;
+        break;
+    case AT86RF212_STATE_TRANSITION_IN_PROGRESS:
+        break;
+    default:
+        device->rx_on = 0;
+        break;
+    }
+}
+
 int at86rf212_set_state(struct at86rf212_s *device, uint8_t state)
 {
+    at86rf212_track_state(device, state);
+
     return at86rf212_update_reg(device, AT86RF212_REG_TRX_STATE, AT86RF212_TRX_STATE_TRX_CMD_MASK, state);
 }
 
@@ -325,6 +500,9 @@ int at86rf212_set_state_blocking(struct at86rf212_s *device, uint8_t state)
 {
     int res;
     int count = 0;
+    uint8_t status;
+
+    at86rf212_track_state(device, state);
 
     // Enable PLL
     res = at86rf212_update_reg(device, AT86RF212_REG_TRX_STATE, AT86RF212_TRX_STATE_TRX_CMD_MASK, state);
@@ -333,13 +511,18 @@ int at86rf212_set_state_blocking(struct at86rf212_s *device, uint8_t state)
     }
 
     // Block while state change occurs
-    while ((state & AT86RF212_TRX_STATUS_TRX_STATUS_MASK) == AT86RF212_STATE_TRANSITION_IN_PROGRESS) {
-        res = at86rf212_read_reg(device, AT86RF212_REG_TRX_STATE, &state);
+    do {
+        res = at86rf212_read_reg(device, AT86RF212_REG_TRX_STATUS, &status);
+        if (res < 0) {
+            return res;
+        }
         count ++;
         if (count > AT86RF212_MAX_RETRIES) {
             return AT86RF212_ERROR_RETRIES;
         }
-    }
+    } while ((status & AT86RF212_TRX_STATUS_TRX_STATUS_MASK) == AT86RF212_STATE_TRANSITION_IN_PROGRESS);
+
+    at86rf212_confirm_state(device, status);
 
     return AT86RF212_RES_OK;
 }
@@ -361,16 +544,15 @@ int at86rf212_get_state(struct at86rf212_s *device, uint8_t *state)
 int at86rf212_set_channel(struct at86rf212_s *device, uint8_t channel)
 {
     return at86rf212_update_reg(device, AT86RF212_REG_PHY_CC_CCA,
-                                AT86RF212_PHY_CC_CCA_CHANNEL_MASK,
-                                channel << AT86RF212_PHY_CC_CCA_CHANNEL_SHIFT);
+                                AT86RF212_FIELD_MASK(PHY_CC_CCA_CHANNEL),
+                                AT86RF212_FIELD_VAL(PHY_CC_CCA_CHANNEL, channel));
 }
 
 int at86rf212_get_channel(struct at86rf212_s *device, uint8_t *channel)
 {
     int res = at86rf212_read_reg(device, AT86RF212_REG_PHY_CC_CCA, channel);
 
-    *channel = (*channel >> AT86RF212_PHY_CC_CCA_CHANNEL_SHIFT)
-               & AT86RF212_PHY_CC_CCA_CHANNEL_MASK;
+    *channel = AT86RF212_FIELD_GET(PHY_CC_CCA_CHANNEL, *channel);
 
     return res;
 }
@@ -385,11 +567,140 @@ int at86rf212_get_irq_status(struct at86rf212_s *device, uint8_t *status)
     return at86rf212_read_reg(device, AT86RF212_REG_IRQ_STATUS, status);
 }
 
+int at86rf212_get_irq_fd(struct at86rf212_s *device, int *fd)
+{
+    if (!AT86RF212_HAS_IRQ_FD(device)) {
+        return AT86RF212_DRIVER_INVALID;
+    }
+
+    return AT86RF212_GET_IRQ_FD(device, fd);
+}
+
+int at86rf212_cca(struct at86rf212_s *device, uint8_t *clear)
+{
+    int res;
+    uint8_t status = 0;
+
+    // Request CCA measurement
+    res = at86rf212_update_reg(device, AT86RF212_REG_PHY_CC_CCA,
+                               AT86RF212_PHY_CC_CCA_CCA_REQ_MASK,
+                               1 << AT86RF212_PHY_CC_CCA_CCA_REQ_SHIFT);
+    if (res < 0) {
+        return res;
+    }
+
+    // Await completion (8 symbol periods)
+    for (int i = 0; i < AT86RF212_MAX_RETRIES; i++) {
+        res = at86rf212_read_reg(device, AT86RF212_REG_TRX_STATUS, &status);
+        if (res < 0) {
+            return res;
+        }
+        at86rf212_confirm_state(device, status);
+        if ((status & AT86RF212_TRX_STATUS_CCA_DONE_MASK) != 0) {
+            *clear = (status & AT86RF212_TRX_STATUS_CCA_STATUS_MASK) >> AT86RF212_TRX_STATUS_CCA_STATUS_SHIFT;
+            return AT86RF212_RES_OK;
+        }
+    }
+
+    return AT86RF212_ERROR_RETRIES;
+}
+
+int at86rf212_get_rnd_bits(struct at86rf212_s *device, uint8_t *bits)
+{
+    int res;
+    uint8_t val;
+
+    res = at86rf212_read_reg(device, AT86RF212_REG_PHY_RSSI, &val);
+    if (res < 0) {
+        return res;
+    }
+
+    *bits = (val & AT86RF212_PHY_RSSI_RND_VALUE_MASK) >> AT86RF212_PHY_RSSI_RND_VALUE_SHIFT;
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_get_random(struct at86rf212_s *device, uint8_t *data, uint8_t length)
+{
+    int res;
+    uint8_t status;
+    uint8_t data_out[2] = {AT86RF212_REG_PHY_RSSI | AT86RF212_REG_READ_FLAG, 0x00};
+    uint8_t data_in[2];
+
+    // Receive state requested but not yet seen in TRX_STATUS
+    if ((device->rx_on == 0) && (device->rx_on_requested != 0)) {
+        res = at86rf212_read_reg(device, AT86RF212_REG_TRX_STATUS, &status);
+        if (res < 0) {
+            return res;
+        }
+        at86rf212_confirm_state(device, status);
+    }
+
+    for (int i = 0; i < length; i++) {
+
+        // Top up the pool from PHY_RSSI reads
+        // The status byte is sampled in the same transaction as the register, so only the register
+        // value is used, keeping each sample independent
+        while (device->rnd_bits < 8) {
+            if (device->rx_on == 0) {
+                return AT86RF212_ERROR_STATE;
+            }
+
+            res = AT86RF212_SPI_TRANSFER(device, 2, data_out, data_in);
+            if (res < 0) {
+                return res;
+            }
+            at86rf212_harvest_rnd(device, data_in[1], &device->rnd_stats.bits_fetched);
+            device->rnd_stats.fetch_bus_bytes += 2;
+        }
+
+        device->rnd_bits -= 8;
+        data[i] = (device->rnd_pool >> device->rnd_bits) & 0xFF;
+        device->rnd_stats.bytes_served ++;
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_seed_csma(struct at86rf212_s *device)
+{
+    int res;
+    uint8_t seed[2];
+
+    res = at86rf212_get_random(device, seed, sizeof(seed));
+    if (res < 0) {
+        return res;
+    }
+
+    res = at86rf212_write_reg(device, AT86RF212_REG_CSMA_SEED_0, seed[0]);
+    if (res < 0) {
+        return res;
+    }
+
+    res = at86rf212_update_reg(device, AT86RF212_REG_CSMA_SEED_1,
+                               AT86RF212_CSMA_SEED_1_CSMA_SEED_1_MASK,
+                               seed[1] << AT86RF212_CSMA_SEED_1_CSMA_SEED_1_SHIFT);
+    if (res < 0) {
+        return res;
+    }
+
+    device->csma_seeded = 1;
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_get_random_stats(struct at86rf212_s *device, struct at86rf212_random_stats_s *stats)
+{
+    *stats = device->rnd_stats;
+
+    return AT86RF212_RES_OK;
+}
+
 int at86rf212_set_cca_mode(struct at86rf212_s *device, uint8_t mode)
 {
     return at86rf212_update_reg(device, AT86RF212_REG_PHY_CC_CCA,
-                                AT86RF212_PHY_CC_CCA_CHANNEL_MASK,
-                                mode << AT86RF212_PHY_CC_CCA_CHANNEL_SHIFT);
+                                AT86RF212_FIELD_MASK(PHY_CC_CCA_CCA_MODE),
+                                AT86RF212_FIELD_VAL(PHY_CC_CCA_CCA_MODE, mode));
 }
 
 int at86rf212_set_short_address(struct at86rf212_s *device, uint16_t address)
@@ -431,6 +742,89 @@ int at86rf212_set_power_raw(struct at86rf212_s *device, uint8_t power)
                                 power << AT86RF212_PHY_TX_PWR_TX_PWR_SHIFT);
 }
 
+int at86rf212_set_phy_mode(struct at86rf212_s *device, uint8_t mode)
+{
+    int res;
+
+    res = at86rf212_update_reg(device, AT86RF212_REG_TRX_CTRL_2,
+                               AT86RF212_TRX_CTRL2_PHY_MODE_MASK,
+                               mode << AT86RF212_TRX_CTRL2_PHY_MODE_SHIFT);
+    if (res < 0) {
+        return res;
+    }
+
+    device->phy_mode = mode;
+
+    return AT86RF212_RES_OK;
+}
+
+uint32_t at86rf212_get_bit_rate(uint8_t mode)
+{
+    switch (mode) {
+    case AT86RF212_PHY_BPSK_20:
+        return 20000;
+    case AT86RF212_PHY_BPSK_40:
+        return 40000;
+    case AT86RF212_PHY_OQPSK_100:
+        return 100000;
+    case AT86RF212_PHY_OQPSK_200:
+        return 200000;
+    case AT86RF212_PHY_OQPSK_400:
+        return 400000;
+    case AT86RF212_PHY_OQPSK_250:
+        return 250000;
+    case AT86RF212_PHY_OQPSK_500:
+        return 500000;
+    case AT86RF212_PHY_OQPSK_1000:
+        return 1000000;
+    }
+
+    return 20000;
+}
+
+int8_t at86rf212_get_rssi_base(uint8_t mode)
+{
+    switch (mode) {
+    case AT86RF212_PHY_BPSK_20:
+        return -100;
+    case AT86RF212_PHY_BPSK_40:
+        return -99;
+    case AT86RF212_PHY_OQPSK_100:
+    case AT86RF212_PHY_OQPSK_200:
+    case AT86RF212_PHY_OQPSK_400:
+        return -98;
+    case AT86RF212_PHY_OQPSK_250:
+    case AT86RF212_PHY_OQPSK_500:
+    case AT86RF212_PHY_OQPSK_1000:
+        return -97;
+    }
+
+    return -100;
+}
+
+uint32_t at86rf212_airtime_us(uint8_t mode, uint8_t psdu_len)
+{
+    uint32_t header_rate;
+    uint32_t bit_rate = at86rf212_get_bit_rate(mode);
+
+    switch (mode) {
+    case AT86RF212_PHY_OQPSK_200:
+    case AT86RF212_PHY_OQPSK_400:
+        header_rate = at86rf212_get_bit_rate(AT86RF212_PHY_OQPSK_100);
+        break;
+    case AT86RF212_PHY_OQPSK_500:
+    case AT86RF212_PHY_OQPSK_1000:
+        header_rate = at86rf212_get_bit_rate(AT86RF212_PHY_OQPSK_250);
+        break;
+    default:
+        header_rate = bit_rate;
+        break;
+    }
+
+    return ((AT86RF212_SHR_LEN + AT86RF212_LEN_FIELD_LEN) * 8000000UL) / header_rate
+           + (psdu_len * 8000000UL) / bit_rate;
+}
+
 int at86rf212_start_rx(struct at86rf212_s *device)
 {
     int res;
@@ -438,6 +832,8 @@ int at86rf212_start_rx(struct at86rf212_s *device)
 
     // TODO: ensure PLL is enabled
 
+    device->rx_end_pending = 0;
+
     // Reset state
     res = at86rf212_set_state_blocking(device, AT86RF212_CMD_TRX_OFF);
     if (res < 0) {
@@ -483,26 +879,211 @@ int at86rf212_start_rx(struct at86rf212_s *device)
         return res;
     }
 
+    // Seed hardware CSMA from the radio's own random bits on first use, so nodes
+    // that power up together do not share backoff sequences
+    if (device->csma_seeded == 0) {
+        res = at86rf212_seed_csma(device);
+        if (res < 0) {
+            return res;
+        }
+    }
+
     return AT86RF212_RES_OK;
 }
 
+// Record the time of TRX_END for frame timestamps
+static void at86rf212_stamp_rx_end(struct at86rf212_s *device)
+{
+    if (AT86RF212_HAS_TIME(device)) {
+        AT86RF212_GET_TIME_US(device, &device->rx_end_time);
+    } else {
+        device->rx_end_time = 0;
+    }
+}
+
 int at86rf212_check_rx(struct at86rf212_s *device)
 {
     int res;
     uint8_t irq;
 
+    if (device->rx_end_pending != 0) {
+        return AT86RF212_RES_DONE;
+    }
+
+    res = at86rf212_read_reg(device, AT86RF212_REG_IRQ_STATUS, &irq);
+    if (res < 0) {
+        return AT86RF212_ERROR_DRIVER;
+    }
+
+    if ((irq & AT86RF212_IRQ_STATUS_IRQ_3_TRX_END_MASK) != 0) {
+        at86rf212_stamp_rx_end(device);
+        return AT86RF212_RES_DONE;
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_check_rx_start(struct at86rf212_s *device)
+{
+    int res;
+    uint8_t irq;
+
     res = at86rf212_read_reg(device, AT86RF212_REG_IRQ_STATUS, &irq);
     if (res < 0) {
         return AT86RF212_ERROR_DRIVER;
     }
 
+    // Reading IRQ_STATUS clears it, so remember TRX_END for check_rx
     if ((irq & AT86RF212_IRQ_STATUS_IRQ_3_TRX_END_MASK) != 0) {
+        at86rf212_stamp_rx_end(device);
+        device->rx_end_pending = 1;
+        return AT86RF212_RES_DONE;
+    }
+
+    if ((irq & AT86RF212_IRQ_STATUS_IRQ_2_RX_START_MASK) != 0) {
         return AT86RF212_RES_DONE;
     }
 
     return AT86RF212_RES_OK;
 }
 
+int at86rf212_get_rx_early(struct at86rf212_s *device, uint8_t* length, uint8_t* data)
+{
+    int res;
+    uint8_t frame_len;
+    uint8_t fetched = 0;
+    uint8_t stream_len;
+    uint32_t byte_time_us = 8000000 / at86rf212_get_bit_rate(device->phy_mode);
+    uint32_t start = 0;
+    uint32_t now = 0;
+    uint8_t has_time = AT86RF212_HAS_TIME(device);
+
+    // Timing starts when RX_START is observed, which is after the PHR was received
+    // so the estimate of bytes received is conservative
+    if (has_time) {
+        AT86RF212_GET_TIME_US(device, &start);
+    }
+
+    // PHR is available from RX_START
+    // Every failure releases the frame buffer, with RX_SAFE_MODE the radio otherwise stops receiving
+    res = at86rf212_read_sram(device, 0, AT86RF212_LEN_FIELD_LEN, &frame_len);
+    if (res < 0) {
+        at86rf212_discard_rx(device);
+        return AT86RF212_ERROR_DRIVER;
+    }
+    if (frame_len > AT86RF212_MAX_LENGTH) {
+        at86rf212_discard_rx(device);
+        return AT86RF212_ERROR_LEN;
+    }
+
+    // Stream the PSDU while it arrives, leaving the final chunk until TRX_END
+    stream_len = (frame_len > AT86RF212_EARLY_RX_CHUNK) ? frame_len - AT86RF212_EARLY_RX_CHUNK : 0;
+    while (fetched < stream_len) {
+        uint32_t arrived;
+
+        if (has_time) {
+            AT86RF212_GET_TIME_US(device, &now);
+            arrived = (now - start) / byte_time_us;
+            // Stay a byte behind the byte currently being received
+            arrived = (arrived > 0) ? arrived - 1 : 0;
+        } else {
+            PLATFORM_SLEEP_US(byte_time_us * AT86RF212_EARLY_RX_CHUNK);
+            arrived = fetched + AT86RF212_EARLY_RX_CHUNK;
+        }
+        if (arrived > stream_len) {
+            arrived = stream_len;
+        }
+
+        if ((arrived < (uint32_t)(fetched + AT86RF212_EARLY_RX_CHUNK)) && (arrived < stream_len)) {
+            continue;
+        }
+        if (arrived <= fetched) {
+            continue;
+        }
+
+        res = at86rf212_read_sram(device, AT86RF212_LEN_FIELD_LEN + fetched, arrived - fetched, data + fetched);
+        if (res < 0) {
+            at86rf212_discard_rx(device);
+            return AT86RF212_ERROR_DRIVER;
+        }
+        fetched = arrived;
+    }
+
+    // Await TRX_END
+    for (int i = 0; ; i++) {
+        res = at86rf212_check_rx(device);
+        if (res < 0) {
+            at86rf212_discard_rx(device);
+            return res;
+        }
+        if (res == AT86RF212_RES_DONE) {
+            break;
+        }
+
+        if (has_time) {
+            AT86RF212_GET_TIME_US(device, &now);
+            if ((now - start) > (2 * (frame_len + AT86RF212_EARLY_RX_CHUNK) * byte_time_us)) {
+                at86rf212_discard_rx(device);
+                return AT86RF212_ERROR_RETRIES;
+            }
+        } else {
+            PLATFORM_SLEEP_US(byte_time_us);
+            if (i > (2 * (frame_len + AT86RF212_EARLY_RX_CHUNK))) {
+                at86rf212_discard_rx(device);
+                return AT86RF212_ERROR_RETRIES;
+            }
+        }
+    }
+
+    return at86rf212_get_rx_remainder(device, frame_len, fetched, length, data);
+}
+
+int at86rf212_get_rx_remainder(struct at86rf212_s *device, uint8_t frame_len, uint8_t fetched,
+                               uint8_t* length, uint8_t* data)
+{
+    int res;
+    uint8_t status;
+    uint8_t ed;
+    uint8_t lqi_len;
+
+    device->rx_end_pending = 0;
+
+    if ((frame_len > AT86RF212_MAX_LENGTH) || (fetched > frame_len)) {
+        at86rf212_discard_rx(device);
+        return AT86RF212_ERROR_LEN;
+    }
+
+    // Fetch the remainder and LQI, the status byte carries RX_CRC_VALID
+    // LQI follows the PSDU in SRAM, except for maximum length frames where it does not fit
+    lqi_len = (AT86RF212_LEN_FIELD_LEN + frame_len < AT86RF212_SRAM_SIZE) ? 1 : 0;
+    res = at86rf212_read_sram_status(device, AT86RF212_LEN_FIELD_LEN + fetched,
+                                     frame_len - fetched + lqi_len, data + fetched, &status);
+    if (res < 0) {
+        at86rf212_discard_rx(device);
+        return AT86RF212_ERROR_DRIVER;
+    }
+    if (lqi_len == 0) {
+        data[frame_len] = 0;
+    }
+
+    res = at86rf212_read_reg(device, AT86RF212_REG_PHY_ED_LEVEL, &ed);
+    if (res < 0) {
+        return AT86RF212_ERROR_DRIVER;
+    }
+
+    // SRAM reads leave the frame buffer protected
+    res = at86rf212_discard_rx(device);
+    if (res < 0) {
+        return res;
+    }
+
+    data[frame_len + 1] = ed;
+    data[frame_len + 2] = status & AT86RF212_PHY_RSSI_RX_CRC_VALID_MASK;
+    *length = frame_len + AT86RF212_FRAME_RX_OVERHEAD;
+
+    return AT86RF212_RES_OK;
+}
+
 int at86rf212_get_rx(struct at86rf212_s *device, uint8_t* length, uint8_t* data)
 {
     int res;
@@ -511,6 +1092,8 @@ int at86rf212_get_rx(struct at86rf212_s *device, uint8_t* length, uint8_t* data)
     // Check CRC
     // AT86RF212_REG_PHY_RSSI & 0x80 != 0
 
+    device->rx_end_pending = 0;
+
     // Fetch frame length
     uint8_t frame_len;
     res = at86rf212_read_frame(device, AT86RF212_LEN_FIELD_LEN, &frame_len);
@@ -539,12 +1122,77 @@ int at86rf212_get_rx(struct at86rf212_s *device, uint8_t* length, uint8_t* data)
     return res;
 }
 
-int at86rf212_start_tx(struct at86rf212_s *device, uint8_t length, uint8_t* data)
+int at86rf212_discard_rx(struct at86rf212_s *device)
 {
+    uint8_t frame_len;
     int res;
-    uint8_t irq;
 
-    uint8_t send_data[AT86RF212_MAX_LENGTH];
+    device->rx_end_pending = 0;
+
+    res = at86rf212_read_frame(device, AT86RF212_LEN_FIELD_LEN, &frame_len);
+    if (res < 0) {
+        return AT86RF212_ERROR_DRIVER;
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_get_rx_frame(struct at86rf212_s *device, struct at86rf212_rx_frame_s *frame,
+                           uint8_t *buffer, uint8_t accept_bad_crc)
+{
+    int res;
+    uint8_t data_out[AT86RF212_RX_BUFFER_LEN] = {0};
+    uint8_t phr_in[1 + AT86RF212_LEN_FIELD_LEN];
+    uint8_t frame_len;
+    uint8_t crc_valid;
+
+    device->rx_end_pending = 0;
+
+    // Fetch frame length, the status byte carries RX_CRC_VALID
+    data_out[0] = AT86RF212_FRAME_READ_FLAG;
+    res = AT86RF212_SPI_TRANSFER(device, sizeof(phr_in), data_out, phr_in);
+    if (res < 0) {
+        return AT86RF212_ERROR_DRIVER;
+    }
+    at86rf212_harvest_rnd(device, phr_in[0], &device->rnd_stats.bits_harvested);
+
+    frame_len = phr_in[1];
+    crc_valid = (phr_in[0] & AT86RF212_PHY_RSSI_RX_CRC_VALID_MASK) != 0;
+
+    if (frame_len > AT86RF212_MAX_LENGTH) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    frame->length = frame_len;
+    frame->crc_valid = crc_valid;
+    frame->timestamp = device->rx_end_time;
+
+    if ((crc_valid == 0) && (accept_bad_crc == 0)) {
+        return AT86RF212_RES_REJECTED;
+    }
+
+    // Read status, PHR, PSDU, LQI, ED and RX_STATUS directly into the caller buffer
+    res = AT86RF212_SPI_TRANSFER(device, 1 + AT86RF212_LEN_FIELD_LEN + frame_len + AT86RF212_FRAME_RX_OVERHEAD,
+                                       data_out, buffer);
+    if (res < 0) {
+        return AT86RF212_ERROR_DRIVER;
+    }
+    at86rf212_harvest_rnd(device, buffer[0], &device->rnd_stats.bits_harvested);
+
+    frame->payload = buffer + 1 + AT86RF212_LEN_FIELD_LEN;
+    frame->lqi = frame->payload[frame_len];
+    frame->ed = frame->payload[frame_len + 1];
+    frame->rx_status = frame->payload[frame_len + 2];
+    frame->crc_valid = (frame->rx_status & AT86RF212_RX_STATUS_CRC_VALID_MASK) != 0;
+
+    return AT86RF212_RES_OK;
+}
+
+// Move to PLL_ON with interrupts cleared, ready to upload and transmit a frame
+static int at86rf212_prepare_tx(struct at86rf212_s *device)
+{
+    int res;
+    uint8_t irq;
 
     // Reset state
     res = at86rf212_set_state_blocking(device, AT86RF212_CMD_TRX_OFF);
@@ -585,20 +1233,13 @@ int at86rf212_start_tx(struct at86rf212_s *device, uint8_t length, uint8_t* data
         return AT86RF212_ERROR_PLL;
     }
 
-    // Create data frame for writing
-    send_data[0] = length + AT86RF212_CRC_LEN;
-    for (int i = 0; i < length; i++) {
-        send_data[i + 1] = data[i];
-    }
-    send_data[length + 1] = 0x00;
-    send_data[length + 2] = 0x00;
+    return AT86RF212_RES_OK;
+}
 
-    // Write frame to device
-    // Note that data[0] must be length - AT86RF212_LEN_FIELD_LEN
-    res = at86rf212_write_frame(device, length + AT86RF212_LEN_FIELD_LEN + AT86RF212_CRC_LEN, send_data);
-    if (res < 0) {
-        return res;
-    }
+// Transmit the uploaded frame
+static int at86rf212_trigger_tx(struct at86rf212_s *device)
+{
+    int res;
 
 #if 0
     //TODO: not currently using auto ack mode
@@ -618,14 +1259,185 @@ int at86rf212_start_tx(struct at86rf212_s *device, uint8_t length, uint8_t* data
     }
 #else
     // Assert SLP_TR pin to trigger transmission
-    device->driver->set_slp_tr(device->driver_ctx, 1);
+    AT86RF212_SET_SLP_TR(device, 1);
     PLATFORM_SLEEP_MS(1);
-    device->driver->set_slp_tr(device->driver_ctx, 0);
+    AT86RF212_SET_SLP_TR(device, 0);
 #endif
 
     return AT86RF212_RES_OK;
 }
 
+// Upload a frame with its PHR and CRC placeholder
+static int at86rf212_upload_tx(struct at86rf212_s *device, uint8_t length, uint8_t* data)
+{
+    uint8_t send_data[AT86RF212_LEN_FIELD_LEN + AT86RF212_MAX_LENGTH];
+
+    // Create data frame for writing
+    send_data[0] = length + AT86RF212_CRC_LEN;
+    for (int i = 0; i < length; i++) {
+        send_data[i + 1] = data[i];
+    }
+    send_data[length + 1] = 0x00;
+    send_data[length + 2] = 0x00;
+
+    // Write frame to device
+    // Note that data[0] must be length - AT86RF212_LEN_FIELD_LEN
+    return at86rf212_write_frame(device, length + AT86RF212_LEN_FIELD_LEN + AT86RF212_CRC_LEN, send_data);
+}
+
+int at86rf212_load_tx(struct at86rf212_s *device, uint8_t length, uint8_t* data)
+{
+    int res;
+
+    if (length > (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    res = at86rf212_prepare_tx(device);
+    if (res < 0) {
+        return res;
+    }
+
+    return at86rf212_upload_tx(device, length, data);
+}
+
+int at86rf212_start_tx(struct at86rf212_s *device, uint8_t length, uint8_t* data)
+{
+    int res;
+
+    res = at86rf212_load_tx(device, length, data);
+    if (res < 0) {
+        return res;
+    }
+
+    return at86rf212_trigger_tx(device);
+}
+
+int at86rf212_start_tx_fast(struct at86rf212_s *device, uint8_t length, uint8_t* data)
+{
+    int res;
+    uint8_t status;
+    uint8_t irq;
+    uint8_t receiving = 0;
+
+    if (length > (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    // A received frame still in the buffer would be overwritten by the upload
+    if (device->rx_end_pending != 0) {
+        return AT86RF212_RES_REJECTED;
+    }
+
+    res = at86rf212_read_reg(device, AT86RF212_REG_TRX_STATUS, &status);
+    if (res < 0) {
+        return res;
+    }
+    at86rf212_confirm_state(device, status);
+    status &= AT86RF212_TRX_STATUS_TRX_STATUS_MASK;
+
+    if ((status == AT86RF212_RX_ON) || (status == AT86RF212_BUSY_RX)) {
+        // PLL remains locked moving from RX_ON to PLL_ON, a frame being received would be overwritten
+        at86rf212_track_state(device, AT86RF212_CMD_FORCE_PLL_ON);
+        res = at86rf212_write_reg(device, AT86RF212_REG_TRX_STATE, AT86RF212_CMD_FORCE_PLL_ON);
+        if (res < 0) {
+            return res;
+        }
+        receiving = 1;
+    } else if (status != AT86RF212_PLL_ON) {
+        return at86rf212_start_tx(device, length, data);
+    }
+
+    // Clear interrupts, so TRX_END is raised only by this transmission
+    res = at86rf212_get_irq_status(device, &irq);
+    if (res < 0) {
+        return res;
+    }
+
+    // A frame completed before the receiver was stopped, leave it for at86rf212_check_rx
+    if ((receiving != 0) && ((irq & AT86RF212_IRQ_STATUS_IRQ_3_TRX_END_MASK) != 0)) {
+        at86rf212_stamp_rx_end(device);
+        device->rx_end_pending = 1;
+        return AT86RF212_RES_REJECTED;
+    }
+
+    res = at86rf212_upload_tx(device, length, data);
+    if (res < 0) {
+        return res;
+    }
+
+    // TRAC_STATUS bits are read only so no read-modify-write is required
+    at86rf212_track_state(device, AT86RF212_CMD_TX_START);
+    return at86rf212_write_reg(device, AT86RF212_REG_TRX_STATE, AT86RF212_CMD_TX_START);
+}
+
+int at86rf212_start_tx_buffer(struct at86rf212_s *device, uint8_t length, uint8_t* buffer)
+{
+    int res;
+    uint8_t transfer_len = 1 + AT86RF212_LEN_FIELD_LEN + length + AT86RF212_CRC_LEN;
+    uint8_t data_in[1 + AT86RF212_LEN_FIELD_LEN + AT86RF212_MAX_LENGTH];
+
+    if (length > (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    res = at86rf212_prepare_tx(device);
+    if (res < 0) {
+        return res;
+    }
+
+    // Command, PHR and CRC placeholder are written around the frame, which is uploaded in place
+    buffer[0] = AT86RF212_FRAME_WRITE_FLAG;
+    buffer[1] = length + AT86RF212_CRC_LEN;
+    buffer[2 + length] = 0x00;
+    buffer[3 + length] = 0x00;
+
+    res = AT86RF212_SPI_TRANSFER(device, transfer_len, buffer, data_in);
+    if (res < 0) {
+        return res;
+    }
+    at86rf212_harvest_rnd(device, data_in[0], &device->rnd_stats.bits_harvested);
+
+    return at86rf212_trigger_tx(device);
+}
+
+int at86rf212_resend(struct at86rf212_s *device, uint8_t count, struct at86rf212_patch_s *patches)
+{
+    int res;
+    uint8_t status;
+
+    // Frame buffer contents are retained after transmission, so only the patched bytes are uploaded
+    for (int i = 0; i < count; i++) {
+        res = at86rf212_write_sram(device, patches[i].offset + AT86RF212_LEN_FIELD_LEN,
+                                   patches[i].length, patches[i].data);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    res = at86rf212_read_reg(device, AT86RF212_REG_TRX_STATUS, &status);
+    if (res < 0) {
+        return res;
+    }
+    at86rf212_confirm_state(device, status);
+    status &= AT86RF212_TRX_STATUS_TRX_STATUS_MASK;
+
+    if (status == AT86RF212_RX_ON) {
+        // PLL remains locked moving from RX_ON to PLL_ON
+        res = at86rf212_set_state_blocking(device, AT86RF212_CMD_PLL_ON);
+        if (res < 0) {
+            return res;
+        }
+    } else if (status != AT86RF212_PLL_ON) {
+        AT86RF212_DEBUG_PRINT("Resend requires PLL_ON (state: 0x%x)\r\n", status);
+        return AT86RF212_ERROR_STATE;
+    }
+
+    // Trigger transmission, TRAC_STATUS bits are read only so no read-modify-write is required
+    at86rf212_track_state(device, AT86RF212_CMD_TX_START);
+    return at86rf212_write_reg(device, AT86RF212_REG_TRX_STATE, AT86RF212_CMD_TX_START);
+}
+
 int at86rf212_check_tx(struct at86rf212_s *device)
 {
     int res;
@@ -634,7 +1446,7 @@ int at86rf212_check_tx(struct at86rf212_s *device)
 #if 0
     // TODO: if IRQ pin is enabled can poll or interrupt on this.
     // This code should however be in the application, not the driver
-    res = device->driver->get_irq(device->driver_ctx, &irq);
+    res = AT86RF212_GET_IRQ(device, &irq);
     if (res < 0) {
         return AT86RF212_ERROR_DRIVER;
     }
@@ -0,0 +1,152 @@
+/*
+ * at86rf212 small message aggregation
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_agg.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+void at86rf212_agg_default_config(struct at86rf212_agg_config_s *config)
+{
+    config->max_length = AT86RF212_AGG_MAX_PAYLOAD;
+    config->max_hold_us = 10000;
+}
+
+int at86rf212_agg_init(struct at86rf212_agg_s *agg, const struct at86rf212_agg_config_s *config,
+                       at86rf212_agg_send_f send, void* send_ctx)
+{
+    if ((config->max_length > AT86RF212_AGG_MAX_PAYLOAD)
+        || (config->max_length < (AT86RF212_AGG_HEADER_LEN + AT86RF212_AGG_SUB_HEADER_LEN + 1))) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    memset(agg, 0, sizeof(struct at86rf212_agg_s));
+
+    agg->config = *config;
+    agg->send = send;
+    agg->send_ctx = send_ctx;
+
+    return AT86RF212_RES_OK;
+}
+
+// No further message could fit
+static int at86rf212_agg_full(struct at86rf212_agg_s *agg)
+{
+    return (agg->length + AT86RF212_AGG_SUB_HEADER_LEN + 1) > agg->config.max_length;
+}
+
+int at86rf212_agg_flush(struct at86rf212_agg_s *agg)
+{
+    int res;
+
+    if (agg->count == 0) {
+        return AT86RF212_RES_OK;
+    }
+
+    res = agg->send(agg->send_ctx, agg->length, agg->buffer);
+    if (res < 0) {
+        return res;
+    }
+
+    agg->stats.messages += agg->count;
+    agg->stats.frames ++;
+    agg->stats.bytes += agg->length;
+
+    agg->length = 0;
+    agg->count = 0;
+
+    return AT86RF212_RES_DONE;
+}
+
+int at86rf212_agg_push(struct at86rf212_agg_s *agg, uint32_t now_us, uint8_t length, const uint8_t* data)
+{
+    int res = AT86RF212_RES_OK;
+
+    if ((length == 0)
+        || ((AT86RF212_AGG_HEADER_LEN + AT86RF212_AGG_SUB_HEADER_LEN + length) > agg->config.max_length)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    // Send the pending aggregate if the message does not fit
+    if ((agg->length + AT86RF212_AGG_SUB_HEADER_LEN + length) > agg->config.max_length) {
+        res = at86rf212_agg_flush(agg);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    if (agg->count == 0) {
+        agg->buffer[0] = AT86RF212_AGG_TYPE;
+        agg->length = AT86RF212_AGG_HEADER_LEN;
+        agg->first_time = now_us;
+    }
+
+    agg->buffer[agg->length] = length;
+    memcpy(&agg->buffer[agg->length + AT86RF212_AGG_SUB_HEADER_LEN], data, length);
+    agg->length += AT86RF212_AGG_SUB_HEADER_LEN + length;
+    agg->count ++;
+
+    // Send as soon as no further message could fit
+    // The message is buffered either way, if the send fails the aggregate is retried by the next poll
+    if (at86rf212_agg_full(agg) && (at86rf212_agg_flush(agg) == AT86RF212_RES_DONE)) {
+        return AT86RF212_RES_DONE;
+    }
+
+    return res;
+}
+
+int at86rf212_agg_poll(struct at86rf212_agg_s *agg, uint32_t now_us)
+{
+    int res;
+    int expired;
+
+    if (agg->count == 0) {
+        return AT86RF212_RES_OK;
+    }
+
+    // A full aggregate is only left buffered when sending it failed, so is retried immediately
+    expired = (now_us - agg->first_time) >= agg->config.max_hold_us;
+    if (!expired && !at86rf212_agg_full(agg)) {
+        return AT86RF212_RES_OK;
+    }
+
+    res = at86rf212_agg_flush(agg);
+    if ((res == AT86RF212_RES_DONE) && expired) {
+        agg->stats.timeouts ++;
+    }
+
+    return res;
+}
+
+int at86rf212_agg_next(uint8_t length, const uint8_t* data, uint8_t* offset,
+                       uint8_t* message_length, const uint8_t** message)
+{
+    uint8_t sub_length;
+
+    if ((length < AT86RF212_AGG_HEADER_LEN) || (data[0] != AT86RF212_AGG_TYPE)) {
+        return AT86RF212_RES_REJECTED;
+    }
+    if (*offset < AT86RF212_AGG_HEADER_LEN) {
+        *offset = AT86RF212_AGG_HEADER_LEN;
+    }
+    if (*offset >= length) {
+        return AT86RF212_RES_OK;
+    }
+
+    sub_length = data[*offset];
+    if ((sub_length == 0) || ((*offset + AT86RF212_AGG_SUB_HEADER_LEN + sub_length) > length)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    *message_length = sub_length;
+    *message = &data[*offset + AT86RF212_AGG_SUB_HEADER_LEN];
+    *offset += AT86RF212_AGG_SUB_HEADER_LEN + sub_length;
+
+    return AT86RF212_RES_DONE;
+}
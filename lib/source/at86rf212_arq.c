@@ -0,0 +1,352 @@
+/*
+ * at86rf212 reliable transfer layer
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_arq.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+#define AT86RF212_ARQ_BUFFER_MASK   (AT86RF212_ARQ_BUFFER_SIZE - 1)
+#define AT86RF212_ARQ_WINDOW_MASK   (AT86RF212_ARQ_MAX_WINDOW - 1)
+
+#if (AT86RF212_ARQ_BUFFER_SIZE & AT86RF212_ARQ_BUFFER_MASK) != 0
+#error "AT86RF212_ARQ_BUFFER_SIZE must be a power of two"
+#endif
+
+void at86rf212_arq_default_config(struct at86rf212_arq_config_s *config)
+{
+    config->window = 16;
+    config->segment_len = AT86RF212_ARQ_MAX_SEGMENT;
+    config->rto_initial_us = 500000;
+    config->rto_min_us = 1000;
+    config->rto_max_us = 4000000;
+}
+
+int at86rf212_arq_init(struct at86rf212_arq_s *arq, const struct at86rf212_arq_config_s *config,
+                       at86rf212_arq_send_f send, void* send_ctx)
+{
+    if ((config->window == 0) || (config->window > AT86RF212_ARQ_MAX_WINDOW)) {
+        return AT86RF212_ERROR_LEN;
+    }
+    if ((config->segment_len == 0) || (config->segment_len > AT86RF212_ARQ_MAX_SEGMENT)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    memset(arq, 0, sizeof(struct at86rf212_arq_s));
+
+    arq->config = *config;
+    arq->send = send;
+    arq->send_ctx = send_ctx;
+    arq->rto = config->rto_initial_us;
+
+    return AT86RF212_RES_OK;
+}
+
+uint32_t at86rf212_arq_write(struct at86rf212_arq_s *arq, const uint8_t* data, uint32_t length)
+{
+    uint32_t space = AT86RF212_ARQ_BUFFER_SIZE - (arq->tx_tail - arq->tx_head);
+
+    if (length > space) {
+        length = space;
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        arq->tx_buffer[(arq->tx_tail + i) & AT86RF212_ARQ_BUFFER_MASK] = data[i];
+    }
+    arq->tx_tail += length;
+
+    return length;
+}
+
+// Deliver in order segments from the reorder slots to the receive stream
+// Called whenever receive buffer space or a new segment may allow progress, returns 1 if any
+// segment was delivered.
+static int at86rf212_arq_deliver(struct at86rf212_arq_s *arq)
+{
+    int delivered = 0;
+
+    while (1) {
+        struct at86rf212_arq_slot_s *slot = &arq->slots[arq->rx_next & AT86RF212_ARQ_WINDOW_MASK];
+        uint32_t space = AT86RF212_ARQ_BUFFER_SIZE - (arq->rx_tail - arq->rx_head);
+
+        // Segments that do not fit remain buffered (and unacknowledged cumulatively)
+        if ((slot->valid == 0) || (slot->length > space)) {
+            return delivered;
+        }
+
+        for (int i = 0; i < slot->length; i++) {
+            arq->rx_buffer[(arq->rx_tail + i) & AT86RF212_ARQ_BUFFER_MASK] = slot->data[i];
+        }
+        arq->rx_tail += slot->length;
+        arq->stats.bytes_received += slot->length;
+        slot->valid = 0;
+        arq->rx_next ++;
+        delivered = 1;
+    }
+}
+
+uint32_t at86rf212_arq_read(struct at86rf212_arq_s *arq, uint8_t* data, uint32_t length)
+{
+    uint32_t available = arq->rx_tail - arq->rx_head;
+
+    if (length > available) {
+        length = available;
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        data[i] = arq->rx_buffer[(arq->rx_head + i) & AT86RF212_ARQ_BUFFER_MASK];
+    }
+    arq->rx_head += length;
+
+    // Segments held back by a full buffer, acknowledged so the peer stops retransmitting them
+    if (at86rf212_arq_deliver(arq)) {
+        arq->ack_pending = 1;
+    }
+
+    return length;
+}
+
+uint32_t at86rf212_arq_unacked(struct at86rf212_arq_s *arq)
+{
+    return arq->tx_tail - arq->tx_head;
+}
+
+// Update the round trip estimate (RFC 6298)
+static void at86rf212_arq_rtt_sample(struct at86rf212_arq_s *arq, uint32_t rtt)
+{
+    if (arq->srtt == 0) {
+        arq->srtt = rtt;
+        arq->rttvar = rtt / 2;
+    } else {
+        uint32_t err = (rtt > arq->srtt) ? (rtt - arq->srtt) : (arq->srtt - rtt);
+        arq->rttvar = (3 * arq->rttvar + err) / 4;
+        arq->srtt = (7 * arq->srtt + rtt) / 8;
+    }
+
+    arq->rto = arq->srtt + 4 * arq->rttvar;
+    if (arq->rto < arq->config.rto_min_us) {
+        arq->rto = arq->config.rto_min_us;
+    }
+    if (arq->rto > arq->config.rto_max_us) {
+        arq->rto = arq->config.rto_max_us;
+    }
+}
+
+static void at86rf212_arq_input_data(struct at86rf212_arq_s *arq, uint8_t seq, uint8_t length, const uint8_t* data)
+{
+    uint8_t distance = seq - arq->rx_next;
+    struct at86rf212_arq_slot_s *slot = &arq->slots[seq & AT86RF212_ARQ_WINDOW_MASK];
+
+    // Always acknowledge, so lost acknowledgements for old segments are repaired
+    arq->ack_pending = 1;
+
+    if (distance >= arq->config.window) {
+        at86rf212_arq_deliver(arq);
+        arq->stats.duplicates ++;
+        return;
+    }
+    if (slot->valid != 0) {
+        at86rf212_arq_deliver(arq);
+        arq->stats.duplicates ++;
+        return;
+    }
+
+    memcpy(slot->data, data, length);
+    slot->length = length;
+    slot->valid = 1;
+
+    at86rf212_arq_deliver(arq);
+}
+
+static void at86rf212_arq_input_ack(struct at86rf212_arq_s *arq, uint32_t now_us, uint8_t cumulative, uint32_t bitmap)
+{
+    uint8_t in_flight = arq->next_seq - arq->base_seq;
+
+    // The receive direction may be waiting on buffer space freed since the last frame
+    at86rf212_arq_deliver(arq);
+
+    // Ignore acknowledgements for segments that have not been sent
+    if ((uint8_t)(cumulative - arq->base_seq) > in_flight) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < in_flight; i++) {
+        uint8_t seq = arq->base_seq + i;
+        struct at86rf212_arq_segment_s *segment = &arq->segments[seq & AT86RF212_ARQ_WINDOW_MASK];
+        uint8_t ahead = seq - cumulative;
+        uint8_t acked;
+
+        if ((uint8_t)(seq - arq->base_seq) < (uint8_t)(cumulative - arq->base_seq)) {
+            acked = 1;
+        } else {
+            acked = (ahead >= 1) && (ahead <= 32) && ((bitmap >> (ahead - 1)) & 0x01);
+        }
+
+        if (acked && (segment->acked == 0)) {
+            segment->acked = 1;
+            arq->stats.bytes_acked += segment->length;
+            // Karn's algorithm, retransmitted segments give ambiguous samples
+            if (segment->retries == 0) {
+                at86rf212_arq_rtt_sample(arq, now_us - segment->sent_time);
+            }
+        }
+    }
+
+    // Slide the window over acknowledged segments
+    while (arq->base_seq != arq->next_seq) {
+        struct at86rf212_arq_segment_s *segment = &arq->segments[arq->base_seq & AT86RF212_ARQ_WINDOW_MASK];
+        if (segment->acked == 0) {
+            break;
+        }
+        arq->tx_head = segment->offset + segment->length;
+        arq->base_seq ++;
+    }
+}
+
+int at86rf212_arq_input(struct at86rf212_arq_s *arq, uint32_t now_us, uint8_t length, const uint8_t* data)
+{
+    if (length < 1) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    switch (data[0]) {
+    case AT86RF212_ARQ_TYPE_DATA:
+        if ((length < AT86RF212_ARQ_DATA_HEADER_LEN)
+            || ((length - AT86RF212_ARQ_DATA_HEADER_LEN) > AT86RF212_ARQ_MAX_SEGMENT)) {
+            return AT86RF212_ERROR_LEN;
+        }
+        at86rf212_arq_input_data(arq, data[1], length - AT86RF212_ARQ_DATA_HEADER_LEN,
+                                 data + AT86RF212_ARQ_DATA_HEADER_LEN);
+        return AT86RF212_RES_OK;
+
+    case AT86RF212_ARQ_TYPE_ACK:
+        if (length < AT86RF212_ARQ_ACK_LEN) {
+            return AT86RF212_ERROR_LEN;
+        }
+        at86rf212_arq_input_ack(arq, now_us, data[1],
+                                data[2] | (data[3] << 8) | (data[4] << 16) | ((uint32_t)data[5] << 24));
+        return AT86RF212_RES_OK;
+    }
+
+    return AT86RF212_RES_REJECTED;
+}
+
+static int at86rf212_arq_send_ack(struct at86rf212_arq_s *arq)
+{
+    uint8_t frame[AT86RF212_ARQ_ACK_LEN];
+    uint32_t bitmap = 0;
+    int res;
+
+    // Bit n acknowledges rx_next + 1 + n
+    for (int i = 0; i < (arq->config.window - 1); i++) {
+        uint8_t seq = arq->rx_next + 1 + i;
+        if (arq->slots[seq & AT86RF212_ARQ_WINDOW_MASK].valid) {
+            bitmap |= (1UL << i);
+        }
+    }
+
+    frame[0] = AT86RF212_ARQ_TYPE_ACK;
+    frame[1] = arq->rx_next;
+    frame[2] = bitmap & 0xFF;
+    frame[3] = (bitmap >> 8) & 0xFF;
+    frame[4] = (bitmap >> 16) & 0xFF;
+    frame[5] = (bitmap >> 24) & 0xFF;
+
+    res = arq->send(arq->send_ctx, sizeof(frame), frame);
+    if (res < 0) {
+        return res;
+    }
+
+    arq->ack_pending = 0;
+    arq->stats.acks_sent ++;
+
+    return AT86RF212_RES_DONE;
+}
+
+static int at86rf212_arq_send_segment(struct at86rf212_arq_s *arq, uint32_t now_us, uint8_t seq)
+{
+    struct at86rf212_arq_segment_s *segment = &arq->segments[seq & AT86RF212_ARQ_WINDOW_MASK];
+    uint8_t frame[AT86RF212_ARQ_DATA_HEADER_LEN + AT86RF212_ARQ_MAX_SEGMENT];
+    int res;
+
+    frame[0] = AT86RF212_ARQ_TYPE_DATA;
+    frame[1] = seq;
+    for (int i = 0; i < segment->length; i++) {
+        frame[AT86RF212_ARQ_DATA_HEADER_LEN + i] = arq->tx_buffer[(segment->offset + i) & AT86RF212_ARQ_BUFFER_MASK];
+    }
+
+    res = arq->send(arq->send_ctx, AT86RF212_ARQ_DATA_HEADER_LEN + segment->length, frame);
+    if (res < 0) {
+        return res;
+    }
+
+    segment->sent_time = now_us;
+    arq->stats.segments_sent ++;
+
+    return AT86RF212_RES_DONE;
+}
+
+int at86rf212_arq_poll(struct at86rf212_arq_s *arq, uint32_t now_us)
+{
+    uint8_t in_flight = arq->next_seq - arq->base_seq;
+    int res;
+
+    // Acknowledgements first, they unblock the peer
+    if (arq->ack_pending) {
+        return at86rf212_arq_send_ack(arq);
+    }
+
+    // Retransmit the oldest timed out segment
+    for (uint8_t i = 0; i < in_flight; i++) {
+        uint8_t seq = arq->base_seq + i;
+        struct at86rf212_arq_segment_s *segment = &arq->segments[seq & AT86RF212_ARQ_WINDOW_MASK];
+
+        if ((segment->acked == 0) && ((now_us - segment->sent_time) >= arq->rto)) {
+            res = at86rf212_arq_send_segment(arq, now_us, seq);
+            if (res < 0) {
+                return res;
+            }
+            segment->retries ++;
+            arq->stats.retransmissions ++;
+
+            // Back off (once per window) until a fresh round trip sample is available
+            if (i == 0) {
+                arq->rto *= 2;
+                if (arq->rto > arq->config.rto_max_us) {
+                    arq->rto = arq->config.rto_max_us;
+                }
+            }
+            return AT86RF212_RES_DONE;
+        }
+    }
+
+    // Send a new segment if the window allows
+    if ((in_flight < arq->config.window) && (arq->tx_next != arq->tx_tail)) {
+        struct at86rf212_arq_segment_s *segment = &arq->segments[arq->next_seq & AT86RF212_ARQ_WINDOW_MASK];
+        uint32_t length = arq->tx_tail - arq->tx_next;
+
+        if (length > arq->config.segment_len) {
+            length = arq->config.segment_len;
+        }
+
+        segment->offset = arq->tx_next;
+        segment->length = length;
+        segment->acked = 0;
+        segment->retries = 0;
+
+        res = at86rf212_arq_send_segment(arq, now_us, arq->next_seq);
+        if (res < 0) {
+            return res;
+        }
+
+        arq->tx_next += length;
+        arq->next_seq ++;
+        return AT86RF212_RES_DONE;
+    }
+
+    return AT86RF212_RES_OK;
+}
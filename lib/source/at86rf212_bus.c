@@ -0,0 +1,285 @@
+/*
+ * at86rf212 shared SPI bus arbiter
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#if (defined __linux__ || defined __APPLE__ || defined __unix__)
+
+#include "at86rf212/at86rf212_bus.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "at86rf212/at86rf212_defs.h"
+#include "at86rf212/at86rf212_regs.h"
+
+#include "at86rf212_platform.h"
+
+static uint64_t at86rf212_bus_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Forward the non-SPI driver functions to the radio driver
+static int at86rf212_bus_set_reset(void* context, uint8_t val)
+{
+    struct at86rf212_bus_port_s *port = (struct at86rf212_bus_port_s*) context;
+    return port->radio_driver->set_reset(port->radio_ctx, val);
+}
+
+static int at86rf212_bus_set_slp_tr(void* context, uint8_t val)
+{
+    struct at86rf212_bus_port_s *port = (struct at86rf212_bus_port_s*) context;
+    return port->radio_driver->set_slp_tr(port->radio_ctx, val);
+}
+
+static int at86rf212_bus_get_irq(void* context, uint8_t *val)
+{
+    struct at86rf212_bus_port_s *port = (struct at86rf212_bus_port_s*) context;
+    return port->radio_driver->get_irq(port->radio_ctx, val);
+}
+
+static int at86rf212_bus_get_dig1(void* context, uint8_t *val)
+{
+    struct at86rf212_bus_port_s *port = (struct at86rf212_bus_port_s*) context;
+    return port->radio_driver->get_dig1(port->radio_ctx, val);
+}
+
+static int at86rf212_bus_get_dig2(void* context, uint8_t *val)
+{
+    struct at86rf212_bus_port_s *port = (struct at86rf212_bus_port_s*) context;
+    return port->radio_driver->get_dig2(port->radio_ctx, val);
+}
+
+int at86rf212_bus_init(struct at86rf212_bus_s *bus, const struct at86rf212_bus_backend_s *backend, void* backend_ctx)
+{
+    if (backend->transfer == NULL) {
+        return AT86RF212_DRIVER_INVALID;
+    }
+
+    memset(bus, 0, sizeof(struct at86rf212_bus_s));
+    bus->backend = backend;
+    bus->backend_ctx = backend_ctx;
+
+    if (pthread_mutex_init(&bus->lock, NULL) != 0) {
+        return AT86RF212_ERROR_DRIVER;
+    }
+    if (pthread_cond_init(&bus->complete, NULL) != 0) {
+        pthread_mutex_destroy(&bus->lock);
+        return AT86RF212_ERROR_DRIVER;
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_bus_port_init(struct at86rf212_bus_s *bus, struct at86rf212_bus_port_s *port, uint8_t cs,
+                            struct at86rf212_driver_s *radio_driver, void* radio_ctx)
+{
+    memset(port, 0, sizeof(struct at86rf212_bus_port_s));
+    port->bus = bus;
+    port->cs = cs;
+    port->radio_driver = radio_driver;
+    port->radio_ctx = radio_ctx;
+
+    // Optional functions stay optional
+    port->driver.spi_transfer = at86rf212_bus_spi_transfer;
+    port->driver.set_reset = (radio_driver->set_reset != NULL) ? at86rf212_bus_set_reset : NULL;
+    port->driver.set_slp_tr = (radio_driver->set_slp_tr != NULL) ? at86rf212_bus_set_slp_tr : NULL;
+    port->driver.get_irq = (radio_driver->get_irq != NULL) ? at86rf212_bus_get_irq : NULL;
+    port->driver.get_dig1 = (radio_driver->get_dig1 != NULL) ? at86rf212_bus_get_dig1 : NULL;
+    port->driver.get_dig2 = (radio_driver->get_dig2 != NULL) ? at86rf212_bus_get_dig2 : NULL;
+
+    return AT86RF212_RES_OK;
+}
+
+uint8_t at86rf212_bus_classify(int len, const uint8_t *data_out)
+{
+    uint8_t cmd;
+    uint8_t reg;
+
+    if (len < 1) {
+        return AT86RF212_BUS_PRIO_CONFIG;
+    }
+
+    cmd = data_out[0];
+    reg = cmd & ~AT86RF212_REG_WRITE_FLAG;
+
+    // Register accesses have the top bit set, frame buffer and SRAM accesses are selected by the next two
+    if ((cmd & AT86RF212_REG_READ_FLAG) != 0) {
+        if ((reg == AT86RF212_REG_TRX_STATE) || (reg == AT86RF212_REG_IRQ_STATUS) || (reg == AT86RF212_REG_TRX_STATUS)) {
+            return AT86RF212_BUS_PRIO_CONTROL;
+        }
+        return AT86RF212_BUS_PRIO_CONFIG;
+    }
+
+    // SRAM reads fetch received frames early (at86rf212_get_rx_early and the filters)
+    switch (cmd & AT86RF212_FRAME_WRITE_FLAG) {
+    case AT86RF212_FRAME_READ_FLAG:
+    case AT86RF212_SRAM_READ_FLAG:
+        return AT86RF212_BUS_PRIO_RX;
+    case AT86RF212_FRAME_WRITE_FLAG:
+        return AT86RF212_BUS_PRIO_CONTROL;
+    }
+
+    return AT86RF212_BUS_PRIO_CONFIG;
+}
+
+// Take the next batch from the queues in priority order, called with the bus locked
+// The first transfer is always taken, further transfers only while they fit the batch limits.
+static int at86rf212_bus_take(struct at86rf212_bus_s *bus, struct at86rf212_bus_op_s **batch)
+{
+    int count = 0;
+    int bytes = 0;
+    int max = (bus->backend->batch != NULL) ? AT86RF212_BUS_BATCH_MAX : 1;
+
+    for (int p = 0; (p < AT86RF212_BUS_PRIOS) && (count < max); p++) {
+        while ((bus->head[p] != NULL) && (count < max)) {
+            struct at86rf212_bus_op_s *op = bus->head[p];
+
+            if ((count > 0) && ((bytes + op->len) > AT86RF212_BUS_BATCH_BYTES)) {
+                return count;
+            }
+
+            bus->head[p] = op->next;
+            if (bus->head[p] == NULL) {
+                bus->tail[p] = NULL;
+            }
+            bus->pending --;
+
+            batch[count++] = op;
+            bytes += op->len;
+        }
+    }
+
+    return count;
+}
+
+// Run a batch on the backend, called with the bus unlocked
+static void at86rf212_bus_execute(struct at86rf212_bus_s *bus, int count, struct at86rf212_bus_op_s **batch)
+{
+    struct at86rf212_bus_xfer_s xfers[AT86RF212_BUS_BATCH_MAX];
+    int res;
+
+    if (count == 1) {
+        struct at86rf212_bus_op_s *op = batch[0];
+        op->result = bus->backend->transfer(bus->backend_ctx, op->port->cs, op->len, op->data_out, op->data_in);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        xfers[i].cs = batch[i]->port->cs;
+        xfers[i].len = batch[i]->len;
+        xfers[i].data_out = batch[i]->data_out;
+        xfers[i].data_in = batch[i]->data_in;
+    }
+
+    res = bus->backend->batch(bus->backend_ctx, count, xfers);
+    for (int i = 0; i < count; i++) {
+        batch[i]->result = res;
+    }
+}
+
+int at86rf212_bus_spi_transfer(void* context, int len, uint8_t *data_out, uint8_t* data_in)
+{
+    struct at86rf212_bus_port_s *port = (struct at86rf212_bus_port_s*) context;
+    struct at86rf212_bus_s *bus = port->bus;
+    struct at86rf212_bus_op_s op;
+    struct at86rf212_bus_op_s *batch[AT86RF212_BUS_BATCH_MAX];
+
+    op.port = port;
+    op.len = len;
+    op.data_out = data_out;
+    op.data_in = data_in;
+    op.priority = at86rf212_bus_classify(len, data_out);
+    op.done = 0;
+    op.result = AT86RF212_ERROR_DRIVER;
+    op.next = NULL;
+
+    pthread_mutex_lock(&bus->lock);
+
+    op.queued_ns = at86rf212_bus_now_ns();
+    if (bus->tail[op.priority] != NULL) {
+        bus->tail[op.priority]->next = &op;
+    } else {
+        bus->head[op.priority] = &op;
+    }
+    bus->tail[op.priority] = &op;
+    bus->pending ++;
+    if (bus->pending > bus->stats.max_pending) {
+        bus->stats.max_pending = bus->pending;
+    }
+
+    // Whichever thread finds the bus idle runs the highest priority queued transfers (which may
+    // belong to other threads), so the bus is re-arbitrated after every batch without a handoff
+    while (op.done == 0) {
+        if (bus->busy != 0) {
+            pthread_cond_wait(&bus->complete, &bus->lock);
+            continue;
+        }
+
+        int count = at86rf212_bus_take(bus, batch);
+        uint64_t start_ns = at86rf212_bus_now_ns();
+        bus->busy = 1;
+        bus->stats.batches ++;
+        if (count > 1) {
+            bus->stats.coalesced += count;
+        }
+
+        pthread_mutex_unlock(&bus->lock);
+        at86rf212_bus_execute(bus, count, batch);
+        pthread_mutex_lock(&bus->lock);
+
+        for (int i = 0; i < count; i++) {
+            struct at86rf212_bus_op_s *done = batch[i];
+            struct at86rf212_bus_stats_s *stats = &done->port->stats[done->priority];
+            uint32_t wait_us = (start_ns - done->queued_ns) / 1000;
+
+            stats->transfers ++;
+            stats->bytes += done->len;
+            stats->wait_us += wait_us;
+            if (wait_us > stats->max_wait_us) {
+                stats->max_wait_us = wait_us;
+            }
+            done->done = 1;
+        }
+
+        bus->busy = 0;
+        pthread_cond_broadcast(&bus->complete);
+    }
+
+    pthread_mutex_unlock(&bus->lock);
+
+    return op.result;
+}
+
+void at86rf212_bus_port_stats(struct at86rf212_bus_port_s *port, struct at86rf212_bus_stats_s *stats)
+{
+    pthread_mutex_lock(&port->bus->lock);
+    memcpy(stats, port->stats, sizeof(port->stats));
+    pthread_mutex_unlock(&port->bus->lock);
+}
+
+uint32_t at86rf212_bus_pending(struct at86rf212_bus_s *bus)
+{
+    uint32_t pending;
+
+    pthread_mutex_lock(&bus->lock);
+    pending = bus->pending;
+    pthread_mutex_unlock(&bus->lock);
+
+    return pending;
+}
+
+void at86rf212_bus_close(struct at86rf212_bus_s *bus)
+{
+    pthread_cond_destroy(&bus->complete);
+    pthread_mutex_destroy(&bus->lock);
+}
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ * at86rf212 command submission queue
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_cmdq.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+static void at86rf212_cmdq_push(struct at86rf212_cmdq_s *queue, struct at86rf212_cmd_s *cmd)
+{
+    struct at86rf212_cmd_s *prev;
+
+    __atomic_store_n(&cmd->next, NULL, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&queue->head, cmd, __ATOMIC_ACQ_REL);
+    // The command is unreachable by the owner until this link is written
+    __atomic_store_n(&prev->next, cmd, __ATOMIC_RELEASE);
+}
+
+// Returns NULL when empty, or when the next command's submission has not yet linked it
+static struct at86rf212_cmd_s* at86rf212_cmdq_pop(struct at86rf212_cmdq_s *queue)
+{
+    struct at86rf212_cmd_s *tail = queue->tail;
+    struct at86rf212_cmd_s *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    if (tail == &queue->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+
+    // Tail is the last command, requeue the stub behind it so it can be removed
+    if (tail != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    at86rf212_cmdq_push(queue, &queue->stub);
+
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+void at86rf212_cmdq_init(struct at86rf212_cmdq_s *queue, struct at86rf212_s *device,
+                         at86rf212_cmdq_notify_f notify, void* notify_ctx)
+{
+    memset(queue, 0, sizeof(struct at86rf212_cmdq_s));
+
+    queue->device = device;
+    queue->notify = notify;
+    queue->notify_ctx = notify_ctx;
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+}
+
+void at86rf212_cmdq_submit(struct at86rf212_cmdq_s *queue, struct at86rf212_cmd_s *cmd)
+{
+    cmd->result = AT86RF212_RES_OK;
+    __atomic_store_n(&cmd->complete, 0, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&queue->stats.submitted, 1, __ATOMIC_RELAXED);
+
+    at86rf212_cmdq_push(queue, cmd);
+
+    // Only the first submission after a run wakes the owner
+    if ((queue->notify != NULL) && (__atomic_exchange_n(&queue->signalled, 1, __ATOMIC_ACQ_REL) == 0)) {
+        __atomic_fetch_add(&queue->stats.notifies, 1, __ATOMIC_RELAXED);
+        queue->notify(queue->notify_ctx);
+    }
+}
+
+static int at86rf212_cmdq_execute(struct at86rf212_s *device, struct at86rf212_cmd_s *cmd)
+{
+    uint8_t val;
+    int res;
+
+    switch (cmd->type) {
+    case AT86RF212_CMDQ_TX:
+        return at86rf212_start_tx(device, cmd->args.tx.length, cmd->args.tx.data);
+    case AT86RF212_CMDQ_SET_CHANNEL:
+        return at86rf212_set_channel(device, cmd->args.value);
+    case AT86RF212_CMDQ_SET_POWER:
+        return at86rf212_set_power_raw(device, cmd->args.value);
+    case AT86RF212_CMDQ_UPDATE_REGS:
+        return at86rf212_update_regs(device, cmd->args.regs.count, cmd->args.regs.updates);
+    case AT86RF212_CMDQ_READ_REG:
+        res = at86rf212_read_reg(device, cmd->args.reg, &val);
+        return (res < 0) ? res : val;
+    case AT86RF212_CMDQ_RANDOM_STATS:
+        return at86rf212_get_random_stats(device, cmd->args.stats);
+    case AT86RF212_CMDQ_CALL:
+        return cmd->args.call.fn(device, cmd->args.call.ctx);
+    }
+
+    return AT86RF212_ERROR_STATE;
+}
+
+// The callback may release or resubmit the command, so it is not touched afterwards
+static void at86rf212_cmdq_finish(struct at86rf212_cmd_s *cmd, int result)
+{
+    at86rf212_cmd_done_f done = cmd->done;
+    void* done_ctx = cmd->done_ctx;
+
+    cmd->result = result;
+    __atomic_store_n(&cmd->complete, 1, __ATOMIC_RELEASE);
+    if (done != NULL) {
+        done(done_ctx, cmd, result);
+    }
+}
+
+int at86rf212_cmdq_run(struct at86rf212_cmdq_s *queue, int max)
+{
+    struct at86rf212_cmd_s *cmd;
+    int count = 0;
+
+    // Cleared first, so a submission racing with this run requests another
+    __atomic_store_n(&queue->signalled, 0, __ATOMIC_SEQ_CST);
+
+    while (count < max) {
+        cmd = at86rf212_cmdq_pop(queue);
+        if (cmd == NULL) {
+            break;
+        }
+
+        at86rf212_cmdq_finish(cmd, at86rf212_cmdq_execute(queue->device, cmd));
+        count ++;
+    }
+
+    queue->stats.executed += count;
+    if ((uint32_t)count > queue->stats.max_batch) {
+        queue->stats.max_batch = count;
+    }
+
+    // Stopped at max with commands left, no submission will wake the owner for them
+    if ((count == max) && at86rf212_cmdq_pending(queue) && (queue->notify != NULL)
+        && (__atomic_exchange_n(&queue->signalled, 1, __ATOMIC_ACQ_REL) == 0)) {
+        __atomic_fetch_add(&queue->stats.notifies, 1, __ATOMIC_RELAXED);
+        queue->notify(queue->notify_ctx);
+    }
+
+    return count;
+}
+
+int at86rf212_cmdq_pending(struct at86rf212_cmdq_s *queue)
+{
+    return (queue->tail != &queue->stub) || (__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) != &queue->stub);
+}
+
+int at86rf212_cmdq_cancel(struct at86rf212_cmdq_s *queue, int result)
+{
+    struct at86rf212_cmd_s *cmd;
+    int count = 0;
+
+    while ((cmd = at86rf212_cmdq_pop(queue)) != NULL) {
+        at86rf212_cmdq_finish(cmd, result);
+        count ++;
+    }
+
+    return count;
+}
+
+int at86rf212_cmd_complete(struct at86rf212_cmd_s *cmd)
+{
+    return __atomic_load_n(&cmd->complete, __ATOMIC_ACQUIRE);
+}
+
+static void at86rf212_cmd_init(struct at86rf212_cmd_s *cmd, uint8_t type)
+{
+    memset(cmd, 0, sizeof(struct at86rf212_cmd_s));
+    cmd->type = type;
+}
+
+void at86rf212_cmd_tx(struct at86rf212_cmd_s *cmd, uint8_t length, uint8_t *data)
+{
+    at86rf212_cmd_init(cmd, AT86RF212_CMDQ_TX);
+    cmd->args.tx.length = length;
+    cmd->args.tx.data = data;
+}
+
+void at86rf212_cmd_set_channel(struct at86rf212_cmd_s *cmd, uint8_t channel)
+{
+    at86rf212_cmd_init(cmd, AT86RF212_CMDQ_SET_CHANNEL);
+    cmd->args.value = channel;
+}
+
+void at86rf212_cmd_set_power(struct at86rf212_cmd_s *cmd, uint8_t power)
+{
+    at86rf212_cmd_init(cmd, AT86RF212_CMDQ_SET_POWER);
+    cmd->args.value = power;
+}
+
+void at86rf212_cmd_update_regs(struct at86rf212_cmd_s *cmd, uint8_t count, const struct at86rf212_reg_update_s *updates)
+{
+    at86rf212_cmd_init(cmd, AT86RF212_CMDQ_UPDATE_REGS);
+    cmd->args.regs.count = count;
+    cmd->args.regs.updates = updates;
+}
+
+void at86rf212_cmd_read_reg(struct at86rf212_cmd_s *cmd, uint8_t reg)
+{
+    at86rf212_cmd_init(cmd, AT86RF212_CMDQ_READ_REG);
+    cmd->args.reg = reg;
+}
+
+void at86rf212_cmd_random_stats(struct at86rf212_cmd_s *cmd, struct at86rf212_random_stats_s *stats)
+{
+    at86rf212_cmd_init(cmd, AT86RF212_CMDQ_RANDOM_STATS);
+    cmd->args.stats = stats;
+}
+
+void at86rf212_cmd_call(struct at86rf212_cmd_s *cmd, at86rf212_cmd_call_f fn, void* ctx)
+{
+    at86rf212_cmd_init(cmd, AT86RF212_CMDQ_CALL);
+    cmd->args.call.fn = fn;
+    cmd->args.call.ctx = ctx;
+}
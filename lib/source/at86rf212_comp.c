@@ -0,0 +1,311 @@
+/*
+ * at86rf212 payload compression
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_comp.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+#define AT86RF212_COMP_HASH_SIZE        256
+#define AT86RF212_COMP_CHAIN_DEPTH      32
+#define AT86RF212_COMP_NONE             0xFFFF
+#define AT86RF212_COMP_MAX_LITERALS     128
+
+#define AT86RF212_COMP_HISTORY_LEN      (AT86RF212_COMP_MAX_DICT + 2 * AT86RF212_COMP_MAX_PAYLOAD)
+
+int at86rf212_comp_init(struct at86rf212_comp_s *comp, const uint8_t* dict, uint16_t dict_len, uint8_t key_interval)
+{
+    if (dict_len > AT86RF212_COMP_MAX_DICT) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    memset(comp, 0, sizeof(struct at86rf212_comp_s));
+
+    comp->dict = dict;
+    comp->dict_len = dict_len;
+    comp->key_interval = key_interval;
+
+    return AT86RF212_RES_OK;
+}
+
+static inline uint8_t at86rf212_comp_hash(const uint8_t* data)
+{
+    return ((data[0] << 4) ^ (data[1] << 2) ^ data[2]) & (AT86RF212_COMP_HASH_SIZE - 1);
+}
+
+// Remember a frame as the reference for the next delta frame
+static void at86rf212_comp_set_prev(struct at86rf212_comp_s *comp, uint8_t seq, uint8_t length, const uint8_t* data)
+{
+    memcpy(comp->prev, data, length);
+    comp->prev_len = length;
+    comp->prev_seq = seq;
+    comp->prev_valid = 1;
+}
+
+// Emit a literal run, returns 0 if the output limit would be exceeded
+static int at86rf212_comp_literals(uint8_t* out, uint8_t* pos, uint8_t limit, const uint8_t* data, uint8_t count)
+{
+    if (count == 0) {
+        return 1;
+    }
+    if ((*pos + 1 + count) > limit) {
+        return 0;
+    }
+
+    out[(*pos)++] = count - 1;
+    memcpy(&out[*pos], data, count);
+    *pos += count;
+
+    return 1;
+}
+
+int at86rf212_comp_compress(struct at86rf212_comp_s *comp, uint8_t in_len, const uint8_t* in,
+                            uint8_t* out_len, uint8_t* out)
+{
+    uint8_t history[AT86RF212_COMP_HISTORY_LEN];
+    uint16_t chain[AT86RF212_COMP_HISTORY_LEN];
+    uint16_t head[AT86RF212_COMP_HASH_SIZE];
+    uint16_t base, end, pos;
+    uint8_t use_delta;
+    uint8_t out_pos;
+    uint8_t header_len;
+    uint8_t limit;
+    uint8_t literals = 0;
+    uint8_t seq = comp->seq;
+
+    if (in_len > AT86RF212_COMP_MAX_INPUT) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    use_delta = comp->prev_valid;
+    if ((comp->key_interval != 0) && ((seq % comp->key_interval) == 0)) {
+        use_delta = 0;
+    }
+
+    // History is the dictionary, the previous frame (for delta frames) and the payload
+    if (comp->dict_len > 0) {
+        memcpy(history, comp->dict, comp->dict_len);
+    }
+    base = comp->dict_len;
+    if (use_delta) {
+        memcpy(&history[base], comp->prev, comp->prev_len);
+        base += comp->prev_len;
+    }
+    memcpy(&history[base], in, in_len);
+    end = base + in_len;
+
+    memset(head, 0xFF, sizeof(head));
+    for (pos = 0; (pos + AT86RF212_COMP_MIN_MATCH) <= base; pos++) {
+        uint8_t h = at86rf212_comp_hash(&history[pos]);
+        chain[pos] = head[h];
+        head[h] = pos;
+    }
+
+    out[0] = use_delta ? AT86RF212_COMP_TYPE_DELTA : AT86RF212_COMP_TYPE_LZ;
+    out[1] = seq;
+    header_len = 2;
+    if (use_delta) {
+        out[header_len++] = comp->prev_seq;
+    }
+    out_pos = header_len;
+
+    // Coding stops once the output is no smaller than the payload or would not fit in a frame
+    limit = in_len + header_len;
+    if (limit > AT86RF212_COMP_MAX_PAYLOAD) {
+        limit = AT86RF212_COMP_MAX_PAYLOAD;
+    }
+
+    pos = base;
+    while (pos < end) {
+        uint16_t best_len = 0;
+        uint16_t best_dist = 0;
+        uint16_t max_len = end - pos;
+
+        if (max_len > AT86RF212_COMP_MAX_MATCH) {
+            max_len = AT86RF212_COMP_MAX_MATCH;
+        }
+
+        if (max_len >= AT86RF212_COMP_MIN_MATCH) {
+            uint16_t candidate = head[at86rf212_comp_hash(&history[pos])];
+
+            for (int depth = 0; (depth < AT86RF212_COMP_CHAIN_DEPTH) && (candidate != AT86RF212_COMP_NONE); depth++) {
+                uint16_t dist = pos - candidate;
+                uint16_t len = 0;
+
+                if (dist > AT86RF212_COMP_MAX_DISTANCE) {
+                    break;
+                }
+                // Matches may run on into the bytes being coded
+                while ((len < max_len) && (history[candidate + len] == history[pos + len])) {
+                    len ++;
+                }
+                if (len > best_len) {
+                    best_len = len;
+                    best_dist = dist;
+                    if (len == max_len) {
+                        break;
+                    }
+                }
+                candidate = chain[candidate];
+            }
+        }
+
+        if (best_len >= AT86RF212_COMP_MIN_MATCH) {
+            if (!at86rf212_comp_literals(out, &out_pos, limit, &history[pos - literals], literals)) {
+                break;
+            }
+            literals = 0;
+            if ((out_pos + 2) > limit) {
+                break;
+            }
+            out[out_pos++] = 0x80 | ((best_len - AT86RF212_COMP_MIN_MATCH) << 1) | ((best_dist - 1) >> 8);
+            out[out_pos++] = (best_dist - 1) & 0xFF;
+        } else {
+            best_len = 1;
+            literals ++;
+        }
+
+        // Index the coded bytes
+        for (uint16_t i = 0; i < best_len; i++, pos++) {
+            if ((pos + AT86RF212_COMP_MIN_MATCH) <= end) {
+                uint8_t h = at86rf212_comp_hash(&history[pos]);
+                chain[pos] = head[h];
+                head[h] = pos;
+            }
+        }
+
+        if (literals == AT86RF212_COMP_MAX_LITERALS) {
+            if (!at86rf212_comp_literals(out, &out_pos, limit, &history[pos - literals], literals)) {
+                break;
+            }
+            literals = 0;
+        }
+    }
+
+    if ((pos < end)
+        || !at86rf212_comp_literals(out, &out_pos, limit, &history[pos - literals], literals)
+        || (out_pos >= (in_len + 2))) {
+        // Compression did not help, store the payload
+        out[0] = AT86RF212_COMP_TYPE_RAW;
+        out[1] = seq;
+        memcpy(&out[2], in, in_len);
+        out_pos = in_len + 2;
+        use_delta = 0;
+        comp->stats.raw_frames ++;
+    } else if (use_delta) {
+        comp->stats.delta_frames ++;
+    }
+
+    at86rf212_comp_set_prev(comp, seq, in_len, in);
+    comp->seq ++;
+
+    comp->stats.frames ++;
+    comp->stats.bytes_in += in_len;
+    comp->stats.bytes_out += out_pos;
+    *out_len = out_pos;
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_comp_decompress(struct at86rf212_comp_s *comp, uint8_t in_len, const uint8_t* in,
+                              uint8_t* out_len, uint8_t* out)
+{
+    uint8_t type;
+    uint8_t seq;
+    uint8_t pos;
+    uint16_t prev_len = 0;
+    uint16_t base;
+    uint16_t out_pos = 0;
+
+    if (in_len < 2) {
+        return AT86RF212_RES_REJECTED;
+    }
+    type = in[0];
+    seq = in[1];
+
+    switch (type) {
+    case AT86RF212_COMP_TYPE_RAW:
+        if ((in_len - 2) > AT86RF212_COMP_MAX_PAYLOAD) {
+            return AT86RF212_ERROR_LEN;
+        }
+        memcpy(out, &in[2], in_len - 2);
+        out_pos = in_len - 2;
+        break;
+
+    case AT86RF212_COMP_TYPE_LZ:
+    case AT86RF212_COMP_TYPE_DELTA:
+        pos = 2;
+        if (type == AT86RF212_COMP_TYPE_DELTA) {
+            if ((in_len < 3) || (comp->prev_valid == 0) || (comp->prev_seq != in[2])) {
+                comp->stats.errors ++;
+                return AT86RF212_ERROR_STATE;
+            }
+            prev_len = comp->prev_len;
+            pos = 3;
+        }
+        base = comp->dict_len + prev_len;
+
+        while (pos < in_len) {
+            uint8_t token = in[pos++];
+
+            if ((token & 0x80) == 0) {
+                uint8_t count = token + 1;
+                if (((pos + count) > in_len) || ((out_pos + count) > AT86RF212_COMP_MAX_PAYLOAD)) {
+                    comp->stats.errors ++;
+                    return AT86RF212_ERROR_LEN;
+                }
+                memcpy(&out[out_pos], &in[pos], count);
+                out_pos += count;
+                pos += count;
+            } else {
+                uint16_t len, dist, src;
+
+                if (pos >= in_len) {
+                    comp->stats.errors ++;
+                    return AT86RF212_ERROR_LEN;
+                }
+                len = ((token >> 1) & 0x3F) + AT86RF212_COMP_MIN_MATCH;
+                dist = (((token & 0x01) << 8) | in[pos++]) + 1;
+                if ((dist > (base + out_pos)) || ((out_pos + len) > AT86RF212_COMP_MAX_PAYLOAD)) {
+                    comp->stats.errors ++;
+                    return AT86RF212_ERROR_LEN;
+                }
+
+                // Resolve the source in the virtual history without building it
+                src = base + out_pos - dist;
+                for (uint16_t i = 0; i < len; i++, src++) {
+                    if (src < comp->dict_len) {
+                        out[out_pos++] = comp->dict[src];
+                    } else if (src < base) {
+                        out[out_pos++] = comp->prev[src - comp->dict_len];
+                    } else {
+                        out[out_pos++] = out[src - base];
+                    }
+                }
+            }
+        }
+        if (type == AT86RF212_COMP_TYPE_DELTA) {
+            comp->stats.delta_frames ++;
+        }
+        break;
+
+    default:
+        return AT86RF212_RES_REJECTED;
+    }
+
+    at86rf212_comp_set_prev(comp, seq, out_pos, out);
+    comp->seq = seq;
+
+    comp->stats.frames ++;
+    comp->stats.bytes_in += in_len;
+    comp->stats.bytes_out += out_pos;
+    *out_len = out_pos;
+
+    return AT86RF212_RES_OK;
+}
@@ -0,0 +1,304 @@
+/*
+ * at86rf212 software CSMA-CA engine
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_csma.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+// Busy ratio EWMA weight (1 / 2^n)
+#define AT86RF212_CSMA_BUSY_RATIO_WEIGHT    3
+
+// Random backoff of up to 2^be - 1 periods
+static uint16_t at86rf212_csma_random_backoff(uint8_t be, uint8_t rnd)
+{
+    return rnd & ((1 << be) - 1);
+}
+
+/***        Policies                    ***/
+
+static uint16_t at86rf212_csma_beb_begin(struct at86rf212_csma_s *csma, uint8_t rnd)
+{
+    return at86rf212_csma_random_backoff(csma->be, rnd);
+}
+
+static int at86rf212_csma_beb_decide(struct at86rf212_csma_s *csma, uint8_t clear, uint8_t rnd, uint16_t *backoff)
+{
+    if (clear) {
+        return AT86RF212_CSMA_TRANSMIT;
+    }
+
+    if (csma->nb > csma->config.max_backoffs) {
+        return AT86RF212_CSMA_FAIL;
+    }
+
+    if (csma->be < csma->config.max_be) {
+        csma->be ++;
+    }
+    *backoff = at86rf212_csma_random_backoff(csma->be, rnd);
+
+    return AT86RF212_CSMA_BACKOFF;
+}
+
+const struct at86rf212_csma_policy_s at86rf212_csma_policy_beb = {
+    "beb",
+    at86rf212_csma_beb_begin,
+    at86rf212_csma_beb_decide
+};
+
+static uint16_t at86rf212_csma_persistent_begin(struct at86rf212_csma_s *csma, uint8_t rnd)
+{
+    (void)csma;
+    (void)rnd;
+
+    // Sense immediately, persistence provides the randomisation
+    return 0;
+}
+
+static int at86rf212_csma_persistent_decide(struct at86rf212_csma_s *csma, uint8_t clear, uint8_t rnd, uint16_t *backoff)
+{
+    if (csma->assessments >= AT86RF212_CSMA_MAX_ASSESSMENTS) {
+        return AT86RF212_CSMA_FAIL;
+    }
+
+    // Transmit on an idle slot with probability p, otherwise defer a slot
+    if (clear && (rnd < csma->config.persistence)) {
+        return AT86RF212_CSMA_TRANSMIT;
+    }
+
+    *backoff = 1;
+
+    return AT86RF212_CSMA_BACKOFF;
+}
+
+const struct at86rf212_csma_policy_s at86rf212_csma_policy_persistent = {
+    "p-persistent",
+    at86rf212_csma_persistent_begin,
+    at86rf212_csma_persistent_decide
+};
+
+// Select an exponent in [min_be, max_be] proportional to the busy ratio
+static uint8_t at86rf212_csma_adaptive_be(struct at86rf212_csma_s *csma)
+{
+    uint8_t range = csma->config.max_be - csma->config.min_be + 1;
+    uint8_t be = csma->config.min_be + ((csma->busy_ratio * range) / (AT86RF212_CSMA_BUSY_RATIO_ONE + 1));
+
+    return be;
+}
+
+static uint16_t at86rf212_csma_adaptive_begin(struct at86rf212_csma_s *csma, uint8_t rnd)
+{
+    csma->be = at86rf212_csma_adaptive_be(csma);
+
+    return at86rf212_csma_random_backoff(csma->be, rnd);
+}
+
+static int at86rf212_csma_adaptive_decide(struct at86rf212_csma_s *csma, uint8_t clear, uint8_t rnd, uint16_t *backoff)
+{
+    uint8_t be;
+
+    if (clear) {
+        return AT86RF212_CSMA_TRANSMIT;
+    }
+
+    if (csma->nb > csma->config.max_backoffs) {
+        return AT86RF212_CSMA_FAIL;
+    }
+
+    // Grow the exponent as usual, but never below the load derived exponent
+    be = at86rf212_csma_adaptive_be(csma);
+    if (csma->be < csma->config.max_be) {
+        csma->be ++;
+    }
+    if (csma->be < be) {
+        csma->be = be;
+    }
+    *backoff = at86rf212_csma_random_backoff(csma->be, rnd);
+
+    return AT86RF212_CSMA_BACKOFF;
+}
+
+const struct at86rf212_csma_policy_s at86rf212_csma_policy_adaptive = {
+    "adaptive",
+    at86rf212_csma_adaptive_begin,
+    at86rf212_csma_adaptive_decide
+};
+
+/***        Engine                      ***/
+
+void at86rf212_csma_default_config(struct at86rf212_csma_config_s *config)
+{
+    config->policy = &at86rf212_csma_policy_beb;
+    config->min_be = AT86RF212_DEFAULT_MINBE;
+    config->max_be = AT86RF212_DEFAULT_MAXBE;
+    config->max_backoffs = AT86RF212_DEFAULT_MAX_CSMA_BACKOFFS;
+    config->persistence = AT86RF212_CSMA_DEFAULT_PERSISTENCE;
+    config->unit_backoff_us = AT86RF212_CSMA_DEFAULT_UNIT_BACKOFF_US;
+}
+
+int at86rf212_csma_init(struct at86rf212_csma_s *csma, struct at86rf212_s *device,
+                        const struct at86rf212_csma_config_s *config)
+{
+    if ((config->policy == NULL) || (config->policy->begin == NULL) || (config->policy->decide == NULL)) {
+        return AT86RF212_DRIVER_INVALID;
+    }
+    if ((config->max_be > 8) || (config->min_be > config->max_be)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    memset(csma, 0, sizeof(struct at86rf212_csma_s));
+
+    csma->device = device;
+    csma->config = *config;
+    csma->be = config->min_be;
+
+    return AT86RF212_RES_OK;
+}
+
+uint16_t at86rf212_csma_begin(struct at86rf212_csma_s *csma, uint8_t rnd)
+{
+    uint16_t backoff;
+
+    csma->nb = 0;
+    csma->assessments = 0;
+    csma->be = csma->config.min_be;
+    csma->stats.frames ++;
+
+    backoff = csma->config.policy->begin(csma, rnd);
+    csma->stats.backoff_periods += backoff;
+
+    return backoff;
+}
+
+int at86rf212_csma_step(struct at86rf212_csma_s *csma, uint8_t clear, uint8_t rnd, uint16_t *backoff)
+{
+    int action;
+    uint16_t sample = clear ? 0 : AT86RF212_CSMA_BUSY_RATIO_ONE;
+
+    // Track channel load, shared by all policies
+    csma->busy_ratio = csma->busy_ratio - (csma->busy_ratio >> AT86RF212_CSMA_BUSY_RATIO_WEIGHT)
+                       + (sample >> AT86RF212_CSMA_BUSY_RATIO_WEIGHT);
+
+    csma->assessments ++;
+    csma->stats.assessments ++;
+    if (!clear) {
+        csma->nb ++;
+        csma->stats.busy ++;
+    }
+
+    *backoff = 0;
+    action = csma->config.policy->decide(csma, clear, rnd, backoff);
+
+    switch (action) {
+    case AT86RF212_CSMA_TRANSMIT:
+        csma->stats.sent ++;
+        break;
+    case AT86RF212_CSMA_FAIL:
+        csma->stats.failures ++;
+        break;
+    default:
+        csma->stats.backoff_periods += *backoff;
+        break;
+    }
+
+    return action;
+}
+
+// Fetch 8 random bits from the device random pool
+static int at86rf212_csma_rnd(struct at86rf212_csma_s *csma, uint8_t *rnd)
+{
+    return at86rf212_get_random(csma->device, rnd, 1);
+}
+
+int at86rf212_csma_start_tx(struct at86rf212_csma_s *csma, uint8_t length, uint8_t* data)
+{
+    int res;
+    int action;
+    uint8_t rnd;
+    uint8_t clear;
+    uint8_t irq;
+    uint8_t loaded = 0;
+    uint8_t started = 0;
+    uint16_t backoff = 0;
+
+    while (1) {
+        // Upload and lock the PLL before assessing, so a clear channel is followed directly by TX_START
+        if (!loaded) {
+            res = at86rf212_load_tx(csma->device, length, data);
+            if (res < 0) {
+                return res;
+            }
+            loaded = 1;
+        }
+
+        if (backoff > 0) {
+            PLATFORM_SLEEP_US((uint32_t)backoff * csma->config.unit_backoff_us);
+        }
+
+        // CCA and random bits need RX_ON, the PLL stays locked
+        res = at86rf212_set_state_blocking(csma->device, AT86RF212_CMD_RX_ON);
+        if (res < 0) {
+            return res;
+        }
+
+        // The radio may have been left in PLL_ON by the last transmission, so the initial backoff
+        // is only drawn once listening
+        if (!started) {
+            res = at86rf212_csma_rnd(csma, &rnd);
+            if (res < 0) {
+                return res;
+            }
+            backoff = at86rf212_csma_begin(csma, rnd);
+            started = 1;
+
+            if (backoff > 0) {
+                // Back off in PLL_ON, as between assessments
+                res = at86rf212_set_state(csma->device, AT86RF212_CMD_FORCE_PLL_ON);
+                if (res < 0) {
+                    return res;
+                }
+                continue;
+            }
+        }
+
+        res = at86rf212_csma_rnd(csma, &rnd);
+        if (res < 0) {
+            return res;
+        }
+
+        res = at86rf212_cca(csma->device, &clear);
+        if (res < 0) {
+            return res;
+        }
+
+        // Stop listening, a frame received since leaving PLL_ON has replaced the upload
+        res = at86rf212_set_state(csma->device, AT86RF212_CMD_FORCE_PLL_ON);
+        if (res < 0) {
+            return res;
+        }
+        res = at86rf212_get_irq_status(csma->device, &irq);
+        if (res < 0) {
+            return res;
+        }
+        if ((irq & AT86RF212_IRQ_2_RX_START) != 0) {
+            clear = 0;
+            loaded = 0;
+        }
+
+        action = at86rf212_csma_step(csma, clear, rnd, &backoff);
+        if (action == AT86RF212_CSMA_TRANSMIT) {
+            break;
+        } else if (action == AT86RF212_CSMA_FAIL) {
+            AT86RF212_DEBUG_PRINT("CSMA channel access failure after %d assessments\r\n", csma->assessments);
+            return AT86RF212_ERROR_CHANNEL_ACCESS;
+        }
+    }
+
+    return at86rf212_resend(csma->device, 0, NULL);
+}
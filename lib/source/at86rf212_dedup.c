@@ -0,0 +1,219 @@
+/*
+ * at86rf212 duplicate frame suppression
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_dedup.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+#define AT86RF212_DEDUP_MASK        (AT86RF212_DEDUP_SETS - 1)
+
+// Duplicate key extracted from a frame header
+struct at86rf212_dedup_key_s {
+    uint64_t addr;
+    uint16_t hash;
+    uint8_t seq;
+    uint8_t mode;
+};
+
+static const uint8_t at86rf212_dedup_addr_len[4] = {0, 0, AT86RF212_MAC_SHORT_ADDR_LEN, AT86RF212_MAC_EXT_ADDR_LEN};
+
+static inline struct at86rf212_dedup_entry_s* at86rf212_dedup_set(struct at86rf212_dedup_s *dedup,
+                                                                  const struct at86rf212_dedup_key_s *key)
+{
+    uint64_t h = (key->addr ^ ((uint64_t)key->mode << 62)) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ key->seq) * 0x9E3779B97F4A7C15ULL;
+    return dedup->sets[(h >> 32) & AT86RF212_DEDUP_MASK];
+}
+
+static int at86rf212_dedup_find(struct at86rf212_dedup_s *dedup, const struct at86rf212_dedup_key_s *key, uint32_t now)
+{
+    struct at86rf212_dedup_entry_s *set = at86rf212_dedup_set(dedup, key);
+
+    for (int i = 0; i < AT86RF212_DEDUP_WAYS; i++) {
+        if ((set[i].addr == key->addr) && (set[i].seq == key->seq) && (set[i].mode == key->mode)
+            && (set[i].hash == key->hash) && ((now - set[i].time) <= dedup->lifetime)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void at86rf212_dedup_insert(struct at86rf212_dedup_s *dedup, const struct at86rf212_dedup_key_s *key, uint32_t now)
+{
+    struct at86rf212_dedup_entry_s *set = at86rf212_dedup_set(dedup, key);
+    struct at86rf212_dedup_entry_s *victim = &set[0];
+
+    // Replace an empty entry if available, otherwise the oldest
+    for (int i = 0; i < AT86RF212_DEDUP_WAYS; i++) {
+        if (set[i].mode == AT86RF212_MAC_ADDR_NONE) {
+            victim = &set[i];
+            break;
+        }
+        if ((now - set[i].time) > (now - victim->time)) {
+            victim = &set[i];
+        }
+    }
+
+    if ((victim->mode != AT86RF212_MAC_ADDR_NONE) && ((now - victim->time) <= dedup->lifetime)) {
+        dedup->stats.evictions ++;
+    }
+
+    victim->addr = key->addr;
+    victim->time = now;
+    victim->hash = key->hash;
+    victim->seq = key->seq;
+    victim->mode = key->mode;
+}
+
+// Extract the duplicate key from a PSDU header, returns 0 for frames that can not be tracked
+static int at86rf212_dedup_key(const struct at86rf212_dedup_s *dedup, uint8_t frame_len, const uint8_t* header,
+                               struct at86rf212_dedup_key_s *key)
+{
+    uint16_t fcf;
+    uint8_t version, dest_pan, src_pan, pos;
+    uint8_t len = (frame_len > AT86RF212_DEDUP_FETCH_LEN) ? AT86RF212_DEDUP_FETCH_LEN : frame_len;
+
+    if (len < 2) {
+        return 0;
+    }
+
+    fcf = header[0] | (header[1] << 8);
+    version = (fcf >> AT86RF212_MAC_FCF_VERSION_SHIFT) & 0x03;
+    key->mode = (fcf >> AT86RF212_MAC_FCF_SRC_MODE_SHIFT) & 0x03;
+    if ((key->mode != AT86RF212_MAC_ADDR_SHORT) && (key->mode != AT86RF212_MAC_ADDR_EXTENDED)) {
+        return 0;
+    }
+    if ((version == AT86RF212_MAC_VERSION_2015) && (fcf & AT86RF212_MAC_FCF_SEQ_SUPPRESS)) {
+        return 0;
+    }
+
+    at86rf212_mac_pan_presence(fcf, &dest_pan, &src_pan);
+    pos = 3 + (dest_pan ? 2 : 0) + at86rf212_dedup_addr_len[(fcf >> AT86RF212_MAC_FCF_DST_MODE_SHIFT) & 0x03]
+          + (src_pan ? 2 : 0);
+    if ((pos + at86rf212_dedup_addr_len[key->mode]) > len) {
+        return 0;
+    }
+
+    key->seq = header[2];
+    if (key->mode == AT86RF212_MAC_ADDR_SHORT) {
+        key->addr = at86rf212_mac_short_addr(&header[pos]);
+    } else {
+        key->addr = 0;
+        for (int i = AT86RF212_MAC_EXT_ADDR_LEN - 1; i >= 0; i--) {
+            key->addr = (key->addr << 8) | header[pos + i];
+        }
+    }
+
+    // FNV-1a over the frame length and leading bytes, folded to 16 bits
+    key->hash = 0;
+    if (dedup->use_hash) {
+        uint32_t h = 2166136261u ^ frame_len;
+        h *= 16777619u;
+        for (int i = 0; i < len; i++) {
+            h = (h ^ header[i]) * 16777619u;
+        }
+        key->hash = (h >> 16) ^ (h & 0xFFFF);
+    }
+
+    return 1;
+}
+
+void at86rf212_dedup_init(struct at86rf212_dedup_s *dedup, uint32_t lifetime, uint8_t use_hash)
+{
+    memset(dedup, 0, sizeof(struct at86rf212_dedup_s));
+    dedup->lifetime = lifetime;
+    dedup->use_hash = use_hash;
+}
+
+int at86rf212_dedup_check(struct at86rf212_dedup_s *dedup, uint8_t mode, uint64_t addr,
+                          uint8_t seq, uint16_t hash, uint32_t now)
+{
+    struct at86rf212_dedup_key_s key = {addr, hash, seq, mode};
+
+    dedup->stats.lookups ++;
+    if (at86rf212_dedup_find(dedup, &key, now)) {
+        dedup->stats.duplicates ++;
+        return 1;
+    }
+    at86rf212_dedup_insert(dedup, &key, now);
+
+    return 0;
+}
+
+int at86rf212_dedup_check_header(struct at86rf212_dedup_s *dedup, uint8_t length,
+                                 const uint8_t* header, uint32_t now)
+{
+    struct at86rf212_dedup_key_s key;
+
+    if (at86rf212_dedup_key(dedup, length, header, &key) == 0) {
+        dedup->stats.untracked ++;
+        return 0;
+    }
+
+    return at86rf212_dedup_check(dedup, key.mode, key.addr, key.seq, key.hash, now);
+}
+
+int at86rf212_get_rx_dedup(struct at86rf212_s *device, struct at86rf212_dedup_s *dedup, uint32_t now,
+                           uint8_t* length, uint8_t* data)
+{
+    int res;
+    uint8_t frame_len;
+    uint8_t buffer[AT86RF212_LEN_FIELD_LEN + AT86RF212_DEDUP_FETCH_LEN];
+    uint8_t fetched;
+    int tracked;
+    struct at86rf212_dedup_key_s key;
+
+    // Fetch the PHR and leading PSDU bytes
+    res = at86rf212_read_sram(device, 0, sizeof(buffer), buffer);
+    if (res < 0) {
+        at86rf212_discard_rx(device);
+        return AT86RF212_ERROR_DRIVER;
+    }
+
+    frame_len = buffer[0];
+    if (frame_len > AT86RF212_MAX_LENGTH) {
+        at86rf212_discard_rx(device);
+        return AT86RF212_ERROR_LEN;
+    }
+    fetched = (frame_len < AT86RF212_DEDUP_FETCH_LEN) ? frame_len : AT86RF212_DEDUP_FETCH_LEN;
+
+    // The CRC field is not part of the key, and stale bytes beyond the frame must not be hashed
+    tracked = at86rf212_dedup_key(dedup, (frame_len > AT86RF212_CRC_LEN) ? frame_len - AT86RF212_CRC_LEN : 0,
+                                  buffer + AT86RF212_LEN_FIELD_LEN, &key);
+    if (tracked == 0) {
+        dedup->stats.untracked ++;
+    } else {
+        dedup->stats.lookups ++;
+        if (at86rf212_dedup_find(dedup, &key, now)) {
+            dedup->stats.duplicates ++;
+            dedup->stats.bytes_saved += frame_len - fetched + AT86RF212_FRAME_RX_OVERHEAD;
+            res = at86rf212_discard_rx(device);
+            if (res < 0) {
+                return res;
+            }
+            return AT86RF212_RES_REJECTED;
+        }
+    }
+
+    // The header bytes already fetched are not read again
+    memcpy(data, buffer + AT86RF212_LEN_FIELD_LEN, fetched);
+    res = at86rf212_get_rx_remainder(device, frame_len, fetched, length, data);
+    if (res < 0) {
+        return res;
+    }
+
+    // Only record frames that arrived intact, so a retry of a corrupted frame is still delivered
+    if (tracked && ((data[frame_len + 2] & AT86RF212_RX_STATUS_CRC_VALID_MASK) != 0)) {
+        at86rf212_dedup_insert(dedup, &key, now);
+    }
+
+    return AT86RF212_RES_OK;
+}
@@ -0,0 +1,201 @@
+/*
+ * at86rf212 header-first receive filtering
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_filter.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+// Frame control field layout
+#define AT86RF212_FCF_TYPE_MASK             0x07    //!< Frame type (FCF byte 0)
+#define AT86RF212_FCF_PAN_COMP_SHIFT        6       //!< PAN ID compression (FCF byte 0)
+#define AT86RF212_FCF_DST_MODE_MASK         0x0C    //!< Destination addressing mode (FCF byte 1)
+#define AT86RF212_FCF_DST_MODE_SHIFT        2
+#define AT86RF212_FCF_DST_MODE_SHORT        0x08
+#define AT86RF212_FCF_SRC_MODE_MASK         0xC0    //!< Source addressing mode (FCF byte 1)
+#define AT86RF212_FCF_SRC_MODE_SHORT        0x80
+
+// Fixed header offsets (frames with a short destination address)
+#define AT86RF212_HDR_DST_PAN_OFFSET        3
+#define AT86RF212_HDR_DST_ADDR_OFFSET       5
+
+// Source address offset, indexed by (destination addressing mode << 1) | PAN ID compression
+static const uint8_t at86rf212_src_addr_offsets[8] = {
+    5, 3,       // No destination address
+    5, 3,       // Reserved
+    9, 7,       // Short destination address
+    15, 13      // Extended destination address
+};
+
+static void at86rf212_filter_add_cond(struct at86rf212_filter_s *filter, uint8_t offset, uint8_t mask, uint8_t value)
+{
+    struct at86rf212_filter_match_s *cond = &filter->conds[filter->num_conds];
+
+    cond->offset = offset;
+    cond->mask = mask;
+    cond->value = value & mask;
+    filter->num_conds ++;
+
+    if (filter->cond_len < (offset + 1)) {
+        filter->cond_len = offset + 1;
+    }
+}
+
+int at86rf212_filter_compile(struct at86rf212_filter_s *filter, const struct at86rf212_filter_spec_s *spec)
+{
+    uint8_t dest_short;
+
+    if ((spec->num_sources > AT86RF212_FILTER_MAX_ADDRESSES)
+        || (spec->num_matches > AT86RF212_FILTER_MAX_MATCHES)) {
+        return AT86RF212_ERROR_LEN;
+    }
+    for (int i = 0; i < spec->num_matches; i++) {
+        if (spec->matches[i].offset >= AT86RF212_FILTER_MAX_HEADER) {
+            return AT86RF212_ERROR_LEN;
+        }
+    }
+
+    memset(filter, 0, sizeof(struct at86rf212_filter_s));
+
+    // Frame type is always evaluated, so the first byte is always fetched
+    filter->type_map = (spec->frame_types != 0) ? spec->frame_types : 0xFF;
+    filter->cond_len = 1;
+
+    // Destination filters require a short destination address
+    dest_short = spec->match_dest_pan || spec->match_dest_addr;
+    if (dest_short) {
+        at86rf212_filter_add_cond(filter, 1, AT86RF212_FCF_DST_MODE_MASK, AT86RF212_FCF_DST_MODE_SHORT);
+    }
+    if (spec->match_dest_pan) {
+        at86rf212_filter_add_cond(filter, AT86RF212_HDR_DST_PAN_OFFSET, 0xFF, spec->dest_pan & 0xFF);
+        at86rf212_filter_add_cond(filter, AT86RF212_HDR_DST_PAN_OFFSET + 1, 0xFF, (spec->dest_pan >> 8) & 0xFF);
+    }
+    if (spec->match_dest_addr) {
+        filter->dests[filter->num_dests++] = spec->dest_addr;
+        if (spec->accept_broadcast) {
+            filter->dests[filter->num_dests++] = AT86RF212_FILTER_BROADCAST;
+        }
+        if (filter->cond_len < (AT86RF212_HDR_DST_ADDR_OFFSET + 2)) {
+            filter->cond_len = AT86RF212_HDR_DST_ADDR_OFFSET + 2;
+        }
+    }
+
+    // Source filters require a short source address, whose position depends on the header layout
+    if (spec->num_sources > 0) {
+        at86rf212_filter_add_cond(filter, 1, AT86RF212_FCF_SRC_MODE_MASK, AT86RF212_FCF_SRC_MODE_SHORT);
+        for (int i = 0; i < spec->num_sources; i++) {
+            filter->sources[i] = spec->sources[i];
+        }
+        filter->num_sources = spec->num_sources;
+    }
+
+    for (int i = 0; i < spec->num_matches; i++) {
+        at86rf212_filter_add_cond(filter, spec->matches[i].offset, spec->matches[i].mask, spec->matches[i].value);
+    }
+
+    // Fetch enough of the header to cover every condition, including the furthest source address
+    filter->header_len = filter->cond_len;
+    if (filter->num_sources > 0) {
+        uint8_t src_end = (dest_short ? at86rf212_src_addr_offsets[4] : at86rf212_src_addr_offsets[6]) + 2;
+        if (filter->header_len < src_end) {
+            filter->header_len = src_end;
+        }
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_filter_match(const struct at86rf212_filter_s *filter, uint8_t frame_len, const uint8_t *header)
+{
+    uint8_t fail = 0;
+    uint8_t hit;
+    uint16_t addr;
+
+    fail |= (frame_len < filter->cond_len);
+    fail |= ((filter->type_map >> (header[0] & AT86RF212_FCF_TYPE_MASK)) & 0x01) ^ 0x01;
+
+    for (int i = 0; i < filter->num_conds; i++) {
+        fail |= (header[filter->conds[i].offset] & filter->conds[i].mask) ^ filter->conds[i].value;
+    }
+
+    if (filter->num_dests > 0) {
+        addr = header[AT86RF212_HDR_DST_ADDR_OFFSET] | (header[AT86RF212_HDR_DST_ADDR_OFFSET + 1] << 8);
+        hit = 0;
+        for (int i = 0; i < filter->num_dests; i++) {
+            hit |= (addr == filter->dests[i]);
+        }
+        fail |= hit ^ 0x01;
+    }
+
+    if (filter->num_sources > 0) {
+        uint8_t index = ((header[1] & AT86RF212_FCF_DST_MODE_MASK) >> (AT86RF212_FCF_DST_MODE_SHIFT - 1))
+                        | ((header[0] >> AT86RF212_FCF_PAN_COMP_SHIFT) & 0x01);
+        uint8_t offset = at86rf212_src_addr_offsets[index];
+
+        fail |= (frame_len < (offset + 2));
+        addr = header[offset] | (header[offset + 1] << 8);
+        hit = 0;
+        for (int i = 0; i < filter->num_sources; i++) {
+            hit |= (addr == filter->sources[i]);
+        }
+        fail |= hit ^ 0x01;
+    }
+
+    return (fail == 0) ? 1 : 0;
+}
+
+int at86rf212_get_rx_filtered(struct at86rf212_s *device, struct at86rf212_filter_s *filter,
+                              uint8_t* length, uint8_t* data)
+{
+    int res;
+    uint8_t frame_len;
+    uint8_t buffer[AT86RF212_LEN_FIELD_LEN + AT86RF212_FILTER_MAX_HEADER];
+
+    // Fetch the PHR and the header bytes used by the filter
+    // SRAM reads leave the frame buffer protected, so frames that are not downloaded are discarded.
+    res = at86rf212_read_sram(device, 0, AT86RF212_LEN_FIELD_LEN + filter->header_len, buffer);
+    if (res < 0) {
+        at86rf212_discard_rx(device);
+        return AT86RF212_ERROR_DRIVER;
+    }
+
+    frame_len = buffer[0];
+    if (frame_len > AT86RF212_MAX_LENGTH) {
+        at86rf212_discard_rx(device);
+        return AT86RF212_ERROR_LEN;
+    }
+
+    // Stale buffer contents beyond the frame must not take part in matching
+    for (int i = frame_len; i < filter->header_len; i++) {
+        buffer[AT86RF212_LEN_FIELD_LEN + i] = 0x00;
+    }
+
+    filter->stats.frames ++;
+    filter->stats.bytes_fetched += AT86RF212_LEN_FIELD_LEN + filter->header_len;
+
+    if (at86rf212_filter_match(filter, frame_len, buffer + AT86RF212_LEN_FIELD_LEN) == 0) {
+        filter->stats.rejected ++;
+        filter->stats.bytes_fetched += AT86RF212_LEN_FIELD_LEN;
+        res = at86rf212_discard_rx(device);
+        if (res < 0) {
+            return res;
+        }
+        return AT86RF212_RES_REJECTED;
+    }
+
+    res = at86rf212_get_rx(device, length, data);
+    if (res < 0) {
+        return res;
+    }
+
+    filter->stats.accepted ++;
+    filter->stats.bytes_fetched += AT86RF212_LEN_FIELD_LEN * 2 + frame_len + AT86RF212_FRAME_RX_OVERHEAD;
+
+    return AT86RF212_RES_OK;
+}
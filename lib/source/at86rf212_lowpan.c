@@ -0,0 +1,843 @@
+/*
+ * at86rf212 6LoWPAN adaptation layer
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_lowpan.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+// IPHC encoding (RFC 6282 section 3.1)
+#define AT86RF212_LOWPAN_IPHC_TF_SHIFT      3
+#define AT86RF212_LOWPAN_IPHC_NH            0x04
+#define AT86RF212_LOWPAN_IPHC_HLIM_MASK     0x03
+#define AT86RF212_LOWPAN_IPHC_CID           0x80
+#define AT86RF212_LOWPAN_IPHC_SAC           0x40
+#define AT86RF212_LOWPAN_IPHC_SAM_SHIFT     4
+#define AT86RF212_LOWPAN_IPHC_M             0x08
+#define AT86RF212_LOWPAN_IPHC_DAC           0x04
+#define AT86RF212_LOWPAN_IPHC_DAM_SHIFT     0
+
+// NHC UDP encoding (RFC 6282 section 4.3)
+#define AT86RF212_LOWPAN_NHC_UDP            0xF0
+#define AT86RF212_LOWPAN_NHC_UDP_MASK       0xF8
+#define AT86RF212_LOWPAN_NHC_UDP_CHECKSUM   0x04
+#define AT86RF212_LOWPAN_NHC_UDP_PORTS      0x03
+
+#define AT86RF212_LOWPAN_NEXT_UDP           17
+
+enum at86rf212_lowpan_reasm_state_e {
+    AT86RF212_LOWPAN_REASM_FREE = 0,
+    AT86RF212_LOWPAN_REASM_ACTIVE,
+    AT86RF212_LOWPAN_REASM_COMPLETE
+};
+
+static const uint8_t at86rf212_lowpan_short_iid[6] = {0x00, 0x00, 0x00, 0xFF, 0xFE, 0x00};
+
+void at86rf212_lowpan_default_config(struct at86rf212_lowpan_config_s *config)
+{
+    memset(config, 0, sizeof(struct at86rf212_lowpan_config_s));
+    config->reasm_timeout_us = 60000000;
+}
+
+int at86rf212_lowpan_init(struct at86rf212_lowpan_s *lowpan, const struct at86rf212_lowpan_config_s *config)
+{
+    memset(lowpan, 0, sizeof(struct at86rf212_lowpan_s));
+    lowpan->config = *config;
+
+    return AT86RF212_RES_OK;
+}
+
+void at86rf212_lowpan_ll_addr(uint8_t mode, const uint8_t* addr, struct at86rf212_lowpan_ll_s *ll)
+{
+    uint8_t len = (mode == AT86RF212_MAC_ADDR_EXTENDED) ? AT86RF212_MAC_EXT_ADDR_LEN :
+                  (mode == AT86RF212_MAC_ADDR_SHORT) ? AT86RF212_MAC_SHORT_ADDR_LEN : 0;
+
+    ll->mode = mode;
+    ll->addr = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        ll->addr |= (uint64_t)addr[i] << (i * 8);
+    }
+}
+
+static inline int at86rf212_lowpan_is_zero(const uint8_t* data, uint8_t length)
+{
+    for (uint8_t i = 0; i < length; i++) {
+        if (data[i] != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Derive an interface identifier from a link layer address (RFC 4944 section 6, RFC 6282 section 3.2.2)
+static int at86rf212_lowpan_iid(const struct at86rf212_lowpan_ll_s *ll, uint8_t* iid)
+{
+    if (ll->mode == AT86RF212_MAC_ADDR_EXTENDED) {
+        for (uint8_t i = 0; i < 8; i++) {
+            iid[i] = (ll->addr >> (56 - i * 8)) & 0xFF;
+        }
+        iid[0] ^= 0x02;
+        return 1;
+    }
+    if (ll->mode == AT86RF212_MAC_ADDR_SHORT) {
+        memcpy(iid, at86rf212_lowpan_short_iid, sizeof(at86rf212_lowpan_short_iid));
+        iid[6] = (ll->addr >> 8) & 0xFF;
+        iid[7] = ll->addr & 0xFF;
+        return 1;
+    }
+    return 0;
+}
+
+// Compress the interface identifier of an address whose prefix is elided, returns the SAM/DAM mode
+static uint8_t at86rf212_lowpan_compress_iid(const uint8_t* addr, const struct at86rf212_lowpan_ll_s *ll,
+                                             uint8_t* out, uint8_t* pos)
+{
+    uint8_t derived[8];
+
+    if (at86rf212_lowpan_iid(ll, derived) && (memcmp(&addr[8], derived, 8) == 0)) {
+        return 3;
+    }
+    if (memcmp(&addr[8], at86rf212_lowpan_short_iid, sizeof(at86rf212_lowpan_short_iid)) == 0) {
+        out[(*pos)++] = addr[14];
+        out[(*pos)++] = addr[15];
+        return 2;
+    }
+    memcpy(&out[*pos], &addr[8], 8);
+    *pos += 8;
+    return 1;
+}
+
+// Compress a unicast address, returns the address mode and context flag for the IPHC header
+static uint8_t at86rf212_lowpan_compress_addr(struct at86rf212_lowpan_s *lowpan, const uint8_t* addr,
+                                              const struct at86rf212_lowpan_ll_s *ll, uint8_t* out, uint8_t* pos,
+                                              uint8_t* context)
+{
+    *context = 0;
+
+    if ((addr[0] == 0xFE) && (addr[1] == 0x80) && at86rf212_lowpan_is_zero(&addr[2], 6)) {
+        return at86rf212_lowpan_compress_iid(addr, ll, out, pos);
+    }
+    if (lowpan->config.context_valid && (memcmp(addr, lowpan->config.context, 8) == 0)) {
+        *context = 1;
+        return at86rf212_lowpan_compress_iid(addr, ll, out, pos);
+    }
+
+    memcpy(&out[*pos], addr, 16);
+    *pos += 16;
+    return 0;
+}
+
+static int at86rf212_lowpan_compress(struct at86rf212_lowpan_s *lowpan,
+                                     const struct at86rf212_lowpan_ll_s *src, const struct at86rf212_lowpan_ll_s *dst,
+                                     uint16_t length, const uint8_t* ip, uint8_t* out, uint16_t* consumed)
+{
+    uint8_t iphc0 = AT86RF212_LOWPAN_DISPATCH_IPHC;
+    uint8_t iphc1 = 0;
+    uint8_t pos = 2;
+    uint8_t tc, ecn, dscp, mode, context;
+    uint32_t flow;
+    uint8_t udp;
+
+    if ((length < AT86RF212_LOWPAN_IPV6_HEADER) || ((ip[0] >> 4) != 6)
+        || (((ip[4] << 8) | ip[5]) != (length - AT86RF212_LOWPAN_IPV6_HEADER))) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    // Traffic class and flow label, the traffic class is carried as ECN then DSCP
+    tc = ((ip[0] << 4) | (ip[1] >> 4)) & 0xFF;
+    ecn = tc & 0x03;
+    dscp = tc >> 2;
+    flow = ((ip[1] & 0x0F) << 16) | (ip[2] << 8) | ip[3];
+    if ((flow == 0) && (tc == 0)) {
+        iphc0 |= 3 << AT86RF212_LOWPAN_IPHC_TF_SHIFT;
+    } else if (flow == 0) {
+        iphc0 |= 2 << AT86RF212_LOWPAN_IPHC_TF_SHIFT;
+        out[pos++] = (ecn << 6) | dscp;
+    } else if (dscp == 0) {
+        iphc0 |= 1 << AT86RF212_LOWPAN_IPHC_TF_SHIFT;
+        out[pos++] = (ecn << 6) | ((flow >> 16) & 0x0F);
+        out[pos++] = (flow >> 8) & 0xFF;
+        out[pos++] = flow & 0xFF;
+    } else {
+        out[pos++] = (ecn << 6) | dscp;
+        out[pos++] = (flow >> 16) & 0x0F;
+        out[pos++] = (flow >> 8) & 0xFF;
+        out[pos++] = flow & 0xFF;
+    }
+
+    // Next header, UDP headers are compressed when the UDP length is consistent
+    udp = (ip[6] == AT86RF212_LOWPAN_NEXT_UDP)
+          && (length >= (AT86RF212_LOWPAN_IPV6_HEADER + AT86RF212_LOWPAN_UDP_HEADER))
+          && (((ip[44] << 8) | ip[45]) == (length - AT86RF212_LOWPAN_IPV6_HEADER));
+    if (udp) {
+        iphc0 |= AT86RF212_LOWPAN_IPHC_NH;
+    } else {
+        out[pos++] = ip[6];
+    }
+
+    switch (ip[7]) {
+    case 1:
+        iphc0 |= 1;
+        break;
+    case 64:
+        iphc0 |= 2;
+        break;
+    case 255:
+        iphc0 |= 3;
+        break;
+    default:
+        out[pos++] = ip[7];
+        break;
+    }
+
+    // Source address, the unspecified address uses the stateful mode 0
+    if (at86rf212_lowpan_is_zero(&ip[8], 16)) {
+        iphc1 |= AT86RF212_LOWPAN_IPHC_SAC;
+    } else {
+        mode = at86rf212_lowpan_compress_addr(lowpan, &ip[8], src, out, &pos, &context);
+        iphc1 |= (context ? AT86RF212_LOWPAN_IPHC_SAC : 0) | (mode << AT86RF212_LOWPAN_IPHC_SAM_SHIFT);
+    }
+
+    // Destination address
+    if (ip[24] == 0xFF) {
+        iphc1 |= AT86RF212_LOWPAN_IPHC_M;
+        if ((ip[25] == 0x02) && at86rf212_lowpan_is_zero(&ip[26], 13)) {
+            iphc1 |= 3;
+            out[pos++] = ip[39];
+        } else if (at86rf212_lowpan_is_zero(&ip[26], 11)) {
+            iphc1 |= 2;
+            out[pos++] = ip[25];
+            memcpy(&out[pos], &ip[37], 3);
+            pos += 3;
+        } else if (at86rf212_lowpan_is_zero(&ip[26], 9)) {
+            iphc1 |= 1;
+            out[pos++] = ip[25];
+            memcpy(&out[pos], &ip[35], 5);
+            pos += 5;
+        } else {
+            memcpy(&out[pos], &ip[24], 16);
+            pos += 16;
+        }
+    } else {
+        mode = at86rf212_lowpan_compress_addr(lowpan, &ip[24], dst, out, &pos, &context);
+        iphc1 |= (context ? AT86RF212_LOWPAN_IPHC_DAC : 0) | (mode << AT86RF212_LOWPAN_IPHC_DAM_SHIFT);
+    }
+
+    out[0] = iphc0;
+    out[1] = iphc1;
+    *consumed = AT86RF212_LOWPAN_IPV6_HEADER;
+
+    // UDP ports, the length is elided and the checksum is carried inline
+    if (udp) {
+        uint16_t src_port = (ip[40] << 8) | ip[41];
+        uint16_t dst_port = (ip[42] << 8) | ip[43];
+
+        if (((src_port & 0xFFF0) == 0xF0B0) && ((dst_port & 0xFFF0) == 0xF0B0)) {
+            out[pos++] = AT86RF212_LOWPAN_NHC_UDP | 0x03;
+            out[pos++] = ((src_port & 0x0F) << 4) | (dst_port & 0x0F);
+        } else if ((dst_port & 0xFF00) == 0xF000) {
+            out[pos++] = AT86RF212_LOWPAN_NHC_UDP | 0x01;
+            out[pos++] = ip[40];
+            out[pos++] = ip[41];
+            out[pos++] = ip[43];
+        } else if ((src_port & 0xFF00) == 0xF000) {
+            out[pos++] = AT86RF212_LOWPAN_NHC_UDP | 0x02;
+            out[pos++] = ip[41];
+            out[pos++] = ip[42];
+            out[pos++] = ip[43];
+        } else {
+            out[pos++] = AT86RF212_LOWPAN_NHC_UDP;
+            memcpy(&out[pos], &ip[40], 4);
+            pos += 4;
+        }
+        out[pos++] = ip[46];
+        out[pos++] = ip[47];
+        *consumed += AT86RF212_LOWPAN_UDP_HEADER;
+    }
+
+    return pos;
+}
+
+// Decompress an address interface identifier
+static int at86rf212_lowpan_decompress_iid(uint8_t mode, const struct at86rf212_lowpan_ll_s *ll,
+                                           uint8_t length, const uint8_t* in, uint8_t* pos, uint8_t* addr)
+{
+    switch (mode) {
+    case 1:
+        if ((*pos + 8) > length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        memcpy(&addr[8], &in[*pos], 8);
+        *pos += 8;
+        break;
+    case 2:
+        if ((*pos + 2) > length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        memcpy(&addr[8], at86rf212_lowpan_short_iid, sizeof(at86rf212_lowpan_short_iid));
+        addr[14] = in[(*pos)++];
+        addr[15] = in[(*pos)++];
+        break;
+    default:
+        if (!at86rf212_lowpan_iid(ll, &addr[8])) {
+            return AT86RF212_ERROR_LEN;
+        }
+        break;
+    }
+    return AT86RF212_RES_OK;
+}
+
+static int at86rf212_lowpan_decompress_addr(struct at86rf212_lowpan_s *lowpan, uint8_t context, uint8_t mode,
+                                            const struct at86rf212_lowpan_ll_s *ll,
+                                            uint8_t length, const uint8_t* in, uint8_t* pos, uint8_t* addr)
+{
+    if (mode == 0) {
+        if (context) {
+            memset(addr, 0, 16);
+            return AT86RF212_RES_OK;
+        }
+        if ((*pos + 16) > length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        memcpy(addr, &in[*pos], 16);
+        *pos += 16;
+        return AT86RF212_RES_OK;
+    }
+
+    if (context) {
+        if (!lowpan->config.context_valid) {
+            return AT86RF212_ERROR_LEN;
+        }
+        memcpy(addr, lowpan->config.context, 8);
+    } else {
+        memset(addr, 0, 8);
+        addr[0] = 0xFE;
+        addr[1] = 0x80;
+    }
+    return at86rf212_lowpan_decompress_iid(mode, ll, length, in, pos, addr);
+}
+
+// Decompress an IPHC header into ip, returns the number of compressed bytes consumed
+// The IPv6 payload length and UDP length are left for the caller, who knows the datagram size.
+static int at86rf212_lowpan_decompress(struct at86rf212_lowpan_s *lowpan,
+                                       const struct at86rf212_lowpan_ll_s *src, const struct at86rf212_lowpan_ll_s *dst,
+                                       uint8_t length, const uint8_t* in, uint8_t* ip, uint8_t* header_len, uint8_t* udp)
+{
+    uint8_t iphc0, iphc1;
+    uint8_t pos = 2;
+    uint8_t tf, ecn = 0, dscp = 0;
+    uint32_t flow = 0;
+    int res;
+
+    if (length < 2) {
+        return AT86RF212_ERROR_LEN;
+    }
+    iphc0 = in[0];
+    iphc1 = in[1];
+
+    // Only context 0 is supported
+    if (iphc1 & AT86RF212_LOWPAN_IPHC_CID) {
+        if ((length < 3) || (in[pos++] != 0)) {
+            return AT86RF212_ERROR_LEN;
+        }
+    }
+
+    tf = (iphc0 >> AT86RF212_LOWPAN_IPHC_TF_SHIFT) & 0x03;
+    if ((pos + ((tf == 0) ? 4 : (tf == 1) ? 3 : (tf == 2) ? 1 : 0)) > length) {
+        return AT86RF212_ERROR_LEN;
+    }
+    if (tf != 3) {
+        ecn = in[pos] >> 6;
+    }
+    switch (tf) {
+    case 0:
+        dscp = in[pos] & 0x3F;
+        flow = ((in[pos + 1] & 0x0F) << 16) | (in[pos + 2] << 8) | in[pos + 3];
+        pos += 4;
+        break;
+    case 1:
+        flow = ((in[pos] & 0x0F) << 16) | (in[pos + 1] << 8) | in[pos + 2];
+        pos += 3;
+        break;
+    case 2:
+        dscp = in[pos] & 0x3F;
+        pos += 1;
+        break;
+    default:
+        break;
+    }
+    ip[0] = 0x60 | (dscp >> 2);
+    ip[1] = ((dscp & 0x03) << 6) | (ecn << 4) | ((flow >> 16) & 0x0F);
+    ip[2] = (flow >> 8) & 0xFF;
+    ip[3] = flow & 0xFF;
+
+    *udp = (iphc0 & AT86RF212_LOWPAN_IPHC_NH) ? 1 : 0;
+    if (*udp) {
+        ip[6] = AT86RF212_LOWPAN_NEXT_UDP;
+    } else {
+        if (pos >= length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        ip[6] = in[pos++];
+    }
+
+    switch (iphc0 & AT86RF212_LOWPAN_IPHC_HLIM_MASK) {
+    case 1:
+        ip[7] = 1;
+        break;
+    case 2:
+        ip[7] = 64;
+        break;
+    case 3:
+        ip[7] = 255;
+        break;
+    default:
+        if (pos >= length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        ip[7] = in[pos++];
+        break;
+    }
+
+    res = at86rf212_lowpan_decompress_addr(lowpan, iphc1 & AT86RF212_LOWPAN_IPHC_SAC,
+                                           (iphc1 >> AT86RF212_LOWPAN_IPHC_SAM_SHIFT) & 0x03,
+                                           src, length, in, &pos, &ip[8]);
+    if (res < 0) {
+        return res;
+    }
+
+    if (iphc1 & AT86RF212_LOWPAN_IPHC_M) {
+        uint8_t dam = iphc1 & 0x03;
+        uint8_t inline_len = (dam == 0) ? 16 : (dam == 1) ? 6 : (dam == 2) ? 4 : 1;
+
+        if ((iphc1 & AT86RF212_LOWPAN_IPHC_DAC) || ((pos + inline_len) > length)) {
+            return AT86RF212_ERROR_LEN;
+        }
+        memset(&ip[24], 0, 16);
+        ip[24] = 0xFF;
+        switch (dam) {
+        case 0:
+            memcpy(&ip[24], &in[pos], 16);
+            break;
+        case 1:
+            ip[25] = in[pos];
+            memcpy(&ip[35], &in[pos + 1], 5);
+            break;
+        case 2:
+            ip[25] = in[pos];
+            memcpy(&ip[37], &in[pos + 1], 3);
+            break;
+        default:
+            ip[25] = 0x02;
+            ip[39] = in[pos];
+            break;
+        }
+        pos += inline_len;
+    } else {
+        res = at86rf212_lowpan_decompress_addr(lowpan, iphc1 & AT86RF212_LOWPAN_IPHC_DAC,
+                                               (iphc1 >> AT86RF212_LOWPAN_IPHC_DAM_SHIFT) & 0x03,
+                                               dst, length, in, &pos, &ip[24]);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    *header_len = AT86RF212_LOWPAN_IPV6_HEADER;
+    if (*udp) {
+        uint8_t nhc, ports_len;
+
+        if (pos >= length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        nhc = in[pos++];
+        if (((nhc & AT86RF212_LOWPAN_NHC_UDP_MASK) != AT86RF212_LOWPAN_NHC_UDP)
+            || (nhc & AT86RF212_LOWPAN_NHC_UDP_CHECKSUM)) {
+            return AT86RF212_ERROR_LEN;
+        }
+        ports_len = ((nhc & 0x03) == 0) ? 4 : ((nhc & 0x03) == 3) ? 1 : 3;
+        if ((pos + ports_len + 2) > length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        switch (nhc & AT86RF212_LOWPAN_NHC_UDP_PORTS) {
+        case 0:
+            memcpy(&ip[40], &in[pos], 4);
+            break;
+        case 1:
+            ip[40] = in[pos];
+            ip[41] = in[pos + 1];
+            ip[42] = 0xF0;
+            ip[43] = in[pos + 2];
+            break;
+        case 2:
+            ip[40] = 0xF0;
+            ip[41] = in[pos];
+            ip[42] = in[pos + 1];
+            ip[43] = in[pos + 2];
+            break;
+        default:
+            ip[40] = 0xF0;
+            ip[41] = 0xB0 | (in[pos] >> 4);
+            ip[42] = 0xF0;
+            ip[43] = 0xB0 | (in[pos] & 0x0F);
+            break;
+        }
+        pos += ports_len;
+        ip[46] = in[pos++];
+        ip[47] = in[pos++];
+        *header_len += AT86RF212_LOWPAN_UDP_HEADER;
+    }
+
+    return pos;
+}
+
+// Fill the length fields of a decompressed header
+static void at86rf212_lowpan_set_lengths(uint8_t* ip, uint16_t size, uint8_t udp)
+{
+    uint16_t payload_len = size - AT86RF212_LOWPAN_IPV6_HEADER;
+
+    ip[4] = (payload_len >> 8) & 0xFF;
+    ip[5] = payload_len & 0xFF;
+    if (udp) {
+        ip[44] = ip[4];
+        ip[45] = ip[5];
+    }
+}
+
+int at86rf212_lowpan_tx_start(struct at86rf212_lowpan_s *lowpan, struct at86rf212_lowpan_tx_s *tx,
+                              const struct at86rf212_lowpan_ll_s *src, const struct at86rf212_lowpan_ll_s *dst,
+                              uint16_t length, const uint8_t* packet)
+{
+    int res;
+
+    if (length > AT86RF212_LOWPAN_MTU) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    res = at86rf212_lowpan_compress(lowpan, src, dst, length, packet, tx->header, &tx->consumed);
+    if (res < 0) {
+        return res;
+    }
+
+    tx->packet = packet;
+    tx->length = length;
+    tx->offset = 0;
+    tx->header_len = res;
+    tx->tag = lowpan->tag++;
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_lowpan_tx_next(struct at86rf212_lowpan_s *lowpan, struct at86rf212_lowpan_tx_s *tx,
+                             uint8_t max_length, uint8_t* data)
+{
+    uint16_t chunk, end;
+    uint8_t pos;
+
+    if (tx->offset >= tx->length) {
+        return 0;
+    }
+
+    if (tx->offset == 0) {
+        // Unfragmented
+        if ((tx->header_len + tx->length - tx->consumed) <= max_length) {
+            memcpy(data, tx->header, tx->header_len);
+            memcpy(&data[tx->header_len], &tx->packet[tx->consumed], tx->length - tx->consumed);
+            tx->offset = tx->length;
+            lowpan->stats.packets_tx ++;
+            return tx->header_len + tx->length - tx->consumed;
+        }
+
+        // First fragment, ending on an 8 byte boundary of the uncompressed datagram
+        if (max_length <= (AT86RF212_LOWPAN_FRAG1_LEN + tx->header_len)) {
+            return AT86RF212_ERROR_LEN;
+        }
+        end = (tx->consumed + max_length - AT86RF212_LOWPAN_FRAG1_LEN - tx->header_len) & ~0x07;
+        if (end <= tx->consumed) {
+            return AT86RF212_ERROR_LEN;
+        }
+
+        data[0] = AT86RF212_LOWPAN_DISPATCH_FRAG1 | ((tx->length >> 8) & 0x07);
+        data[1] = tx->length & 0xFF;
+        data[2] = (tx->tag >> 8) & 0xFF;
+        data[3] = tx->tag & 0xFF;
+        pos = AT86RF212_LOWPAN_FRAG1_LEN;
+        memcpy(&data[pos], tx->header, tx->header_len);
+        pos += tx->header_len;
+        memcpy(&data[pos], &tx->packet[tx->consumed], end - tx->consumed);
+        pos += end - tx->consumed;
+
+        tx->offset = end;
+        lowpan->stats.fragments_tx ++;
+        return pos;
+    }
+
+    // Subsequent fragments
+    chunk = tx->length - tx->offset;
+    if ((AT86RF212_LOWPAN_FRAGN_LEN + chunk) > max_length) {
+        if (max_length < AT86RF212_LOWPAN_FRAGN_LEN) {
+            return AT86RF212_ERROR_LEN;
+        }
+        chunk = (max_length - AT86RF212_LOWPAN_FRAGN_LEN) & ~0x07;
+        if (chunk == 0) {
+            return AT86RF212_ERROR_LEN;
+        }
+    }
+
+    data[0] = AT86RF212_LOWPAN_DISPATCH_FRAGN | ((tx->length >> 8) & 0x07);
+    data[1] = tx->length & 0xFF;
+    data[2] = (tx->tag >> 8) & 0xFF;
+    data[3] = tx->tag & 0xFF;
+    data[4] = tx->offset / 8;
+    memcpy(&data[AT86RF212_LOWPAN_FRAGN_LEN], &tx->packet[tx->offset], chunk);
+
+    tx->offset += chunk;
+    lowpan->stats.fragments_tx ++;
+    if (tx->offset == tx->length) {
+        lowpan->stats.packets_tx ++;
+    }
+
+    return AT86RF212_LOWPAN_FRAGN_LEN + chunk;
+}
+
+static void at86rf212_lowpan_free(struct at86rf212_lowpan_s *lowpan, struct at86rf212_lowpan_reasm_s *reasm)
+{
+    lowpan->stats.reasm_bytes -= reasm->size;
+    reasm->state = AT86RF212_LOWPAN_REASM_FREE;
+}
+
+// Account for the bytes of a buffer in use
+static void at86rf212_lowpan_reserve(struct at86rf212_lowpan_s *lowpan, struct at86rf212_lowpan_reasm_s *reasm, uint16_t size)
+{
+    reasm->size = size;
+    lowpan->stats.reasm_bytes += size;
+    if (lowpan->stats.reasm_bytes > lowpan->stats.reasm_high_water) {
+        lowpan->stats.reasm_high_water = lowpan->stats.reasm_bytes;
+    }
+}
+
+static struct at86rf212_lowpan_reasm_s* at86rf212_lowpan_alloc(struct at86rf212_lowpan_s *lowpan)
+{
+    for (int i = 0; i < AT86RF212_LOWPAN_REASM_SLOTS; i++) {
+        struct at86rf212_lowpan_reasm_s *reasm = &lowpan->reasm[i];
+
+        if (reasm->state == AT86RF212_LOWPAN_REASM_FREE) {
+            reasm->state = AT86RF212_LOWPAN_REASM_ACTIVE;
+            reasm->size = 0;
+            reasm->received = 0;
+            memset(reasm->map, 0, sizeof(reasm->map));
+            return reasm;
+        }
+    }
+    return NULL;
+}
+
+static inline int at86rf212_lowpan_ll_equal(const struct at86rf212_lowpan_ll_s *a, const struct at86rf212_lowpan_ll_s *b)
+{
+    return (a->mode == b->mode) && (a->addr == b->addr);
+}
+
+void at86rf212_lowpan_poll(struct at86rf212_lowpan_s *lowpan, uint32_t now_us)
+{
+    for (int i = 0; i < AT86RF212_LOWPAN_REASM_SLOTS; i++) {
+        struct at86rf212_lowpan_reasm_s *reasm = &lowpan->reasm[i];
+
+        if ((reasm->state == AT86RF212_LOWPAN_REASM_ACTIVE)
+            && ((now_us - reasm->start_time) >= lowpan->config.reasm_timeout_us)) {
+            at86rf212_lowpan_free(lowpan, reasm);
+            lowpan->stats.timeouts ++;
+        }
+    }
+}
+
+// Handle an unfragmented payload
+static int at86rf212_lowpan_input_single(struct at86rf212_lowpan_s *lowpan,
+                                         const struct at86rf212_lowpan_ll_s *src, const struct at86rf212_lowpan_ll_s *dst,
+                                         uint8_t length, const uint8_t* data,
+                                         uint16_t* packet_length, const uint8_t** packet)
+{
+    struct at86rf212_lowpan_reasm_s *reasm;
+    uint8_t header_len, udp;
+    uint16_t size;
+    int res;
+
+    reasm = at86rf212_lowpan_alloc(lowpan);
+    if (reasm == NULL) {
+        lowpan->stats.dropped ++;
+        return AT86RF212_ERROR_FULL;
+    }
+
+    if (data[0] == AT86RF212_LOWPAN_DISPATCH_IPV6) {
+        size = length - 1;
+        memcpy(reasm->buffer, &data[1], size);
+    } else {
+        res = at86rf212_lowpan_decompress(lowpan, src, dst, length, data, reasm->buffer, &header_len, &udp);
+        if (res < 0) {
+            at86rf212_lowpan_free(lowpan, reasm);
+            lowpan->stats.dropped ++;
+            return res;
+        }
+        size = header_len + length - res;
+        memcpy(&reasm->buffer[header_len], &data[res], length - res);
+        at86rf212_lowpan_set_lengths(reasm->buffer, size, udp);
+    }
+
+    at86rf212_lowpan_reserve(lowpan, reasm, size);
+    reasm->state = AT86RF212_LOWPAN_REASM_COMPLETE;
+    lowpan->stats.packets_rx ++;
+
+    *packet_length = size;
+    *packet = reasm->buffer;
+
+    return AT86RF212_RES_DONE;
+}
+
+int at86rf212_lowpan_input(struct at86rf212_lowpan_s *lowpan, uint32_t now_us,
+                           const struct at86rf212_lowpan_ll_s *src, const struct at86rf212_lowpan_ll_s *dst,
+                           uint8_t length, const uint8_t* data,
+                           uint16_t* packet_length, const uint8_t** packet)
+{
+    struct at86rf212_lowpan_reasm_s *reasm = NULL;
+    uint16_t size, tag, offset, start, end;
+    uint8_t header_len;
+    uint32_t first, last, held;
+    int res;
+
+    // Release the previously delivered packet
+    for (int i = 0; i < AT86RF212_LOWPAN_REASM_SLOTS; i++) {
+        if (lowpan->reasm[i].state == AT86RF212_LOWPAN_REASM_COMPLETE) {
+            at86rf212_lowpan_free(lowpan, &lowpan->reasm[i]);
+        }
+    }
+    at86rf212_lowpan_poll(lowpan, now_us);
+
+    if (length < 1) {
+        return AT86RF212_RES_REJECTED;
+    }
+    if (((data[0] & 0xF8) != AT86RF212_LOWPAN_DISPATCH_FRAG1) && ((data[0] & 0xF8) != AT86RF212_LOWPAN_DISPATCH_FRAGN)) {
+        if (((data[0] & 0xE0) == AT86RF212_LOWPAN_DISPATCH_IPHC) || (data[0] == AT86RF212_LOWPAN_DISPATCH_IPV6)) {
+            return at86rf212_lowpan_input_single(lowpan, src, dst, length, data, packet_length, packet);
+        }
+        return AT86RF212_RES_REJECTED;
+    }
+
+    // Fragment header
+    header_len = ((data[0] & 0xF8) == AT86RF212_LOWPAN_DISPATCH_FRAG1) ? AT86RF212_LOWPAN_FRAG1_LEN : AT86RF212_LOWPAN_FRAGN_LEN;
+    if (length <= header_len) {
+        lowpan->stats.dropped ++;
+        return AT86RF212_ERROR_LEN;
+    }
+    size = ((data[0] & 0x07) << 8) | data[1];
+    tag = (data[2] << 8) | data[3];
+    offset = (header_len == AT86RF212_LOWPAN_FRAGN_LEN) ? (data[4] * 8) : 0;
+    if ((size > AT86RF212_LOWPAN_MTU) || (size < AT86RF212_LOWPAN_IPV6_HEADER)) {
+        lowpan->stats.dropped ++;
+        return AT86RF212_ERROR_LEN;
+    }
+
+    lowpan->stats.fragments_rx ++;
+
+    for (int i = 0; i < AT86RF212_LOWPAN_REASM_SLOTS; i++) {
+        struct at86rf212_lowpan_reasm_s *r = &lowpan->reasm[i];
+        if ((r->state == AT86RF212_LOWPAN_REASM_ACTIVE) && (r->tag == tag) && (r->size == size)
+            && at86rf212_lowpan_ll_equal(&r->src, src) && at86rf212_lowpan_ll_equal(&r->dst, dst)) {
+            reasm = r;
+            break;
+        }
+    }
+    if (reasm == NULL) {
+        reasm = at86rf212_lowpan_alloc(lowpan);
+        if (reasm == NULL) {
+            lowpan->stats.dropped ++;
+            return AT86RF212_ERROR_FULL;
+        }
+        at86rf212_lowpan_reserve(lowpan, reasm, size);
+        reasm->src = *src;
+        reasm->dst = *dst;
+        reasm->tag = tag;
+        reasm->start_time = now_us;
+    }
+
+    // Uncompressed range covered by the fragment, FRAG1 carries the IPv6 header
+    if ((header_len == AT86RF212_LOWPAN_FRAG1_LEN) && (data[header_len] == AT86RF212_LOWPAN_DISPATCH_IPV6)) {
+        header_len += 1;
+        if (length <= header_len) {
+            at86rf212_lowpan_free(lowpan, reasm);
+            lowpan->stats.dropped ++;
+            return AT86RF212_ERROR_LEN;
+        }
+        start = 0;
+        offset = 0;
+    } else if (header_len == AT86RF212_LOWPAN_FRAG1_LEN) {
+        uint8_t ip_header_len, udp;
+
+        if ((data[header_len] & 0xE0) != AT86RF212_LOWPAN_DISPATCH_IPHC) {
+            at86rf212_lowpan_free(lowpan, reasm);
+            lowpan->stats.dropped ++;
+            return AT86RF212_RES_REJECTED;
+        }
+        res = at86rf212_lowpan_decompress(lowpan, src, dst, length - header_len, &data[header_len],
+                                          reasm->buffer, &ip_header_len, &udp);
+        if (res < 0) {
+            at86rf212_lowpan_free(lowpan, reasm);
+            lowpan->stats.dropped ++;
+            return res;
+        }
+        at86rf212_lowpan_set_lengths(reasm->buffer, size, udp);
+        header_len += res;
+        start = 0;
+        offset = ip_header_len;
+    } else {
+        start = offset;
+    }
+    end = offset + length - header_len;
+
+    // Fragments other than the last must cover whole 8 byte units
+    if ((end > size) || ((end != size) && ((end & 0x07) != 0))) {
+        at86rf212_lowpan_free(lowpan, reasm);
+        lowpan->stats.dropped ++;
+        return AT86RF212_ERROR_LEN;
+    }
+
+    // A repeated fragment is ignored, one that partially overlaps earlier fragments
+    // discards the reassembly (RFC 4944 section 5.3)
+    first = start / 8;
+    last = (end + 7) / 8;
+    held = 0;
+    for (uint32_t i = first; i < last; i++) {
+        if (reasm->map[i / 32] & (1UL << (i % 32))) {
+            held ++;
+        }
+    }
+    if (held == (last - first)) {
+        lowpan->stats.duplicates ++;
+        return AT86RF212_RES_OK;
+    }
+    if (held != 0) {
+        at86rf212_lowpan_free(lowpan, reasm);
+        lowpan->stats.dropped ++;
+        return AT86RF212_ERROR_STATE;
+    }
+    for (uint32_t i = first; i < last; i++) {
+        reasm->map[i / 32] |= 1UL << (i % 32);
+    }
+
+    memcpy(&reasm->buffer[offset], &data[header_len], length - header_len);
+    reasm->received += end - start;
+
+    if (reasm->received < size) {
+        return AT86RF212_RES_OK;
+    }
+
+    reasm->state = AT86RF212_LOWPAN_REASM_COMPLETE;
+    lowpan->stats.packets_rx ++;
+    *packet_length = size;
+    *packet = reasm->buffer;
+
+    return AT86RF212_RES_DONE;
+}
@@ -0,0 +1,366 @@
+/*
+ * at86rf212 IEEE 802.15.4 MAC frame codec
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_mac.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+// Key identifier field length, indexed by key identifier mode
+static const uint8_t at86rf212_mac_key_id_len[4] = {0, 1, 5, 9};
+
+// MIC length, indexed by the low two bits of the security level
+static const uint8_t at86rf212_mac_mic_len[4] = {0, 4, 8, 16};
+
+static inline uint8_t at86rf212_mac_addr_len(uint8_t mode)
+{
+    switch (mode) {
+    case AT86RF212_MAC_ADDR_SHORT:
+        return AT86RF212_MAC_SHORT_ADDR_LEN;
+    case AT86RF212_MAC_ADDR_EXTENDED:
+        return AT86RF212_MAC_EXT_ADDR_LEN;
+    default:
+        return 0;
+    }
+}
+
+static inline uint16_t at86rf212_mac_get16(const uint8_t* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+static inline void at86rf212_mac_put16(uint8_t* data, uint16_t value)
+{
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+}
+
+void at86rf212_mac_pan_presence(uint16_t fcf, uint8_t* dest_pan, uint8_t* src_pan)
+{
+    uint8_t dest_mode = (fcf >> AT86RF212_MAC_FCF_DST_MODE_SHIFT) & 0x03;
+    uint8_t src_mode = (fcf >> AT86RF212_MAC_FCF_SRC_MODE_SHIFT) & 0x03;
+    uint8_t version = (fcf >> AT86RF212_MAC_FCF_VERSION_SHIFT) & 0x03;
+    uint8_t pan_comp = (fcf & AT86RF212_MAC_FCF_PAN_COMP) ? 1 : 0;
+
+    if (version < AT86RF212_MAC_VERSION_2015) {
+        *dest_pan = (dest_mode != AT86RF212_MAC_ADDR_NONE);
+        *src_pan = (src_mode != AT86RF212_MAC_ADDR_NONE) && !pan_comp;
+        return;
+    }
+
+    // 802.15.4-2015 table 7-2
+    if ((dest_mode == AT86RF212_MAC_ADDR_NONE) && (src_mode == AT86RF212_MAC_ADDR_NONE)) {
+        *dest_pan = pan_comp;
+        *src_pan = 0;
+    } else if (src_mode == AT86RF212_MAC_ADDR_NONE) {
+        *dest_pan = !pan_comp;
+        *src_pan = 0;
+    } else if (dest_mode == AT86RF212_MAC_ADDR_NONE) {
+        *dest_pan = 0;
+        *src_pan = !pan_comp;
+    } else if ((dest_mode == AT86RF212_MAC_ADDR_EXTENDED) && (src_mode == AT86RF212_MAC_ADDR_EXTENDED)) {
+        *dest_pan = !pan_comp;
+        *src_pan = 0;
+    } else {
+        *dest_pan = 1;
+        *src_pan = !pan_comp;
+    }
+}
+
+int at86rf212_mac_parse(struct at86rf212_mac_frame_s *frame, uint8_t length, const uint8_t* data)
+{
+    uint8_t pos = 2;
+    uint8_t dest_len, src_len;
+    uint8_t terminated = 0;
+
+    if (length < 2) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    memset(frame, 0, sizeof(struct at86rf212_mac_frame_s));
+
+    frame->fcf = at86rf212_mac_get16(data);
+    frame->type = frame->fcf & AT86RF212_MAC_FCF_TYPE_MASK;
+    frame->version = (frame->fcf >> AT86RF212_MAC_FCF_VERSION_SHIFT) & 0x03;
+    frame->dest_mode = (frame->fcf >> AT86RF212_MAC_FCF_DST_MODE_SHIFT) & 0x03;
+    frame->src_mode = (frame->fcf >> AT86RF212_MAC_FCF_SRC_MODE_SHIFT) & 0x03;
+
+    if ((frame->dest_mode == 1) || (frame->src_mode == 1)) {
+        return AT86RF212_ERROR_LEN;
+    }
+    dest_len = at86rf212_mac_addr_len(frame->dest_mode);
+    src_len = at86rf212_mac_addr_len(frame->src_mode);
+    at86rf212_mac_pan_presence(frame->fcf, &frame->dest_pan_present, &frame->src_pan_present);
+
+    // Sequence number and addressing fields
+    frame->seq_present = !((frame->version == AT86RF212_MAC_VERSION_2015)
+                           && (frame->fcf & AT86RF212_MAC_FCF_SEQ_SUPPRESS));
+    if ((pos + frame->seq_present + (frame->dest_pan_present ? 2 : 0) + dest_len
+         + (frame->src_pan_present ? 2 : 0) + src_len) > length) {
+        return AT86RF212_ERROR_LEN;
+    }
+    if (frame->seq_present) {
+        frame->seq = data[pos++];
+    }
+    if (frame->dest_pan_present) {
+        frame->dest_pan = at86rf212_mac_get16(&data[pos]);
+        pos += 2;
+    }
+    if (dest_len != 0) {
+        frame->dest_addr = &data[pos];
+        pos += dest_len;
+    }
+    if (frame->src_pan_present) {
+        frame->src_pan = at86rf212_mac_get16(&data[pos]);
+        pos += 2;
+    } else {
+        frame->src_pan = frame->dest_pan;
+    }
+    if (src_len != 0) {
+        frame->src_addr = &data[pos];
+        pos += src_len;
+    }
+
+    // Auxiliary security header
+    if (frame->fcf & AT86RF212_MAC_FCF_SECURITY) {
+        uint8_t control;
+
+        if (pos >= length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        control = data[pos];
+        frame->security_len = 1 + at86rf212_mac_key_id_len[(control & AT86RF212_MAC_SEC_KEY_MODE_MASK) >> AT86RF212_MAC_SEC_KEY_MODE_SHIFT];
+        if (!((frame->version == AT86RF212_MAC_VERSION_2015) && (control & AT86RF212_MAC_SEC_FC_SUPPRESS))) {
+            frame->security_len += 4;
+        }
+        if ((pos + frame->security_len) > length) {
+            return AT86RF212_ERROR_LEN;
+        }
+        frame->security = &data[pos];
+        frame->mic_len = at86rf212_mac_mic_len[control & 0x03];
+        pos += frame->security_len;
+    }
+
+    // Header IEs, up to a termination IE or the end of the frame
+    if ((frame->version == AT86RF212_MAC_VERSION_2015) && (frame->fcf & AT86RF212_MAC_FCF_IE_PRESENT)) {
+        frame->header_ies = &data[pos];
+        while ((pos + AT86RF212_MAC_IE_DESC_LEN) <= length) {
+            uint16_t desc = at86rf212_mac_get16(&data[pos]);
+            uint8_t id = (desc >> AT86RF212_MAC_HIE_ID_SHIFT) & 0xFF;
+            uint8_t ie_len = desc & AT86RF212_MAC_HIE_LEN_MASK;
+
+            if ((pos + AT86RF212_MAC_IE_DESC_LEN + ie_len) > length) {
+                return AT86RF212_ERROR_LEN;
+            }
+            pos += AT86RF212_MAC_IE_DESC_LEN + ie_len;
+            if ((id == AT86RF212_MAC_HIE_TERM_PAYLOAD) || (id == AT86RF212_MAC_HIE_TERM_NO_PAYLOAD)) {
+                terminated = id;
+                break;
+            }
+        }
+        frame->header_ies_len = &data[pos] - frame->header_ies;
+    }
+    frame->header_len = pos;
+
+    if (frame->mic_len > (length - pos)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    // Payload IEs are only visible in unsecured frames, secured frames carry them in the payload
+    if ((terminated == AT86RF212_MAC_HIE_TERM_PAYLOAD) && (frame->security == NULL)) {
+        frame->payload_ies = &data[pos];
+        while ((pos + AT86RF212_MAC_IE_DESC_LEN) <= length) {
+            uint16_t desc = at86rf212_mac_get16(&data[pos]);
+            uint8_t group = (desc >> AT86RF212_MAC_PIE_GROUP_SHIFT) & 0x0F;
+            uint16_t ie_len = desc & AT86RF212_MAC_PIE_LEN_MASK;
+
+            if ((pos + AT86RF212_MAC_IE_DESC_LEN + ie_len) > length) {
+                return AT86RF212_ERROR_LEN;
+            }
+            pos += AT86RF212_MAC_IE_DESC_LEN + ie_len;
+            if (group == AT86RF212_MAC_PIE_TERM) {
+                break;
+            }
+        }
+        frame->payload_ies_len = &data[pos] - frame->payload_ies;
+    }
+
+    frame->payload = &data[pos];
+    frame->payload_len = length - pos - frame->mic_len;
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_mac_build(const struct at86rf212_mac_header_s *header, uint8_t max_length, uint8_t* data)
+{
+    uint16_t fcf;
+    uint8_t dest_pan, src_pan;
+    uint8_t dest_len = at86rf212_mac_addr_len(header->dest_mode);
+    uint8_t src_len = at86rf212_mac_addr_len(header->src_mode);
+    uint8_t has_ies = (header->header_ies_len != 0) || (header->payload_ies_len != 0);
+    uint8_t seq_present = !((header->version == AT86RF212_MAC_VERSION_2015) && header->seq_suppress);
+    uint8_t fc_suppress = header->security_enabled && header->security.fc_suppress;
+    uint8_t security_len = 0;
+    uint16_t length;
+    uint8_t pos;
+
+    if ((has_ies || !seq_present || fc_suppress) && (header->version != AT86RF212_MAC_VERSION_2015)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    fcf = (header->type & AT86RF212_MAC_FCF_TYPE_MASK)
+          | (header->security_enabled ? AT86RF212_MAC_FCF_SECURITY : 0)
+          | (header->pending ? AT86RF212_MAC_FCF_PENDING : 0)
+          | (header->ack_req ? AT86RF212_MAC_FCF_ACK_REQ : 0)
+          | (header->pan_comp ? AT86RF212_MAC_FCF_PAN_COMP : 0)
+          | (seq_present ? 0 : AT86RF212_MAC_FCF_SEQ_SUPPRESS)
+          | (has_ies ? AT86RF212_MAC_FCF_IE_PRESENT : 0)
+          | ((header->dest_mode & 0x03) << AT86RF212_MAC_FCF_DST_MODE_SHIFT)
+          | ((header->version & 0x03) << AT86RF212_MAC_FCF_VERSION_SHIFT)
+          | ((header->src_mode & 0x03) << AT86RF212_MAC_FCF_SRC_MODE_SHIFT);
+    at86rf212_mac_pan_presence(fcf, &dest_pan, &src_pan);
+
+    if (header->security_enabled) {
+        security_len = 1 + at86rf212_mac_key_id_len[header->security.key_id_mode & 0x03];
+        if (!fc_suppress) {
+            security_len += 4;
+        }
+    }
+
+    // Header IEs are followed by a termination, as are payload IEs
+    length = 2 + seq_present + (dest_pan ? 2 : 0) + dest_len + (src_pan ? 2 : 0) + src_len + security_len;
+    if (has_ies) {
+        length += header->header_ies_len + AT86RF212_MAC_IE_DESC_LEN;
+    }
+    if (header->payload_ies_len != 0) {
+        length += header->payload_ies_len + AT86RF212_MAC_IE_DESC_LEN;
+    }
+    if (length > max_length) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    at86rf212_mac_put16(data, fcf);
+    pos = 2;
+    if (seq_present) {
+        data[pos++] = header->seq;
+    }
+    if (dest_pan) {
+        at86rf212_mac_put16(&data[pos], header->dest_pan);
+        pos += 2;
+    }
+    for (uint8_t i = 0; i < dest_len; i++) {
+        data[pos++] = (header->dest_addr >> (i * 8)) & 0xFF;
+    }
+    if (src_pan) {
+        at86rf212_mac_put16(&data[pos], header->src_pan);
+        pos += 2;
+    }
+    for (uint8_t i = 0; i < src_len; i++) {
+        data[pos++] = (header->src_addr >> (i * 8)) & 0xFF;
+    }
+
+    if (header->security_enabled) {
+        const struct at86rf212_mac_security_s *sec = &header->security;
+        uint8_t key_mode = sec->key_id_mode & 0x03;
+
+        data[pos++] = (sec->level & AT86RF212_MAC_SEC_LEVEL_MASK)
+                      | (key_mode << AT86RF212_MAC_SEC_KEY_MODE_SHIFT)
+                      | (sec->fc_suppress ? AT86RF212_MAC_SEC_FC_SUPPRESS : 0)
+                      | (sec->asn_nonce ? AT86RF212_MAC_SEC_ASN_NONCE : 0);
+        if (!sec->fc_suppress) {
+            for (uint8_t i = 0; i < 4; i++) {
+                data[pos++] = (sec->frame_counter >> (i * 8)) & 0xFF;
+            }
+        }
+        if (key_mode != 0) {
+            memcpy(&data[pos], sec->key_source, at86rf212_mac_key_id_len[key_mode] - 1);
+            pos += at86rf212_mac_key_id_len[key_mode] - 1;
+            data[pos++] = sec->key_index;
+        }
+    }
+
+    if (has_ies) {
+        uint8_t term = (header->payload_ies_len != 0) ? AT86RF212_MAC_HIE_TERM_PAYLOAD : AT86RF212_MAC_HIE_TERM_NO_PAYLOAD;
+
+        if (header->header_ies_len != 0) {
+            memcpy(&data[pos], header->header_ies, header->header_ies_len);
+            pos += header->header_ies_len;
+        }
+        pos += at86rf212_mac_ie_put(0, term, 0, NULL, AT86RF212_MAC_IE_DESC_LEN, &data[pos]);
+    }
+    if (header->payload_ies_len != 0) {
+        memcpy(&data[pos], header->payload_ies, header->payload_ies_len);
+        pos += header->payload_ies_len;
+        pos += at86rf212_mac_ie_put(1, AT86RF212_MAC_PIE_TERM, 0, NULL, AT86RF212_MAC_IE_DESC_LEN, &data[pos]);
+    }
+
+    return pos;
+}
+
+int at86rf212_mac_ie_next(uint8_t length, const uint8_t* data, uint8_t payload, uint8_t* offset,
+                          struct at86rf212_mac_ie_s *ie)
+{
+    uint16_t desc;
+
+    if ((*offset + AT86RF212_MAC_IE_DESC_LEN) > length) {
+        return (*offset == length) ? AT86RF212_RES_OK : AT86RF212_ERROR_LEN;
+    }
+
+    desc = at86rf212_mac_get16(&data[*offset]);
+    if (((desc & AT86RF212_MAC_IE_TYPE_PAYLOAD) != 0) != (payload != 0)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    ie->payload = payload;
+    if (payload) {
+        ie->id = (desc >> AT86RF212_MAC_PIE_GROUP_SHIFT) & 0x0F;
+        ie->length = desc & AT86RF212_MAC_PIE_LEN_MASK;
+        if (ie->id == AT86RF212_MAC_PIE_TERM) {
+            return AT86RF212_RES_OK;
+        }
+    } else {
+        ie->id = (desc >> AT86RF212_MAC_HIE_ID_SHIFT) & 0xFF;
+        ie->length = desc & AT86RF212_MAC_HIE_LEN_MASK;
+        if ((ie->id == AT86RF212_MAC_HIE_TERM_PAYLOAD) || (ie->id == AT86RF212_MAC_HIE_TERM_NO_PAYLOAD)) {
+            return AT86RF212_RES_OK;
+        }
+    }
+
+    if ((*offset + AT86RF212_MAC_IE_DESC_LEN + ie->length) > length) {
+        return AT86RF212_ERROR_LEN;
+    }
+    ie->content = &data[*offset + AT86RF212_MAC_IE_DESC_LEN];
+    *offset += AT86RF212_MAC_IE_DESC_LEN + ie->length;
+
+    return AT86RF212_RES_DONE;
+}
+
+int at86rf212_mac_ie_put(uint8_t payload, uint8_t id, uint16_t length, const uint8_t* content,
+                         uint8_t max_length, uint8_t* data)
+{
+    uint16_t desc;
+
+    if ((payload && (length > AT86RF212_MAC_PIE_LEN_MASK)) || (!payload && (length > AT86RF212_MAC_HIE_LEN_MASK))
+        || ((AT86RF212_MAC_IE_DESC_LEN + length) > max_length)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    if (payload) {
+        desc = AT86RF212_MAC_IE_TYPE_PAYLOAD | ((id & 0x0F) << AT86RF212_MAC_PIE_GROUP_SHIFT) | length;
+    } else {
+        desc = (id << AT86RF212_MAC_HIE_ID_SHIFT) | length;
+    }
+
+    at86rf212_mac_put16(data, desc);
+    if (length != 0) {
+        memcpy(&data[AT86RF212_MAC_IE_DESC_LEN], content, length);
+    }
+
+    return AT86RF212_MAC_IE_DESC_LEN + length;
+}
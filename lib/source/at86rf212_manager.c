@@ -0,0 +1,302 @@
+/*
+ * at86rf212 multi-radio manager
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifdef __linux__
+
+#include "at86rf212/at86rf212_manager.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "at86rf212_platform.h"
+
+static void at86rf212_manager_tx_done(void* context, int handle, int result)
+{
+    struct at86rf212_manager_radio_s *radio = (struct at86rf212_manager_radio_s*) context;
+    struct at86rf212_manager_s *manager = radio->manager;
+
+    manager->stats.tx_frames ++;
+    if (manager->tx != NULL) {
+        manager->tx(manager->tx_ctx, radio->index, handle, result);
+    }
+}
+
+int at86rf212_manager_init(struct at86rf212_manager_s *manager,
+                           at86rf212_manager_rx_f rx, void* rx_ctx,
+                           at86rf212_manager_tx_f tx, void* tx_ctx)
+{
+    memset(manager, 0, sizeof(struct at86rf212_manager_s));
+
+    manager->rx = rx;
+    manager->rx_ctx = rx_ctx;
+    manager->tx = tx;
+    manager->tx_ctx = tx_ctx;
+
+    manager->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (manager->epoll_fd < 0) {
+        return AT86RF212_ERROR_DRIVER;
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+int at86rf212_manager_add(struct at86rf212_manager_s *manager, struct at86rf212_driver_s *driver, void* driver_ctx,
+                          int irq_fd, const struct at86rf212_config_s *config)
+{
+    struct at86rf212_manager_radio_s *radio;
+    struct at86rf212_config_s radio_config;
+    struct epoll_event event;
+    int res;
+
+    if (irq_fd < 0) {
+        return AT86RF212_DRIVER_INVALID;
+    }
+    if (manager->count >= AT86RF212_MANAGER_MAX_RADIOS) {
+        return AT86RF212_ERROR_FULL;
+    }
+
+    radio = &manager->radios[manager->count];
+    memset(radio, 0, sizeof(struct at86rf212_manager_radio_s));
+    radio->manager = manager;
+    radio->index = manager->count;
+    radio->irq_fd = irq_fd;
+
+    // Only TRX_END is serviced, so other interrupts must not raise the line
+    radio_config = *config;
+    radio_config.irq_mask = AT86RF212_IRQ_3_TRX_END;
+
+    res = at86rf212_init_config(&radio->device, driver, driver_ctx, &radio_config);
+    if (res < 0) {
+        return res;
+    }
+
+    at86rf212_ring_init(&radio->ring);
+    at86rf212_txq_init(&radio->txq, &radio->device, at86rf212_manager_tx_done, radio);
+
+    res = at86rf212_start_rx(&radio->device);
+    if (res < 0) {
+        at86rf212_close(&radio->device);
+        return res;
+    }
+    radio->state = AT86RF212_MANAGER_RX;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u32 = radio->index;
+    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, radio->irq_fd, &event) < 0) {
+        at86rf212_close(&radio->device);
+        return AT86RF212_ERROR_DRIVER;
+    }
+
+    manager->count ++;
+
+    return radio->index;
+}
+
+int at86rf212_manager_send(struct at86rf212_manager_s *manager, uint8_t radio, uint8_t tx_class,
+                           uint8_t length, uint8_t* data)
+{
+    if (radio >= manager->count) {
+        return AT86RF212_ERROR_STATE;
+    }
+
+    return at86rf212_txq_submit(&manager->radios[radio].txq, tx_class, length, data);
+}
+
+// Complete or start transmissions, and drain a received frame following an IRQ
+static int at86rf212_manager_handle_irq(struct at86rf212_manager_radio_s *radio)
+{
+    int res;
+
+    radio->stats.irqs ++;
+
+    if (radio->state == AT86RF212_MANAGER_TX) {
+        // Completes the frame in flight (if TRX_END is set) and starts the next queued frame
+        res = at86rf212_txq_run(&radio->txq);
+        if (res < 0) {
+            return res;
+        }
+        if (res == AT86RF212_RES_DONE) {
+            // Queue is empty, the radio is in PLL_ON so listening again does not require a relock
+            radio->state = AT86RF212_MANAGER_RX;
+            return at86rf212_set_state(&radio->device, AT86RF212_CMD_RX_ON);
+        }
+        return AT86RF212_RES_OK;
+    }
+
+    res = at86rf212_check_rx(&radio->device);
+    if (res < 0) {
+        return res;
+    }
+    if (res != AT86RF212_RES_DONE) {
+        radio->stats.spurious ++;
+        return AT86RF212_RES_OK;
+    }
+
+    // Frames rejected for a bad CRC or lack of space are counted by the ring
+    res = at86rf212_ring_drain(&radio->device, &radio->ring);
+    if (res < 0) {
+        return res;
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+static int at86rf212_manager_service(struct at86rf212_manager_s *manager, struct at86rf212_manager_radio_s *radio)
+{
+    struct at86rf212_rx_frame_s *frame;
+    int res;
+
+    if (radio->irq_pending != 0) {
+        radio->irq_pending = 0;
+        res = at86rf212_manager_handle_irq(radio);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    // Start queued frames while listening
+    if ((radio->state == AT86RF212_MANAGER_RX) && (at86rf212_txq_depth(&radio->txq) > 0)) {
+        res = at86rf212_txq_run(&radio->txq);
+        if (res == AT86RF212_RES_REJECTED) {
+            // A frame completed since the IRQ was handled, drain it before it is overwritten
+            res = at86rf212_ring_drain(&radio->device, &radio->ring);
+            if (res < 0) {
+                return res;
+            }
+            res = at86rf212_txq_run(&radio->txq);
+        }
+        if (res < 0) {
+            return res;
+        }
+        if (res == AT86RF212_RES_OK) {
+            radio->state = AT86RF212_MANAGER_TX;
+        } else {
+            // Every queued frame failed to start
+            res = at86rf212_set_state(&radio->device, AT86RF212_CMD_RX_ON);
+            if (res < 0) {
+                return res;
+            }
+        }
+    }
+
+    // Deliver a bounded number of frames, so a busy radio cannot hold up the others
+    for (int i = 0; i < AT86RF212_MANAGER_RX_BUDGET; i++) {
+        frame = at86rf212_ring_get(&radio->ring);
+        if (frame == NULL) {
+            break;
+        }
+        if (manager->rx != NULL) {
+            manager->rx(manager->rx_ctx, radio->index, frame);
+        }
+        at86rf212_ring_release(&radio->ring, frame);
+        manager->stats.rx_frames ++;
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+// Indicates a pass is required without waiting for an IRQ
+static int at86rf212_manager_backlog(struct at86rf212_manager_s *manager)
+{
+    for (int i = 0; i < manager->count; i++) {
+        struct at86rf212_manager_radio_s *radio = &manager->radios[i];
+
+        if (at86rf212_ring_count(&radio->ring) > 0) {
+            return 1;
+        }
+        if ((radio->state == AT86RF212_MANAGER_RX) && (at86rf212_txq_depth(&radio->txq) > 0)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int at86rf212_manager_run(struct at86rf212_manager_s *manager, int timeout_ms)
+{
+    struct epoll_event events[AT86RF212_MANAGER_MAX_RADIOS];
+    uint8_t discard[64];
+    int count;
+
+    if (at86rf212_manager_backlog(manager)) {
+        timeout_ms = 0;
+    }
+
+    count = epoll_wait(manager->epoll_fd, events, AT86RF212_MANAGER_MAX_RADIOS, timeout_ms);
+    if (count < 0) {
+        if (errno != EINTR) {
+            return AT86RF212_ERROR_DRIVER;
+        }
+        count = 0;
+    }
+
+    // Acknowledge the descriptors, a single read clears an eventfd or reads several line events
+    // (any left over only cause a spurious wakeup, as the descriptors are level triggered)
+    for (int i = 0; i < count; i++) {
+        struct at86rf212_manager_radio_s *radio = &manager->radios[events[i].data.u32];
+
+        if (read(radio->irq_fd, discard, sizeof(discard)) < 0) {
+            radio->stats.errors ++;
+        }
+        radio->irq_pending = 1;
+    }
+
+    if (count > 0) {
+        manager->stats.wakeups ++;
+        manager->stats.events += count;
+        if ((uint32_t)count > manager->stats.max_events) {
+            manager->stats.max_events = count;
+        }
+    }
+
+    // Service every radio once, rotating the first so none is consistently favoured
+    for (int i = 0; i < manager->count; i++) {
+        struct at86rf212_manager_radio_s *radio = &manager->radios[(manager->next + i) % manager->count];
+
+        if (at86rf212_manager_service(manager, radio) < 0) {
+            radio->stats.errors ++;
+        }
+    }
+    if (manager->count > 0) {
+        manager->next = (manager->next + 1) % manager->count;
+    }
+
+    return count;
+}
+
+struct at86rf212_s* at86rf212_manager_device(struct at86rf212_manager_s *manager, uint8_t radio)
+{
+    if (radio >= manager->count) {
+        return NULL;
+    }
+
+    return &manager->radios[radio].device;
+}
+
+int at86rf212_manager_close(struct at86rf212_manager_s *manager)
+{
+    for (int i = 0; i < manager->count; i++) {
+        struct at86rf212_manager_radio_s *radio = &manager->radios[i];
+
+        epoll_ctl(manager->epoll_fd, EPOLL_CTL_DEL, radio->irq_fd, NULL);
+        at86rf212_close(&radio->device);
+    }
+    manager->count = 0;
+
+    if (manager->epoll_fd >= 0) {
+        close(manager->epoll_fd);
+        manager->epoll_fd = -1;
+    }
+
+    return AT86RF212_RES_OK;
+}
+
+#endif
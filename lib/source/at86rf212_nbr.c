@@ -0,0 +1,208 @@
+/*
+ * at86rf212 neighbour link quality table
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_nbr.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+#define AT86RF212_NBR_MASK          (AT86RF212_NBR_SLOTS - 1)
+#define AT86RF212_NBR_DECAY_MAX     32
+
+// PRR decay over n missed frames, (7/8)^n in 1/65536 units
+static const uint16_t at86rf212_nbr_decay[AT86RF212_NBR_DECAY_MAX + 1] = {
+    65535, 57344, 50176, 43904, 38416, 33614, 29412, 25736, 22519, 19704, 17241, 15086, 13200,
+    11550, 10106, 8843, 7738, 6770, 5924, 5184, 4536, 3969, 3473, 3039, 2659, 2326, 2036, 1781,
+    1558, 1364, 1193, 1044, 914
+};
+
+static inline uint32_t at86rf212_nbr_hash(uint8_t mode, uint64_t addr)
+{
+    return ((addr + mode) * 0x9E3779B97F4A7C15ULL) >> 32;
+}
+
+static inline uint32_t at86rf212_nbr_home(const struct at86rf212_nbr_s *nbr)
+{
+    return at86rf212_nbr_hash(nbr->mode, nbr->addr) & AT86RF212_NBR_MASK;
+}
+
+void at86rf212_nbr_init(struct at86rf212_nbr_table_s *table, uint8_t phy_mode)
+{
+    memset(table, 0, sizeof(struct at86rf212_nbr_table_s));
+    table->rssi_base = at86rf212_get_rssi_base(phy_mode);
+}
+
+struct at86rf212_nbr_s* at86rf212_nbr_find(struct at86rf212_nbr_table_s *table, uint8_t mode, uint64_t addr)
+{
+    uint32_t i = at86rf212_nbr_hash(mode, addr) & AT86RF212_NBR_MASK;
+
+    while (table->slots[i].mode != AT86RF212_MAC_ADDR_NONE) {
+        if ((table->slots[i].addr == addr) && (table->slots[i].mode == mode)) {
+            return &table->slots[i];
+        }
+        i = (i + 1) & AT86RF212_NBR_MASK;
+    }
+
+    return NULL;
+}
+
+void at86rf212_nbr_remove(struct at86rf212_nbr_table_s *table, struct at86rf212_nbr_s *nbr)
+{
+    uint32_t i = nbr - table->slots;
+    uint32_t j = i;
+
+    // Shift back following entries whose probe sequence passes through the hole
+    while (1) {
+        uint32_t home;
+
+        j = (j + 1) & AT86RF212_NBR_MASK;
+        if (table->slots[j].mode == AT86RF212_MAC_ADDR_NONE) {
+            break;
+        }
+        home = at86rf212_nbr_home(&table->slots[j]);
+        if (((j > i) && ((home <= i) || (home > j))) || ((j < i) && (home <= i) && (home > j))) {
+            table->slots[i] = table->slots[j];
+            i = j;
+        }
+    }
+
+    table->slots[i].mode = AT86RF212_MAC_ADDR_NONE;
+    table->count --;
+}
+
+static void at86rf212_nbr_evict(struct at86rf212_nbr_table_s *table, uint32_t now)
+{
+    struct at86rf212_nbr_s *oldest = NULL;
+
+    for (uint32_t i = 0; i < AT86RF212_NBR_SLOTS; i++) {
+        struct at86rf212_nbr_s *nbr = &table->slots[i];
+        if ((nbr->mode != AT86RF212_MAC_ADDR_NONE)
+            && ((oldest == NULL) || ((now - nbr->last_seen) > (now - oldest->last_seen)))) {
+            oldest = nbr;
+        }
+    }
+
+    at86rf212_nbr_remove(table, oldest);
+    table->evictions ++;
+}
+
+struct at86rf212_nbr_s* at86rf212_nbr_update(struct at86rf212_nbr_table_s *table, uint8_t mode, uint64_t addr,
+                                             uint8_t seq, uint8_t lqi, uint8_t ed, uint32_t now)
+{
+    uint32_t i = at86rf212_nbr_hash(mode, addr) & AT86RF212_NBR_MASK;
+    int16_t rssi = (table->rssi_base + ed) * 16 + (ed >> 1);
+    struct at86rf212_nbr_s *nbr;
+    uint8_t gap;
+
+    while (table->slots[i].mode != AT86RF212_MAC_ADDR_NONE) {
+        nbr = &table->slots[i];
+        if ((nbr->addr == addr) && (nbr->mode == mode)) {
+            break;
+        }
+        i = (i + 1) & AT86RF212_NBR_MASK;
+    }
+    nbr = &table->slots[i];
+
+    // New neighbour
+    if (nbr->mode == AT86RF212_MAC_ADDR_NONE) {
+        if (table->count >= AT86RF212_NBR_MAX_ENTRIES) {
+            at86rf212_nbr_evict(table, now);
+            i = at86rf212_nbr_hash(mode, addr) & AT86RF212_NBR_MASK;
+            while (table->slots[i].mode != AT86RF212_MAC_ADDR_NONE) {
+                i = (i + 1) & AT86RF212_NBR_MASK;
+            }
+            nbr = &table->slots[i];
+        }
+
+        nbr->addr = addr;
+        nbr->mode = mode;
+        nbr->last_seq = seq;
+        nbr->last_seen = now;
+        nbr->frames = 1;
+        nbr->missed = 0;
+        nbr->rssi = rssi;
+        nbr->lqi = lqi * 16;
+        nbr->prr = AT86RF212_NBR_PRR_ONE;
+        table->count ++;
+        return nbr;
+    }
+
+    // Sequence gaps count as missed frames, large backwards jumps are treated as a restart
+    gap = seq - nbr->last_seq;
+    if ((gap != 0) && (gap < 128)) {
+        uint8_t missed = gap - 1;
+        uint32_t prr = nbr->prr;
+
+        if (missed != 0) {
+            prr = (prr * at86rf212_nbr_decay[(missed < AT86RF212_NBR_DECAY_MAX) ? missed : AT86RF212_NBR_DECAY_MAX]) >> 16;
+            nbr->missed += missed;
+        }
+        nbr->prr = prr + ((AT86RF212_NBR_PRR_ONE - prr) >> AT86RF212_NBR_EWMA_SHIFT);
+    }
+    nbr->last_seq = seq;
+    nbr->last_seen = now;
+    nbr->frames ++;
+
+    nbr->rssi += (rssi - nbr->rssi) / (1 << AT86RF212_NBR_EWMA_SHIFT);
+    nbr->lqi += ((int16_t)(lqi * 16) - (int16_t)nbr->lqi) / (1 << AT86RF212_NBR_EWMA_SHIFT);
+
+    return nbr;
+}
+
+struct at86rf212_nbr_s* at86rf212_nbr_update_rx(struct at86rf212_nbr_table_s *table,
+                                                const struct at86rf212_mac_frame_s *mac,
+                                                const struct at86rf212_rx_frame_s *rx)
+{
+    uint64_t addr;
+
+    if ((mac->src_addr == NULL) || !mac->seq_present) {
+        return NULL;
+    }
+
+    if (mac->src_mode == AT86RF212_MAC_ADDR_SHORT) {
+        addr = at86rf212_mac_short_addr(mac->src_addr);
+    } else {
+        memcpy(&addr, mac->src_addr, sizeof(addr));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        addr = __builtin_bswap64(addr);
+#endif
+    }
+
+    return at86rf212_nbr_update(table, mac->src_mode, addr, mac->seq, rx->lqi, rx->ed, rx->timestamp);
+}
+
+uint16_t at86rf212_nbr_expire(struct at86rf212_nbr_table_s *table, uint32_t now, uint32_t max_age)
+{
+    uint16_t removed = 0;
+    uint32_t i = 0;
+
+    // Removal shifts later entries back into the hole, so the slot is examined again
+    while (i < AT86RF212_NBR_SLOTS) {
+        struct at86rf212_nbr_s *nbr = &table->slots[i];
+        if ((nbr->mode != AT86RF212_MAC_ADDR_NONE) && ((now - nbr->last_seen) > max_age)) {
+            at86rf212_nbr_remove(table, nbr);
+            removed ++;
+        } else {
+            i ++;
+        }
+    }
+
+    return removed;
+}
+
+struct at86rf212_nbr_s* at86rf212_nbr_next(struct at86rf212_nbr_table_s *table, uint16_t* index)
+{
+    while (*index < AT86RF212_NBR_SLOTS) {
+        struct at86rf212_nbr_s *nbr = &table->slots[(*index)++];
+        if (nbr->mode != AT86RF212_MAC_ADDR_NONE) {
+            return nbr;
+        }
+    }
+    return NULL;
+}
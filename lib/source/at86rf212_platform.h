@@ -0,0 +1,74 @@
+/*
+ * at86rf212 platform helpers for internal library use
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#ifndef AT86RF212_PLATFORM_H
+#define AT86RF212_PLATFORM_H
+
+#include <stdint.h>
+
+//#define DEBUG_AT86RF212
+
+// Automagically define PLATFORM_SLEEP_MS and _US on unix-like platforms
+#ifndef PLATFORM_SLEEP_MS
+#if (defined __linux__ || defined __APPLE__ || defined __unix__)
+#include <unistd.h>
+#define PLATFORM_SLEEP_MS(a)    usleep(a * 1000);
+#define PLATFORM_SLEEP_US(a)    usleep(a);
+#else
+#warning "PLATFORM_SLEEP_MS undefined and platform not recognised"
+#define PLATFORM_SLEEP_MS(a) for (volatile uint32_t i = 0; i < 1000000; i++);
+#define PLATFORM_SLEEP_US(a) for (volatile uint32_t i = 0; i < 1000; i++);
+#endif
+
+#else
+extern void PLATFORM_SLEEP_MS(uint32_t);
+extern void PLATFORM_SLEEP_US(uint32_t);
+#endif
+
+// Driver access
+// Calls go through the device driver object, or directly to the at86rf212_port_* functions
+// when the driver is bound at compile time (AT86RF212_STATIC_DRIVER, see at86rf212.h)
+#ifdef AT86RF212_STATIC_DRIVER
+#define AT86RF212_SPI_TRANSFER(device, len, data_out, data_in)  at86rf212_port_spi_transfer(len, data_out, data_in)
+#define AT86RF212_SET_RESET(device, val)                        at86rf212_port_set_reset(val)
+#define AT86RF212_SET_SLP_TR(device, val)                       at86rf212_port_set_slp_tr(val)
+#define AT86RF212_GET_IRQ(device, val)                          at86rf212_port_get_irq(val)
+// The device is still evaluated where it is the only use of a caller's parameter
+#ifdef AT86RF212_STATIC_DRIVER_TIME
+#define AT86RF212_HAS_TIME(device)                              ((void)(device), 1)
+#define AT86RF212_GET_TIME_US(device, time_us)                  at86rf212_port_get_time_us(time_us)
+#else
+#define AT86RF212_HAS_TIME(device)                              ((void)(device), 0)
+#define AT86RF212_GET_TIME_US(device, time_us)                  do { (void)(device); (void)(time_us); } while (0)
+#endif
+#ifdef AT86RF212_STATIC_DRIVER_IRQ_FD
+#define AT86RF212_HAS_IRQ_FD(device)                            ((void)(device), 1)
+#define AT86RF212_GET_IRQ_FD(device, fd)                        at86rf212_port_get_irq_fd(fd)
+#else
+#define AT86RF212_HAS_IRQ_FD(device)                            ((void)(device), 0)
+#define AT86RF212_GET_IRQ_FD(device, fd)                        ((void)(fd), AT86RF212_DRIVER_INVALID)
+#endif
+#else
+#define AT86RF212_SPI_TRANSFER(device, len, data_out, data_in) \
+    (device)->driver->spi_transfer((device)->driver_ctx, len, data_out, data_in)
+#define AT86RF212_SET_RESET(device, val)        (device)->driver->set_reset((device)->driver_ctx, val)
+#define AT86RF212_SET_SLP_TR(device, val)       (device)->driver->set_slp_tr((device)->driver_ctx, val)
+#define AT86RF212_GET_IRQ(device, val)          (device)->driver->get_irq((device)->driver_ctx, val)
+#define AT86RF212_HAS_TIME(device)              ((device)->get_time_us != NULL)
+#define AT86RF212_GET_TIME_US(device, time_us)  (device)->get_time_us((device)->time_ctx, time_us)
+#define AT86RF212_HAS_IRQ_FD(device)            ((device)->get_irq_fd != NULL)
+#define AT86RF212_GET_IRQ_FD(device, fd)        (device)->get_irq_fd((device)->irq_fd_ctx, fd)
+#endif
+
+// Wrap debug outputs
+#ifdef DEBUG_AT86RF212
+#include <stdio.h>
+#define AT86RF212_DEBUG_PRINT(...) printf(__VA_ARGS__)
+#else
+#define AT86RF212_DEBUG_PRINT(...)
+#endif
+
+#endif
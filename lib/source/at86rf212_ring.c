@@ -0,0 +1,121 @@
+/*
+ * at86rf212 receive frame ring
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_ring.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+#define AT86RF212_RING_MASK     (AT86RF212_RING_SLOTS - 1)
+
+// Producer side push, the caller guarantees space (each queue can hold every slot)
+static void at86rf212_spsc_push(struct at86rf212_spsc_s *q, uint8_t slot)
+{
+    uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+
+    q->slots[tail & AT86RF212_RING_MASK] = slot;
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// Consumer side pop, returns -1 if empty
+static int at86rf212_spsc_pop(struct at86rf212_spsc_s *q)
+{
+    uint32_t head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    uint8_t slot;
+
+    if (head == tail) {
+        return -1;
+    }
+
+    slot = q->slots[head & AT86RF212_RING_MASK];
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+
+    return slot;
+}
+
+void at86rf212_ring_init(struct at86rf212_ring_s *ring)
+{
+    memset(&ring->ready, 0, sizeof(ring->ready));
+    memset(&ring->empty, 0, sizeof(ring->empty));
+    memset(&ring->stats, 0, sizeof(ring->stats));
+
+    for (int i = 0; i < AT86RF212_RING_SLOTS; i++) {
+        at86rf212_spsc_push(&ring->empty, i);
+    }
+    ring->spare = -1;
+}
+
+int at86rf212_ring_drain(struct at86rf212_s *device, struct at86rf212_ring_s *ring)
+{
+    struct at86rf212_rx_slot_s *slot;
+    uint32_t queued;
+    int res;
+
+    if (ring->spare < 0) {
+        ring->spare = at86rf212_spsc_pop(&ring->empty);
+    }
+    if (ring->spare < 0) {
+        // Drop the frame, with RX_SAFE_MODE the radio would otherwise hold it and receive nothing more
+        ring->stats.dropped ++;
+        res = at86rf212_discard_rx(device);
+        if (res < 0) {
+            return res;
+        }
+        return AT86RF212_RES_REJECTED;
+    }
+
+    slot = &ring->pool[ring->spare];
+    res = at86rf212_get_rx_frame(device, &slot->frame, slot->buffer, 0);
+    if (res < 0) {
+        return res;
+    }
+    if (res == AT86RF212_RES_REJECTED) {
+        // Slot is kept as the spare for the next frame
+        ring->stats.rejected ++;
+        return AT86RF212_RES_REJECTED;
+    }
+
+    at86rf212_spsc_push(&ring->ready, ring->spare);
+    ring->spare = -1;
+
+    ring->stats.received ++;
+    queued = at86rf212_ring_count(ring);
+    if (queued > ring->stats.high_watermark) {
+        ring->stats.high_watermark = queued;
+    }
+
+    return AT86RF212_RES_DONE;
+}
+
+struct at86rf212_rx_frame_s* at86rf212_ring_get(struct at86rf212_ring_s *ring)
+{
+    int index = at86rf212_spsc_pop(&ring->ready);
+
+    if (index < 0) {
+        return NULL;
+    }
+
+    return &ring->pool[index].frame;
+}
+
+void at86rf212_ring_release(struct at86rf212_ring_s *ring, struct at86rf212_rx_frame_s *frame)
+{
+    struct at86rf212_rx_slot_s *slot = (struct at86rf212_rx_slot_s*)frame;
+
+    at86rf212_spsc_push(&ring->empty, slot - ring->pool);
+}
+
+uint32_t at86rf212_ring_count(struct at86rf212_ring_s *ring)
+{
+    uint32_t tail = __atomic_load_n(&ring->ready.tail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&ring->ready.head, __ATOMIC_ACQUIRE);
+
+    return tail - head;
+}
@@ -0,0 +1,263 @@
+/*
+ * at86rf212 priority transmit queue
+ *
+ * Copyright 2016 Ryan Kurte
+ */
+
+#include "at86rf212/at86rf212_txq.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "at86rf212_platform.h"
+
+#define AT86RF212_TXQ_MASK      (AT86RF212_TXQ_DEPTH - 1)
+
+#if (AT86RF212_TXQ_DEPTH & AT86RF212_TXQ_MASK) != 0
+#error "AT86RF212_TXQ_DEPTH must be a power of two"
+#endif
+
+// Entry states
+enum at86rf212_txq_state_e {
+    AT86RF212_TXQ_FREE = 0,
+    AT86RF212_TXQ_QUEUED = 1,
+    AT86RF212_TXQ_ACTIVE = 2,
+    AT86RF212_TXQ_COMPLETE = 3
+};
+
+static uint32_t at86rf212_txq_now(struct at86rf212_txq_s *txq)
+{
+    uint32_t now = 0;
+
+    if (AT86RF212_HAS_TIME(txq->device)) {
+        AT86RF212_GET_TIME_US(txq->device, &now);
+    }
+
+    return now;
+}
+
+void at86rf212_txq_init(struct at86rf212_txq_s *txq, struct at86rf212_s *device,
+                        at86rf212_tx_done_f done, void* done_ctx)
+{
+    memset(txq, 0, sizeof(struct at86rf212_txq_s));
+
+    txq->device = device;
+    txq->done = done;
+    txq->done_ctx = done_ctx;
+    txq->active = -1;
+
+    for (int i = 0; i < AT86RF212_TXQ_DEPTH; i++) {
+        txq->entries[i].handle = -1;
+        txq->entries[i].state = AT86RF212_TXQ_FREE;
+    }
+}
+
+int at86rf212_txq_submit(struct at86rf212_txq_s *txq, uint8_t tx_class, uint8_t length, uint8_t* data)
+{
+    struct at86rf212_txq_entry_s *entry = NULL;
+    struct at86rf212_txq_fifo_s *fifo;
+    int index;
+
+    if (tx_class >= AT86RF212_TX_CLASSES) {
+        return AT86RF212_ERROR_LEN;
+    }
+    if (length > (AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN)) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    for (index = 0; index < AT86RF212_TXQ_DEPTH; index++) {
+        if (txq->entries[index].state == AT86RF212_TXQ_FREE) {
+            entry = &txq->entries[index];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        return AT86RF212_ERROR_FULL;
+    }
+
+    // Handles encode the entry index in the low bits, the remainder is a sequence number
+    entry->handle = (txq->next_handle * AT86RF212_TXQ_DEPTH) + index;
+    txq->next_handle = (txq->next_handle + 1) & 0x00FFFFFF;
+
+    entry->tx_class = tx_class;
+    entry->length = length;
+    entry->state = AT86RF212_TXQ_QUEUED;
+    entry->result = AT86RF212_RES_OK;
+    entry->submit_time = at86rf212_txq_now(txq);
+    memcpy(entry->data, data, length);
+
+    if (txq->started == 0) {
+        txq->start_time = entry->submit_time;
+        txq->started = 1;
+    }
+
+    fifo = &txq->fifos[tx_class];
+    fifo->entries[fifo->tail & AT86RF212_TXQ_MASK] = index;
+    fifo->tail ++;
+
+    txq->stats[tx_class].submitted ++;
+
+    return entry->handle;
+}
+
+static void at86rf212_txq_complete(struct at86rf212_txq_s *txq, int index, int result)
+{
+    struct at86rf212_txq_entry_s *entry = &txq->entries[index];
+    struct at86rf212_txq_class_stats_s *stats = &txq->stats[entry->tx_class];
+    uint32_t now = at86rf212_txq_now(txq);
+    uint32_t latency = now - entry->submit_time;
+    uint8_t bucket = 0;
+
+    while ((latency > 1) && (bucket < (AT86RF212_TXQ_HIST_BUCKETS - 1))) {
+        latency >>= 1;
+        bucket ++;
+    }
+    stats->latency[bucket] ++;
+
+    if (result == AT86RF212_RES_DONE) {
+        stats->sent ++;
+        stats->bytes += entry->length;
+    } else {
+        stats->failed ++;
+    }
+    txq->last_time = now;
+
+    if (txq->done != NULL) {
+        int handle = entry->handle;
+        entry->handle = -1;
+        entry->state = AT86RF212_TXQ_FREE;
+        txq->done(txq->done_ctx, handle, result);
+    } else {
+        entry->result = result;
+        entry->state = AT86RF212_TXQ_COMPLETE;
+    }
+}
+
+int at86rf212_txq_run(struct at86rf212_txq_s *txq)
+{
+    int res;
+
+    // Complete the frame in flight
+    if (txq->active >= 0) {
+        res = at86rf212_check_tx(txq->device);
+        if (res == AT86RF212_RES_OK) {
+            return AT86RF212_RES_OK;
+        }
+        at86rf212_txq_complete(txq, txq->active, res);
+        txq->active = -1;
+    }
+
+    // Start the highest priority queued frame
+    for (int c = 0; c < AT86RF212_TX_CLASSES; c++) {
+        struct at86rf212_txq_fifo_s *fifo = &txq->fifos[c];
+
+        while (fifo->head != fifo->tail) {
+            int index = fifo->entries[fifo->head & AT86RF212_TXQ_MASK];
+            struct at86rf212_txq_entry_s *entry = &txq->entries[index];
+
+            fifo->head ++;
+
+            // The radio is left in PLL_ON by the previous frame, so no relock is needed
+            res = at86rf212_start_tx_fast(txq->device, entry->length, entry->data);
+            if (res == AT86RF212_RES_REJECTED) {
+                // Keep the frame at the head of its class until the received frame is drained
+                fifo->head --;
+                return AT86RF212_RES_REJECTED;
+            }
+            if (res < 0) {
+                at86rf212_txq_complete(txq, index, res);
+                continue;
+            }
+
+            entry->state = AT86RF212_TXQ_ACTIVE;
+            txq->active = index;
+            return AT86RF212_RES_OK;
+        }
+    }
+
+    return AT86RF212_RES_DONE;
+}
+
+int at86rf212_txq_status(struct at86rf212_txq_s *txq, int handle)
+{
+    struct at86rf212_txq_entry_s *entry;
+    int result;
+
+    if (handle < 0) {
+        return AT86RF212_ERROR_LEN;
+    }
+
+    entry = &txq->entries[handle & AT86RF212_TXQ_MASK];
+    if (entry->handle != handle) {
+        return AT86RF212_ERROR_STATE;
+    }
+    if (entry->state != AT86RF212_TXQ_COMPLETE) {
+        return AT86RF212_RES_OK;
+    }
+
+    result = entry->result;
+    entry->handle = -1;
+    entry->state = AT86RF212_TXQ_FREE;
+
+    return result;
+}
+
+uint32_t at86rf212_txq_depth(struct at86rf212_txq_s *txq)
+{
+    uint32_t depth = 0;
+
+    for (int i = 0; i < AT86RF212_TXQ_DEPTH; i++) {
+        if ((txq->entries[i].state == AT86RF212_TXQ_QUEUED) || (txq->entries[i].state == AT86RF212_TXQ_ACTIVE)) {
+            depth ++;
+        }
+    }
+
+    return depth;
+}
+
+uint32_t at86rf212_txq_latency_percentile(struct at86rf212_txq_s *txq, uint8_t tx_class, uint8_t percent)
+{
+    struct at86rf212_txq_class_stats_s *stats;
+    uint32_t total = 0;
+    uint32_t target;
+    uint32_t count = 0;
+
+    if (tx_class >= AT86RF212_TX_CLASSES) {
+        return 0;
+    }
+    stats = &txq->stats[tx_class];
+
+    for (int i = 0; i < AT86RF212_TXQ_HIST_BUCKETS; i++) {
+        total += stats->latency[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    target = (total * percent + 99) / 100;
+    for (int i = 0; i < AT86RF212_TXQ_HIST_BUCKETS; i++) {
+        count += stats->latency[i];
+        if (count >= target) {
+            return 1UL << (i + 1);
+        }
+    }
+
+    return 1UL << AT86RF212_TXQ_HIST_BUCKETS;
+}
+
+uint32_t at86rf212_txq_throughput(struct at86rf212_txq_s *txq)
+{
+    uint64_t bytes = 0;
+    uint32_t elapsed = txq->last_time - txq->start_time;
+
+    if ((txq->started == 0) || (elapsed == 0)) {
+        return 0;
+    }
+
+    for (int i = 0; i < AT86RF212_TX_CLASSES; i++) {
+        bytes += txq->stats[i].bytes;
+    }
+
+    return (uint32_t)((bytes * 1000000) / elapsed);
+}
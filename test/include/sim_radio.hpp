@@ -0,0 +1,476 @@
+#pragma once
+
+/*
+ * Simulated at86rf212 for hardware-free testing
+ * Models the SPI register, frame buffer and SRAM interfaces of one radio, and a shared
+ * medium that delivers transmitted frames to every listening radio on the same channel.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_regs.h"
+#include "at86rf212/at86rf212_defs.h"
+
+class SimRadio;
+
+class SimMedium
+{
+public:
+  SimMedium() : busy(false), loss(0.0), rng(1) {}
+
+  void attach(SimRadio* radio)
+  {
+    radios.push_back(radio);
+  }
+
+  void detach(SimRadio* radio)
+  {
+    for (size_t i = 0; i < radios.size(); i++) {
+      if (radios[i] == radio) {
+        radios.erase(radios.begin() + i);
+        return;
+      }
+    }
+  }
+
+  void transmit(SimRadio* from, uint8_t len, const uint8_t* psdu);
+
+  bool busy;                    //!< Reported CCA state
+  double loss;                  //!< Frame loss probability per receiver
+  std::vector<SimRadio*> radios;
+  std::mt19937 rng;
+};
+
+class SimRadio
+{
+public:
+  SimRadio(SimMedium* medium = NULL, uint32_t seed = 1) : medium(medium), rng(seed)
+  {
+    reset();
+    if (medium != NULL) {
+      medium->attach(this);
+    }
+  }
+
+  ~SimRadio()
+  {
+    if (medium != NULL) {
+      medium->detach(this);
+    }
+  }
+
+  // Restore power on register values
+  void reset()
+  {
+    memset(regs, 0, sizeof(regs));
+    memset(buffer, 0, sizeof(buffer));
+    regs[AT86RF212_REG_TRX_STATUS] = AT86RF212_TRX_OFF;
+    regs[AT86RF212_REG_TRX_CTRL_0] = 0x19;
+    regs[AT86RF212_REG_TRX_CTRL_1] = 0x20;
+    regs[AT86RF212_REG_PHY_TX_PWR] = 0x60;
+    regs[AT86RF212_REG_PHY_CC_CCA] = 0x21;
+    regs[AT86RF212_REG_CCA_THRES] = 0xC7;
+    regs[AT86RF212_REG_TRX_CTRL_2] = 0x24;
+    regs[AT86RF212_REG_SFD_VALUE] = 0xA7;
+    regs[AT86RF212_REG_VREG_CTRL] = AT86RF212_VREG_CTRL_DVDD_OK_MASK | AT86RF212_VREG_CTRL_AVDD_OK_MASK;
+    regs[AT86RF212_REG_PART_NUM] = 0x07;
+    regs[AT86RF212_REG_VERSION_NUM] = 0x01;
+    regs[AT86RF212_REG_MAN_ID_0] = 0x1F;
+    regs[AT86RF212_REG_SHORT_ADDR_0] = 0xFF;
+    regs[AT86RF212_REG_SHORT_ADDR_1] = 0xFF;
+    regs[AT86RF212_REG_PAN_ID_0] = 0xFF;
+    regs[AT86RF212_REG_PAN_ID_1] = 0xFF;
+    regs[AT86RF212_REG_XAH_CTRL_0] = 0x38;
+    regs[AT86RF212_REG_CSMA_SEED_0] = 0xEA;
+    regs[AT86RF212_REG_CSMA_SEED_1] = 0x42;
+    regs[AT86RF212_REG_CSMA_BE] = 0x53;
+    irq = 0;
+    lqi = 0xFF;
+    ed = 0x40;
+    crc_valid = true;
+    transfers = 0;
+    bytes = 0;
+    frames_sent = 0;
+    spi_hz = 4000000;
+    now_us = 0;
+    rx_len = 0;
+    rx_start_us = 0;
+    rx_receiving = false;
+    underruns = 0;
+    fb_protected = false;
+    rx_blocked = 0;
+    tx_airtime = false;
+    tx_busy = false;
+    tx_end_us = 0;
+    airtime_us = 0;
+  }
+
+  // Air time of a frame including the synchronisation header and PHR
+  uint32_t frame_time_us(uint8_t len)
+  {
+    return at86rf212_airtime_us(regs[AT86RF212_REG_TRX_CTRL_2] & AT86RF212_TRX_CTRL2_PHY_MODE_MASK, len);
+  }
+
+  // PSDU byte period for the configured PHY mode
+  uint32_t byte_time_us()
+  {
+    return 8000000 / at86rf212_get_bit_rate(regs[AT86RF212_REG_TRX_CTRL_2] & AT86RF212_TRX_CTRL2_PHY_MODE_MASK);
+  }
+
+  // Load a frame into the buffer as if received over the air
+  void receive(uint8_t len, const uint8_t* psdu)
+  {
+    if (fb_protected) {
+      rx_blocked ++;
+      return;
+    }
+    buffer[0] = len;
+    memcpy(&buffer[1], psdu, len);
+    if ((1 + len) < (int)sizeof(buffer)) {
+      buffer[1 + len] = lqi;
+    }
+    irq |= AT86RF212_IRQ_2_RX_START | AT86RF212_IRQ_3_TRX_END;
+    protect();
+  }
+
+  // Start receiving a frame over the air at the current time
+  // RX_START is raised immediately (PHR received), PSDU bytes then arrive one per byte period
+  // and TRX_END is raised once the last byte is in the buffer.
+  void begin_receive(uint8_t len, const uint8_t* psdu)
+  {
+    if (fb_protected) {
+      rx_blocked ++;
+      return;
+    }
+    memcpy(rx_psdu, psdu, len);
+    rx_len = len;
+    rx_start_us = now_us;
+    rx_receiving = true;
+    buffer[0] = len;
+    irq |= AT86RF212_IRQ_2_RX_START;
+  }
+
+  // Advance the virtual clock, completing any frame in progress
+  void advance(uint32_t us)
+  {
+    now_us += us;
+    update_rx();
+    update_tx();
+  }
+
+  int transfer(int len, uint8_t* data_out, uint8_t* data_in)
+  {
+    uint8_t cmd = data_out[0];
+
+    transfers ++;
+    bytes += len;
+
+    // Bus time for the transaction plus a little software overhead
+    advance((uint64_t)len * 8 * 1000000 / spi_hz + 1);
+
+    memset(data_in, 0, len);
+    data_in[0] = status_byte();
+
+    if ((cmd & 0xC0) == AT86RF212_REG_READ_FLAG) {
+      data_in[1] = read(cmd & 0x3F);
+
+    } else if ((cmd & 0xC0) == AT86RF212_REG_WRITE_FLAG) {
+      write(cmd & 0x3F, data_out[1]);
+
+    } else if ((cmd & 0xE0) == AT86RF212_FRAME_READ_FLAG) {
+      // Any frame buffer read releases the buffer once complete
+      fb_protected = false;
+      // PHR, PSDU, then LQI, ED and RX_STATUS
+      uint8_t frame_len = buffer[0];
+      for (int i = 1; i < len; i++) {
+        int index = i - 1;
+        if (index <= frame_len) {
+          data_in[i] = buffer[index];
+        } else if (index == frame_len + 1) {
+          data_in[i] = lqi;
+        } else if (index == frame_len + 2) {
+          data_in[i] = ed;
+        } else if (index == frame_len + 3) {
+          data_in[i] = crc_valid ? 0x80 : 0x00;
+        }
+      }
+
+    } else if ((cmd & 0xE0) == AT86RF212_FRAME_WRITE_FLAG) {
+      for (int i = 1; (i < len) && (i <= (int)sizeof(buffer)); i++) {
+        buffer[i - 1] = data_out[i];
+      }
+
+    } else if ((cmd & 0xE0) == AT86RF212_SRAM_READ_FLAG) {
+      uint8_t addr = data_out[1];
+      for (int i = 2; i < len; i++) {
+        uint8_t index = (addr + i - 2) & 0x7F;
+        if (rx_receiving && (index >= 1) && (index <= rx_len) && (index > rx_arrived())) {
+          underruns ++;
+        }
+        data_in[i] = buffer[index];
+      }
+
+    } else if ((cmd & 0xE0) == AT86RF212_SRAM_WRITE_FLAG) {
+      uint8_t addr = data_out[1];
+      for (int i = 2; i < len; i++) {
+        buffer[(addr + i - 2) & 0x7F] = data_out[i];
+      }
+    }
+
+    return 0;
+  }
+
+  uint8_t state()
+  {
+    return regs[AT86RF212_REG_TRX_STATUS] & AT86RF212_TRX_STATUS_TRX_STATUS_MASK;
+  }
+
+  // C driver object bound to this radio (pass the radio as the driver context)
+  static struct at86rf212_driver_s* driver()
+  {
+    static struct at86rf212_driver_s d = {
+      spi_transfer_cb, set_pin_cb, set_pin_cb, get_irq_cb, NULL, NULL
+    };
+    return &d;
+  }
+
+  // Time source for at86rf212_set_time_source (pass the radio as the context)
+  static time_get_f clock()
+  {
+    return get_time_cb;
+  }
+
+  uint8_t regs[0x40];
+  uint8_t buffer[128];
+  uint8_t irq;
+  uint8_t lqi;
+  uint8_t ed;
+  bool crc_valid;
+
+  uint32_t transfers;           //!< SPI transactions
+  uint32_t bytes;               //!< SPI bytes clocked
+  uint32_t frames_sent;         //!< Frames transmitted
+  uint32_t underruns;           //!< Frame buffer bytes read before they were received
+  uint32_t rx_blocked;          //!< Frames lost because the frame buffer was protected
+  bool fb_protected;            //!< Received frame protected by RX_SAFE_MODE until a frame buffer read
+
+  uint32_t airtime_us;          //!< Total time spent transmitting
+  bool tx_airtime;              //!< Model transmission time (otherwise transmission completes immediately)
+
+  uint32_t spi_hz;              //!< SPI clock used to advance the virtual clock
+  uint32_t now_us;              //!< Virtual clock
+
+  SimMedium* medium;
+  std::mt19937 rng;
+
+private:
+  uint8_t rx_psdu[AT86RF212_MAX_LENGTH];
+  uint8_t rx_len;
+  uint32_t rx_start_us;
+  bool rx_receiving;
+  bool tx_busy;
+  uint32_t tx_end_us;
+
+  // PSDU bytes in the buffer so far
+  uint32_t rx_arrived()
+  {
+    uint32_t arrived = (now_us - rx_start_us) / byte_time_us();
+    return (arrived > rx_len) ? rx_len : arrived;
+  }
+
+  void update_rx()
+  {
+    if (!rx_receiving) {
+      return;
+    }
+    uint32_t arrived = rx_arrived();
+    memcpy(&buffer[1], rx_psdu, arrived);
+    if (arrived == rx_len) {
+      if ((1 + rx_len) < (int)sizeof(buffer)) {
+        buffer[1 + rx_len] = lqi;
+      }
+      irq |= AT86RF212_IRQ_3_TRX_END;
+      rx_receiving = false;
+      protect();
+    }
+  }
+
+  // With RX_SAFE_MODE, a received frame is kept until it is read or the radio leaves RX_ON
+  void protect()
+  {
+    if ((regs[AT86RF212_REG_TRX_CTRL_2] & AT86RF212_TRX_CTRL2_RX_SAFE_MODE_MASK) != 0) {
+      fb_protected = true;
+    }
+  }
+
+  void update_tx()
+  {
+    if (tx_busy && ((int32_t)(now_us - tx_end_us) >= 0)) {
+      tx_busy = false;
+      end_tx();
+    }
+  }
+
+  void end_tx()
+  {
+    frames_sent ++;
+    if (medium != NULL) {
+      medium->transmit(this, buffer[0], &buffer[1]);
+    }
+    regs[AT86RF212_REG_TRX_STATUS] = AT86RF212_PLL_ON;
+    irq |= AT86RF212_IRQ_3_TRX_END;
+  }
+
+  uint8_t phy_rssi()
+  {
+    uint8_t val = crc_valid ? AT86RF212_PHY_RSSI_RX_CRC_VALID_MASK : 0;
+    if (state() == AT86RF212_RX_ON) {
+      val |= (rng() & 0x03) << AT86RF212_PHY_RSSI_RND_VALUE_SHIFT;
+    }
+    return val;
+  }
+
+  uint8_t status_byte()
+  {
+    switch ((regs[AT86RF212_REG_TRX_CTRL_1] & AT86RF212_TRX_CTRL1_SPI_CMD_MODE_MASK) >> AT86RF212_TRX_CTRL1_SPI_CMD_MODE_SHIFT) {
+    case AT86RF212_SPI_CMD_MODE_TRX_STATUS:
+      return regs[AT86RF212_REG_TRX_STATUS];
+    case AT86RF212_SPI_CMD_MODE_PHY_RSSI:
+      return phy_rssi();
+    case AT86RF212_SPI_CMD_MODE_IRQ_STATUS:
+      return irq;
+    }
+    return 0;
+  }
+
+  uint8_t read(uint8_t reg)
+  {
+    uint8_t val;
+
+    switch (reg) {
+    case AT86RF212_REG_IRQ_STATUS:
+      // Cleared on read
+      val = irq;
+      irq = 0;
+      return val;
+    case AT86RF212_REG_PHY_RSSI:
+      return phy_rssi();
+    case AT86RF212_REG_PHY_ED_LEVEL:
+      return ed;
+    }
+
+    return regs[reg];
+  }
+
+  void write(uint8_t reg, uint8_t val)
+  {
+    switch (reg) {
+    case AT86RF212_REG_TRX_STATE:
+      // Leaving RX_ON releases the frame buffer
+      fb_protected = false;
+      regs[reg] = val;
+      command(val & AT86RF212_TRX_STATE_TRX_CMD_MASK);
+      return;
+    case AT86RF212_REG_PHY_CC_CCA:
+      if ((val & AT86RF212_PHY_CC_CCA_CCA_REQ_MASK) != 0) {
+        regs[AT86RF212_REG_TRX_STATUS] |= AT86RF212_TRX_STATUS_CCA_DONE_MASK;
+        if ((medium != NULL) && medium->busy) {
+          regs[AT86RF212_REG_TRX_STATUS] &= ~AT86RF212_TRX_STATUS_CCA_STATUS_MASK;
+        } else {
+          regs[AT86RF212_REG_TRX_STATUS] |= AT86RF212_TRX_STATUS_CCA_STATUS_MASK;
+        }
+        val &= ~AT86RF212_PHY_CC_CCA_CCA_REQ_MASK;
+      }
+      break;
+    case AT86RF212_REG_PHY_ED_LEVEL:
+      // Writes start a manual energy detection, the result is ed
+      if (state() == AT86RF212_RX_ON) {
+        irq |= AT86RF212_IRQ_4_CCA_ED_DONE;
+      }
+      return;
+    case AT86RF212_REG_PART_NUM:
+    case AT86RF212_REG_VERSION_NUM:
+    case AT86RF212_REG_IRQ_STATUS:
+      return;
+    }
+
+    regs[reg] = val;
+  }
+
+  void command(uint8_t cmd)
+  {
+    switch (cmd) {
+    case AT86RF212_CMD_TRX_OFF:
+    case AT86RF212_CMD_FORCE_TRX_OFF:
+      regs[AT86RF212_REG_TRX_STATUS] = AT86RF212_TRX_OFF;
+      break;
+    case AT86RF212_CMD_PLL_ON:
+    case AT86RF212_CMD_FORCE_PLL_ON:
+      regs[AT86RF212_REG_TRX_STATUS] = AT86RF212_PLL_ON;
+      irq |= AT86RF212_IRQ_0_PLL_LOCK;
+      break;
+    case AT86RF212_CMD_RX_ON:
+      regs[AT86RF212_REG_TRX_STATUS] = AT86RF212_RX_ON;
+      break;
+    case AT86RF212_CMD_TX_START:
+      if (tx_airtime) {
+        regs[AT86RF212_REG_TRX_STATUS] = AT86RF212_BUSY_TX;
+        airtime_us += frame_time_us(buffer[0]);
+        tx_end_us = now_us + frame_time_us(buffer[0]);
+        tx_busy = true;
+      } else {
+        // Transmission completes immediately
+        end_tx();
+      }
+      break;
+    }
+  }
+
+  static int spi_transfer_cb(void* context, int len, uint8_t *data_out, uint8_t* data_in)
+  {
+    return ((SimRadio*)context)->transfer(len, data_out, data_in);
+  }
+
+  static int set_pin_cb(void* context, uint8_t val)
+  {
+    return 0;
+  }
+
+  static int get_irq_cb(void* context, uint8_t *val)
+  {
+    *val = (((SimRadio*)context)->irq != 0) ? 1 : 0;
+    return 0;
+  }
+
+  static int get_time_cb(void* context, uint32_t *time_us)
+  {
+    SimRadio* radio = (SimRadio*)context;
+    radio->advance(1);
+    *time_us = radio->now_us;
+    return 0;
+  }
+};
+
+inline void SimMedium::transmit(SimRadio* from, uint8_t len, const uint8_t* psdu)
+{
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  uint8_t channel = from->regs[AT86RF212_REG_PHY_CC_CCA] & AT86RF212_PHY_CC_CCA_CHANNEL_MASK;
+
+  for (size_t i = 0; i < radios.size(); i++) {
+    SimRadio* to = radios[i];
+    if ((to == from) || (to->state() != AT86RF212_RX_ON)) {
+      continue;
+    }
+    if ((to->regs[AT86RF212_REG_PHY_CC_CCA] & AT86RF212_PHY_CC_CCA_CHANNEL_MASK) != channel) {
+      continue;
+    }
+    if (dist(rng) < loss) {
+      continue;
+    }
+    to->receive(len, psdu);
+  }
+}
@@ -0,0 +1,202 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_agg.h"
+
+#include "sim_radio.hpp"
+
+#define MAC_HEADER_LEN      9       // Data frame with PAN ID compression and short addresses
+#define FRAME_OVERHEAD_US   400     // State transitions and frame upload per transmission
+
+struct AggFrames {
+  std::vector<std::vector<uint8_t> > frames;
+};
+
+static int collect_cb(void* context, uint8_t length, uint8_t* data)
+{
+  ((AggFrames*)context)->frames.push_back(std::vector<uint8_t>(data, data + length));
+  return AT86RF212_RES_OK;
+}
+
+static int failing_cb(void* context, uint8_t length, uint8_t* data)
+{
+  (void)length;
+  (void)data;
+  return (*(int*)context)-- > 0 ? AT86RF212_ERROR_STATE : AT86RF212_RES_OK;
+}
+
+static int radio_send_cb(void* context, uint8_t length, uint8_t* data)
+{
+  return at86rf212_start_tx((struct at86rf212_s*)context, length, data);
+}
+
+// Sensor reading of 8 to 20 bytes
+static uint8_t reading(uint32_t i, uint8_t* data)
+{
+  uint8_t length = 8 + (i % 13);
+  for (int j = 0; j < length; j++) {
+    data[j] = i + j;
+  }
+  return length;
+}
+
+TEST(At86rf212Agg, RoundTrip)
+{
+  SimMedium medium;
+  SimRadio sim_tx(&medium, 1), sim_rx(&medium, 2);
+  struct at86rf212_s tx, rx;
+  struct at86rf212_agg_config_s config;
+  struct at86rf212_agg_s agg;
+  uint8_t data[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+  uint8_t length;
+  uint32_t received = 0;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&tx, SimRadio::driver(), (void*) &sim_tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), (void*) &sim_rx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+
+  at86rf212_agg_default_config(&config);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_agg_init(&agg, &config, radio_send_cb, &tx));
+
+  for (uint32_t i = 0; i < 100; i++) {
+    uint8_t message[32];
+    uint8_t message_len = reading(i, message);
+
+    int res = at86rf212_agg_push(&agg, i * 100, message_len, message);
+    ASSERT_GE(res, 0);
+    if (i == 99) {
+      ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_agg_flush(&agg));
+      res = AT86RF212_RES_DONE;
+    }
+    if (res != AT86RF212_RES_DONE) {
+      continue;
+    }
+
+    // Unpack the aggregate that was just sent
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx(&rx, &length, data));
+    uint8_t psdu_len = length - AT86RF212_FRAME_RX_OVERHEAD - AT86RF212_CRC_LEN;
+    uint8_t offset = 0;
+    uint8_t sub_len;
+    const uint8_t* sub;
+    while ((res = at86rf212_agg_next(psdu_len, data, &offset, &sub_len, &sub)) == AT86RF212_RES_DONE) {
+      uint8_t expected[32];
+      ASSERT_EQ(reading(received, expected), sub_len);
+      EXPECT_EQ(0, memcmp(expected, sub, sub_len));
+      received ++;
+    }
+    EXPECT_EQ(AT86RF212_RES_OK, res);
+    at86rf212_start_rx(&rx);
+  }
+
+  EXPECT_EQ(100, received);
+  EXPECT_EQ(100, agg.stats.messages);
+  EXPECT_LT(agg.stats.frames, 20);
+}
+
+TEST(At86rf212Agg, HoldTime)
+{
+  struct at86rf212_agg_config_s config;
+  struct at86rf212_agg_s agg;
+  AggFrames out;
+  uint8_t message[8] = {0};
+
+  at86rf212_agg_default_config(&config);
+  config.max_hold_us = 5000;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_agg_init(&agg, &config, collect_cb, &out));
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_agg_push(&agg, 1000, sizeof(message), message));
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_agg_poll(&agg, 5999));
+  EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_agg_poll(&agg, 6000));
+  EXPECT_EQ(1, out.frames.size());
+  EXPECT_EQ(1, agg.stats.timeouts);
+
+  // Malformed and foreign frames
+  uint8_t bad[4] = {AT86RF212_AGG_TYPE, 5, 0, 0};
+  uint8_t offset = 0, sub_len;
+  const uint8_t* sub;
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_agg_next(sizeof(bad), bad, &offset, &sub_len, &sub));
+  bad[0] = 0x41;
+  offset = 0;
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_agg_next(sizeof(bad), bad, &offset, &sub_len, &sub));
+}
+
+TEST(At86rf212Agg, AirtimeBenchmark)
+{
+  const uint8_t modes[] = {AT86RF212_PHY_BPSK_20, AT86RF212_PHY_BPSK_40, AT86RF212_PHY_OQPSK_100,
+                           AT86RF212_PHY_OQPSK_250, AT86RF212_PHY_OQPSK_1000
+                          };
+  const uint32_t messages = 1000;
+
+  printf("Per message cost with a %u byte MAC header and %u us per frame overhead:\r\n",
+         MAC_HEADER_LEN, FRAME_OVERHEAD_US);
+  printf("    rate     single (us, msg/s)   aggregated (us, msg/s)\r\n");
+
+  for (unsigned m = 0; m < sizeof(modes); m++) {
+    struct at86rf212_agg_config_s config;
+    struct at86rf212_agg_s agg;
+    AggFrames out;
+    uint64_t single_us = 0, agg_us = 0;
+
+    at86rf212_agg_default_config(&config);
+    config.max_length = AT86RF212_AGG_MAX_PAYLOAD - MAC_HEADER_LEN;
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_agg_init(&agg, &config, collect_cb, &out));
+
+    for (uint32_t i = 0; i < messages; i++) {
+      uint8_t message[32];
+      uint8_t message_len = reading(i, message);
+
+      single_us += FRAME_OVERHEAD_US + at86rf212_airtime_us(modes[m], MAC_HEADER_LEN + message_len + AT86RF212_CRC_LEN);
+      ASSERT_GE(at86rf212_agg_push(&agg, 0, message_len, message), 0);
+    }
+    at86rf212_agg_flush(&agg);
+
+    for (size_t i = 0; i < out.frames.size(); i++) {
+      agg_us += FRAME_OVERHEAD_US + at86rf212_airtime_us(modes[m], MAC_HEADER_LEN + out.frames[i].size() + AT86RF212_CRC_LEN);
+    }
+
+    double single_per = (double)single_us / messages;
+    double agg_per = (double)agg_us / messages;
+    printf("%8u  %10.0f %9.0f  %12.0f %9.0f\r\n", at86rf212_get_bit_rate(modes[m]) / 1000,
+           single_per, 1000000 / single_per, agg_per, 1000000 / agg_per);
+
+    EXPECT_EQ(messages, agg.stats.messages);
+    EXPECT_LT(agg_per, single_per);
+  }
+}
+
+TEST(At86rf212Agg, SendFailure)
+{
+  struct at86rf212_agg_config_s config;
+  struct at86rf212_agg_s agg;
+  uint8_t message[8] = {0};
+  int failures = 0;
+
+  // Room for two messages
+  at86rf212_agg_default_config(&config);
+  config.max_length = AT86RF212_AGG_HEADER_LEN + 2 * (AT86RF212_AGG_SUB_HEADER_LEN + sizeof(message));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_agg_init(&agg, &config, failing_cb, &failures));
+
+  // The message completing the aggregate is kept when sending fails
+  failures = 1;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_agg_push(&agg, 0, sizeof(message), message));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_agg_push(&agg, 0, sizeof(message), message));
+  EXPECT_EQ(2, agg.count);
+
+  // A further message is refused while the aggregate can not be sent
+  failures = 1;
+  EXPECT_EQ(AT86RF212_ERROR_STATE, at86rf212_agg_push(&agg, 0, sizeof(message), message));
+  EXPECT_EQ(2, agg.count);
+
+  // The full aggregate is retried without waiting for the hold time
+  failures = 0;
+  EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_agg_poll(&agg, 1));
+  EXPECT_EQ(2, agg.stats.messages);
+  EXPECT_EQ(0, agg.stats.timeouts);
+  EXPECT_EQ(0, agg.count);
+}
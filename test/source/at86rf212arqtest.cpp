@@ -0,0 +1,235 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_arq.h"
+
+// Half duplex lossy link between two ARQ endpoints
+// Each endpoint holds at most one frame for its radio, the channel carries one frame at a time
+// with air time from at86rf212_airtime_us plus a fixed upload and turnaround overhead.
+class ArqLink
+{
+public:
+  struct Node {
+    struct at86rf212_arq_s arq;
+    bool pending;
+    uint8_t length;
+    uint8_t frame[AT86RF212_MAX_LENGTH];
+  };
+
+  ArqLink(uint8_t mode, double loss, uint8_t window) : mode(mode), loss(loss), now(0), rng(1)
+  {
+    struct at86rf212_arq_config_s config;
+    at86rf212_arq_default_config(&config);
+    config.window = window;
+
+    nodes = new Node[2];
+    for (int i = 0; i < 2; i++) {
+      nodes[i].pending = false;
+      at86rf212_arq_init(&nodes[i].arq, &config, send_cb, &nodes[i]);
+    }
+  }
+
+  ~ArqLink()
+  {
+    delete[] nodes;
+  }
+
+  static int send_cb(void* context, uint8_t length, uint8_t* data)
+  {
+    Node* node = (Node*)context;
+    if (node->pending) {
+      return AT86RF212_ERROR_FULL;
+    }
+    memcpy(node->frame, data, length);
+    node->length = length;
+    node->pending = true;
+    return AT86RF212_RES_OK;
+  }
+
+  // Run one channel event, returns false when idle
+  bool step()
+  {
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+    // Receiver first so acknowledgements are not starved
+    for (int i = 1; i >= 0; i--) {
+      if (!nodes[i].pending) {
+        at86rf212_arq_poll(&nodes[i].arq, now);
+      }
+    }
+
+    for (int i = 1; i >= 0; i--) {
+      Node* from = &nodes[i];
+      Node* to = &nodes[i ^ 1];
+      if (!from->pending) {
+        continue;
+      }
+      // Frame upload over SPI plus TX turnaround, then air time
+      now += 200 + from->length * 2 + at86rf212_airtime_us(mode, from->length + AT86RF212_CRC_LEN);
+      from->pending = false;
+      if (dist(rng) >= loss) {
+        at86rf212_arq_input(&to->arq, now, from->length, from->frame);
+      }
+      return true;
+    }
+
+    now += 500;
+    return false;
+  }
+
+  uint8_t mode;
+  double loss;
+  uint32_t now;
+  std::mt19937 rng;
+  Node* nodes;
+};
+
+// Transfer a blob over the link, returns the goodput in bits per second
+static double transfer(ArqLink& link, const std::vector<uint8_t>& blob, std::vector<uint8_t>& out)
+{
+  uint32_t written = 0;
+  uint8_t buffer[256];
+
+  out.clear();
+  while (out.size() < blob.size()) {
+    if (written < blob.size()) {
+      written += at86rf212_arq_write(&link.nodes[0].arq, &blob[written], blob.size() - written);
+    }
+    link.step();
+    uint32_t n;
+    while ((n = at86rf212_arq_read(&link.nodes[1].arq, buffer, sizeof(buffer))) > 0) {
+      out.insert(out.end(), buffer, buffer + n);
+    }
+    if (link.now > 600000000) {
+      break;
+    }
+  }
+
+  return (double)blob.size() * 8 * 1000000 / link.now;
+}
+
+TEST(At86rf212Arq, InOrderDelivery)
+{
+  std::vector<uint8_t> blob(10000), out;
+  for (size_t i = 0; i < blob.size(); i++) {
+    blob[i] = (i * 7) ^ (i >> 8);
+  }
+
+  ArqLink link(AT86RF212_PHY_OQPSK_250, 0.3, 16);
+  transfer(link, blob, out);
+
+  // Let the final acknowledgements through
+  while ((at86rf212_arq_unacked(&link.nodes[0].arq) > 0) && (link.now < 600000000)) {
+    link.step();
+  }
+
+  ASSERT_EQ(blob.size(), out.size());
+  EXPECT_TRUE(blob == out);
+  EXPECT_GT(link.nodes[0].arq.stats.retransmissions, 0);
+  EXPECT_EQ(blob.size(), link.nodes[0].arq.stats.bytes_acked);
+  EXPECT_EQ(0, at86rf212_arq_unacked(&link.nodes[0].arq));
+}
+
+TEST(At86rf212Arq, SlowReader)
+{
+  std::vector<uint8_t> blob(4 * AT86RF212_ARQ_BUFFER_SIZE), out;
+  uint8_t buffer[256];
+  uint32_t written = 0;
+
+  for (size_t i = 0; i < blob.size(); i++) {
+    blob[i] = (i * 13) ^ (i >> 8);
+  }
+
+  ArqLink link(AT86RF212_PHY_OQPSK_250, 0.1, 16);
+  struct at86rf212_arq_s* rx = &link.nodes[1].arq;
+
+  // The reader drains the receive buffer only occasionally, so it fills and the sender's window
+  // stalls on held back segments before each drain
+  uint32_t drains = 0;
+  for (uint32_t step = 1; (out.size() < blob.size()) && (link.now < 600000000); step++) {
+    if (written < blob.size()) {
+      written += at86rf212_arq_write(&link.nodes[0].arq, &blob[written], blob.size() - written);
+    }
+    link.step();
+
+    if ((step % 500) == 0) {
+      if ((rx->rx_tail - rx->rx_head) + AT86RF212_ARQ_MAX_SEGMENT > AT86RF212_ARQ_BUFFER_SIZE) {
+        drains ++;
+      }
+      uint32_t n;
+      while ((n = at86rf212_arq_read(rx, buffer, sizeof(buffer))) > 0) {
+        out.insert(out.end(), buffer, buffer + n);
+      }
+    }
+  }
+
+  ASSERT_EQ(blob.size(), out.size());
+  EXPECT_TRUE(blob == out);
+  EXPECT_GE(drains, 3u);
+}
+
+TEST(At86rf212Arq, AckBitmap)
+{
+  struct at86rf212_arq_config_s config;
+  struct at86rf212_arq_s arq;
+  ArqLink::Node node;
+  uint8_t data[8] = {0};
+
+  at86rf212_arq_default_config(&config);
+  node.pending = false;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_arq_init(&arq, &config, ArqLink::send_cb, &node));
+
+  // Segments 0 and 2 arrive, 1 is lost
+  uint8_t frame[2 + sizeof(data)] = {AT86RF212_ARQ_TYPE_DATA, 0};
+  at86rf212_arq_input(&arq, 0, sizeof(frame), frame);
+  frame[1] = 2;
+  at86rf212_arq_input(&arq, 0, sizeof(frame), frame);
+
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_arq_poll(&arq, 0));
+  ASSERT_TRUE(node.pending);
+  EXPECT_EQ(AT86RF212_ARQ_TYPE_ACK, node.frame[0]);
+  EXPECT_EQ(1, node.frame[1]);
+  EXPECT_EQ(0x01, node.frame[2]);
+
+  // Only the in order segment is readable
+  EXPECT_EQ(sizeof(data), at86rf212_arq_read(&arq, data, sizeof(data)));
+  EXPECT_EQ(0, at86rf212_arq_read(&arq, data, sizeof(data)));
+}
+
+TEST(At86rf212Arq, GoodputBenchmark)
+{
+  const uint8_t modes[] = {AT86RF212_PHY_BPSK_20, AT86RF212_PHY_BPSK_40, AT86RF212_PHY_OQPSK_100,
+                           AT86RF212_PHY_OQPSK_200, AT86RF212_PHY_OQPSK_400, AT86RF212_PHY_OQPSK_250,
+                           AT86RF212_PHY_OQPSK_500, AT86RF212_PHY_OQPSK_1000
+                          };
+  const double loss = 0.1;
+  std::vector<uint8_t> blob(16384), out;
+
+  for (size_t i = 0; i < blob.size(); i++) {
+    blob[i] = i & 0xFF;
+  }
+
+  printf("Goodput (kb/s) for %u bytes at %.0f%% frame loss:\r\n", (unsigned)blob.size(), loss * 100);
+  printf("    rate  stop-and-wait  window 16\r\n");
+
+  for (unsigned m = 0; m < sizeof(modes); m++) {
+    ArqLink saw(modes[m], loss, 1);
+    double saw_goodput = transfer(saw, blob, out);
+    ASSERT_TRUE(blob == out);
+
+    ArqLink window(modes[m], loss, 16);
+    double window_goodput = transfer(window, blob, out);
+    ASSERT_TRUE(blob == out);
+
+    printf("%8u  %13.1f  %9.1f\r\n", at86rf212_get_bit_rate(modes[m]) / 1000,
+           saw_goodput / 1000, window_goodput / 1000);
+    EXPECT_GT(window_goodput, saw_goodput * 1.2);
+  }
+}
@@ -0,0 +1,353 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_bus.h"
+#include "at86rf212/at86rf212_regs.h"
+
+#include "sim_radio.hpp"
+
+// Simulated radios on one bus, each transfer occupies the bus for one microsecond per byte
+// The first transfer can be held, to queue others behind it.
+class SimBus
+{
+public:
+  SimBus(int count, bool batching) : hold(false), held(false), batches(0)
+  {
+    for (int i = 0; i < count; i++) {
+      radios.emplace_back(new SimRadio(NULL, i + 1));
+    }
+    backend.transfer = transfer_cb;
+    backend.batch = batching ? batch_cb : NULL;
+  }
+
+  int transfer(uint8_t cs, int len, uint8_t* data_out, uint8_t* data_in)
+  {
+    while (hold.load()) {
+      held = true;
+      std::this_thread::yield();
+    }
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      log.push_back((cs << 8) | data_out[0]);
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(len));
+    return radios[cs]->transfer(len, data_out, data_in);
+  }
+
+  static int transfer_cb(void* context, uint8_t cs, int len, uint8_t *data_out, uint8_t* data_in)
+  {
+    return ((SimBus*)context)->transfer(cs, len, data_out, data_in);
+  }
+
+  static int batch_cb(void* context, int count, struct at86rf212_bus_xfer_s *xfers)
+  {
+    SimBus* bus = (SimBus*)context;
+    bus->batches ++;
+    for (int i = 0; i < count; i++) {
+      int res = bus->transfer(xfers[i].cs, xfers[i].len, xfers[i].data_out, xfers[i].data_in);
+      if (res < 0) {
+        return res;
+      }
+    }
+    return 0;
+  }
+
+  std::vector<std::unique_ptr<SimRadio>> radios;
+  struct at86rf212_bus_backend_s backend;
+  std::atomic<bool> hold;
+  std::atomic<bool> held;
+  std::atomic<uint32_t> batches;
+  std::mutex lock;
+  std::vector<uint16_t> log;
+};
+
+static int read_reg(struct at86rf212_bus_port_s* port, uint8_t reg)
+{
+  uint8_t data_out[2] = {(uint8_t)(AT86RF212_REG_READ_FLAG | reg), 0};
+  uint8_t data_in[2];
+  return at86rf212_bus_spi_transfer(port, 2, data_out, data_in);
+}
+
+static int write_reg(struct at86rf212_bus_port_s* port, uint8_t reg, uint8_t val)
+{
+  uint8_t data_out[2] = {(uint8_t)(AT86RF212_REG_WRITE_FLAG | reg), val};
+  uint8_t data_in[2];
+  return at86rf212_bus_spi_transfer(port, 2, data_out, data_in);
+}
+
+static int read_frame(struct at86rf212_bus_port_s* port)
+{
+  uint8_t data_out[AT86RF212_RX_BUFFER_LEN] = {AT86RF212_FRAME_READ_FLAG};
+  uint8_t data_in[AT86RF212_RX_BUFFER_LEN];
+  return at86rf212_bus_spi_transfer(port, sizeof(data_out), data_out, data_in);
+}
+
+TEST(At86rf212Bus, Classify)
+{
+  uint8_t frame_read[] = {AT86RF212_FRAME_READ_FLAG, 0};
+  uint8_t frame_write[] = {AT86RF212_FRAME_WRITE_FLAG, 10};
+  uint8_t tx_start[] = {AT86RF212_REG_WRITE_FLAG | AT86RF212_REG_TRX_STATE, AT86RF212_CMD_TX_START};
+  uint8_t irq_read[] = {AT86RF212_REG_READ_FLAG | AT86RF212_REG_IRQ_STATUS, 0};
+  uint8_t channel_write[] = {AT86RF212_REG_WRITE_FLAG | AT86RF212_REG_PHY_CC_CCA, 1};
+  uint8_t part_read[] = {AT86RF212_REG_READ_FLAG | AT86RF212_REG_PART_NUM, 0};
+  uint8_t sram_read[] = {AT86RF212_SRAM_READ_FLAG, 0x10};
+  uint8_t sram_write[] = {AT86RF212_SRAM_WRITE_FLAG, 0x10};
+
+  EXPECT_EQ(AT86RF212_BUS_PRIO_RX, at86rf212_bus_classify(sizeof(frame_read), frame_read));
+  EXPECT_EQ(AT86RF212_BUS_PRIO_CONTROL, at86rf212_bus_classify(sizeof(frame_write), frame_write));
+  EXPECT_EQ(AT86RF212_BUS_PRIO_CONTROL, at86rf212_bus_classify(sizeof(tx_start), tx_start));
+  EXPECT_EQ(AT86RF212_BUS_PRIO_CONTROL, at86rf212_bus_classify(sizeof(irq_read), irq_read));
+  EXPECT_EQ(AT86RF212_BUS_PRIO_CONFIG, at86rf212_bus_classify(sizeof(channel_write), channel_write));
+  EXPECT_EQ(AT86RF212_BUS_PRIO_CONFIG, at86rf212_bus_classify(sizeof(part_read), part_read));
+  EXPECT_EQ(AT86RF212_BUS_PRIO_RX, at86rf212_bus_classify(sizeof(sram_read), sram_read));
+  EXPECT_EQ(AT86RF212_BUS_PRIO_CONFIG, at86rf212_bus_classify(sizeof(sram_write), sram_write));
+}
+
+TEST(At86rf212Bus, InitThroughBus)
+{
+  SimBus sim(2, false);
+  struct at86rf212_bus_s bus;
+  struct at86rf212_bus_port_s ports[2];
+  struct at86rf212_s devices[2];
+  uint8_t channel;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_bus_init(&bus, &sim.backend, &sim));
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_bus_port_init(&bus, &ports[i], i, SimRadio::driver(), sim.radios[i].get()));
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&devices[i], &ports[i].driver, &ports[i]));
+  }
+
+  // Each port reaches its own radio, optional driver functions are passed through
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_channel(&devices[1], 5));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_channel(&devices[0], &channel));
+  EXPECT_EQ(AT86RF212_DEFAULT_CHANNEL, channel);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_channel(&devices[1], &channel));
+  EXPECT_EQ(5, channel);
+  EXPECT_TRUE(ports[0].driver.get_irq != NULL);
+  EXPECT_TRUE(ports[0].driver.get_dig1 == NULL);
+
+  struct at86rf212_bus_stats_s stats[AT86RF212_BUS_PRIOS];
+  at86rf212_bus_port_stats(&ports[1], stats);
+  EXPECT_LT(0u, stats[AT86RF212_BUS_PRIO_CONFIG].transfers);
+  EXPECT_LT(0u, stats[AT86RF212_BUS_PRIO_CONTROL].transfers);
+
+  at86rf212_bus_close(&bus);
+}
+
+// Queue transfers from several threads behind a held transfer, returning the execution order
+static std::vector<uint16_t> queue_behind_hold(SimBus& sim, struct at86rf212_bus_s* bus,
+                                               std::vector<std::function<void()>> ops)
+{
+  std::vector<std::thread> threads;
+
+  sim.hold = true;
+  threads.emplace_back([bus, &sim]() {
+    struct at86rf212_bus_port_s port;
+    at86rf212_bus_port_init(bus, &port, 0, SimRadio::driver(), sim.radios[0].get());
+    read_reg(&port, AT86RF212_REG_VERSION_NUM);
+  });
+  while (!sim.held.load()) {
+    std::this_thread::yield();
+  }
+
+  for (size_t i = 0; i < ops.size(); i++) {
+    threads.emplace_back(ops[i]);
+    while (at86rf212_bus_pending(bus) < i + 1) {
+      std::this_thread::yield();
+    }
+  }
+  sim.hold = false;
+
+  for (auto& t : threads) {
+    t.join();
+  }
+  return std::vector<uint16_t>(sim.log.begin() + 1, sim.log.end());
+}
+
+TEST(At86rf212Bus, PriorityOrder)
+{
+  SimBus sim(4, false);
+  struct at86rf212_bus_s bus;
+  struct at86rf212_bus_port_s ports[4];
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_bus_init(&bus, &sim.backend, &sim));
+  for (int i = 0; i < 4; i++) {
+    at86rf212_bus_port_init(&bus, &ports[i], i, SimRadio::driver(), sim.radios[i].get());
+  }
+
+  // Submitted lowest priority first
+  std::vector<uint16_t> order = queue_behind_hold(sim, &bus, {
+    [&]() { write_reg(&ports[1], AT86RF212_REG_SHORT_ADDR_0, 1); },
+    [&]() { read_reg(&ports[2], AT86RF212_REG_PART_NUM); },
+    [&]() { read_reg(&ports[3], AT86RF212_REG_IRQ_STATUS); },
+    [&]() { read_frame(&ports[1]); },
+  });
+
+  ASSERT_EQ(4u, order.size());
+  EXPECT_EQ((1 << 8) | AT86RF212_FRAME_READ_FLAG, order[0]);
+  EXPECT_EQ((3 << 8) | AT86RF212_REG_READ_FLAG | AT86RF212_REG_IRQ_STATUS, order[1]);
+  EXPECT_EQ((1 << 8) | AT86RF212_REG_WRITE_FLAG | AT86RF212_REG_SHORT_ADDR_0, order[2]);
+  EXPECT_EQ((2 << 8) | AT86RF212_REG_READ_FLAG | AT86RF212_REG_PART_NUM, order[3]);
+  EXPECT_EQ(4u, bus.stats.max_pending);
+  EXPECT_EQ(5u, bus.stats.batches);
+  EXPECT_EQ(0u, bus.stats.coalesced);
+
+  at86rf212_bus_close(&bus);
+}
+
+TEST(At86rf212Bus, Coalescing)
+{
+  SimBus sim(4, true);
+  struct at86rf212_bus_s bus;
+  struct at86rf212_bus_port_s ports[4];
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_bus_init(&bus, &sim.backend, &sim));
+  for (int i = 0; i < 4; i++) {
+    at86rf212_bus_port_init(&bus, &ports[i], i, SimRadio::driver(), sim.radios[i].get());
+  }
+
+  std::vector<uint16_t> order = queue_behind_hold(sim, &bus, {
+    [&]() { write_reg(&ports[1], AT86RF212_REG_SHORT_ADDR_0, 1); },
+    [&]() { read_frame(&ports[2]); },
+    [&]() { read_reg(&ports[3], AT86RF212_REG_IRQ_STATUS); },
+    [&]() { read_frame(&ports[3]); },
+    [&]() { read_reg(&ports[2], AT86RF212_REG_PART_NUM); },
+  });
+
+  // Frame reads fill a batch alone, the register accesses share one backend call
+  ASSERT_EQ(5u, order.size());
+  EXPECT_EQ((2 << 8) | AT86RF212_FRAME_READ_FLAG, order[0]);
+  EXPECT_EQ((3 << 8) | AT86RF212_FRAME_READ_FLAG, order[1]);
+  EXPECT_EQ((3 << 8) | AT86RF212_REG_READ_FLAG | AT86RF212_REG_IRQ_STATUS, order[2]);
+  EXPECT_EQ(4u, bus.stats.batches);
+  EXPECT_EQ(3u, bus.stats.coalesced);
+  EXPECT_EQ(1u, sim.batches.load());
+
+  at86rf212_bus_close(&bus);
+}
+
+struct DrainResult {
+  uint32_t max_wait_us;
+  double mean_wait_us;
+  uint32_t drains;
+};
+
+// Each radio has a thread running long configuration sequences and a thread draining frames,
+// measuring how long frame reads wait for the bus
+template <typename Transfer>
+static DrainResult drain_under_load(int count, Transfer transfer)
+{
+  std::atomic<bool> running(true);
+  std::vector<std::thread> threads;
+  std::vector<uint32_t> max_wait(count, 0);
+  std::vector<double> total_wait(count, 0);
+  std::vector<uint32_t> drains(count, 0);
+
+  for (int i = 0; i < count; i++) {
+    threads.emplace_back([&, i]() {
+      while (running.load()) {
+        for (int j = 0; j < 40; j++) {
+          uint8_t data_out[2] = {(uint8_t)(AT86RF212_REG_WRITE_FLAG | AT86RF212_REG_SHORT_ADDR_0), (uint8_t)j};
+          uint8_t data_in[2];
+          transfer(i, 2, data_out, data_in);
+        }
+      }
+    });
+    threads.emplace_back([&, i]() {
+      uint8_t data_out[AT86RF212_RX_BUFFER_LEN] = {AT86RF212_FRAME_READ_FLAG};
+      uint8_t data_in[AT86RF212_RX_BUFFER_LEN];
+      while (running.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        auto start = std::chrono::steady_clock::now();
+        transfer(i, sizeof(data_out), data_out, data_in);
+        // Time on the bus is excluded, leaving the wait
+        uint32_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start).count();
+        wait_us = (wait_us > sizeof(data_out)) ? wait_us - sizeof(data_out) : 0;
+        total_wait[i] += wait_us;
+        drains[i] ++;
+        if (wait_us > max_wait[i]) {
+          max_wait[i] = wait_us;
+        }
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  running = false;
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  DrainResult result = {0, 0, 0};
+  double total = 0;
+  for (int i = 0; i < count; i++) {
+    if (max_wait[i] > result.max_wait_us) {
+      result.max_wait_us = max_wait[i];
+    }
+    total += total_wait[i];
+    result.drains += drains[i];
+  }
+  result.mean_wait_us = total / result.drains;
+  return result;
+}
+
+TEST(At86rf212Bus, DrainLatency)
+{
+  const int count = 4;
+
+  // Baseline: transfers serialised by a mutex in arbitrary order
+  SimBus baseline_sim(count, false);
+  std::mutex bus_lock;
+  DrainResult baseline = drain_under_load(count, [&](int cs, int len, uint8_t* data_out, uint8_t* data_in) {
+    std::lock_guard<std::mutex> guard(bus_lock);
+    return baseline_sim.transfer(cs, len, data_out, data_in);
+  });
+
+  SimBus sim(count, true);
+  struct at86rf212_bus_s bus;
+  struct at86rf212_bus_port_s ports[count];
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_bus_init(&bus, &sim.backend, &sim));
+  for (int i = 0; i < count; i++) {
+    at86rf212_bus_port_init(&bus, &ports[i], i, SimRadio::driver(), sim.radios[i].get());
+  }
+  DrainResult arbitrated = drain_under_load(count, [&](int cs, int len, uint8_t* data_out, uint8_t* data_in) {
+    return at86rf212_bus_spi_transfer(&ports[cs], len, data_out, data_in);
+  });
+
+  // Bus statistics agree with the measured waits
+  uint32_t max_wait_us = 0;
+  uint32_t drains = 0;
+  for (int i = 0; i < count; i++) {
+    struct at86rf212_bus_stats_s stats[AT86RF212_BUS_PRIOS];
+    at86rf212_bus_port_stats(&ports[i], stats);
+    drains += stats[AT86RF212_BUS_PRIO_RX].transfers;
+    if (stats[AT86RF212_BUS_PRIO_RX].max_wait_us > max_wait_us) {
+      max_wait_us = stats[AT86RF212_BUS_PRIO_RX].max_wait_us;
+    }
+  }
+  EXPECT_EQ(arbitrated.drains, drains);
+  EXPECT_LE(max_wait_us, arbitrated.max_wait_us);
+
+  printf("Frame drain wait with %d radios under configuration load: mutex %.0f us mean / %u us max, "
+         "arbiter %.0f us mean / %u us max (%u batches, %u coalesced transfers)\r\n",
+         count, baseline.mean_wait_us, baseline.max_wait_us, arbitrated.mean_wait_us, arbitrated.max_wait_us,
+         bus.stats.batches, bus.stats.coalesced);
+
+  // A drain waits for at most the batch in progress and the other radios' drains
+  EXPECT_LT(arbitrated.mean_wait_us, baseline.mean_wait_us);
+
+  at86rf212_bus_close(&bus);
+}
@@ -0,0 +1,347 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_cmdq.h"
+#include "at86rf212/at86rf212_cmdq.hpp"
+#include "at86rf212/at86rf212_regs.h"
+
+#include "sim_radio.hpp"
+
+static void count_notify(void* context)
+{
+  (*(std::atomic<uint32_t>*)context) ++;
+}
+
+static int record_channel(struct at86rf212_s* device, void* context)
+{
+  return at86rf212_get_channel(device, (uint8_t*)context);
+}
+
+TEST(At86rf212Cmdq, SubmitAndRun)
+{
+  SimRadio sim(NULL, 1);
+  struct at86rf212_s device;
+  struct at86rf212_cmdq_s queue;
+  struct at86rf212_cmd_s set, read, call, stats_cmd;
+  struct at86rf212_random_stats_s stats;
+  std::atomic<uint32_t> notifies(0);
+  uint8_t channel = 0xFF;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&device, SimRadio::driver(), &sim));
+  at86rf212_cmdq_init(&queue, &device, count_notify, &notifies);
+
+  EXPECT_EQ(0, at86rf212_cmdq_run(&queue, 16));
+
+  at86rf212_cmd_set_channel(&set, 7);
+  at86rf212_cmd_read_reg(&read, AT86RF212_REG_PHY_CC_CCA);
+  at86rf212_cmd_call(&call, record_channel, &channel);
+  at86rf212_cmd_random_stats(&stats_cmd, &stats);
+  at86rf212_cmdq_submit(&queue, &set);
+  at86rf212_cmdq_submit(&queue, &read);
+  at86rf212_cmdq_submit(&queue, &call);
+  at86rf212_cmdq_submit(&queue, &stats_cmd);
+
+  // Nothing executes outside the owner, which is woken once
+  EXPECT_FALSE(at86rf212_cmd_complete(&set));
+  EXPECT_EQ(1u, notifies.load());
+  uint32_t transfers = sim.transfers;
+  EXPECT_EQ(AT86RF212_DEFAULT_CHANNEL, sim.regs[AT86RF212_REG_PHY_CC_CCA] & AT86RF212_PHY_CC_CCA_CHANNEL_MASK);
+
+  // Commands run in submission order, limited by max
+  // Stopping with commands left wakes the owner again, as no submission will
+  EXPECT_EQ(2, at86rf212_cmdq_run(&queue, 2));
+  EXPECT_TRUE(at86rf212_cmd_complete(&set));
+  EXPECT_TRUE(at86rf212_cmd_complete(&read));
+  EXPECT_FALSE(at86rf212_cmd_complete(&call));
+  EXPECT_LT(transfers, sim.transfers);
+  EXPECT_EQ(AT86RF212_RES_OK, set.result);
+  EXPECT_EQ(7, read.result & AT86RF212_PHY_CC_CCA_CHANNEL_MASK);
+  EXPECT_TRUE(at86rf212_cmdq_pending(&queue));
+  EXPECT_EQ(2u, notifies.load());
+
+  // Emptying the queue at exactly max does not
+  EXPECT_EQ(2, at86rf212_cmdq_run(&queue, 2));
+  EXPECT_EQ(7, channel);
+  EXPECT_EQ(AT86RF212_RES_OK, stats_cmd.result);
+  EXPECT_FALSE(at86rf212_cmdq_pending(&queue));
+  EXPECT_EQ(2u, notifies.load());
+  EXPECT_EQ(0, at86rf212_cmdq_run(&queue, 16));
+
+  // Commands may be reused once complete, and the owner is woken again
+  at86rf212_cmd_set_channel(&set, 2);
+  at86rf212_cmdq_submit(&queue, &set);
+  EXPECT_EQ(3u, notifies.load());
+  EXPECT_EQ(1, at86rf212_cmdq_run(&queue, 16));
+  EXPECT_EQ(2, sim.regs[AT86RF212_REG_PHY_CC_CCA] & AT86RF212_PHY_CC_CCA_CHANNEL_MASK);
+
+  EXPECT_EQ(5u, queue.stats.submitted);
+  EXPECT_EQ(5u, queue.stats.executed);
+  EXPECT_EQ(2u, queue.stats.max_batch);
+}
+
+// Per-producer sequence check run in the owner context
+struct OrderCheck {
+  std::vector<uint32_t> next;
+  uint32_t errors;
+};
+
+struct OrderCmd {
+  struct at86rf212_cmd_s cmd;
+  OrderCheck* check;
+  uint32_t producer;
+  uint32_t seq;
+};
+
+static int check_order(struct at86rf212_s* device, void* context)
+{
+  OrderCmd* c = (OrderCmd*)context;
+  if (c->check->next[c->producer] != c->seq) {
+    c->check->errors ++;
+  }
+  c->check->next[c->producer] = c->seq + 1;
+  return c->seq;
+}
+
+TEST(At86rf212Cmdq, ProducerOrder)
+{
+  const int producers = 4;
+  const int per_producer = 20000;
+  SimRadio sim(NULL, 1);
+  struct at86rf212_s device;
+  struct at86rf212_cmdq_s queue;
+  OrderCheck check = {std::vector<uint32_t>(producers, 0), 0};
+  std::vector<OrderCmd> cmds(producers * per_producer);
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&device, SimRadio::driver(), &sim));
+  at86rf212_cmdq_init(&queue, &device, NULL, NULL);
+
+  std::thread owner([&]() {
+    while (queue.stats.executed < (uint32_t)(producers * per_producer)) {
+      if (at86rf212_cmdq_run(&queue, 64) == 0) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p]() {
+      for (int i = 0; i < per_producer; i++) {
+        OrderCmd* c = &cmds[p * per_producer + i];
+        c->check = &check;
+        c->producer = p;
+        c->seq = i;
+        at86rf212_cmd_call(&c->cmd, check_order, c);
+        at86rf212_cmdq_submit(&queue, &c->cmd);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  owner.join();
+
+  // Every command ran once, in order for each producer
+  EXPECT_EQ(0u, check.errors);
+  for (int p = 0; p < producers; p++) {
+    EXPECT_EQ((uint32_t)per_producer, check.next[p]);
+  }
+  for (auto& c : cmds) {
+    EXPECT_TRUE(at86rf212_cmd_complete(&c.cmd));
+  }
+  EXPECT_EQ((uint32_t)(producers * per_producer), queue.stats.executed);
+}
+
+TEST(At86rf212Cmdq, Futures)
+{
+  SimRadio sim(NULL, 1);
+  struct at86rf212_s device;
+  std::atomic<bool> running(true);
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&device, SimRadio::driver(), &sim));
+  AT86RF212::CommandQueue commands(&device);
+
+  std::thread owner([&]() {
+    while (running.load()) {
+      if (commands.run() == 0) {
+        std::this_thread::yield();
+      }
+    }
+    commands.run();
+  });
+
+  // Transmit, configure and read from several threads at once
+  std::vector<std::thread> threads;
+  std::atomic<uint32_t> errors(0);
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      uint8_t frame[16] = {0x41, 0x88, (uint8_t)t};
+      for (int i = 0; i < 50; i++) {
+        if (commands.send(sizeof(frame), frame).get() < 0) {
+          errors ++;
+        }
+        if (commands.set_power_raw(0x60 + t).get() < 0) {
+          errors ++;
+        }
+        if (commands.read_reg(AT86RF212_REG_PART_NUM).get() != 0x07) {
+          errors ++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  std::future<int> channel = commands.call([](struct at86rf212_s* d) {
+    uint8_t c;
+    int res = at86rf212_get_channel(d, &c);
+    return (res < 0) ? res : c;
+  });
+  EXPECT_EQ(AT86RF212_DEFAULT_CHANNEL, channel.get());
+
+  running = false;
+  owner.join();
+
+  EXPECT_EQ(0u, errors.load());
+  EXPECT_EQ(200u, sim.frames_sent);
+  EXPECT_EQ(commands.stats().submitted, commands.stats().executed);
+}
+
+TEST(At86rf212Cmdq, FuturesAlwaysComplete)
+{
+  SimRadio sim(NULL, 1);
+  struct at86rf212_s device;
+  uint8_t frame[AT86RF212_MAX_LENGTH] = {0x41, 0x88};
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&device, SimRadio::driver(), &sim));
+
+  std::future<int> queued;
+  {
+    AT86RF212::CommandQueue commands(&device);
+
+    // Oversized frames are rejected rather than truncated
+    std::future<int> oversized = commands.send(sizeof(frame), frame);
+    ASSERT_EQ(std::future_status::ready, oversized.wait_for(std::chrono::seconds(0)));
+    EXPECT_EQ(AT86RF212_ERROR_LEN, oversized.get());
+    EXPECT_EQ(0u, commands.stats().submitted);
+
+    // Commands left queued are completed when the queue is destroyed
+    queued = commands.send(16, frame);
+  }
+  ASSERT_EQ(std::future_status::ready, queued.wait_for(std::chrono::seconds(0)));
+  EXPECT_EQ(AT86RF212_ERROR_STATE, queued.get());
+  EXPECT_EQ(0u, sim.frames_sent);
+}
+
+struct LatencyStats {
+  double p50;
+  double p99;
+  double p999;
+  double max;
+};
+
+static LatencyStats percentiles(std::vector<double>& samples)
+{
+  std::sort(samples.begin(), samples.end());
+  LatencyStats s;
+  s.p50 = samples[samples.size() / 2];
+  s.p99 = samples[samples.size() * 99 / 100];
+  s.p999 = samples[samples.size() * 999 / 1000];
+  s.max = samples.back();
+  return s;
+}
+
+// Each thread issues register reads and waits for the result, recording the latency of each
+template <typename Read>
+static std::vector<double> contend(int threads, int per_thread, Read read)
+{
+  std::vector<std::vector<double>> latency(threads);
+  std::vector<std::thread> workers;
+
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      latency[t].reserve(per_thread);
+      for (int i = 0; i < per_thread; i++) {
+        auto start = std::chrono::steady_clock::now();
+        read();
+        latency[t].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+      }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  std::vector<double> all;
+  for (auto& l : latency) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  return all;
+}
+
+TEST(At86rf212Cmdq, Contention)
+{
+  const int per_thread = 5000;
+
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    SimRadio sim(NULL, 1);
+    struct at86rf212_s device;
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&device, SimRadio::driver(), &sim));
+
+    // Coarse lock around every call
+    std::mutex lock;
+    std::vector<double> locked = contend(threads, per_thread, [&]() {
+      std::lock_guard<std::mutex> guard(lock);
+      uint8_t val;
+      at86rf212_read_reg(&device, AT86RF212_REG_PART_NUM, &val);
+    });
+
+    // Submission to the owner thread, polling for completion
+    struct at86rf212_cmdq_s queue;
+    std::atomic<bool> running(true);
+    at86rf212_cmdq_init(&queue, &device, NULL, NULL);
+    std::thread owner([&]() {
+      while (running.load()) {
+        if (at86rf212_cmdq_run(&queue, 64) == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    std::atomic<uint32_t> errors(0);
+    std::vector<double> queued = contend(threads, per_thread, [&]() {
+      struct at86rf212_cmd_s cmd;
+      at86rf212_cmd_read_reg(&cmd, AT86RF212_REG_PART_NUM);
+      at86rf212_cmdq_submit(&queue, &cmd);
+      while (!at86rf212_cmd_complete(&cmd)) {
+        std::this_thread::yield();
+      }
+      if (cmd.result != 0x07) {
+        errors ++;
+      }
+    });
+    running = false;
+    owner.join();
+
+    EXPECT_EQ(0u, errors.load());
+    EXPECT_EQ((uint32_t)(threads * per_thread), queue.stats.executed);
+
+    LatencyStats l = percentiles(locked);
+    LatencyStats q = percentiles(queued);
+    printf("Commands from %d threads: mutex p50 %.1f / p99 %.1f / p99.9 %.1f / max %.0f us, "
+           "queue p50 %.1f / p99 %.1f / p99.9 %.1f / max %.0f us (max batch %u)\r\n",
+           threads, l.p50, l.p99, l.p999, l.max, q.p50, q.p99, q.p999, q.max, queue.stats.max_batch);
+  }
+}
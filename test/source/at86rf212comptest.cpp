@@ -0,0 +1,221 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_comp.h"
+
+#define MAC_HEADER_LEN      9       // Data frame with PAN ID compression and short addresses
+
+// Shared dictionary of common telemetry fields
+static const char comp_dict[] =
+  "{\"node\":\"sensor-\",\"seq\":,\"temp\":,\"humidity\":,\"pressure\":,\"battery\":3.,"
+  "\"rssi\":-,\"status\":\"ok\",\"uptime\":,\"light\":,\"co2\":,\"state\":\"idle\"}";
+
+// Telemetry message with slowly varying readings
+static std::string telemetry(uint32_t i)
+{
+  char buffer[AT86RF212_COMP_MAX_INPUT + 1];
+  snprintf(buffer, sizeof(buffer),
+           "{\"node\":\"sensor-%02u\",\"seq\":%u,\"temp\":%u.%u,\"humidity\":%u,"
+           "\"pressure\":%u,\"battery\":3.%02u,\"rssi\":-%u,\"status\":\"ok\"}",
+           i % 4, i, 20 + (i / 50) % 5, i % 10, 40 + (i / 20) % 10,
+           1000 + (i / 100) % 20, 90 - (i / 200) % 10, 60 + i % 7);
+  return std::string(buffer);
+}
+
+static void comp_init(struct at86rf212_comp_s *comp, uint8_t key_interval)
+{
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_init(comp, (const uint8_t*)comp_dict,
+                                                  sizeof(comp_dict) - 1, key_interval));
+}
+
+TEST(At86rf212Comp, RoundTrip)
+{
+  struct at86rf212_comp_s tx, rx;
+  uint8_t frame[AT86RF212_COMP_MAX_PAYLOAD];
+  uint8_t data[AT86RF212_COMP_MAX_PAYLOAD];
+  uint8_t frame_len, data_len;
+
+  comp_init(&tx, 16);
+  comp_init(&rx, 16);
+
+  for (uint32_t i = 0; i < 200; i++) {
+    std::string message = telemetry(i);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_compress(&tx, message.size(), (const uint8_t*)message.data(),
+                                                        &frame_len, frame));
+    ASSERT_LE(frame_len, message.size() + 2);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_decompress(&rx, frame_len, frame, &data_len, data));
+    ASSERT_EQ(message.size(), data_len);
+    ASSERT_EQ(0, memcmp(message.data(), data, data_len));
+  }
+  EXPECT_GT(tx.stats.delta_frames, 0);
+
+  // Incompressible payloads are stored
+  uint8_t noise[AT86RF212_COMP_MAX_INPUT];
+  uint32_t state = 12345;
+  for (unsigned i = 0; i < sizeof(noise); i++) {
+    state = state * 1103515245 + 12345;
+    noise[i] = state >> 16;
+  }
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_compress(&tx, sizeof(noise), noise, &frame_len, frame));
+  EXPECT_EQ(AT86RF212_COMP_TYPE_RAW, frame[0]);
+  EXPECT_EQ(sizeof(noise) + 2, frame_len);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_decompress(&rx, frame_len, frame, &data_len, data));
+  EXPECT_EQ(0, memcmp(noise, data, sizeof(noise)));
+
+  // Oversized input
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_comp_compress(&tx, AT86RF212_COMP_MAX_INPUT + 1, noise, &frame_len, frame));
+}
+
+TEST(At86rf212Comp, OutputBound)
+{
+  struct at86rf212_comp_s tx, rx;
+  uint8_t frame[AT86RF212_COMP_MAX_PAYLOAD + 1];
+  uint8_t data[AT86RF212_COMP_MAX_PAYLOAD];
+  uint8_t payload[AT86RF212_COMP_MAX_PAYLOAD];
+  uint8_t frame_len, data_len;
+  uint32_t state = 1;
+
+  // Delta frames carry the largest header, so nearly incompressible payloads reach the frame limit
+  comp_init(&tx, 0);
+  comp_init(&rx, 0);
+
+  for (int i = 0; i < 2000; i++) {
+    uint8_t length = AT86RF212_COMP_MAX_INPUT - (i % 4);
+    for (int j = 0; j < length; j++) {
+      state = state * 1103515245 + 12345;
+      payload[j] = state >> 16;
+    }
+    // A few short repeats, so the coder emits matches between long literal runs
+    int repeats = i % 3 + 1;
+    for (int r = 0; r < repeats; r++) {
+      state = state * 1103515245 + 12345;
+      int repeat = 3 + (state >> 8) % 4;
+      int offset = (state >> 16) % (length - 2 * repeat);
+      memcpy(&payload[offset + repeat], &payload[offset], repeat);
+    }
+
+    frame[AT86RF212_COMP_MAX_PAYLOAD] = 0xA5;
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_compress(&tx, length, payload, &frame_len, frame));
+    ASSERT_EQ(0xA5, frame[AT86RF212_COMP_MAX_PAYLOAD]) << "frame " << i;
+    ASSERT_LE(frame_len, AT86RF212_COMP_MAX_PAYLOAD);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_decompress(&rx, frame_len, frame, &data_len, data));
+    ASSERT_EQ(length, data_len);
+    ASSERT_EQ(0, memcmp(payload, data, length));
+  }
+
+  // A full 125 byte payload cannot be framed with a header
+  frame[AT86RF212_COMP_MAX_PAYLOAD] = 0xA5;
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_comp_compress(&tx, AT86RF212_COMP_MAX_PAYLOAD, payload, &frame_len, frame));
+  EXPECT_EQ(0xA5, frame[AT86RF212_COMP_MAX_PAYLOAD]);
+}
+
+TEST(At86rf212Comp, LostReference)
+{
+  struct at86rf212_comp_s tx, rx;
+  uint8_t frame[AT86RF212_COMP_MAX_PAYLOAD];
+  uint8_t data[AT86RF212_COMP_MAX_PAYLOAD];
+  uint8_t frame_len, data_len;
+  std::string message;
+
+  comp_init(&tx, 4);
+  comp_init(&rx, 4);
+
+  // Frame 0 is lost, frames 1 to 3 reference their predecessor
+  message = telemetry(0);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_compress(&tx, message.size(), (const uint8_t*)message.data(),
+                                                      &frame_len, frame));
+  for (uint32_t i = 1; i < 4; i++) {
+    message = telemetry(i);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_compress(&tx, message.size(), (const uint8_t*)message.data(),
+                                                        &frame_len, frame));
+    ASSERT_EQ(AT86RF212_COMP_TYPE_DELTA, frame[0]);
+    EXPECT_EQ(AT86RF212_ERROR_STATE, at86rf212_comp_decompress(&rx, frame_len, frame, &data_len, data));
+  }
+
+  // Key frame recovers the link
+  message = telemetry(4);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_compress(&tx, message.size(), (const uint8_t*)message.data(),
+                                                      &frame_len, frame));
+  EXPECT_NE(AT86RF212_COMP_TYPE_DELTA, frame[0]);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_decompress(&rx, frame_len, frame, &data_len, data));
+  EXPECT_EQ(0, memcmp(message.data(), data, data_len));
+  EXPECT_EQ(3, rx.stats.errors);
+
+  // Foreign and malformed frames
+  uint8_t foreign[4] = {0x41, 0x88, 0, 0};
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_comp_decompress(&rx, sizeof(foreign), foreign, &data_len, data));
+  uint8_t truncated[4] = {AT86RF212_COMP_TYPE_LZ, 0, 0x05, 'a'};
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_comp_decompress(&rx, sizeof(truncated), truncated, &data_len, data));
+  uint8_t distance[4] = {AT86RF212_COMP_TYPE_LZ, 0, 0x81, 0xFF};
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_comp_decompress(&rx, sizeof(distance), distance, &data_len, data));
+}
+
+TEST(At86rf212Comp, CorpusBenchmark)
+{
+  const uint8_t modes[] = {AT86RF212_PHY_BPSK_20, AT86RF212_PHY_BPSK_40, AT86RF212_PHY_OQPSK_100,
+                           AT86RF212_PHY_OQPSK_250, AT86RF212_PHY_OQPSK_1000
+                          };
+  const uint32_t messages = 2000;
+  struct at86rf212_comp_s tx, rx;
+  std::vector<std::string> corpus;
+  std::vector<std::vector<uint8_t> > frames;
+  uint8_t frame[AT86RF212_COMP_MAX_PAYLOAD];
+  uint8_t data[AT86RF212_COMP_MAX_PAYLOAD];
+  uint8_t frame_len, data_len;
+
+  for (uint32_t i = 0; i < messages; i++) {
+    corpus.push_back(telemetry(i));
+  }
+
+  comp_init(&tx, 16);
+  comp_init(&rx, 16);
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < messages; i++) {
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_compress(&tx, corpus[i].size(), (const uint8_t*)corpus[i].data(),
+                                                        &frame_len, frame));
+    frames.push_back(std::vector<uint8_t>(frame, frame + frame_len));
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < messages; i++) {
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_comp_decompress(&rx, frames[i].size(), frames[i].data(), &data_len, data));
+    ASSERT_EQ(0, memcmp(corpus[i].data(), data, data_len));
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double compress_ns = std::chrono::duration<double, std::nano>(mid - start).count() / messages;
+  double decompress_ns = std::chrono::duration<double, std::nano>(end - mid).count() / messages;
+  double ratio = (double)tx.stats.bytes_out / tx.stats.bytes_in;
+
+  printf("Corpus: %u messages, %u bytes in, %u bytes out (ratio %.2f), %u delta %u raw\r\n",
+         messages, tx.stats.bytes_in, tx.stats.bytes_out, ratio, tx.stats.delta_frames, tx.stats.raw_frames);
+  printf("CPU per frame: compress %.0f ns, decompress %.0f ns\r\n", compress_ns, decompress_ns);
+  printf("Per frame airtime with a %u byte MAC header:\r\n", MAC_HEADER_LEN);
+  printf("    rate   plain (us)   compressed (us)   saved\r\n");
+
+  for (unsigned m = 0; m < sizeof(modes); m++) {
+    uint64_t plain_us = 0, comp_us = 0;
+
+    for (uint32_t i = 0; i < messages; i++) {
+      plain_us += at86rf212_airtime_us(modes[m], MAC_HEADER_LEN + corpus[i].size() + AT86RF212_CRC_LEN);
+      comp_us += at86rf212_airtime_us(modes[m], MAC_HEADER_LEN + frames[i].size() + AT86RF212_CRC_LEN);
+    }
+
+    double plain_per = (double)plain_us / messages;
+    double comp_per = (double)comp_us / messages;
+    printf("%8u  %10.0f  %16.0f  %5.1f%%\r\n", at86rf212_get_bit_rate(modes[m]) / 1000,
+           plain_per, comp_per, 100 * (plain_per - comp_per) / plain_per);
+
+    EXPECT_LT(comp_per, plain_per);
+  }
+
+  EXPECT_LT(ratio, 0.6);
+}
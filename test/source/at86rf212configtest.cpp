@@ -0,0 +1,127 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212.hpp"
+#include "at86rf212/at86rf212_regs.h"
+#include "at86rf212/at86rf212_defs.h"
+
+#include "sim_radio.hpp"
+
+// Profiles are plain constant data
+constexpr struct at86rf212_config_s default_profile = AT86RF212_CONFIG_DEFAULT;
+
+constexpr struct at86rf212_config_s node_profile = {
+  AT86RF212_PHY_OQPSK_250,
+  3,
+  AT86RF212_CCA_MODE_CS_OR_ENERGY,
+  3,
+  5,
+  4,
+  3,
+  0,
+  0xC0,
+  AT86RF212_IRQ_2_RX_START | AT86RF212_IRQ_3_TRX_END,
+  0x0010,
+  0x1234
+};
+
+constexpr struct at86rf212_config_s reset_profile = {
+  AT86RF212_PHY_BPSK_40,
+  1,
+  AT86RF212_CCA_MODE_ENERGY,
+  3,
+  5,
+  4,
+  3,
+  0,
+  0x60,
+  AT86RF212_IRQ_NONE,
+  0xFFFF,
+  0xFFFF
+};
+
+static_assert(node_profile.phy_mode == AT86RF212_PHY_OQPSK_250, "Profiles are usable at compile time");
+
+TEST(At86rf212Config, Program)
+{
+  struct at86rf212_reg_update_s program[AT86RF212_CONFIG_PROGRAM_MAX];
+  uint8_t count;
+
+  // Settings matching the reset values produce no writes, leaving the fixed driver settings
+  EXPECT_EQ(2, at86rf212_config_program(&reset_profile, program));
+  EXPECT_EQ(AT86RF212_REG_TRX_CTRL_1, program[0].reg);
+  EXPECT_EQ(AT86RF212_REG_TRX_CTRL_2, program[1].reg);
+  EXPECT_EQ(0xA4, program[1].value);
+
+  // Default profile, CSMA and CCA settings are the reset values
+  count = at86rf212_config_program(&default_profile, program);
+  ASSERT_EQ(4, count);
+  EXPECT_EQ(AT86RF212_REG_TRX_CTRL_1, program[0].reg);
+  EXPECT_EQ(AT86RF212_REG_TRX_CTRL_2, program[1].reg);
+  EXPECT_EQ(0xA4, program[1].value);
+  EXPECT_EQ(AT86RF212_REG_XAH_CTRL_1, program[2].reg);
+  EXPECT_EQ(AT86RF212_REG_IRQ_MASK, program[3].reg);
+
+  // Every entry is a whole register write, interrupts are enabled last
+  count = at86rf212_config_program(&node_profile, program);
+  for (int i = 0; i < count; i++) {
+    EXPECT_EQ(0xFF, program[i].mask);
+  }
+  EXPECT_EQ(AT86RF212_REG_IRQ_MASK, program[count - 1].reg);
+}
+
+TEST(At86rf212Config, Profiles)
+{
+  const struct {
+    const char* name;
+    const struct at86rf212_config_s* config;
+  } profiles[] = {
+    {"reset", &reset_profile},
+    {"default", &default_profile},
+    {"node", &node_profile},
+  };
+
+  for (auto& p : profiles) {
+    SimRadio sim(NULL, 1);
+    AT86RF212::At86rf212 device;
+    struct at86rf212_reg_update_s program[AT86RF212_CONFIG_PROGRAM_MAX];
+    uint8_t channel;
+
+    ASSERT_EQ(AT86RF212_RES_OK, device.init(SimRadio::driver(), (void*) &sim, *p.config));
+    printf("Profile %s: %u register writes, %u init SPI transactions\r\n", p.name,
+           at86rf212_config_program(p.config, program), sim.transfers);
+
+    // Resulting register state matches the profile
+    const struct at86rf212_config_s& c = *p.config;
+    EXPECT_EQ(c.phy_mode, AT86RF212_FIELD_GET(TRX_CTRL2_PHY_MODE, sim.regs[AT86RF212_REG_TRX_CTRL_2]));
+    ASSERT_EQ(AT86RF212_RES_OK, device.get_channel(&channel));
+    EXPECT_EQ(c.channel, channel);
+    EXPECT_EQ(c.cca_mode, AT86RF212_FIELD_GET(PHY_CC_CCA_CCA_MODE, sim.regs[AT86RF212_REG_PHY_CC_CCA]));
+    EXPECT_EQ(c.min_be, AT86RF212_FIELD_GET(CSMA_BE_MIN, sim.regs[AT86RF212_REG_CSMA_BE]));
+    EXPECT_EQ(c.max_be, AT86RF212_FIELD_GET(CSMA_BE_MAX, sim.regs[AT86RF212_REG_CSMA_BE]));
+    EXPECT_EQ(c.max_csma_backoffs, AT86RF212_FIELD_GET(XAH_CTRL_MAX_CSMA_RETRIES, sim.regs[AT86RF212_REG_XAH_CTRL_0]));
+    EXPECT_EQ(c.promiscuous, AT86RF212_FIELD_GET(XAH_CTRL_1_AACK_PROM_MODE, sim.regs[AT86RF212_REG_XAH_CTRL_1]));
+    EXPECT_EQ(c.tx_power, sim.regs[AT86RF212_REG_PHY_TX_PWR]);
+    EXPECT_EQ(c.irq_mask, sim.regs[AT86RF212_REG_IRQ_MASK]);
+    EXPECT_EQ(c.short_address, sim.regs[AT86RF212_REG_SHORT_ADDR_0] | (sim.regs[AT86RF212_REG_SHORT_ADDR_1] << 8));
+    EXPECT_EQ(c.pan_id, sim.regs[AT86RF212_REG_PAN_ID_0] | (sim.regs[AT86RF212_REG_PAN_ID_1] << 8));
+    EXPECT_EQ(AT86RF212_SPI_CMD_MODE_PHY_RSSI, AT86RF212_FIELD_GET(TRX_CTRL1_SPI_CMD_MODE, sim.regs[AT86RF212_REG_TRX_CTRL_1]));
+  }
+}
+
+TEST(At86rf212Config, DefaultKeepsPowerOnModulation)
+{
+  SimRadio sim(NULL, 1);
+  AT86RF212::At86rf212 device;
+  uint8_t power_on = sim.regs[AT86RF212_REG_TRX_CTRL_2];
+
+  // Unconfigured nodes must stay on the air with nodes that never write TRX_CTRL_2
+  ASSERT_EQ(AT86RF212_RES_OK, device.init(SimRadio::driver(), (void*) &sim));
+  EXPECT_EQ(AT86RF212_FIELD_GET(TRX_CTRL2_PHY_MODE, power_on),
+            AT86RF212_FIELD_GET(TRX_CTRL2_PHY_MODE, sim.regs[AT86RF212_REG_TRX_CTRL_2]));
+}
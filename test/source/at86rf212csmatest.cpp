@@ -0,0 +1,285 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_csma.h"
+#include "at86rf212/at86rf212_regs.h"
+
+#include "sim_radio.hpp"
+
+// Slotted multi-node medium for benchmarking CSMA policies under contention
+// Each slot is one unit backoff period, all nodes are saturated (always have a frame queued)
+#define SIM_SLOTS           200000
+#define SIM_FRAME_SLOTS     5
+
+struct SimNode {
+  struct at86rf212_csma_s csma;
+  std::mt19937 rng;
+  uint16_t countdown;
+  int tx_remaining;
+  bool collided;
+  uint32_t delivered;
+};
+
+struct SimResult {
+  double goodput;
+  double fairness;
+  uint32_t failures;
+};
+
+static SimResult simulate(const struct at86rf212_csma_policy_s *policy, int num_nodes)
+{
+  std::vector<SimNode> nodes(num_nodes);
+  struct at86rf212_csma_config_s config;
+  SimResult result = {0, 0, 0};
+
+  at86rf212_csma_default_config(&config);
+  config.policy = policy;
+
+  for (int i = 0; i < num_nodes; i++) {
+    SimNode &n = nodes[i];
+    at86rf212_csma_init(&n.csma, NULL, &config);
+    n.rng.seed(i + 1);
+    n.countdown = at86rf212_csma_begin(&n.csma, n.rng());
+    n.tx_remaining = 0;
+    n.collided = false;
+    n.delivered = 0;
+  }
+
+  for (int slot = 0; slot < SIM_SLOTS; slot++) {
+    int active = 0;
+    for (int i = 0; i < num_nodes; i++) {
+      active += (nodes[i].tx_remaining > 0) ? 1 : 0;
+    }
+    uint8_t clear = (active == 0) ? 1 : 0;
+
+    // Channel assessments happen at the slot boundary, so simultaneous starts collide
+    for (int i = 0; i < num_nodes; i++) {
+      SimNode &n = nodes[i];
+      if (n.tx_remaining > 0) {
+        continue;
+      }
+      if (n.countdown > 0) {
+        n.countdown --;
+        continue;
+      }
+
+      uint16_t backoff;
+      int action = at86rf212_csma_step(&n.csma, clear, n.rng(), &backoff);
+      if (action == AT86RF212_CSMA_TRANSMIT) {
+        n.tx_remaining = SIM_FRAME_SLOTS;
+        n.collided = false;
+      } else if (action == AT86RF212_CSMA_FAIL) {
+        n.countdown = at86rf212_csma_begin(&n.csma, n.rng());
+      } else {
+        n.countdown = backoff;
+      }
+    }
+
+    active = 0;
+    for (int i = 0; i < num_nodes; i++) {
+      active += (nodes[i].tx_remaining > 0) ? 1 : 0;
+    }
+
+    for (int i = 0; i < num_nodes; i++) {
+      SimNode &n = nodes[i];
+      if (n.tx_remaining == 0) {
+        continue;
+      }
+      if (active > 1) {
+        n.collided = true;
+      }
+      n.tx_remaining --;
+      if (n.tx_remaining == 0) {
+        if (!n.collided) {
+          n.delivered ++;
+        }
+        n.countdown = at86rf212_csma_begin(&n.csma, n.rng());
+      }
+    }
+  }
+
+  double sum = 0, sum_sq = 0;
+  for (int i = 0; i < num_nodes; i++) {
+    double x = nodes[i].delivered;
+    sum += x;
+    sum_sq += x * x;
+    result.failures += nodes[i].csma.stats.failures;
+  }
+
+  result.goodput = (sum * SIM_FRAME_SLOTS) / SIM_SLOTS;
+  result.fairness = (sum_sq > 0) ? (sum * sum) / (num_nodes * sum_sq) : 0;
+
+  return result;
+}
+
+TEST(At86rf212Csma, PolicyStepping)
+{
+  struct at86rf212_csma_s csma;
+  struct at86rf212_csma_config_s config;
+  uint16_t backoff;
+
+  at86rf212_csma_default_config(&config);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_csma_init(&csma, NULL, &config));
+
+  // Backoff is bounded by the exponent and the channel is acquired when clear
+  EXPECT_LT(at86rf212_csma_begin(&csma, 0xFF), 1 << AT86RF212_DEFAULT_MINBE);
+  EXPECT_EQ(AT86RF212_CSMA_TRANSMIT, at86rf212_csma_step(&csma, 1, 0, &backoff));
+
+  // Busy channel fails after max backoffs
+  at86rf212_csma_begin(&csma, 0);
+  int action = AT86RF212_CSMA_BACKOFF;
+  int steps = 0;
+  while (action == AT86RF212_CSMA_BACKOFF) {
+    action = at86rf212_csma_step(&csma, 0, 0xFF, &backoff);
+    EXPECT_LT(backoff, 1 << AT86RF212_DEFAULT_MAXBE);
+    steps ++;
+  }
+  EXPECT_EQ(AT86RF212_CSMA_FAIL, action);
+  EXPECT_EQ(AT86RF212_DEFAULT_MAX_CSMA_BACKOFFS + 1, steps);
+  EXPECT_EQ(1, csma.stats.failures);
+}
+
+TEST(At86rf212Csma, ContentionBenchmark)
+{
+  const struct at86rf212_csma_policy_s *policies[] = {
+    &at86rf212_csma_policy_beb,
+    &at86rf212_csma_policy_persistent,
+    &at86rf212_csma_policy_adaptive,
+  };
+  const int node_counts[] = {2, 8, 32};
+
+  printf("%-14s %6s %10s %10s %10s\r\n", "policy", "nodes", "goodput", "fairness", "failures");
+
+  for (unsigned p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+    for (unsigned n = 0; n < sizeof(node_counts) / sizeof(node_counts[0]); n++) {
+      SimResult r = simulate(policies[p], node_counts[n]);
+      printf("%-14s %6d %10.3f %10.3f %10u\r\n", policies[p]->name, node_counts[n],
+             r.goodput, r.fairness, r.failures);
+
+      EXPECT_GT(r.goodput, 0.0);
+      EXPECT_LE(r.goodput, 1.0);
+      EXPECT_GT(r.fairness, 0.8);
+    }
+  }
+}
+
+// Simulated radio logging SPI commands, optionally receiving a frame when a CCA is requested
+struct CsmaProbe {
+  SimRadio* sim;
+  std::vector<uint8_t> commands;
+  bool inject;
+};
+
+static int probe_transfer(void* context, int len, uint8_t *data_out, uint8_t* data_in)
+{
+  CsmaProbe* probe = (CsmaProbe*)context;
+  const uint8_t foreign[8] = {0x41, 0x88, 0xEE};
+
+  probe->commands.push_back(data_out[0]);
+  int res = probe->sim->transfer(len, data_out, data_in);
+  if (probe->inject && (data_out[0] == (AT86RF212_REG_WRITE_FLAG | AT86RF212_REG_PHY_CC_CCA))
+      && ((data_out[1] & AT86RF212_PHY_CC_CCA_CCA_REQ_MASK) != 0)) {
+    probe->sim->receive(sizeof(foreign), foreign);
+    probe->inject = false;
+  }
+  return res;
+}
+
+static int probe_get_irq(void* context, uint8_t *val)
+{
+  *val = (((CsmaProbe*)context)->sim->irq != 0) ? 1 : 0;
+  return 0;
+}
+
+static int probe_get_time(void* context, uint32_t *time_us)
+{
+  SimRadio* sim = ((CsmaProbe*)context)->sim;
+  sim->advance(1);
+  *time_us = sim->now_us;
+  return 0;
+}
+
+TEST(At86rf212Csma, TransmitFollowsClearAssessment)
+{
+  SimMedium medium;
+  SimRadio tx_sim(&medium, 1), rx_sim(&medium, 2);
+  CsmaProbe probe = {&tx_sim, {}, false};
+  struct at86rf212_driver_s driver = *SimRadio::driver();
+  struct at86rf212_s tx, rx;
+  struct at86rf212_csma_s csma;
+  struct at86rf212_csma_config_s config;
+  uint8_t frame[20] = {0x41, 0x88, 0x01};
+
+  driver.spi_transfer = probe_transfer;
+  driver.get_irq = probe_get_irq;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&tx, &driver, &probe));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_time_source(&tx, probe_get_time, &probe));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), &rx_sim));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+  at86rf212_csma_default_config(&config);
+  config.unit_backoff_us = 1;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_csma_init(&csma, &tx, &config));
+
+  // The upload precedes the assessment, and only state changes lie between it and TX_START
+  probe.commands.clear();
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_csma_start_tx(&csma, sizeof(frame), frame));
+  ASSERT_EQ(1u, tx_sim.frames_sent);
+  std::vector<uint8_t>& c = probe.commands;
+  size_t upload = std::find(c.begin(), c.end(), AT86RF212_FRAME_WRITE_FLAG) - c.begin();
+  size_t cca = std::find(c.begin(), c.end(), AT86RF212_REG_WRITE_FLAG | AT86RF212_REG_PHY_CC_CCA) - c.begin();
+  ASSERT_LT(upload, cca);
+  ASSERT_LT(cca, c.size());
+  EXPECT_EQ(c.end(), std::find(c.begin() + cca, c.end(), AT86RF212_FRAME_WRITE_FLAG));
+  EXPECT_GE(7u, c.size() - cca);
+  EXPECT_EQ(AT86RF212_REG_WRITE_FLAG | AT86RF212_REG_TRX_STATE, c.back());
+  EXPECT_EQ(0, memcmp(frame, &rx_sim.buffer[1], sizeof(frame)));
+
+  // A frame arriving during the assessment replaces the upload, it is counted busy and reloaded
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_discard_rx(&rx));
+  frame[2] = 0x02;
+  probe.inject = true;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_csma_start_tx(&csma, sizeof(frame), frame));
+  EXPECT_EQ(2u, tx_sim.frames_sent);
+  EXPECT_EQ(1u, csma.stats.busy);
+  EXPECT_EQ(0, memcmp(frame, &rx_sim.buffer[1], sizeof(frame)));
+}
+
+TEST(At86rf212Csma, BackToBack)
+{
+  SimMedium medium;
+  SimRadio tx_sim(&medium, 1), rx_sim(&medium, 2);
+  struct at86rf212_s tx, rx;
+  struct at86rf212_csma_s csma;
+  struct at86rf212_csma_config_s config;
+  uint8_t frame[20] = {0x41, 0x88, 0x01};
+  uint8_t rnd;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&tx, SimRadio::driver(), &tx_sim));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), &rx_sim));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+  at86rf212_csma_default_config(&config);
+  config.unit_backoff_us = 1;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_csma_init(&csma, &tx, &config));
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_csma_start_tx(&csma, sizeof(frame), frame));
+  ASSERT_EQ(AT86RF212_PLL_ON, tx_sim.state());
+
+  // Empty the random pool, the next send starts from PLL_ON with no bits in hand
+  while (at86rf212_get_random(&tx, &rnd, 1) == AT86RF212_RES_OK);
+  ASSERT_EQ(AT86RF212_ERROR_STATE, at86rf212_get_random(&tx, &rnd, 1));
+
+  frame[2] = 0x02;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_csma_start_tx(&csma, sizeof(frame), frame));
+  EXPECT_EQ(2u, tx_sim.frames_sent);
+}
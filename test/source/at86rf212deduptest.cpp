@@ -0,0 +1,195 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_dedup.h"
+#include "at86rf212/at86rf212_mac.hpp"
+
+#include "sim_radio.hpp"
+
+TEST(At86rf212Dedup, Check)
+{
+  struct at86rf212_dedup_s dedup;
+
+  at86rf212_dedup_init(&dedup, 1000, 0);
+
+  EXPECT_EQ(0, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0010, 1, 0, 0));
+  EXPECT_EQ(1, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0010, 1, 0, 100));
+  EXPECT_EQ(1, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0010, 1, 0, 1000));
+
+  // Different sequence number, source or addressing mode
+  EXPECT_EQ(0, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0010, 2, 0, 100));
+  EXPECT_EQ(0, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0011, 1, 0, 100));
+  EXPECT_EQ(0, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_EXTENDED, 0x0010, 1, 0, 100));
+
+  // Entries age out, the reused sequence number is then recorded again
+  EXPECT_EQ(0, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0010, 1, 0, 1001));
+  EXPECT_EQ(1, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0010, 1, 0, 1500));
+
+  // Hash distinguishes different frames reusing a sequence number
+  EXPECT_EQ(0, at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0010, 1, 0x1234, 1500));
+
+  EXPECT_EQ(9, dedup.stats.lookups);
+  EXPECT_EQ(3, dedup.stats.duplicates);
+  EXPECT_EQ(0, dedup.stats.evictions);
+
+  // Overfill: live entries are replaced oldest first
+  at86rf212_dedup_init(&dedup, 1000000, 0);
+  for (int i = 0; i < AT86RF212_DEDUP_SETS * AT86RF212_DEDUP_WAYS * 2; i++) {
+    at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0100 + i / 256, i & 0xFF, 0, i);
+  }
+  EXPECT_LE(AT86RF212_DEDUP_SETS * AT86RF212_DEDUP_WAYS, dedup.stats.evictions);
+  EXPECT_EQ(0, dedup.stats.duplicates);
+}
+
+TEST(At86rf212Dedup, Header)
+{
+  struct at86rf212_dedup_s dedup;
+  uint8_t frame[AT86RF212_MAC_MAX_FRAME];
+  uint8_t len;
+
+  at86rf212_dedup_init(&dedup, 1000, 1);
+
+  // Extended source address
+  len = AT86RF212::MacDataExtended::build(frame, 7, 0x1234, 0x0102030405060708ULL, 0x1234, 0x1112131415161718ULL);
+  memset(&frame[len], 0xAA, 10);
+  len += 10;
+  EXPECT_EQ(0, at86rf212_dedup_check_header(&dedup, len, frame, 0));
+  EXPECT_EQ(1, at86rf212_dedup_check_header(&dedup, len, frame, 10));
+
+  // Same source and sequence number with a different payload
+  frame[len - 1] = 0x55;
+  EXPECT_EQ(0, at86rf212_dedup_check_header(&dedup, len, frame, 20));
+
+  // Short source address
+  len = AT86RF212::MacDataShort::build(frame, 9, 0x1234, 0x0001, 0x1234, 0x0002);
+  EXPECT_EQ(0, at86rf212_dedup_check_header(&dedup, len, frame, 30));
+  EXPECT_EQ(1, at86rf212_dedup_check_header(&dedup, len, frame, 40));
+
+  // Frames without a source address are passed untracked
+  len = AT86RF212::MacAck::build(frame, 9, 0, 0, 0, 0);
+  EXPECT_EQ(0, at86rf212_dedup_check_header(&dedup, len, frame, 50));
+  EXPECT_EQ(0, at86rf212_dedup_check_header(&dedup, len, frame, 50));
+  EXPECT_EQ(2, dedup.stats.untracked);
+}
+
+TEST(At86rf212Dedup, RetriedFrames)
+{
+  SimMedium medium;
+  SimRadio sim_rx(&medium, 1);
+  SimRadio sim_tx(&medium, 2);
+  struct at86rf212_s rx, tx;
+  struct at86rf212_dedup_s dedup;
+  uint8_t frame[AT86RF212_MAC_MAX_FRAME];
+  uint8_t data[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+  uint8_t length;
+  int res;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), (void*) &sim_rx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&tx, SimRadio::driver(), (void*) &sim_tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+  at86rf212_dedup_init(&dedup, 100000, 1);
+
+  // Four sources, every frame retried twice (ACK lost)
+  const int frames = 100;
+  int delivered = 0;
+
+  for (int i = 0; i < frames; i++) {
+    uint8_t len = AT86RF212::MacDataShortAck::build(frame, i / 4, 0x0100, 0x0001, 0x0100, 0x0010 + (i % 4));
+    for (int j = 0; j < 60; j++) {
+      frame[len++] = i + j;
+    }
+
+    for (int retry = 0; retry < 3; retry++) {
+      ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_tx(&tx, len, frame));
+      res = at86rf212_get_rx_dedup(&rx, &dedup, i * 10000 + retry * 1000, &length, data);
+      ASSERT_GE(res, 0);
+      if (res == AT86RF212_RES_OK) {
+        delivered ++;
+        EXPECT_EQ(0, memcmp(frame, data, len));
+      }
+    }
+  }
+
+  EXPECT_EQ(frames, delivered);
+  EXPECT_EQ(frames * 3, dedup.stats.lookups);
+  EXPECT_EQ(frames * 2, dedup.stats.duplicates);
+  printf("Duplicate filter: %u of %u frames suppressed, %u frame buffer bytes avoided\r\n",
+         dedup.stats.duplicates, dedup.stats.lookups, dedup.stats.bytes_saved);
+}
+
+TEST(At86rf212Dedup, LookupCost)
+{
+  const uint32_t sources = 16;
+  const uint32_t iterations = 2000000;
+  struct at86rf212_dedup_s dedup;
+  std::vector<uint8_t> seqs(sources, 0);
+  uint32_t state = 1;
+
+  // 1 ms per frame, entries live for 50 ms, a third of frames are retries
+  at86rf212_dedup_init(&dedup, 50000, 1);
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    state = state * 1103515245 + 12345;
+    uint32_t s = (state >> 16) % sources;
+    if (((state >> 8) % 3) != 0) {
+      seqs[s] ++;
+    }
+    at86rf212_dedup_check(&dedup, AT86RF212_MAC_ADDR_SHORT, 0x0100 + s, seqs[s], seqs[s] * 31, i * 1000);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double lookup_ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  printf("Duplicate filter: %.1f ns per lookup, hit rate %.1f%%, %u evictions (%u bytes)\r\n",
+         lookup_ns, 100.0 * dedup.stats.duplicates / dedup.stats.lookups, dedup.stats.evictions,
+         (unsigned)sizeof(dedup));
+
+  EXPECT_EQ(iterations, dedup.stats.lookups);
+  // Retries of frames older than the lifetime or evicted are missed
+  EXPECT_NEAR(1.0 / 3, (double)dedup.stats.duplicates / dedup.stats.lookups, 0.04);
+}
+
+TEST(At86rf212Dedup, SingleDownload)
+{
+  SimRadio sim(NULL, 1);
+  struct at86rf212_s rx;
+  struct at86rf212_dedup_s dedup;
+  uint8_t frame[AT86RF212_MAC_MAX_FRAME];
+  uint8_t data[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+  uint8_t length;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), (void*) &sim));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+  at86rf212_dedup_init(&dedup, 100000, 1);
+
+  uint8_t len = AT86RF212::MacDataShortAck::build(frame, 7, 0x0100, 0x0001, 0x0100, 0x0010);
+  for (int j = 0; j < 90; j++) {
+    frame[len++] = j;
+  }
+
+  // Header bytes are fetched once, the remainder completes the frame
+  sim.receive(len + AT86RF212_CRC_LEN, frame);
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx_start(&rx));
+  uint32_t bytes = sim.bytes;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx_dedup(&rx, &dedup, 0, &length, data));
+  uint32_t full = (2 + AT86RF212_DEDUP_FETCH_LEN) + (1 + AT86RF212_LEN_FIELD_LEN + len + AT86RF212_CRC_LEN + AT86RF212_FRAME_RX_OVERHEAD);
+  EXPECT_LT(sim.bytes - bytes, full - AT86RF212_DEDUP_FETCH_LEN + 8);
+  EXPECT_EQ(len + AT86RF212_CRC_LEN + AT86RF212_FRAME_RX_OVERHEAD, length);
+  EXPECT_EQ(0, memcmp(frame, data, len));
+  EXPECT_EQ(sim.lqi, data[len + AT86RF212_CRC_LEN]);
+  EXPECT_NE(0, data[len + AT86RF212_CRC_LEN + 2] & AT86RF212_RX_STATUS_CRC_VALID_MASK);
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_check_rx(&rx));
+
+  // A duplicate with TRX_END latched is consumed rather than reported again
+  sim.receive(len + AT86RF212_CRC_LEN, frame);
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx_start(&rx));
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_get_rx_dedup(&rx, &dedup, 1000, &length, data));
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_check_rx(&rx));
+}
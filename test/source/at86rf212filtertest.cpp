@@ -0,0 +1,168 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_filter.h"
+
+#include "sim_radio.hpp"
+
+// Build a data frame with PAN ID compression and short addressing
+static uint8_t build_frame(uint8_t* frame, uint8_t seq, uint16_t pan, uint16_t dest, uint16_t src, uint8_t payload_len)
+{
+  uint8_t header[9] = {0x61, 0x88, seq,
+                       (uint8_t)(pan & 0xFF), (uint8_t)(pan >> 8),
+                       (uint8_t)(dest & 0xFF), (uint8_t)(dest >> 8),
+                       (uint8_t)(src & 0xFF), (uint8_t)(src >> 8)};
+
+  memcpy(frame, header, sizeof(header));
+  for (int i = 0; i < payload_len; i++) {
+    frame[sizeof(header) + i] = i;
+  }
+
+  return sizeof(header) + payload_len + AT86RF212_CRC_LEN;
+}
+
+TEST(At86rf212Filter, Match)
+{
+  struct at86rf212_filter_spec_s spec;
+  struct at86rf212_filter_s filter;
+  uint8_t frame[AT86RF212_MAX_LENGTH];
+  uint8_t len;
+
+  memset(&spec, 0, sizeof(spec));
+  spec.frame_types = 1 << AT86RF212_FRAME_TYPE_DATA;
+  spec.match_dest_pan = 1;
+  spec.dest_pan = 0x0100;
+  spec.match_dest_addr = 1;
+  spec.dest_addr = 0x0001;
+  spec.accept_broadcast = 1;
+  spec.num_sources = 2;
+  spec.sources[0] = 0x0010;
+  spec.sources[1] = 0x0011;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_filter_compile(&filter, &spec));
+  EXPECT_EQ(11, filter.header_len);
+
+  len = build_frame(frame, 0, 0x0100, 0x0001, 0x0010, 4);
+  EXPECT_EQ(1, at86rf212_filter_match(&filter, len, frame));
+
+  len = build_frame(frame, 0, 0x0100, 0xFFFF, 0x0011, 4);
+  EXPECT_EQ(1, at86rf212_filter_match(&filter, len, frame));
+
+  len = build_frame(frame, 0, 0x0200, 0x0001, 0x0010, 4);
+  EXPECT_EQ(0, at86rf212_filter_match(&filter, len, frame));
+
+  len = build_frame(frame, 0, 0x0100, 0x0002, 0x0010, 4);
+  EXPECT_EQ(0, at86rf212_filter_match(&filter, len, frame));
+
+  len = build_frame(frame, 0, 0x0100, 0x0001, 0x0012, 4);
+  EXPECT_EQ(0, at86rf212_filter_match(&filter, len, frame));
+
+  // Frame type
+  len = build_frame(frame, 0, 0x0100, 0x0001, 0x0010, 4);
+  frame[0] = (frame[0] & ~0x07) | AT86RF212_FRAME_TYPE_MAC_CMD;
+  EXPECT_EQ(0, at86rf212_filter_match(&filter, len, frame));
+
+  // User byte match on the first payload byte
+  spec.num_matches = 1;
+  spec.matches[0].offset = 9;
+  spec.matches[0].mask = 0xF0;
+  spec.matches[0].value = 0xA0;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_filter_compile(&filter, &spec));
+
+  len = build_frame(frame, 0, 0x0100, 0x0001, 0x0010, 4);
+  EXPECT_EQ(0, at86rf212_filter_match(&filter, len, frame));
+  frame[9] = 0xA5;
+  EXPECT_EQ(1, at86rf212_filter_match(&filter, len, frame));
+}
+
+TEST(At86rf212Filter, SharedChannelBenchmark)
+{
+  SimMedium medium;
+  SimRadio sim_rx(&medium, 1);
+  SimRadio sim_tx(&medium, 2);
+  struct at86rf212_s rx, tx;
+  struct at86rf212_filter_spec_s spec;
+  struct at86rf212_filter_s filter;
+  uint8_t frame[AT86RF212_MAX_LENGTH];
+  uint8_t data[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+  uint8_t length;
+  int res;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), (void*) &sim_rx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&tx, SimRadio::driver(), (void*) &sim_tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+
+  memset(&spec, 0, sizeof(spec));
+  spec.match_dest_pan = 1;
+  spec.dest_pan = 0x0100;
+  spec.match_dest_addr = 1;
+  spec.dest_addr = 0x0001;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_filter_compile(&filter, &spec));
+
+  // Eight nodes sharing the channel, one in four frames addressed to us
+  const int frames = 200;
+  int accepted = 0;
+  uint32_t unfiltered_bytes = 0;
+
+  for (int i = 0; i < frames; i++) {
+    uint16_t dest = ((i % 4) == 0) ? 0x0001 : (0x0002 + (i % 7));
+    uint8_t len = build_frame(frame, i, 0x0100, dest, 0x0010 + (i % 8), 40 + (i % 60));
+
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_tx(&tx, len - AT86RF212_CRC_LEN, frame));
+    unfiltered_bytes += AT86RF212_LEN_FIELD_LEN * 2 + len + AT86RF212_FRAME_RX_OVERHEAD;
+
+    res = at86rf212_get_rx_filtered(&rx, &filter, &length, data);
+    ASSERT_GE(res, 0);
+    if (res == AT86RF212_RES_OK) {
+      accepted ++;
+      EXPECT_EQ(0x01, data[5]);
+    }
+  }
+
+  EXPECT_EQ(frames / 4, accepted);
+  EXPECT_EQ(frames / 4, filter.stats.accepted);
+  EXPECT_EQ(frames - frames / 4, filter.stats.rejected);
+
+  printf("Frame buffer bytes per frame: %.1f unfiltered, %.1f filtered\r\n",
+         (double)unfiltered_bytes / frames, (double)filter.stats.bytes_fetched / frames);
+  EXPECT_LT(filter.stats.bytes_fetched, unfiltered_bytes / 2);
+}
+
+TEST(At86rf212Filter, RejectedFrameIsConsumed)
+{
+  SimRadio sim(NULL, 1);
+  struct at86rf212_s rx;
+  struct at86rf212_filter_spec_s spec;
+  struct at86rf212_filter_s filter;
+  uint8_t frame[AT86RF212_MAX_LENGTH];
+  uint8_t data[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+  uint8_t length;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), (void*) &sim));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+
+  memset(&spec, 0, sizeof(spec));
+  spec.match_dest_addr = 1;
+  spec.dest_addr = 0x0001;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_filter_compile(&filter, &spec));
+
+  // TRX_END latched while waiting for RX_START belongs to the rejected frame
+  uint8_t len = build_frame(frame, 1, 0x0100, 0x0002, 0x0010, 8);
+  sim.receive(len, frame);
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx_start(&rx));
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_get_rx_filtered(&rx, &filter, &length, data));
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_check_rx(&rx));
+
+  // The next frame is still reported and fetched
+  len = build_frame(frame, 2, 0x0100, 0x0001, 0x0010, 8);
+  sim.receive(len, frame);
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx(&rx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx_filtered(&rx, &filter, &length, data));
+  EXPECT_EQ(2, data[2]);
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_check_rx(&rx));
+}
@@ -0,0 +1,181 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212.hpp"
+#include "at86rf212/at86rf212_frame.hpp"
+#include "at86rf212/at86rf212_mac.hpp"
+
+#include "sim_radio.hpp"
+
+using namespace AT86RF212;
+
+TEST(At86rf212Frame, PoolOwnership)
+{
+  FramePool<4> pool;
+  std::vector<Frame> frames;
+
+  for (int i = 0; i < 4; i++) {
+    frames.push_back(pool.acquire());
+    ASSERT_TRUE(frames.back().valid());
+  }
+
+  // Exhausted pools return empty frames
+  Frame extra = pool.acquire();
+  EXPECT_FALSE(extra.valid());
+  EXPECT_EQ(1u, pool.exhausted_count());
+
+  // Moving transfers ownership, the buffer is returned once
+  static_assert(std::is_nothrow_move_constructible<Frame>::value, "Frame moves must not throw");
+  static_assert(std::is_nothrow_move_assignable<Frame>::value, "Frame moves must not throw");
+  frames[0].resize(10);
+  frames[0].data()[0] = 0x5A;
+  uint8_t* buffer = frames[0].data();
+  Frame moved(std::move(frames[0]));
+  EXPECT_FALSE(frames[0].valid());
+  EXPECT_EQ(buffer, moved.data());
+  EXPECT_EQ(10, moved.length());
+
+  extra = std::move(moved);
+  EXPECT_EQ(buffer, extra.data());
+  extra = Frame();
+  EXPECT_TRUE(pool.acquire().valid());
+
+  frames.clear();
+  for (int i = 0; i < 4; i++) {
+    frames.push_back(pool.acquire());
+    EXPECT_TRUE(frames.back().valid());
+  }
+  EXPECT_FALSE(pool.acquire().valid());
+
+  EXPECT_FALSE(frames[0].resize(Frame::capacity + 1));
+  EXPECT_TRUE(frames[0].resize(Frame::capacity));
+}
+
+TEST(At86rf212Frame, SendReceive)
+{
+  SimMedium medium;
+  SimRadio sim_tx(&medium, 1), sim_rx(&medium, 2);
+  At86rf212 tx, rx;
+  FramePool<2> tx_pool, rx_pool;
+
+  ASSERT_EQ(AT86RF212_RES_OK, tx.init(SimRadio::driver(), (void*) &sim_tx));
+  ASSERT_EQ(AT86RF212_RES_OK, rx.init(SimRadio::driver(), (void*) &sim_rx));
+  ASSERT_EQ(AT86RF212_RES_OK, rx.start_rx());
+
+  // Build directly into the pooled buffer
+  Frame frame = tx_pool.acquire();
+  uint8_t header_len = MacDataShort::build(frame.data(), 7, 0x1234, 0x0002, 0x1234, 0x0001);
+  for (int i = 0; i < 40; i++) {
+    frame.data()[header_len + i] = i;
+  }
+  frame.resize(header_len + 40);
+  frame.set_header_length(header_len);
+
+  // Transmission consumes the frame, returning the buffer to the pool
+  uint32_t bytes = sim_tx.bytes;
+  ASSERT_EQ(AT86RF212_RES_OK, tx.start_tx(std::move(frame)));
+  EXPECT_FALSE(frame.valid());
+  uint32_t pooled_bytes = sim_tx.bytes - bytes;
+
+  uint8_t data[AT86RF212_MAX_LENGTH];
+  memset(data, 0, sizeof(data));
+  MacDataShort::build(data, 7, 0x1234, 0x0002, 0x1234, 0x0001);
+  for (int i = 0; i < 40; i++) {
+    data[header_len + i] = i;
+  }
+  bytes = sim_tx.bytes;
+  ASSERT_EQ(AT86RF212_RES_OK, tx.start_tx(header_len + 40, data));
+  EXPECT_EQ(sim_tx.bytes - bytes, pooled_bytes);
+
+  Frame a = tx_pool.acquire(), b = tx_pool.acquire();
+  EXPECT_TRUE(a.valid());
+  EXPECT_TRUE(b.valid());
+
+  // Receive into a pooled buffer, the header is parsed on demand
+  Frame received = rx_pool.acquire();
+  ASSERT_EQ(AT86RF212_RES_OK, rx.get_rx(received));
+  ASSERT_EQ(header_len + 40, received.length());
+  EXPECT_TRUE(received.crc_valid());
+  EXPECT_EQ(sim_rx.lqi, received.lqi());
+  EXPECT_EQ(sim_rx.ed, received.ed());
+  EXPECT_EQ(0, memcmp(data, received.data(), received.length()));
+
+  Span<uint8_t> header = received.header();
+  Span<uint8_t> payload = received.payload();
+  EXPECT_EQ(header_len, header.size());
+  EXPECT_TRUE(MacDataShort::matches(header.size(), header.data()));
+  EXPECT_EQ(7, MacDataShort::seq(header.data()));
+  ASSERT_EQ(40u, payload.size());
+  uint8_t expected = 0;
+  for (uint8_t v : payload) {
+    EXPECT_EQ(expected++, v);
+  }
+
+  // Frames without a buffer are rejected
+  Frame none;
+  EXPECT_EQ(AT86RF212_ERROR_FULL, rx.get_rx(none));
+  EXPECT_EQ(AT86RF212_ERROR_FULL, tx.start_tx(std::move(none)));
+}
+
+TEST(At86rf212Frame, ConcurrentPool)
+{
+  const int threads = 4;
+  const int iterations = 200000;
+  FramePool<16> pool;
+  std::atomic<uint32_t> errors(0);
+  std::vector<std::thread> workers;
+
+  // Each thread acquires, holds and releases frames, checking no other thread was given the same buffer
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&pool, &errors, t, iterations]() {
+      std::vector<Frame> held;
+      for (int i = 0; i < iterations; i++) {
+        if ((held.size() < 3) && ((i % 5) != 0)) {
+          Frame f = pool.acquire();
+          if (f.valid()) {
+            f.resize(2);
+            f.data()[0] = t;
+            f.data()[1] = i & 0xFF;
+            held.push_back(std::move(f));
+          }
+        } else if (!held.empty()) {
+          Frame& f = held.front();
+          // No other thread may have been given the same buffer
+          if ((f.data()[0] != t) || (f.length() != 2)) {
+            errors ++;
+          }
+          held.erase(held.begin());
+        }
+      }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(0u, errors.load());
+
+  // Every buffer was returned
+  std::vector<Frame> frames;
+  for (int i = 0; i < 16; i++) {
+    frames.push_back(pool.acquire());
+    EXPECT_TRUE(frames.back().valid());
+  }
+  EXPECT_FALSE(pool.acquire().valid());
+
+  printf("Frame pool: %.1f ns per iteration with %d threads contending\r\n",
+         std::chrono::duration<double, std::nano>(end - start).count() / iterations, threads);
+}
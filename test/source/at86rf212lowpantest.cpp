@@ -0,0 +1,410 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_mac.h"
+#include "at86rf212/at86rf212_mac.hpp"
+#include "at86rf212/at86rf212_lowpan.h"
+
+#include "sim_radio.hpp"
+
+#define FRAME_ROOM    (AT86RF212_MAC_MAX_FRAME - AT86RF212::MacDataShort::header_len)
+
+static const uint8_t link_local[8] = {0xFE, 0x80, 0, 0, 0, 0, 0, 0};
+static const uint8_t global[8] = {0x20, 0x01, 0x0D, 0xB8, 0x00, 0x01, 0x00, 0x02};
+
+// Build an IPv6 packet, with a UDP header if next_header is 17
+static std::vector<uint8_t> ipv6_packet(const uint8_t* src, const uint8_t* dst, uint8_t next_header,
+                                        uint16_t src_port, uint16_t dst_port, uint16_t payload_len,
+                                        uint8_t tc = 0, uint32_t flow = 0, uint8_t hop_limit = 64)
+{
+  uint16_t length = 40 + ((next_header == 17) ? 8 : 0) + payload_len;
+  std::vector<uint8_t> ip(length);
+
+  ip[0] = 0x60 | (tc >> 4);
+  ip[1] = ((tc & 0x0F) << 4) | ((flow >> 16) & 0x0F);
+  ip[2] = (flow >> 8) & 0xFF;
+  ip[3] = flow & 0xFF;
+  ip[4] = (length - 40) >> 8;
+  ip[5] = (length - 40) & 0xFF;
+  ip[6] = next_header;
+  ip[7] = hop_limit;
+  memcpy(&ip[8], src, 16);
+  memcpy(&ip[24], dst, 16);
+
+  uint16_t offset = 40;
+  if (next_header == 17) {
+    ip[40] = src_port >> 8;
+    ip[41] = src_port & 0xFF;
+    ip[42] = dst_port >> 8;
+    ip[43] = dst_port & 0xFF;
+    ip[44] = ip[4];
+    ip[45] = ip[5];
+    ip[46] = 0xBE;
+    ip[47] = 0xEF;
+    offset = 48;
+  }
+  for (uint16_t i = offset; i < length; i++) {
+    ip[i] = i * 7;
+  }
+  return ip;
+}
+
+static void make_addr(uint8_t* addr, const uint8_t* prefix, const uint8_t* iid)
+{
+  memcpy(addr, prefix, 8);
+  memcpy(&addr[8], iid, 8);
+}
+
+// Send a packet through a tx context and receive it, returns the frame payload lengths
+static std::vector<int> loopback(struct at86rf212_lowpan_s *tx_lowpan, struct at86rf212_lowpan_s *rx_lowpan,
+                                 const struct at86rf212_lowpan_ll_s *src, const struct at86rf212_lowpan_ll_s *dst,
+                                 const std::vector<uint8_t> &packet, uint8_t room)
+{
+  struct at86rf212_lowpan_tx_s tx;
+  uint8_t frame[AT86RF212_MAC_MAX_FRAME];
+  std::vector<int> lengths;
+  uint16_t out_len = 0;
+  const uint8_t* out = NULL;
+  int len, res = -1;
+
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_tx_start(tx_lowpan, &tx, src, dst, packet.size(), packet.data()));
+  while ((len = at86rf212_lowpan_tx_next(tx_lowpan, &tx, room, frame)) > 0) {
+    EXPECT_LE(len, room);
+    lengths.push_back(len);
+    res = at86rf212_lowpan_input(rx_lowpan, 0, src, dst, len, frame, &out_len, &out);
+    EXPECT_GE(res, 0);
+  }
+  EXPECT_EQ(0, len);
+  EXPECT_EQ(AT86RF212_RES_DONE, res);
+  EXPECT_EQ(packet.size(), out_len);
+  if (out != NULL) {
+    EXPECT_EQ(0, memcmp(packet.data(), out, out_len));
+  }
+  return lengths;
+}
+
+TEST(At86rf212Lowpan, HeaderCompression)
+{
+  struct at86rf212_lowpan_config_s config;
+  struct at86rf212_lowpan_s tx, rx;
+  struct at86rf212_lowpan_ll_s src = {AT86RF212_MAC_ADDR_SHORT, 0x0001};
+  struct at86rf212_lowpan_ll_s dst = {AT86RF212_MAC_ADDR_SHORT, 0x0002};
+  struct at86rf212_lowpan_ll_s src_ext = {AT86RF212_MAC_ADDR_EXTENDED, 0x0012345678ABCDEFULL};
+  const uint8_t src_iid[8] = {0, 0, 0, 0xFF, 0xFE, 0, 0x00, 0x01};
+  const uint8_t dst_iid[8] = {0, 0, 0, 0xFF, 0xFE, 0, 0x00, 0x02};
+  const uint8_t ext_iid[8] = {0x02, 0x12, 0x34, 0x56, 0x78, 0xAB, 0xCD, 0xEF};
+  const uint8_t other_iid[8] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+  const uint8_t mcast_all[16] = {0xFF, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01};
+  const uint8_t mcast_site[16] = {0xFF, 0x05, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x00, 0x03};
+  const uint8_t unspecified[16] = {0};
+  uint8_t a[16], b[16];
+  std::vector<int> lengths;
+
+  at86rf212_lowpan_default_config(&config);
+  config.context_valid = 1;
+  memcpy(config.context, global, 8);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&tx, &config));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&rx, &config));
+
+  // Link local addresses derived from the MAC, compressed UDP ports: 6 byte header
+  make_addr(a, link_local, src_iid);
+  make_addr(b, link_local, dst_iid);
+  lengths = loopback(&tx, &rx, &src, &dst, ipv6_packet(a, b, 17, 0xF0B1, 0xF0B2, 20), FRAME_ROOM);
+  ASSERT_EQ(1, lengths.size());
+  EXPECT_EQ(6 + 20, lengths[0]);
+
+  // Extended link layer address
+  make_addr(a, link_local, ext_iid);
+  lengths = loopback(&tx, &rx, &src_ext, &dst, ipv6_packet(a, b, 17, 0xF0B1, 0xF0B2, 20), FRAME_ROOM);
+  EXPECT_EQ(6 + 20, lengths[0]);
+
+  // Context based global addresses and 16 bit IIDs
+  make_addr(a, global, src_iid);
+  make_addr(b, global, other_iid);
+  lengths = loopback(&tx, &rx, &src_ext, &dst, ipv6_packet(a, b, 17, 5683, 0xF012, 20), FRAME_ROOM);
+  EXPECT_EQ(2 + 2 + 8 + 1 + 3 + 2 + 20, lengths[0]);
+
+  // Inline addresses, traffic class, flow label, hop limit and next header
+  const uint8_t prefix[8] = {0x20, 0x01, 0x0D, 0xB8, 0xFF, 0xFF, 0, 0};
+  make_addr(a, prefix, other_iid);
+  lengths = loopback(&tx, &rx, &src, &dst, ipv6_packet(a, a, 58, 0, 0, 16, 0xB8, 0x12345, 17), FRAME_ROOM);
+  EXPECT_EQ(2 + 4 + 1 + 1 + 16 + 16 + 16, lengths[0]);
+  loopback(&tx, &rx, &src, &dst, ipv6_packet(a, a, 58, 0, 0, 16, 0x01, 0x12345, 1), FRAME_ROOM);
+  loopback(&tx, &rx, &src, &dst, ipv6_packet(a, a, 58, 0, 0, 16, 0xB8, 0, 255), FRAME_ROOM);
+
+  // Multicast and unspecified addresses
+  make_addr(a, link_local, src_iid);
+  lengths = loopback(&tx, &rx, &src, &dst, ipv6_packet(a, mcast_all, 17, 1000, 2000, 4), FRAME_ROOM);
+  EXPECT_EQ(2 + 1 + 7 + 4, lengths[0]);
+  loopback(&tx, &rx, &src, &dst, ipv6_packet(unspecified, mcast_site, 17, 1000, 2000, 4), FRAME_ROOM);
+
+  // Non 6LoWPAN and malformed frames
+  uint16_t out_len;
+  const uint8_t* out;
+  uint8_t foreign[4] = {0xA3, 1, 2, 3};
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_lowpan_input(&rx, 0, &src, &dst, sizeof(foreign), foreign, &out_len, &out));
+  uint8_t truncated[3] = {0x60, 0x00, 0x01};
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_lowpan_input(&rx, 0, &src, &dst, sizeof(truncated), truncated, &out_len, &out));
+
+  // Packets must be well formed IPv6
+  struct at86rf212_lowpan_tx_s ctx;
+  std::vector<uint8_t> bad = ipv6_packet(a, b, 17, 1, 2, 4);
+  bad[5] ++;
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_lowpan_tx_start(&tx, &ctx, &src, &dst, bad.size(), bad.data()));
+}
+
+TEST(At86rf212Lowpan, Fragmentation)
+{
+  struct at86rf212_lowpan_config_s config;
+  struct at86rf212_lowpan_s tx, rx;
+  struct at86rf212_lowpan_tx_s ctx;
+  struct at86rf212_lowpan_ll_s src = {AT86RF212_MAC_ADDR_SHORT, 0x0001};
+  struct at86rf212_lowpan_ll_s dst = {AT86RF212_MAC_ADDR_SHORT, 0x0002};
+  const uint8_t src_iid[8] = {0, 0, 0, 0xFF, 0xFE, 0, 0x00, 0x01};
+  uint8_t a[16];
+  std::vector<std::vector<uint8_t> > frames;
+  uint8_t frame[AT86RF212_MAC_MAX_FRAME];
+  uint16_t out_len;
+  const uint8_t* out;
+  int len, res;
+
+  at86rf212_lowpan_default_config(&config);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&tx, &config));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&rx, &config));
+  make_addr(a, link_local, src_iid);
+
+  // Full MTU packet in order
+  std::vector<uint8_t> packet = ipv6_packet(a, a, 17, 0xF0B1, 0xF0B2, AT86RF212_LOWPAN_MTU - 48);
+  std::vector<int> lengths = loopback(&tx, &rx, &src, &dst, packet, FRAME_ROOM);
+  EXPECT_EQ(12, lengths.size());
+  EXPECT_EQ(AT86RF212_LOWPAN_MTU, rx.stats.reasm_high_water);
+
+  // Reverse order with duplicates
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_tx_start(&tx, &ctx, &src, &dst, packet.size(), packet.data()));
+  while ((len = at86rf212_lowpan_tx_next(&tx, &ctx, FRAME_ROOM, frame)) > 0) {
+    frames.push_back(std::vector<uint8_t>(frame, frame + len));
+  }
+  for (size_t i = frames.size() - 1; i > 0; i--) {
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[i].size(), frames[i].data(), &out_len, &out));
+  }
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[3].size(), frames[3].data(), &out_len, &out));
+  EXPECT_EQ(1, rx.stats.duplicates);
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[0].size(), frames[0].data(), &out_len, &out));
+  ASSERT_EQ(packet.size(), out_len);
+  EXPECT_EQ(0, memcmp(packet.data(), out, out_len));
+
+  // Interleaved datagrams from two sources, a third has no buffer
+  struct at86rf212_lowpan_ll_s src2 = {AT86RF212_MAC_ADDR_SHORT, 0x0003};
+  struct at86rf212_lowpan_ll_s src3 = {AT86RF212_MAC_ADDR_SHORT, 0x0004};
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 100, &src, &dst, frames[0].size(), frames[0].data(), &out_len, &out));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 100, &src2, &dst, frames[0].size(), frames[0].data(), &out_len, &out));
+  EXPECT_EQ(AT86RF212_ERROR_FULL, at86rf212_lowpan_input(&rx, 100, &src3, &dst, frames[0].size(), frames[0].data(), &out_len, &out));
+  for (size_t i = 1; i < frames.size(); i++) {
+    res = at86rf212_lowpan_input(&rx, 100, &src2, &dst, frames[i].size(), frames[i].data(), &out_len, &out);
+  }
+  ASSERT_EQ(AT86RF212_RES_DONE, res);
+  std::vector<uint8_t> expected = packet;
+  expected[23] = 0x03;    // Source IID is derived from the link layer address
+  EXPECT_EQ(0, memcmp(expected.data(), out, out_len));
+
+  // Stale reassembly is discarded on timeout
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 100 + config.reasm_timeout_us - 1, &src3, &dst,
+                                                     frames[0].size(), frames[0].data(), &out_len, &out));
+  EXPECT_EQ(0, rx.stats.timeouts);
+  at86rf212_lowpan_poll(&rx, 100 + config.reasm_timeout_us);
+  EXPECT_EQ(1, rx.stats.timeouts);
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 100 + config.reasm_timeout_us, &src3, &dst,
+                                                     frames[1].size(), frames[1].data(), &out_len, &out));
+
+  // Fragment outside the datagram
+  uint8_t bad[13] = {AT86RF212_LOWPAN_DISPATCH_FRAGN, 64, 0, 9, 8};
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_lowpan_input(&rx, 0, &src, &dst, sizeof(bad), bad, &out_len, &out));
+
+  // Frame room too small for any payload
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_tx_start(&tx, &ctx, &src, &dst, packet.size(), packet.data()));
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_lowpan_tx_next(&tx, &ctx, 12, frame));
+}
+
+TEST(At86rf212Lowpan, FragmentOverlap)
+{
+  struct at86rf212_lowpan_config_s config;
+  struct at86rf212_lowpan_s tx, rx;
+  struct at86rf212_lowpan_tx_s ctx;
+  struct at86rf212_lowpan_ll_s src = {AT86RF212_MAC_ADDR_SHORT, 0x0001};
+  struct at86rf212_lowpan_ll_s dst = {AT86RF212_MAC_ADDR_SHORT, 0x0002};
+  const uint8_t src_iid[8] = {0, 0, 0, 0xFF, 0xFE, 0, 0x00, 0x01};
+  uint8_t a[16];
+  std::vector<std::vector<uint8_t> > frames;
+  uint8_t frame[AT86RF212_MAC_MAX_FRAME];
+  uint16_t out_len;
+  const uint8_t* out;
+  int len, res;
+
+  at86rf212_lowpan_default_config(&config);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&tx, &config));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&rx, &config));
+  make_addr(a, link_local, src_iid);
+
+  std::vector<uint8_t> packet = ipv6_packet(a, a, 17, 0xF0B1, 0xF0B2, 400);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_tx_start(&tx, &ctx, &src, &dst, packet.size(), packet.data()));
+  while ((len = at86rf212_lowpan_tx_next(&tx, &ctx, FRAME_ROOM, frame)) > 0) {
+    frames.push_back(std::vector<uint8_t>(frame, frame + len));
+  }
+  ASSERT_LE(4, frames.size());
+
+  // Exact repeats are ignored
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[0].size(), frames[0].data(), &out_len, &out));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[1].size(), frames[1].data(), &out_len, &out));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[1].size(), frames[1].data(), &out_len, &out));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[0].size(), frames[0].data(), &out_len, &out));
+  EXPECT_EQ(2, rx.stats.duplicates);
+  EXPECT_EQ(0, rx.stats.dropped);
+
+  // A fragment starting one unit early overlaps the tail of the previous one
+  std::vector<uint8_t> shifted = frames[2];
+  shifted[4] --;
+  EXPECT_EQ(AT86RF212_ERROR_STATE, at86rf212_lowpan_input(&rx, 0, &src, &dst, shifted.size(), shifted.data(), &out_len, &out));
+  EXPECT_EQ(1, rx.stats.dropped);
+  EXPECT_EQ(0, rx.stats.reasm_bytes);
+
+  // Overlap with a later fragment received first
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[2].size(), frames[2].data(), &out_len, &out));
+  std::vector<uint8_t> longer = frames[1];
+  longer.insert(longer.end(), &frames[2][AT86RF212_LOWPAN_FRAGN_LEN], &frames[2][AT86RF212_LOWPAN_FRAGN_LEN + 8]);
+  EXPECT_EQ(AT86RF212_ERROR_STATE, at86rf212_lowpan_input(&rx, 0, &src, &dst, longer.size(), longer.data(), &out_len, &out));
+  EXPECT_EQ(2, rx.stats.dropped);
+
+  // A fresh reassembly completes after the discard
+  for (size_t i = 0; i < frames.size(); i++) {
+    res = at86rf212_lowpan_input(&rx, 0, &src, &dst, frames[i].size(), frames[i].data(), &out_len, &out);
+  }
+  ASSERT_EQ(AT86RF212_RES_DONE, res);
+  ASSERT_EQ(packet.size(), out_len);
+  EXPECT_EQ(0, memcmp(packet.data(), out, out_len));
+}
+
+TEST(At86rf212Lowpan, UncompressedFirstFragment)
+{
+  struct at86rf212_lowpan_config_s config;
+  struct at86rf212_lowpan_s rx;
+  struct at86rf212_lowpan_ll_s src = {AT86RF212_MAC_ADDR_SHORT, 0x0001};
+  struct at86rf212_lowpan_ll_s dst = {AT86RF212_MAC_ADDR_SHORT, 0x0002};
+  const uint8_t src_iid[8] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+  uint8_t a[16];
+  uint16_t out_len;
+  const uint8_t* out;
+
+  at86rf212_lowpan_default_config(&config);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&rx, &config));
+  make_addr(a, global, src_iid);
+
+  // FRAG1 with an IPv6 dispatch carries the header inline
+  std::vector<uint8_t> packet = ipv6_packet(a, a, 17, 1000, 2000, 120);
+  const uint16_t split = 96;
+  std::vector<uint8_t> frag1 = {(uint8_t)(AT86RF212_LOWPAN_DISPATCH_FRAG1 | (packet.size() >> 8)), (uint8_t)packet.size(),
+                                0x12, 0x34, AT86RF212_LOWPAN_DISPATCH_IPV6};
+  frag1.insert(frag1.end(), packet.begin(), packet.begin() + split);
+  std::vector<uint8_t> fragn = {(uint8_t)(AT86RF212_LOWPAN_DISPATCH_FRAGN | (packet.size() >> 8)), (uint8_t)packet.size(),
+                                0x12, 0x34, split / 8};
+  fragn.insert(fragn.end(), packet.begin() + split, packet.end());
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_input(&rx, 0, &src, &dst, fragn.size(), fragn.data(), &out_len, &out));
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_lowpan_input(&rx, 0, &src, &dst, frag1.size(), frag1.data(), &out_len, &out));
+  ASSERT_EQ(packet.size(), out_len);
+  EXPECT_EQ(0, memcmp(packet.data(), out, out_len));
+
+  // Any other inner dispatch is not a 6LoWPAN header
+  frag1[4] = 0xA3;
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_lowpan_input(&rx, 0, &src, &dst, frag1.size(), frag1.data(), &out_len, &out));
+  EXPECT_EQ(0, rx.stats.reasm_bytes);
+}
+
+TEST(At86rf212Lowpan, SimBenchmark)
+{
+  SimMedium medium;
+  SimRadio sim_tx(&medium, 1), sim_rx(&medium, 2);
+  struct at86rf212_s radio_tx, radio_rx;
+  struct at86rf212_lowpan_config_s config;
+  struct at86rf212_lowpan_s tx, rx;
+  struct at86rf212_lowpan_ll_s src = {AT86RF212_MAC_ADDR_SHORT, 0x0001};
+  struct at86rf212_lowpan_ll_s dst = {AT86RF212_MAC_ADDR_SHORT, 0x0002};
+  const uint8_t src_iid[8] = {0, 0, 0, 0xFF, 0xFE, 0, 0x00, 0x01};
+  const uint8_t dst_iid[8] = {0, 0, 0, 0xFF, 0xFE, 0, 0x00, 0x02};
+  const uint16_t sizes[] = {64, 256, AT86RF212_LOWPAN_MTU};
+  const uint32_t packets = 200;
+  uint8_t a[16], b[16];
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&radio_tx, SimRadio::driver(), (void*) &sim_tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&radio_rx, SimRadio::driver(), (void*) &sim_rx));
+  make_addr(a, link_local, src_iid);
+  make_addr(b, link_local, dst_iid);
+
+  printf("6LoWPAN over the simulator (%u packets per size):\r\n", packets);
+  printf("   size  frames/pkt  host pkt/s  air pkt/s @250k  reasm high water\r\n");
+
+  for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    std::vector<uint8_t> packet = ipv6_packet(a, b, 17, 0xF0B1, 0xF0B2, sizes[s] - 48);
+    uint8_t frame[AT86RF212_MAC_MAX_FRAME];
+    uint8_t rx_buffer[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+    uint64_t airtime_us = 0;
+    uint32_t frames = 0, delivered = 0;
+
+    at86rf212_lowpan_default_config(&config);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&tx, &config));
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_init(&rx, &config));
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t p = 0; p < packets; p++) {
+      struct at86rf212_lowpan_tx_s ctx;
+      int len;
+
+      ASSERT_EQ(AT86RF212_RES_OK, at86rf212_lowpan_tx_start(&tx, &ctx, &src, &dst, packet.size(), packet.data()));
+      while (1) {
+        // Fragment straight into the frame buffer behind the MAC header
+        uint8_t offset = AT86RF212::MacDataShort::build(frame, frames, 0x1234, dst.addr, 0x1234, src.addr);
+        len = at86rf212_lowpan_tx_next(&tx, &ctx, FRAME_ROOM, &frame[offset]);
+        ASSERT_GE(len, 0);
+        if (len == 0) {
+          break;
+        }
+        ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio_rx));
+        ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_tx(&radio_tx, offset + len, frame));
+        airtime_us += at86rf212_airtime_us(AT86RF212_PHY_OQPSK_250, offset + len + AT86RF212_CRC_LEN);
+        frames ++;
+
+        // Parse in place and hand the MAC payload up
+        struct at86rf212_mac_frame_s mac;
+        struct at86rf212_lowpan_ll_s mac_src, mac_dst;
+        uint8_t rx_len;
+        uint16_t out_len;
+        const uint8_t* out;
+
+        ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx(&radio_rx, &rx_len, rx_buffer));
+        ASSERT_EQ(AT86RF212_RES_OK, at86rf212_mac_parse(&mac, rx_len - AT86RF212_FRAME_RX_OVERHEAD - AT86RF212_CRC_LEN, rx_buffer));
+        at86rf212_lowpan_ll_addr(mac.src_mode, mac.src_addr, &mac_src);
+        at86rf212_lowpan_ll_addr(mac.dest_mode, mac.dest_addr, &mac_dst);
+        int res = at86rf212_lowpan_input(&rx, 0, &mac_src, &mac_dst, mac.payload_len, mac.payload, &out_len, &out);
+        ASSERT_GE(res, 0);
+        if (res == AT86RF212_RES_DONE) {
+          ASSERT_EQ(packet.size(), out_len);
+          delivered ++;
+        }
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("  %5u  %10.1f  %10.0f  %15.1f  %16u\r\n", sizes[s], (double)frames / packets, packets / seconds,
+           packets * 1e6 / airtime_us, rx.stats.reasm_high_water);
+
+    EXPECT_EQ(packets, delivered);
+    EXPECT_LE(rx.stats.reasm_high_water, AT86RF212_LOWPAN_MTU);
+  }
+}
@@ -0,0 +1,323 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_mac.h"
+#include "at86rf212/at86rf212_mac.hpp"
+
+#include "sim_radio.hpp"
+
+using namespace AT86RF212;
+
+static void default_header(struct at86rf212_mac_header_s *header)
+{
+  memset(header, 0, sizeof(struct at86rf212_mac_header_s));
+  header->type = AT86RF212_FRAME_TYPE_DATA;
+  header->seq = 0x5A;
+  header->dest_pan = 0x1234;
+  header->dest_addr = 0x0102030405060708ULL;
+  header->src_pan = 0x4321;
+  header->src_addr = 0x1112131415161718ULL;
+}
+
+static uint64_t addr_value(uint8_t mode, const uint8_t* addr)
+{
+  uint64_t value = 0;
+  uint8_t len = (mode == AT86RF212_MAC_ADDR_SHORT) ? 2 : 8;
+  for (int i = 0; i < len; i++) {
+    value |= (uint64_t)addr[i] << (i * 8);
+  }
+  return value;
+}
+
+TEST(At86rf212Mac, AddressingModes)
+{
+  const uint8_t modes[] = {AT86RF212_MAC_ADDR_NONE, AT86RF212_MAC_ADDR_SHORT, AT86RF212_MAC_ADDR_EXTENDED};
+  const uint8_t payload[] = {'h', 'e', 'l', 'l', 'o'};
+
+  for (uint8_t version = 0; version <= AT86RF212_MAC_VERSION_2015; version++) {
+    for (unsigned d = 0; d < sizeof(modes); d++) {
+      for (unsigned s = 0; s < sizeof(modes); s++) {
+        for (uint8_t pan_comp = 0; pan_comp < 2; pan_comp++) {
+          struct at86rf212_mac_header_s header;
+          struct at86rf212_mac_frame_s frame;
+          uint8_t data[AT86RF212_MAC_MAX_FRAME];
+          uint8_t dest_pan, src_pan;
+
+          default_header(&header);
+          header.version = version;
+          header.dest_mode = modes[d];
+          header.src_mode = modes[s];
+          header.pan_comp = pan_comp;
+
+          int len = at86rf212_mac_build(&header, sizeof(data), data);
+          ASSERT_GT(len, 0);
+          memcpy(&data[len], payload, sizeof(payload));
+
+          ASSERT_EQ(AT86RF212_RES_OK, at86rf212_mac_parse(&frame, len + sizeof(payload), data));
+          at86rf212_mac_pan_presence(frame.fcf, &dest_pan, &src_pan);
+
+          EXPECT_EQ(AT86RF212_FRAME_TYPE_DATA, frame.type);
+          EXPECT_EQ(version, frame.version);
+          EXPECT_EQ(0x5A, frame.seq);
+          EXPECT_EQ(modes[d], frame.dest_mode);
+          EXPECT_EQ(modes[s], frame.src_mode);
+          EXPECT_EQ(len, frame.header_len);
+          EXPECT_EQ(sizeof(payload), frame.payload_len);
+          EXPECT_EQ(&data[len], frame.payload);
+          if (dest_pan) {
+            EXPECT_EQ(0x1234, frame.dest_pan);
+          }
+          if (src_pan) {
+            EXPECT_EQ(0x4321, frame.src_pan);
+          }
+          if (modes[d] != AT86RF212_MAC_ADDR_NONE) {
+            uint64_t expected = (modes[d] == AT86RF212_MAC_ADDR_SHORT) ? 0x0708 : header.dest_addr;
+            EXPECT_EQ(expected, addr_value(modes[d], frame.dest_addr));
+          } else {
+            EXPECT_EQ(NULL, frame.dest_addr);
+          }
+          if (modes[s] != AT86RF212_MAC_ADDR_NONE) {
+            uint64_t expected = (modes[s] == AT86RF212_MAC_ADDR_SHORT) ? 0x1718 : header.src_addr;
+            EXPECT_EQ(expected, addr_value(modes[s], frame.src_addr));
+          } else {
+            EXPECT_EQ(NULL, frame.src_addr);
+          }
+
+          // Truncated headers are rejected
+          for (int i = 0; i < len - 1; i++) {
+            EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_mac_parse(&frame, i, data)) << "length " << i;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(At86rf212Mac, SecurityAndIes)
+{
+  struct at86rf212_mac_header_s header;
+  struct at86rf212_mac_frame_s frame;
+  struct at86rf212_mac_ie_s ie;
+  uint8_t data[AT86RF212_MAC_MAX_FRAME];
+  uint8_t header_ies[16], payload_ies[16];
+  uint8_t content[4] = {1, 2, 3, 4};
+  uint8_t offset;
+  int len, res;
+
+  // Header IE 0x1a (CSL) and payload IE group 1 (MLME)
+  len = at86rf212_mac_ie_put(0, 0x1a, sizeof(content), content, sizeof(header_ies), header_ies);
+  ASSERT_EQ(6, len);
+  len = at86rf212_mac_ie_put(1, 0x01, 3, content, sizeof(payload_ies), payload_ies);
+  ASSERT_EQ(5, len);
+
+  default_header(&header);
+  header.version = AT86RF212_MAC_VERSION_2015;
+  header.dest_mode = AT86RF212_MAC_ADDR_SHORT;
+  header.src_mode = AT86RF212_MAC_ADDR_EXTENDED;
+  header.pan_comp = 1;
+  header.header_ies = header_ies;
+  header.header_ies_len = 6;
+  header.payload_ies = payload_ies;
+  header.payload_ies_len = 5;
+
+  len = at86rf212_mac_build(&header, sizeof(data), data);
+  ASSERT_GT(len, 0);
+  data[len] = 0xAA;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_mac_parse(&frame, len + 1, data));
+  EXPECT_TRUE(frame.fcf & AT86RF212_MAC_FCF_IE_PRESENT);
+  EXPECT_EQ(8, frame.header_ies_len);
+  EXPECT_EQ(7, frame.payload_ies_len);
+  EXPECT_EQ(1, frame.payload_len);
+  EXPECT_EQ(0xAA, frame.payload[0]);
+
+  offset = 0;
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_mac_ie_next(frame.header_ies_len, frame.header_ies, 0, &offset, &ie));
+  EXPECT_EQ(0x1a, ie.id);
+  EXPECT_EQ(4, ie.length);
+  EXPECT_EQ(0, memcmp(content, ie.content, 4));
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_mac_ie_next(frame.header_ies_len, frame.header_ies, 0, &offset, &ie));
+
+  offset = 0;
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_mac_ie_next(frame.payload_ies_len, frame.payload_ies, 1, &offset, &ie));
+  EXPECT_EQ(1, ie.id);
+  EXPECT_EQ(3, ie.length);
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_mac_ie_next(frame.payload_ies_len, frame.payload_ies, 1, &offset, &ie));
+
+  // Secured frame with key identifier mode 2, payload IEs are carried in the (encrypted) payload
+  header.security_enabled = 1;
+  header.security.level = 5;
+  header.security.key_id_mode = 2;
+  header.security.frame_counter = 0x01020304;
+  memcpy(header.security.key_source, content, 4);
+  header.security.key_index = 7;
+  header.payload_ies_len = 0;
+  header.header_ies_len = 0;
+
+  len = at86rf212_mac_build(&header, sizeof(data), data);
+  ASSERT_GT(len, 0);
+  memset(&data[len], 0xBB, 10);
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_mac_parse(&frame, len + 10, data));
+  ASSERT_NE((const uint8_t*)NULL, frame.security);
+  EXPECT_EQ(1 + 4 + 5, frame.security_len);
+  EXPECT_EQ(0x05 | (2 << 3), frame.security[0]);
+  EXPECT_EQ(0x04, frame.security[1]);
+  EXPECT_EQ(7, frame.security[9]);
+  EXPECT_EQ(4, frame.mic_len);
+  EXPECT_EQ(6, frame.payload_len);
+
+  // MIC longer than the remaining frame
+  header.security.level = 7;
+  len = at86rf212_mac_build(&header, sizeof(data), data);
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_mac_parse(&frame, len + 10, data));
+
+  // Frame counter suppression
+  header.security.level = 5;
+  header.security.fc_suppress = 1;
+  len = at86rf212_mac_build(&header, sizeof(data), data);
+  ASSERT_GT(len, 0);
+  memset(&data[len], 0xBB, 10);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_mac_parse(&frame, len + 10, data));
+  EXPECT_EQ(1 + 5, frame.security_len);
+  EXPECT_EQ(6, frame.payload_len);
+
+  // IEs and frame counter suppression require a 2015 frame, header must fit
+  header.version = AT86RF212_MAC_VERSION_2006;
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_mac_build(&header, sizeof(data), data));
+  header.security.fc_suppress = 0;
+  header.header_ies_len = 6;
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_mac_build(&header, sizeof(data), data));
+  header.header_ies_len = 0;
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_mac_build(&header, 8, data));
+
+  // Malformed IEs
+  uint8_t bad[3] = {0x05, 0x0d, 0x00};
+  offset = 0;
+  res = at86rf212_mac_ie_next(sizeof(bad), bad, 0, &offset, &ie);
+  EXPECT_EQ(AT86RF212_ERROR_LEN, res);
+}
+
+TEST(At86rf212Mac, CompileTimeLayouts)
+{
+  uint8_t fixed[AT86RF212_MAC_MAX_FRAME], generic[AT86RF212_MAC_MAX_FRAME];
+  struct at86rf212_mac_header_s header;
+  struct at86rf212_mac_frame_s frame;
+
+  // Matches the header previously built by hand in the util and hardware tests
+  const uint8_t expected[] = {0x61, 0x88, 0x05, 0x00, 0x01, 0x01, 0x01, 0x02, 0x02};
+  ASSERT_EQ(sizeof(expected), MacDataShortAck::build(fixed, 0x05, 0x0100, 0x0101, 0x0100, 0x0202));
+  EXPECT_EQ(0, memcmp(expected, fixed, sizeof(expected)));
+  EXPECT_TRUE(MacDataShortAck::matches(sizeof(expected), fixed));
+  EXPECT_FALSE(MacDataShort::matches(sizeof(expected), fixed));
+  EXPECT_EQ(0x0101, MacDataShortAck::dest_addr(fixed));
+  EXPECT_EQ(0x0202, MacDataShortAck::src_addr(fixed));
+  EXPECT_EQ(0x0100, MacDataShortAck::src_pan(fixed));
+
+  // Extended layout agrees with the generic codec
+  default_header(&header);
+  header.dest_mode = AT86RF212_MAC_ADDR_EXTENDED;
+  header.src_mode = AT86RF212_MAC_ADDR_EXTENDED;
+  header.pan_comp = 1;
+  int len = at86rf212_mac_build(&header, sizeof(generic), generic);
+  ASSERT_EQ((int)MacDataExtended::header_len, len);
+  MacDataExtended::build(fixed, header.seq, header.dest_pan, header.dest_addr, header.src_pan, header.src_addr);
+  EXPECT_EQ(0, memcmp(generic, fixed, len));
+  EXPECT_EQ(header.src_addr, MacDataExtended::src_addr(fixed));
+
+  ASSERT_EQ(3, MacAck::build(fixed, 0x33, 0, 0));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_mac_parse(&frame, 3, fixed));
+  EXPECT_EQ(AT86RF212_FRAME_TYPE_ACK, frame.type);
+  EXPECT_EQ(0x33, frame.seq);
+  EXPECT_EQ(0, frame.payload_len);
+}
+
+TEST(At86rf212Mac, ParseInPlace)
+{
+  SimMedium medium;
+  SimRadio sim_tx(&medium, 1), sim_rx(&medium, 2);
+  struct at86rf212_s tx, rx;
+  struct at86rf212_mac_frame_s frame;
+  uint8_t tx_buffer[AT86RF212_MAC_MAX_FRAME];
+  uint8_t rx_buffer[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+  uint8_t length;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&tx, SimRadio::driver(), (void*) &sim_tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), (void*) &sim_rx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+
+  // Build the header and payload directly in the transmit buffer
+  uint8_t offset = MacDataShort::build(tx_buffer, 9, 0xCAFE, 0x0002, 0xCAFE, 0x0001);
+  memcpy(&tx_buffer[offset], "payload", 7);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_tx(&tx, offset + 7, tx_buffer));
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx(&rx, &length, rx_buffer));
+  uint8_t mac_len = length - AT86RF212_FRAME_RX_OVERHEAD - AT86RF212_CRC_LEN;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_mac_parse(&frame, mac_len, rx_buffer));
+
+  EXPECT_EQ(0xCAFE, frame.dest_pan);
+  EXPECT_EQ(0x0002, at86rf212_mac_short_addr(frame.dest_addr));
+  EXPECT_EQ(0x0001, at86rf212_mac_short_addr(frame.src_addr));
+  EXPECT_EQ(&rx_buffer[offset], frame.payload);
+  EXPECT_EQ(7, frame.payload_len);
+  EXPECT_EQ(0, memcmp("payload", frame.payload, 7));
+}
+
+TEST(At86rf212Mac, Throughput)
+{
+  const uint32_t iterations = 1000000;
+  struct at86rf212_mac_header_s header;
+  struct at86rf212_mac_frame_s frame;
+  uint8_t data[AT86RF212_MAC_MAX_FRAME] = {0};
+  volatile uint32_t sink = 0;
+
+  default_header(&header);
+  header.dest_mode = AT86RF212_MAC_ADDR_SHORT;
+  header.src_mode = AT86RF212_MAC_ADDR_SHORT;
+  header.pan_comp = 1;
+  header.ack_req = 1;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    header.seq = i;
+    sink += at86rf212_mac_build(&header, sizeof(data), data);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    sink += MacDataShortAck::build(data, i, 0x1234, i, 0x1234, 0x0001);
+    asm volatile("" : : "r"(data) : "memory");
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    data[2] = i;
+    at86rf212_mac_parse(&frame, 20, data);
+    sink += frame.seq;
+  }
+  auto t3 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    data[2] = i;
+    asm volatile("" : : "r"(data) : "memory");
+    if (MacDataShortAck::matches(20, data)) {
+      sink += MacDataShortAck::seq(data) + MacDataShortAck::src_addr(data);
+    }
+  }
+  auto t4 = std::chrono::steady_clock::now();
+
+  double build_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+  double build_fixed_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations;
+  double parse_ns = std::chrono::duration<double, std::nano>(t3 - t2).count() / iterations;
+  double parse_fixed_ns = std::chrono::duration<double, std::nano>(t4 - t3).count() / iterations;
+
+  printf("MAC codec per frame: build %.1f ns (layout %.1f ns), parse %.1f ns (layout %.1f ns)\r\n",
+         build_ns, build_fixed_ns, parse_ns, parse_fixed_ns);
+  printf("MAC codec throughput: build %.1f Mframe/s, parse %.1f Mframe/s\r\n",
+         1000 / build_ns, 1000 / parse_ns);
+
+  EXPECT_NE(0, sink);
+}
@@ -0,0 +1,346 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_manager.h"
+
+#include "sim_radio.hpp"
+
+// Simulated radio with its IRQ line signalled through an eventfd, as a GPIO line event would be
+// Accesses are locked so frames can arrive from another thread while the manager is running.
+class SimIrqRadio
+{
+public:
+  SimIrqRadio(uint32_t seed) : sim(NULL, seed), fd(eventfd(0, EFD_CLOEXEC)), asserted(false) {}
+  ~SimIrqRadio()
+  {
+    close(fd);
+  }
+
+  // Frame arriving over the air
+  void inject(uint8_t len, const uint8_t* psdu)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    sim.receive(len, psdu);
+    update_line();
+  }
+
+  static struct at86rf212_driver_s* driver()
+  {
+    static struct at86rf212_driver_s d = {
+      spi_transfer_cb, set_pin_cb, set_pin_cb, get_irq_cb, NULL, NULL
+    };
+    return &d;
+  }
+
+  SimRadio sim;
+  int fd;
+
+private:
+  // Signal the rising edge of the IRQ pin (the unmasked IRQ_STATUS bits)
+  void update_line()
+  {
+    bool level = (sim.irq & sim.regs[AT86RF212_REG_IRQ_MASK]) != 0;
+    if (level && !asserted) {
+      uint64_t one = 1;
+      ssize_t res = write(fd, &one, sizeof(one));
+      (void)res;
+    }
+    asserted = level;
+  }
+
+  static int spi_transfer_cb(void* context, int len, uint8_t *data_out, uint8_t* data_in)
+  {
+    SimIrqRadio* radio = (SimIrqRadio*)context;
+    std::lock_guard<std::mutex> guard(radio->lock);
+    int res = radio->sim.transfer(len, data_out, data_in);
+    radio->update_line();
+    return res;
+  }
+
+  static int set_pin_cb(void* context, uint8_t val)
+  {
+    return 0;
+  }
+
+  static int get_irq_cb(void* context, uint8_t *val)
+  {
+    SimIrqRadio* radio = (SimIrqRadio*)context;
+    std::lock_guard<std::mutex> guard(radio->lock);
+    *val = radio->asserted ? 1 : 0;
+    return 0;
+  }
+
+  bool asserted;
+  std::mutex lock;
+};
+
+struct Received {
+  uint8_t radio;
+  uint8_t id;
+  uint8_t seq;
+};
+
+struct Completed {
+  uint8_t radio;
+  int handle;
+  int result;
+};
+
+class Gateway
+{
+public:
+  Gateway() : manager(new struct at86rf212_manager_s) {}
+  ~Gateway()
+  {
+    at86rf212_manager_close(manager.get());
+  }
+
+  int init(int count)
+  {
+    int res = at86rf212_manager_init(manager.get(), rx_cb, this, tx_cb, this);
+    if (res < 0) {
+      return res;
+    }
+    for (int i = 0; i < count; i++) {
+      radios.emplace_back(new SimIrqRadio(i + 1));
+      res = at86rf212_manager_add(manager.get(), SimIrqRadio::driver(), radios[i].get(), radios[i]->fd, &config);
+      if (res != i) {
+        return (res < 0) ? res : AT86RF212_ERROR_STATE;
+      }
+    }
+    return AT86RF212_RES_OK;
+  }
+
+  static void rx_cb(void* context, uint8_t radio, struct at86rf212_rx_frame_s *frame)
+  {
+    Gateway* g = (Gateway*)context;
+    g->received.push_back({radio, frame->payload[0], frame->payload[1]});
+  }
+
+  static void tx_cb(void* context, uint8_t radio, int handle, int result)
+  {
+    ((Gateway*)context)->completed.push_back({radio, handle, result});
+  }
+
+  const struct at86rf212_config_s config = AT86RF212_CONFIG_DEFAULT;
+  std::unique_ptr<struct at86rf212_manager_s> manager;
+  std::vector<std::unique_ptr<SimIrqRadio>> radios;
+  std::vector<Received> received;
+  std::vector<Completed> completed;
+};
+
+static void make_frame(uint8_t* frame, uint8_t id, uint8_t seq)
+{
+  memset(frame, 0, 20);
+  frame[0] = id;
+  frame[1] = seq;
+}
+
+TEST(At86rf212Manager, RequiresIrqFd)
+{
+  SimRadio sim(NULL, 1);
+  struct at86rf212_manager_s manager;
+  const struct at86rf212_config_s config = AT86RF212_CONFIG_DEFAULT;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_manager_init(&manager, NULL, NULL, NULL, NULL));
+  EXPECT_EQ(AT86RF212_DRIVER_INVALID, at86rf212_manager_add(&manager, SimRadio::driver(), &sim, -1, &config));
+  EXPECT_EQ(0, manager.count);
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_manager_close(&manager));
+}
+
+TEST(At86rf212Manager, ReceiveAndTransmit)
+{
+  Gateway g;
+  uint8_t frame[20];
+
+  ASSERT_EQ(AT86RF212_RES_OK, g.init(4));
+  for (auto& r : g.radios) {
+    EXPECT_EQ(AT86RF212_RX_ON, r->sim.state());
+    EXPECT_EQ(AT86RF212_IRQ_3_TRX_END, r->sim.regs[AT86RF212_REG_IRQ_MASK]);
+  }
+
+  // Nothing to do without an IRQ
+  EXPECT_EQ(0, at86rf212_manager_run(g.manager.get(), 0));
+
+  make_frame(frame, 0xA1, 1);
+  g.radios[1]->inject(sizeof(frame), frame);
+  make_frame(frame, 0xA3, 1);
+  g.radios[3]->inject(sizeof(frame), frame);
+
+  EXPECT_EQ(2, at86rf212_manager_run(g.manager.get(), 0));
+  ASSERT_EQ(2u, g.received.size());
+  for (auto& r : g.received) {
+    EXPECT_EQ(0xA0 | r.radio, r.id);
+  }
+
+  // Queued frames are sent back to back, then each radio listens again
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 3; j++) {
+      make_frame(frame, i, j);
+      EXPECT_LE(0, at86rf212_manager_send(g.manager.get(), i, AT86RF212_TX_CLASS_NORMAL, 16, frame));
+    }
+  }
+  EXPECT_EQ(AT86RF212_ERROR_STATE, at86rf212_manager_send(g.manager.get(), 4, AT86RF212_TX_CLASS_NORMAL, 16, frame));
+
+  for (int i = 0; (i < 20) && (g.completed.size() < 12); i++) {
+    ASSERT_LE(0, at86rf212_manager_run(g.manager.get(), 0));
+  }
+  ASSERT_EQ(12u, g.completed.size());
+  for (auto& c : g.completed) {
+    EXPECT_EQ(AT86RF212_RES_DONE, c.result);
+  }
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(3u, g.radios[i]->sim.frames_sent);
+    EXPECT_EQ(AT86RF212_RX_ON, g.radios[i]->sim.state());
+    EXPECT_EQ(AT86RF212_MANAGER_RX, g.manager->radios[i].state);
+    EXPECT_EQ(0u, g.manager->radios[i].stats.errors);
+  }
+
+  make_frame(frame, 0xA0, 2);
+  g.radios[0]->inject(sizeof(frame), frame);
+  EXPECT_EQ(1, at86rf212_manager_run(g.manager.get(), 0));
+  ASSERT_EQ(3u, g.received.size());
+  EXPECT_EQ(0, g.received[2].radio);
+  EXPECT_EQ(12u, g.manager->stats.tx_frames);
+  EXPECT_EQ(3u, g.manager->stats.rx_frames);
+}
+
+TEST(At86rf212Manager, DrainsBeforeTransmit)
+{
+  Gateway g;
+  uint8_t frame[20];
+
+  ASSERT_EQ(AT86RF212_RES_OK, g.init(1));
+
+  // A frame completes after the last IRQ was handled, as a transmission is queued
+  make_frame(frame, 0xA0, 1);
+  g.radios[0]->sim.receive(sizeof(frame), frame);
+  make_frame(frame, 0, 1);
+  ASSERT_LE(0, at86rf212_manager_send(g.manager.get(), 0, AT86RF212_TX_CLASS_NORMAL, 16, frame));
+
+  for (int i = 0; (i < 20) && (g.completed.size() < 1); i++) {
+    ASSERT_LE(0, at86rf212_manager_run(g.manager.get(), 0));
+  }
+
+  // The received frame is delivered intact before the upload replaces it
+  ASSERT_EQ(1u, g.received.size());
+  EXPECT_EQ(0xA0, g.received[0].id);
+  EXPECT_EQ(1, g.received[0].seq);
+  ASSERT_EQ(1u, g.completed.size());
+  EXPECT_EQ(AT86RF212_RES_DONE, g.completed[0].result);
+  EXPECT_EQ(1u, g.radios[0]->sim.frames_sent);
+  EXPECT_EQ(0u, g.manager->radios[0].stats.errors);
+}
+
+TEST(At86rf212Manager, Fairness)
+{
+  const int count = 4;
+  Gateway g;
+  uint8_t frame[20];
+  std::vector<int> first(count, 0);
+
+  ASSERT_EQ(AT86RF212_RES_OK, g.init(count));
+
+  // Every radio has a frame each pass, the radio serviced first rotates
+  for (int pass = 0; pass < 4 * count; pass++) {
+    for (int i = 0; i < count; i++) {
+      make_frame(frame, i, pass);
+      g.radios[i]->inject(sizeof(frame), frame);
+    }
+    g.received.clear();
+    ASSERT_EQ(count, at86rf212_manager_run(g.manager.get(), 0));
+    ASSERT_EQ((size_t)count, g.received.size());
+    first[g.received[0].radio] ++;
+  }
+  for (int i = 0; i < count; i++) {
+    EXPECT_EQ(4, first[i]);
+  }
+  EXPECT_EQ((uint32_t)count, g.manager->stats.max_events);
+}
+
+static uint64_t thread_cpu_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+TEST(At86rf212Manager, Scaling)
+{
+  const int rounds = 1000;
+
+  for (int count = 1; count <= AT86RF212_MANAGER_MAX_RADIOS; count *= 2) {
+    Gateway g;
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> delivered(0);
+    std::vector<std::chrono::steady_clock::time_point> sent(count);
+    std::vector<double> latency;
+    uint64_t cpu_ns = 0;
+
+    ASSERT_EQ(AT86RF212_RES_OK, g.init(count));
+
+    // Event loop thread, blocked in epoll while idle
+    std::thread loop([&]() {
+      uint64_t start = thread_cpu_ns();
+      while (running.load()) {
+        at86rf212_manager_run(g.manager.get(), 10);
+        while (g.received.size() > delivered.load()) {
+          latency.push_back(std::chrono::duration<double, std::micro>(
+                              std::chrono::steady_clock::now() - sent[g.received[delivered.load()].radio]).count());
+          delivered ++;
+        }
+      }
+      cpu_ns = thread_cpu_ns() - start;
+    });
+
+    // Every radio receives a frame per round, rounds are spaced so the loop goes idle between them
+    auto start = std::chrono::steady_clock::now();
+    uint8_t frame[20];
+    for (int r = 0; r < rounds; r++) {
+      for (int i = 0; i < count; i++) {
+        make_frame(frame, i, r);
+        sent[i] = std::chrono::steady_clock::now();
+        g.radios[i]->inject(sizeof(frame), frame);
+      }
+      while (delivered.load() < (uint32_t)((r + 1) * count)) {
+        std::this_thread::yield();
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    double wall_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    running = false;
+    loop.join();
+
+    ASSERT_EQ((size_t)(rounds * count), g.received.size());
+    for (int i = 0; i < count; i++) {
+      EXPECT_EQ(0u, g.manager->radios[i].stats.errors);
+      EXPECT_EQ(0u, g.manager->radios[i].ring.stats.dropped);
+    }
+
+    std::sort(latency.begin(), latency.end());
+    double total = 0;
+    for (double l : latency) {
+      total += l;
+    }
+    printf("Manager with %d radios: %.1f us mean, %.1f us p99 IRQ to delivery latency, "
+           "%.1f events per wakeup, %.1f%% CPU, %.2f us CPU per frame\r\n",
+           count, total / latency.size(), latency[latency.size() * 99 / 100],
+           (double)g.manager->stats.events / g.manager->stats.wakeups,
+           100.0 * cpu_ns / wall_ns, cpu_ns / 1000.0 / (rounds * count));
+  }
+}
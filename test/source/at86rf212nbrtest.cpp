@@ -0,0 +1,178 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_mac.h"
+#include "at86rf212/at86rf212_mac.hpp"
+#include "at86rf212/at86rf212_nbr.h"
+
+#include "sim_radio.hpp"
+
+TEST(At86rf212Nbr, LinkEstimates)
+{
+  struct at86rf212_nbr_table_s table;
+  struct at86rf212_nbr_s *nbr;
+
+  at86rf212_nbr_init(&table, AT86RF212_PHY_OQPSK_250);
+  EXPECT_EQ(NULL, at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_SHORT, 0x0001));
+
+  // Steady link
+  for (int i = 0; i < 100; i++) {
+    nbr = at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_SHORT, 0x0001, i, 200, 30, i * 1000);
+    ASSERT_NE((struct at86rf212_nbr_s*)NULL, nbr);
+  }
+  nbr = at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_SHORT, 0x0001);
+  ASSERT_NE((struct at86rf212_nbr_s*)NULL, nbr);
+  EXPECT_EQ(100, nbr->frames);
+  EXPECT_EQ(0, nbr->missed);
+  EXPECT_EQ(99000, nbr->last_seen);
+  EXPECT_EQ(200 * 16, nbr->lqi);
+  // RSSI = RSSI_BASE_VAL + 1.03 * ED
+  EXPECT_EQ(-97 + 31, at86rf212_nbr_rssi_dbm(nbr));
+  EXPECT_GT(nbr->prr, 65000);
+
+  // Every other frame lost, estimates move towards the new conditions
+  for (int i = 0; i < 100; i++) {
+    at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_SHORT, 0x0001, 100 + i * 2, 100, 10, 100000 + i * 1000);
+  }
+  EXPECT_EQ(99, nbr->missed);
+  EXPECT_NEAR(0.53, nbr->prr / 65535.0, 0.05);
+  EXPECT_NEAR(100 * 16, nbr->lqi, 16);
+  EXPECT_NEAR(-97 + 10, at86rf212_nbr_rssi_dbm(nbr), 1);
+
+  // Duplicates and sequence restarts do not count as losses
+  uint16_t prr = nbr->prr;
+  at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_SHORT, 0x0001, nbr->last_seq, 100, 10, 300000);
+  at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_SHORT, 0x0001, nbr->last_seq - 10, 100, 10, 300000);
+  EXPECT_EQ(prr, nbr->prr);
+  EXPECT_EQ(99, nbr->missed);
+
+  // Short and extended addresses are distinct keys
+  at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_EXTENDED, 0x0001, 0, 50, 5, 0);
+  EXPECT_EQ(2, table.count);
+  EXPECT_EQ(50 * 16, at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_EXTENDED, 0x0001)->lqi);
+}
+
+TEST(At86rf212Nbr, CapacityAndRemoval)
+{
+  struct at86rf212_nbr_table_s table;
+  struct at86rf212_nbr_s *nbr;
+  uint16_t index = 0, count = 0;
+
+  at86rf212_nbr_init(&table, AT86RF212_PHY_BPSK_20);
+
+  for (uint32_t i = 0; i < AT86RF212_NBR_MAX_ENTRIES; i++) {
+    at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_SHORT, 0x100 + i, 0, 255, 40, i);
+  }
+  EXPECT_EQ(AT86RF212_NBR_MAX_ENTRIES, table.count);
+  while ((nbr = at86rf212_nbr_next(&table, &index)) != NULL) {
+    count ++;
+  }
+  EXPECT_EQ(AT86RF212_NBR_MAX_ENTRIES, count);
+
+  // Remove every third neighbour, the rest must remain reachable
+  for (uint32_t i = 0; i < AT86RF212_NBR_MAX_ENTRIES; i += 3) {
+    nbr = at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_SHORT, 0x100 + i);
+    ASSERT_NE((struct at86rf212_nbr_s*)NULL, nbr);
+    at86rf212_nbr_remove(&table, nbr);
+  }
+  for (uint32_t i = 0; i < AT86RF212_NBR_MAX_ENTRIES; i++) {
+    nbr = at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_SHORT, 0x100 + i);
+    if ((i % 3) == 0) {
+      EXPECT_EQ(NULL, nbr) << i;
+    } else {
+      ASSERT_NE((struct at86rf212_nbr_s*)NULL, nbr) << i;
+      EXPECT_EQ(0x100 + i, nbr->addr);
+    }
+  }
+
+  // Expire the older half
+  uint16_t remaining = table.count;
+  uint16_t removed = at86rf212_nbr_expire(&table, AT86RF212_NBR_MAX_ENTRIES, AT86RF212_NBR_MAX_ENTRIES / 2);
+  EXPECT_EQ(remaining - removed, table.count);
+  for (uint32_t i = 0; i < AT86RF212_NBR_MAX_ENTRIES; i++) {
+    nbr = at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_SHORT, 0x100 + i);
+    bool expected = ((i % 3) != 0) && ((AT86RF212_NBR_MAX_ENTRIES - i) <= (AT86RF212_NBR_MAX_ENTRIES / 2));
+    EXPECT_EQ(expected, nbr != NULL) << i;
+  }
+
+  // A full table replaces the least recently seen neighbour
+  for (uint32_t i = 0; table.count < AT86RF212_NBR_MAX_ENTRIES; i++) {
+    at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_SHORT, 0x1000 + i, 0, 255, 40, 1000 + i);
+  }
+  at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_SHORT, 0x2000, 0, 255, 40, 5000);
+  EXPECT_EQ(1, table.evictions);
+  EXPECT_EQ(AT86RF212_NBR_MAX_ENTRIES, table.count);
+  EXPECT_EQ(NULL, at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_SHORT, 0x100 + 25));
+  EXPECT_NE((struct at86rf212_nbr_s*)NULL, at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_SHORT, 0x2000));
+}
+
+TEST(At86rf212Nbr, UpdateFromRx)
+{
+  SimMedium medium;
+  SimRadio sim_tx(&medium, 1), sim_rx(&medium, 2);
+  struct at86rf212_s tx, rx;
+  struct at86rf212_nbr_table_s table;
+  struct at86rf212_rx_frame_s frame;
+  struct at86rf212_mac_frame_s mac;
+  struct at86rf212_nbr_s *nbr;
+  uint8_t tx_buffer[AT86RF212_MAC_MAX_FRAME];
+  uint8_t rx_buffer[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&tx, SimRadio::driver(), (void*) &sim_tx));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&rx, SimRadio::driver(), (void*) &sim_rx));
+  at86rf212_nbr_init(&table, rx.phy_mode);
+
+  for (int i = 0; i < 10; i++) {
+    uint8_t len = AT86RF212::MacDataExtended::build(tx_buffer, i * 2, 0x1234, 0x0102030405060708ULL,
+                                                    0x1234, 0x1112131415161718ULL);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&rx));
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_tx(&tx, len, tx_buffer));
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx_frame(&rx, &frame, rx_buffer, 0));
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_mac_parse(&mac, frame.length - AT86RF212_CRC_LEN, frame.payload));
+    nbr = at86rf212_nbr_update_rx(&table, &mac, &frame);
+    ASSERT_NE((struct at86rf212_nbr_s*)NULL, nbr);
+  }
+
+  nbr = at86rf212_nbr_find(&table, AT86RF212_MAC_ADDR_EXTENDED, 0x1112131415161718ULL);
+  ASSERT_NE((struct at86rf212_nbr_s*)NULL, nbr);
+  EXPECT_EQ(10, nbr->frames);
+  EXPECT_EQ(9, nbr->missed);
+  EXPECT_EQ(frame.timestamp, nbr->last_seen);
+  EXPECT_EQ(frame.lqi * 16, nbr->lqi);
+}
+
+TEST(At86rf212Nbr, UpdateCost)
+{
+  const uint32_t neighbours = AT86RF212_NBR_MAX_ENTRIES;
+  const uint32_t iterations = 2000000;
+  struct at86rf212_nbr_table_s table;
+  std::vector<uint64_t> addrs;
+  uint32_t state = 1;
+
+  at86rf212_nbr_init(&table, AT86RF212_PHY_OQPSK_250);
+  for (uint32_t i = 0; i < neighbours; i++) {
+    addrs.push_back(0x00124B0000000000ULL + i * 7919);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    state = state * 1103515245 + 12345;
+    uint32_t n = (state >> 16) % neighbours;
+    at86rf212_nbr_update(&table, AT86RF212_MAC_ADDR_EXTENDED, addrs[n], i, state & 0xFF, (state >> 8) & 0x3F, i);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double update_ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  printf("Neighbour table update: %.1f ns per frame with %u neighbours (%u slots, %u bytes)\r\n",
+         update_ns, neighbours, AT86RF212_NBR_SLOTS, (unsigned)sizeof(table));
+
+  EXPECT_EQ(neighbours, table.count);
+  EXPECT_EQ(0, table.evictions);
+}
@@ -0,0 +1,87 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_regs.h"
+#include "at86rf212/at86rf212_regs.hpp"
+#include "at86rf212/at86rf212.hpp"
+#include "at86rf212/at86rf212_defs.h"
+
+#include "sim_radio.hpp"
+
+using namespace AT86RF212;
+
+// Field composition is resolved at compile time
+static_assert(Regs::PHY_CC_CCA_CCA_MODE.shift == 5, "CCA mode shift");
+static_assert(Regs::PHY_CC_CCA_CCA_MODE(AT86RF212_CCA_MODE_CS).value == 0x40, "CCA mode value");
+static_assert((Regs::PHY_CC_CCA_CHANNEL(3) | Regs::PHY_CC_CCA_CCA_MODE(1)).mask == 0x7F, "Combined mask");
+static_assert((Regs::PHY_CC_CCA_CHANNEL(3) | Regs::PHY_CC_CCA_CCA_MODE(1)).value == 0x23, "Combined value");
+static_assert((Regs::CSMA_BE_MIN(3) | Regs::CSMA_BE_MAX(5)).mask == 0xFF, "Full register update");
+static_assert(Regs::TRX_STATE_TRAC_STATUS.get(0xA8) == 5, "Field get");
+
+TEST(At86rf212Regs, FieldHelpers)
+{
+  const struct at86rf212_reg_update_s c_update =
+    AT86RF212_UPDATE2(PHY_CC_CCA_CHANNEL, 3, PHY_CC_CCA_CCA_MODE, AT86RF212_CCA_MODE_ENERGY);
+  const struct at86rf212_reg_update_s cpp_update =
+    Regs::PHY_CC_CCA_CHANNEL(3) | Regs::PHY_CC_CCA_CCA_MODE(AT86RF212_CCA_MODE_ENERGY);
+
+  EXPECT_EQ(AT86RF212_REG_PHY_CC_CCA, c_update.reg);
+  EXPECT_EQ(0x7F, c_update.mask);
+  EXPECT_EQ(0x23, c_update.value);
+  EXPECT_EQ(0, memcmp(&c_update, &cpp_update, sizeof(c_update)));
+
+  // Values are truncated to the field
+  EXPECT_EQ(0x1F, AT86RF212_FIELD_VAL(PHY_CC_CCA_CHANNEL, 0xFF));
+  EXPECT_EQ(0x1F, Regs::PHY_CC_CCA_CHANNEL(0xFF).value);
+  EXPECT_EQ(0x0A, AT86RF212_FIELD_GET(PHY_CC_CCA_CHANNEL, 0xEA));
+}
+
+TEST(At86rf212Regs, ChannelAndCcaMode)
+{
+  SimMedium medium;
+  SimRadio sim(&medium, 1);
+  struct at86rf212_s device;
+  uint8_t channel;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&device, SimRadio::driver(), (void*) &sim));
+  EXPECT_EQ(AT86RF212_DEFAULT_CHANNEL | (AT86RF212_DEFAULT_CCA_MODE << 5), sim.regs[AT86RF212_REG_PHY_CC_CCA]);
+
+  // Channel and CCA mode are independent fields of the same register
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_channel(&device, 7));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_cca_mode(&device, AT86RF212_CCA_MODE_CS_AND_ENERGY));
+  EXPECT_EQ(0x67, sim.regs[AT86RF212_REG_PHY_CC_CCA]);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_channel(&device, &channel));
+  EXPECT_EQ(7, channel);
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_cca_mode(&device, AT86RF212_CCA_MODE_CS));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_channel(&device, &channel));
+  EXPECT_EQ(7, channel);
+}
+
+TEST(At86rf212Regs, UpdateTransactions)
+{
+  SimMedium medium;
+  SimRadio sim(&medium, 1);
+  At86rf212 device;
+
+  ASSERT_EQ(AT86RF212_RES_OK, device.init(SimRadio::driver(), (void*) &sim));
+  printf("Init: %u SPI transactions, %u bytes\r\n", sim.transfers, sim.bytes);
+
+  // Partial register updates are one read-modify-write
+  sim.transfers = 0;
+  ASSERT_EQ(0, device.update(Regs::TRX_CTRL1_TX_AUTO_CRC_ON(1) | Regs::TRX_CTRL1_SPI_CMD_MODE(1)
+                             | Regs::TRX_CTRL1_IRQ_MASK_MODE(1)));
+  EXPECT_EQ(2u, sim.transfers);
+  EXPECT_EQ(0x26, sim.regs[AT86RF212_REG_TRX_CTRL_1] & 0x2E);
+
+  // Whole register updates are a single write
+  sim.transfers = 0;
+  ASSERT_EQ(0, device.update(Regs::CSMA_BE_MIN(2) | Regs::CSMA_BE_MAX(6)));
+  EXPECT_EQ(1u, sim.transfers);
+  EXPECT_EQ(0x62, sim.regs[AT86RF212_REG_CSMA_BE]);
+}
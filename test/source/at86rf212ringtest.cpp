@@ -0,0 +1,183 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_ring.h"
+
+#include "sim_radio.hpp"
+
+class At86rf212RingTest : public ::testing::Test
+{
+protected:
+
+  void SetUp()
+  {
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&radio, SimRadio::driver(), (void*) &sim));
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio));
+    ring = new struct at86rf212_ring_s;
+    at86rf212_ring_init(ring);
+  }
+
+  void TearDown()
+  {
+    delete ring;
+    at86rf212_close(&radio);
+  }
+
+  // Deliver a frame tagged with a sequence number
+  void deliver(uint32_t seq)
+  {
+    uint8_t psdu[16];
+    for (unsigned i = 0; i < sizeof(psdu); i++) {
+      psdu[i] = seq + i;
+    }
+    memcpy(psdu, &seq, sizeof(seq));
+    sim.receive(sizeof(psdu), psdu);
+  }
+
+  SimRadio sim;
+  struct at86rf212_s radio;
+  struct at86rf212_ring_s *ring;
+};
+
+TEST_F(At86rf212RingTest, QueueAndRelease)
+{
+  struct at86rf212_rx_frame_s *frame;
+
+  EXPECT_EQ(NULL, at86rf212_ring_get(ring));
+
+  for (uint32_t i = 0; i < 3; i++) {
+    deliver(i);
+    ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_ring_drain(&radio, ring));
+  }
+  EXPECT_EQ(3, at86rf212_ring_count(ring));
+
+  for (uint32_t i = 0; i < 3; i++) {
+    uint32_t seq;
+    frame = at86rf212_ring_get(ring);
+    ASSERT_TRUE(frame != NULL);
+    EXPECT_EQ(16, frame->length);
+    memcpy(&seq, frame->payload, sizeof(seq));
+    EXPECT_EQ(i, seq);
+    at86rf212_ring_release(ring, frame);
+  }
+
+  EXPECT_EQ(NULL, at86rf212_ring_get(ring));
+  EXPECT_EQ(3, ring->stats.received);
+  EXPECT_EQ(3, ring->stats.high_watermark);
+}
+
+TEST_F(At86rf212RingTest, DropsWhenFull)
+{
+  for (uint32_t i = 0; i < AT86RF212_RING_SLOTS + 2; i++) {
+    deliver(i);
+    at86rf212_ring_drain(&radio, ring);
+  }
+
+  EXPECT_EQ(AT86RF212_RING_SLOTS, ring->stats.received);
+  EXPECT_EQ(2, ring->stats.dropped);
+  EXPECT_EQ(AT86RF212_RING_SLOTS, ring->stats.high_watermark);
+
+  // Dropped frames are read out of the protected frame buffer, so the radio keeps receiving
+  EXPECT_FALSE(sim.fb_protected);
+  deliver(100);
+  EXPECT_EQ(0, sim.rx_blocked);
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_ring_drain(&radio, ring));
+
+  // Releasing a slot allows frames to be queued again
+  at86rf212_ring_release(ring, at86rf212_ring_get(ring));
+  deliver(101);
+  EXPECT_EQ(0, sim.rx_blocked);
+  EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_ring_drain(&radio, ring));
+
+  struct at86rf212_rx_frame_s *frame, *last = NULL;
+  while ((frame = at86rf212_ring_get(ring)) != NULL) {
+    if (last != NULL) {
+      at86rf212_ring_release(ring, last);
+    }
+    last = frame;
+  }
+  ASSERT_TRUE(last != NULL);
+  uint32_t seq;
+  memcpy(&seq, last->payload, sizeof(seq));
+  EXPECT_EQ(101, seq);
+}
+
+TEST_F(At86rf212RingTest, BadCrcKeepsSlot)
+{
+  sim.crc_valid = false;
+  deliver(0);
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_ring_drain(&radio, ring));
+  EXPECT_EQ(1, ring->stats.rejected);
+  EXPECT_EQ(0, at86rf212_ring_count(ring));
+
+  sim.crc_valid = true;
+  for (uint32_t i = 0; i < AT86RF212_RING_SLOTS; i++) {
+    deliver(i);
+    EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_ring_drain(&radio, ring));
+  }
+}
+
+TEST_F(At86rf212RingTest, ProducerConsumerThreads)
+{
+  const uint32_t frames = 20000;
+  std::atomic<bool> done(false);
+  uint32_t consumed = 0;
+  uint32_t out_of_order = 0;
+
+  std::thread consumer([&]() {
+    uint32_t last = 0;
+    bool first = true;
+    while (true) {
+      struct at86rf212_rx_frame_s *frame = at86rf212_ring_get(ring);
+      if (frame == NULL) {
+        if (done.load() && (at86rf212_ring_count(ring) == 0)) {
+          break;
+        }
+        std::this_thread::yield();
+        continue;
+      }
+      uint32_t seq;
+      memcpy(&seq, frame->payload, sizeof(seq));
+      if (!first && (seq <= last)) {
+        out_of_order ++;
+      }
+      for (unsigned i = sizeof(seq); i < frame->length; i++) {
+        if (frame->payload[i] != (uint8_t)(seq + i)) {
+          out_of_order ++;
+          break;
+        }
+      }
+      last = seq;
+      first = false;
+      consumed ++;
+      at86rf212_ring_release(ring, frame);
+    }
+  });
+
+  // Producer models a radio that is faster than the consumer in bursts
+  for (uint32_t i = 0; i < frames; i++) {
+    if ((i % 64) == 0) {
+      while (at86rf212_ring_count(ring) > 0) {
+        std::this_thread::yield();
+      }
+    }
+    deliver(i);
+    ASSERT_GE(at86rf212_ring_drain(&radio, ring), 0);
+  }
+  done.store(true);
+  consumer.join();
+
+  printf("Ring: %u received, %u dropped, high watermark %u\r\n",
+         ring->stats.received, ring->stats.dropped, ring->stats.high_watermark);
+  EXPECT_EQ(frames, ring->stats.received + ring->stats.dropped);
+  EXPECT_EQ(ring->stats.received, consumed);
+  EXPECT_EQ(0, out_of_order);
+  EXPECT_GT(ring->stats.received, frames / 8);
+}
@@ -0,0 +1,352 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_regs.h"
+#include "at86rf212/at86rf212_defs.h"
+
+#include "sim_radio.hpp"
+
+// Core driver tests against the simulated radio
+class At86rf212SimTest : public ::testing::Test
+{
+protected:
+
+  void SetUp()
+  {
+    int res;
+
+    sim = new SimRadio(&medium, 1);
+
+    res = at86rf212_init(&radio, SimRadio::driver(), (void*) sim);
+    ASSERT_EQ(AT86RF212_RES_OK, res);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_time_source(&radio, SimRadio::clock(), (void*) sim));
+  }
+
+  void TearDown()
+  {
+    at86rf212_close(&radio);
+    delete sim;
+  }
+
+  SimMedium medium;
+  SimRadio* sim;
+  struct at86rf212_s radio;
+};
+
+TEST_F(At86rf212SimTest, RandomRequiresReceiver)
+{
+  uint8_t val;
+
+  EXPECT_EQ(AT86RF212_ERROR_STATE, at86rf212_get_random(&radio, &val, 1));
+}
+
+TEST_F(At86rf212SimTest, RandomPool)
+{
+  int res;
+  uint8_t data[64];
+  struct at86rf212_random_stats_s stats;
+
+  res = at86rf212_start_rx(&radio);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+
+  // CSMA seed is loaded on the first entry to RX
+  EXPECT_NE(0, radio.csma_seeded);
+
+  res = at86rf212_get_random(&radio, data, sizeof(data));
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+
+  // Check the output is not degenerate
+  int ones = 0;
+  for (unsigned i = 0; i < sizeof(data); i++) {
+    ones += __builtin_popcount(data[i]);
+  }
+  EXPECT_GT(ones, (int)sizeof(data) * 8 * 2 / 5);
+  EXPECT_LT(ones, (int)sizeof(data) * 8 * 3 / 5);
+
+  at86rf212_get_random_stats(&radio, &stats);
+  EXPECT_EQ(sizeof(data) + 2, stats.bytes_served);
+  printf("Random pool: %u bits harvested, %u bits fetched, %.2f bus bytes per random byte\r\n",
+         stats.bits_harvested, stats.bits_fetched, (double)stats.fetch_bus_bytes / stats.bytes_served);
+
+  // Each explicit fetch yields 2 bits for a 2 byte transaction
+  EXPECT_LE(stats.fetch_bus_bytes, stats.bytes_served * 8);
+}
+
+TEST_F(At86rf212SimTest, RandomAwaitsReceiverConfirmation)
+{
+  uint8_t data[8];
+  struct at86rf212_random_stats_s before, after;
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio));
+  EXPECT_NE(0, radio.rx_on);
+
+  // Commanded back into RX_ON, but still settling
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_state(&radio, AT86RF212_CMD_PLL_ON));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_state(&radio, AT86RF212_CMD_RX_ON));
+  sim->regs[AT86RF212_REG_TRX_STATUS] = AT86RF212_STATE_TRANSITION_IN_PROGRESS;
+  EXPECT_EQ(0, radio.rx_on);
+
+  // Status bytes are not harvested and the pool cannot be topped up
+  at86rf212_get_random_stats(&radio, &before);
+  for (int i = 0; i < 4; i++) {
+    at86rf212_check_rx(&radio);
+  }
+  at86rf212_get_random_stats(&radio, &after);
+  EXPECT_EQ(before.bits_harvested, after.bits_harvested);
+  EXPECT_EQ(AT86RF212_ERROR_STATE, at86rf212_get_random(&radio, data, sizeof(data)));
+
+  // Confirmed once TRX_STATUS reports the receive state
+  sim->regs[AT86RF212_REG_TRX_STATUS] = AT86RF212_RX_ON;
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_get_random(&radio, data, sizeof(data)));
+  EXPECT_NE(0, radio.rx_on);
+}
+
+TEST_F(At86rf212SimTest, RandomHarvestedFromStatusBytes)
+{
+  int res;
+  uint8_t val;
+  struct at86rf212_random_stats_s before, after;
+
+  res = at86rf212_start_rx(&radio);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+
+  at86rf212_get_random_stats(&radio, &before);
+
+  // Register accesses made while listening feed the pool without additional transfers
+  for (int i = 0; i < 4; i++) {
+    at86rf212_check_rx(&radio);
+  }
+  at86rf212_get_random_stats(&radio, &after);
+  EXPECT_EQ(before.bits_harvested + 8, after.bits_harvested);
+
+  uint32_t transfers = sim->transfers;
+  res = at86rf212_get_random(&radio, &val, 1);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  EXPECT_EQ(transfers, sim->transfers);
+}
+
+TEST_F(At86rf212SimTest, SramAccess)
+{
+  int res;
+  uint8_t data_out[4] = {0x01, 0x02, 0x03, 0x04};
+  uint8_t data_in[4] = {0};
+
+  res = at86rf212_write_sram(&radio, 0x10, sizeof(data_out), data_out);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+
+  res = at86rf212_read_sram(&radio, 0x10, sizeof(data_in), data_in);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  EXPECT_EQ(0, memcmp(data_out, data_in, sizeof(data_out)));
+
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_write_sram(&radio, 0x7E, sizeof(data_out), data_out));
+}
+
+TEST_F(At86rf212SimTest, ResendPatchesFrame)
+{
+  int res;
+  uint8_t data[AT86RF212_MAX_LENGTH - AT86RF212_CRC_LEN];
+  SimRadio receiver(&medium, 2);
+  struct at86rf212_s rx_radio;
+
+  res = at86rf212_init(&rx_radio, SimRadio::driver(), (void*) &receiver);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  res = at86rf212_start_rx(&rx_radio);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+
+  for (unsigned i = 0; i < sizeof(data); i++) {
+    data[i] = i;
+  }
+
+  uint32_t bytes = sim->bytes;
+  res = at86rf212_start_tx(&radio, sizeof(data), data);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  uint32_t full_bytes = sim->bytes - bytes;
+  EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_check_tx(&radio));
+
+  // Receiver reads the first frame, releasing its frame buffer
+  uint8_t length;
+  uint8_t rx[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+  res = at86rf212_get_rx(&rx_radio, &length, rx);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  EXPECT_EQ(2, rx[2]);
+
+  // Bump the sequence number and retransmit
+  uint8_t seq = 0xAA;
+  struct at86rf212_patch_s patch = {2, 1, &seq};
+
+  bytes = sim->bytes;
+  res = at86rf212_resend(&radio, 1, &patch);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  uint32_t patch_bytes = sim->bytes - bytes;
+  EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_check_tx(&radio));
+
+  printf("Full upload: %u SPI bytes, patched resend: %u SPI bytes\r\n", full_bytes, patch_bytes);
+  EXPECT_LE(patch_bytes, 8);
+  EXPECT_EQ(2, sim->frames_sent);
+
+  // Receiver sees the patched frame
+  res = at86rf212_get_rx(&rx_radio, &length, rx);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  EXPECT_EQ(0xAA, rx[2]);
+  EXPECT_EQ(3, rx[3]);
+}
+
+TEST_F(At86rf212SimTest, EarlyReceive)
+{
+  int res;
+  uint8_t psdu[100];
+  uint8_t length;
+  uint8_t data[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+
+  for (unsigned i = 0; i < sizeof(psdu); i++) {
+    psdu[i] = i ^ 0x5A;
+  }
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_phy_mode(&radio, AT86RF212_PHY_OQPSK_250));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio));
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_check_rx_start(&radio));
+
+  sim->begin_receive(sizeof(psdu), psdu);
+  EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx_start(&radio));
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_check_rx(&radio));
+
+  res = at86rf212_get_rx_early(&radio, &length, data);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  ASSERT_EQ(sizeof(psdu) + AT86RF212_FRAME_RX_OVERHEAD, length);
+  EXPECT_EQ(0, memcmp(psdu, data, sizeof(psdu)));
+  EXPECT_EQ(sim->lqi, data[sizeof(psdu)]);
+  EXPECT_EQ(sim->ed, data[sizeof(psdu) + 1]);
+  EXPECT_EQ(0x80, data[sizeof(psdu) + 2]);
+  EXPECT_EQ(0, sim->underruns);
+
+  // Frame is consumed
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_check_rx(&radio));
+}
+
+TEST_F(At86rf212SimTest, EarlyReceiveReleasesBadFrame)
+{
+  uint8_t psdu[20] = {0};
+  uint8_t length;
+  uint8_t data[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio));
+
+  // Corrupt PHR
+  sim->receive(sizeof(psdu), psdu);
+  sim->buffer[0] = 0xFF;
+  EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx(&radio));
+  ASSERT_TRUE(sim->fb_protected);
+
+  EXPECT_EQ(AT86RF212_ERROR_LEN, at86rf212_get_rx_early(&radio, &length, data));
+  EXPECT_FALSE(sim->fb_protected);
+  EXPECT_EQ(0, radio.rx_end_pending);
+
+  // The next frame is received
+  psdu[0] = 0xA5;
+  sim->receive(sizeof(psdu), psdu);
+  EXPECT_EQ(0u, sim->rx_blocked);
+  EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx(&radio));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx(&radio, &length, data));
+  EXPECT_EQ(sizeof(psdu) + AT86RF212_FRAME_RX_OVERHEAD, length);
+  EXPECT_EQ(0xA5, data[0]);
+}
+
+TEST_F(At86rf212SimTest, EarlyReceiveLatency)
+{
+  const uint8_t modes[] = {AT86RF212_PHY_BPSK_20, AT86RF212_PHY_OQPSK_100,
+                           AT86RF212_PHY_OQPSK_250, AT86RF212_PHY_OQPSK_1000
+                          };
+  uint8_t psdu[AT86RF212_MAX_LENGTH - 1];
+  uint8_t length;
+  uint8_t data[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+
+  for (unsigned i = 0; i < sizeof(psdu); i++) {
+    psdu[i] = i;
+  }
+
+  printf("Frame end to data available latency (us, %u byte PSDU, %u Hz SPI):\r\n",
+         (unsigned)sizeof(psdu), sim->spi_hz);
+
+  for (unsigned m = 0; m < sizeof(modes); m++) {
+    uint32_t end_us, baseline, early;
+
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_phy_mode(&radio, modes[m]));
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio));
+    uint32_t frame_us = sizeof(psdu) * sim->byte_time_us();
+
+    // Poll for TRX_END, then download
+    sim->begin_receive(sizeof(psdu), psdu);
+    end_us = sim->now_us + frame_us;
+    while (at86rf212_check_rx(&radio) != AT86RF212_RES_DONE);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx(&radio, &length, data));
+    baseline = sim->now_us - end_us;
+    EXPECT_EQ(0, memcmp(psdu, data, sizeof(psdu)));
+
+    // Download from RX_START
+    sim->begin_receive(sizeof(psdu), psdu);
+    end_us = sim->now_us + frame_us;
+    while (at86rf212_check_rx_start(&radio) != AT86RF212_RES_DONE);
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx_early(&radio, &length, data));
+    early = sim->now_us - end_us;
+    EXPECT_EQ(0, memcmp(psdu, data, sizeof(psdu)));
+    EXPECT_EQ(0, sim->underruns);
+
+    printf("  %7u bps: baseline %4u, early %4u\r\n", at86rf212_get_bit_rate(modes[m]), baseline, early);
+    EXPECT_LT(early, baseline);
+  }
+}
+
+TEST_F(At86rf212SimTest, RxFrameMetadata)
+{
+  int res;
+  uint8_t psdu[20];
+  uint8_t buffer[AT86RF212_RX_BUFFER_LEN];
+  struct at86rf212_rx_frame_s frame;
+
+  for (unsigned i = 0; i < sizeof(psdu); i++) {
+    psdu[i] = i + 1;
+  }
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio));
+
+  sim->lqi = 0xC8;
+  sim->ed = 0x22;
+  sim->receive(sizeof(psdu), psdu);
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx(&radio));
+  uint32_t stamp = sim->now_us;
+
+  uint32_t transfers = sim->transfers;
+  res = at86rf212_get_rx_frame(&radio, &frame, buffer, 0);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  EXPECT_EQ(transfers + 2, sim->transfers);
+
+  EXPECT_EQ(sizeof(psdu), frame.length);
+  EXPECT_TRUE(frame.payload > buffer && frame.payload < buffer + sizeof(buffer));
+  EXPECT_EQ(0, memcmp(psdu, frame.payload, sizeof(psdu)));
+  EXPECT_EQ(0xC8, frame.lqi);
+  EXPECT_EQ(0x22, frame.ed);
+  EXPECT_EQ(1, frame.crc_valid);
+  EXPECT_EQ(AT86RF212_RX_STATUS_CRC_VALID_MASK, frame.rx_status);
+  EXPECT_EQ(stamp, frame.timestamp);
+
+  // Bad CRC frames are rejected after the PHR
+  sim->crc_valid = false;
+  sim->receive(sizeof(psdu), psdu);
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx(&radio));
+
+  uint32_t bytes = sim->bytes;
+  res = at86rf212_get_rx_frame(&radio, &frame, buffer, 0);
+  EXPECT_EQ(AT86RF212_RES_REJECTED, res);
+  EXPECT_EQ(0, frame.crc_valid);
+  EXPECT_EQ(bytes + 2, sim->bytes);
+
+  res = at86rf212_get_rx_frame(&radio, &frame, buffer, 1);
+  ASSERT_EQ(AT86RF212_RES_OK, res);
+  EXPECT_EQ(0, frame.crc_valid);
+  EXPECT_EQ(0, memcmp(psdu, frame.payload, sizeof(psdu)));
+}
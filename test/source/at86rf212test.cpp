@@ -4,6 +4,7 @@
 #include "gmock/gmock.h"
 
 #include <stdint.h>
+#include <string.h>
 #include <time.h>
 
 #include "at86rf212/at86rf212.hpp"
@@ -30,6 +31,7 @@ protected:
   {
     int res;
 
+    memset(&at86rf212_driver, 0, sizeof(at86rf212_driver));
     at86rf212_driver.spi_transfer = spi_transfer;
     at86rf212_driver.set_reset = set_reset;
     at86rf212_driver.set_slp_tr = set_slp_tr;
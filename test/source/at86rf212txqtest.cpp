@@ -0,0 +1,235 @@
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "at86rf212/at86rf212.h"
+#include "at86rf212/at86rf212_txq.h"
+#include "at86rf212/at86rf212_regs.h"
+
+#include "sim_radio.hpp"
+
+class At86rf212TxqTest : public ::testing::Test
+{
+protected:
+
+  void SetUp()
+  {
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&radio, SimRadio::driver(), (void*) &sim));
+    ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_time_source(&radio, SimRadio::clock(), (void*) &sim));
+    sim.tx_airtime = true;
+  }
+
+  void TearDown()
+  {
+    at86rf212_close(&radio);
+  }
+
+  static void done_cb(void* context, int handle, int result)
+  {
+    At86rf212TxqTest* test = (At86rf212TxqTest*)context;
+    test->completed.push_back(handle);
+    test->results.push_back(result);
+  }
+
+  SimRadio sim;
+  struct at86rf212_s radio;
+  struct at86rf212_txq_s txq;
+  std::vector<int> completed;
+  std::vector<int> results;
+};
+
+TEST_F(At86rf212TxqTest, PriorityOrder)
+{
+  uint8_t data[32] = {0};
+  int bulk[4];
+
+  at86rf212_txq_init(&txq, &radio, done_cb, this);
+
+  for (int i = 0; i < 4; i++) {
+    bulk[i] = at86rf212_txq_submit(&txq, AT86RF212_TX_CLASS_BULK, sizeof(data), data);
+    ASSERT_GE(bulk[i], 0);
+  }
+
+  // First bulk frame goes straight out, then the control frame overtakes the rest
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_txq_run(&txq));
+  int control = at86rf212_txq_submit(&txq, AT86RF212_TX_CLASS_CONTROL, 4, data);
+  ASSERT_GE(control, 0);
+  EXPECT_EQ(5, at86rf212_txq_depth(&txq));
+
+  while (at86rf212_txq_run(&txq) != AT86RF212_RES_DONE);
+
+  ASSERT_EQ(5, completed.size());
+  EXPECT_EQ(bulk[0], completed[0]);
+  EXPECT_EQ(control, completed[1]);
+  EXPECT_EQ(bulk[1], completed[2]);
+  EXPECT_EQ(bulk[3], completed[4]);
+  for (size_t i = 0; i < results.size(); i++) {
+    EXPECT_EQ(AT86RF212_RES_DONE, results[i]);
+  }
+  EXPECT_EQ(0, at86rf212_txq_depth(&txq));
+  EXPECT_EQ(5, sim.frames_sent);
+}
+
+TEST_F(At86rf212TxqTest, PollCompletion)
+{
+  uint8_t data[8] = {0};
+  int handles[AT86RF212_TXQ_DEPTH];
+
+  at86rf212_txq_init(&txq, &radio, NULL, NULL);
+
+  for (int i = 0; i < AT86RF212_TXQ_DEPTH; i++) {
+    handles[i] = at86rf212_txq_submit(&txq, AT86RF212_TX_CLASS_NORMAL, sizeof(data), data);
+    ASSERT_GE(handles[i], 0);
+  }
+  EXPECT_EQ(AT86RF212_ERROR_FULL, at86rf212_txq_submit(&txq, AT86RF212_TX_CLASS_NORMAL, sizeof(data), data));
+  EXPECT_EQ(AT86RF212_RES_OK, at86rf212_txq_status(&txq, handles[0]));
+
+  while (at86rf212_txq_run(&txq) != AT86RF212_RES_DONE);
+
+  for (int i = 0; i < AT86RF212_TXQ_DEPTH; i++) {
+    EXPECT_EQ(AT86RF212_RES_DONE, at86rf212_txq_status(&txq, handles[i]));
+    // Handles are released once the result has been collected
+    EXPECT_EQ(AT86RF212_ERROR_STATE, at86rf212_txq_status(&txq, handles[i]));
+  }
+
+  // Entries are reused with new handles
+  int handle = at86rf212_txq_submit(&txq, AT86RF212_TX_CLASS_NORMAL, sizeof(data), data);
+  ASSERT_GE(handle, 0);
+  for (int i = 0; i < AT86RF212_TXQ_DEPTH; i++) {
+    EXPECT_NE(handles[i], handle);
+  }
+}
+
+// Counts state commands that drop the PLL
+struct RelockProbe {
+  SimRadio* sim;
+  uint32_t trx_off;
+};
+
+static int relock_transfer(void* context, int len, uint8_t *data_out, uint8_t* data_in)
+{
+  RelockProbe* probe = (RelockProbe*)context;
+
+  if ((data_out[0] == (AT86RF212_REG_WRITE_FLAG | AT86RF212_REG_TRX_STATE))
+      && ((data_out[1] & AT86RF212_TRX_STATE_TRX_CMD_MASK) == AT86RF212_CMD_TRX_OFF)) {
+    probe->trx_off ++;
+  }
+  return probe->sim->transfer(len, data_out, data_in);
+}
+
+static int relock_get_irq(void* context, uint8_t *val)
+{
+  *val = (((RelockProbe*)context)->sim->irq != 0) ? 1 : 0;
+  return 0;
+}
+
+static int relock_get_time(void* context, uint32_t *time_us)
+{
+  SimRadio* sim = ((RelockProbe*)context)->sim;
+  sim->advance(1);
+  *time_us = sim->now_us;
+  return 0;
+}
+
+TEST_F(At86rf212TxqTest, StaysInPllOn)
+{
+  RelockProbe probe = {&sim, 0};
+  struct at86rf212_driver_s driver = *SimRadio::driver();
+  uint8_t data[16] = {0x41, 0x88};
+
+  driver.spi_transfer = relock_transfer;
+  driver.get_irq = relock_get_irq;
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_init(&radio, &driver, &probe));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_time_source(&radio, relock_get_time, &probe));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio));
+  at86rf212_txq_init(&txq, &radio, done_cb, this);
+
+  // Frames start from RX_ON and then back to back from PLL_ON, without returning to TRX_OFF
+  probe.trx_off = 0;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_GE(at86rf212_txq_submit(&txq, AT86RF212_TX_CLASS_NORMAL, sizeof(data), data), 0);
+  }
+  while (at86rf212_txq_run(&txq) != AT86RF212_RES_DONE) {
+    sim.advance(100);
+  }
+
+  EXPECT_EQ(4, sim.frames_sent);
+  EXPECT_EQ(0u, probe.trx_off);
+  EXPECT_EQ(AT86RF212_PLL_ON, sim.state());
+  for (size_t i = 0; i < results.size(); i++) {
+    EXPECT_EQ(AT86RF212_RES_DONE, results[i]);
+  }
+}
+
+TEST_F(At86rf212TxqTest, KeepsReceivedFrame)
+{
+  uint8_t data[16] = {0x41, 0x88};
+  uint8_t rx[20] = {0x41, 0x88, 0x5A};
+  uint8_t length, buffer[AT86RF212_MAX_LENGTH + AT86RF212_FRAME_RX_OVERHEAD];
+
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_start_rx(&radio));
+  at86rf212_txq_init(&txq, &radio, done_cb, this);
+  sim.receive(sizeof(rx), rx);
+  ASSERT_GE(at86rf212_txq_submit(&txq, AT86RF212_TX_CLASS_NORMAL, sizeof(data), data), 0);
+
+  // The undrained frame holds up the queue rather than being overwritten
+  EXPECT_EQ(AT86RF212_RES_REJECTED, at86rf212_txq_run(&txq));
+  EXPECT_EQ(0u, sim.frames_sent);
+  EXPECT_EQ(1u, at86rf212_txq_depth(&txq));
+  ASSERT_EQ(AT86RF212_RES_DONE, at86rf212_check_rx(&radio));
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_get_rx(&radio, &length, buffer));
+  EXPECT_EQ(0, memcmp(rx, buffer, sizeof(rx)));
+
+  while (at86rf212_txq_run(&txq) != AT86RF212_RES_DONE) {
+    sim.advance(100);
+  }
+  EXPECT_EQ(1u, sim.frames_sent);
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ(AT86RF212_RES_DONE, results[0]);
+}
+
+TEST_F(At86rf212TxqTest, LineRate)
+{
+  const int frames = 200;
+  uint8_t data[100] = {0};
+  uint32_t polls = 0;
+
+  at86rf212_txq_init(&txq, &radio, done_cb, this);
+  ASSERT_EQ(AT86RF212_RES_OK, at86rf212_set_phy_mode(&radio, AT86RF212_PHY_OQPSK_250));
+
+  // Keep the queue topped up with a mix of classes, servicing it on each pass
+  int submitted = 0;
+  while (completed.size() < (size_t)frames) {
+    while ((submitted < frames) && (at86rf212_txq_depth(&txq) < AT86RF212_TXQ_DEPTH)) {
+      uint8_t tx_class = ((submitted % 8) == 0) ? AT86RF212_TX_CLASS_CONTROL : AT86RF212_TX_CLASS_BULK;
+      ASSERT_GE(at86rf212_txq_submit(&txq, tx_class, (tx_class == AT86RF212_TX_CLASS_CONTROL) ? 8 : sizeof(data), data), 0);
+      submitted ++;
+    }
+    at86rf212_txq_run(&txq);
+    polls ++;
+    // Service the queue on the radio IRQ rather than spinning on the bus
+    while ((sim.irq == 0) && (at86rf212_txq_depth(&txq) > 0)) {
+      sim.advance(10);
+    }
+  }
+
+  uint32_t elapsed = sim.now_us - txq.start_time;
+  double utilisation = (double)sim.airtime_us / elapsed;
+
+  printf("Throughput %u B/s, air utilisation %.3f, %u polls for %d frames\r\n",
+         at86rf212_txq_throughput(&txq), utilisation, polls, frames);
+  printf("Latency p50/p99 (us): control %u/%u, bulk %u/%u\r\n",
+         at86rf212_txq_latency_percentile(&txq, AT86RF212_TX_CLASS_CONTROL, 50),
+         at86rf212_txq_latency_percentile(&txq, AT86RF212_TX_CLASS_CONTROL, 99),
+         at86rf212_txq_latency_percentile(&txq, AT86RF212_TX_CLASS_BULK, 50),
+         at86rf212_txq_latency_percentile(&txq, AT86RF212_TX_CLASS_BULK, 99));
+
+  EXPECT_GT(utilisation, 0.85);
+  EXPECT_LE(polls, (uint32_t)frames + 1);
+  EXPECT_LT(at86rf212_txq_latency_percentile(&txq, AT86RF212_TX_CLASS_CONTROL, 99),
+            at86rf212_txq_latency_percentile(&txq, AT86RF212_TX_CLASS_BULK, 99));
+}
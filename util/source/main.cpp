@@ -14,11 +14,19 @@
 #include <string.h>
 #include <readline/readline.h>
 #include <readline/history.h>
+#include <time.h>
+
+#include <atomic>
+#include <thread>
 
 #include "usbthing/usbthing.h"
 #include "usbthing_bindings.h"
 
 #include "at86rf212/at86rf212.hpp"
+#include "at86rf212/at86rf212_mac.hpp"
+#include "at86rf212/at86rf212_mac.h"
+#include "at86rf212/at86rf212_filter.h"
+#include "at86rf212/at86rf212_ring.h"
 #include "at86rf212_version.h"
 
 
@@ -39,6 +47,8 @@ struct config_s {
     int help;
     uint16_t address;
     uint16_t pan_id;
+    int filter_pan;         //!< Destination PAN shown in receive mode, -1 for all
+    int stats_interval;     //!< Receive pipeline statistics interval in seconds, 0 for exit only
 };
 
 // Prototypes
@@ -54,60 +64,251 @@ void int_handler(int dummy)
     running = 0;
 }
 
-void run_rx(AT86RF212::At86rf212* radio)
+// Receive pipeline
+// The I/O stage (main thread) only drains the radio into the frame ring, the decode stage parses,
+// filters and formats frames into the line queue, and the output stage writes lines in batches.
+// Stages are connected by SPSC queues so slow console output cannot stall reception.
+
+#define RX_LINE_SLOTS       256     //!< Formatted lines queued for output, must be a power of two
+#define RX_LINE_LEN         (AT86RF212_MAX_LENGTH * 3 + 96)
+#define RX_OUTPUT_BUFFER    (64 * 1024)
+#define RX_IDLE_US          200     //!< Decode and output stage poll interval when idle
+
+// Formatted output line
+struct rx_line_s {
+    uint16_t length;
+    char text[RX_LINE_LEN];
+};
+
+// Decode to output stage queue, head is written by the consumer and tail by the producer
+struct rx_line_queue_s {
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    struct rx_line_s lines[RX_LINE_SLOTS];
+};
+
+// Pipeline state and statistics
+struct rx_pipeline_s {
+    struct at86rf212_ring_s ring;           //!< I/O to decode stage
+    struct rx_line_queue_s lines;           //!< Decode to output stage
+    struct at86rf212_filter_s filter;
+    bool filtered;
+    std::atomic<bool> io_done;
+    std::atomic<bool> decode_done;
+
+    std::atomic<uint32_t> decoded;          //!< Frames formatted for output
+    std::atomic<uint32_t> filtered_out;     //!< Frames rejected by the filter
+    std::atomic<uint32_t> malformed;        //!< Frames that failed to parse (printed raw)
+    std::atomic<uint32_t> line_drops;       //!< Frames dropped because the line queue was full
+    std::atomic<uint32_t> line_high_watermark;
+    std::atomic<uint32_t> writes;           //!< Output write calls
+    std::atomic<uint32_t> bytes_written;
+};
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static int rx_format_hex(char* out, uint8_t length, const uint8_t* data)
+{
+    for (int i = 0; i < length; i++) {
+        out[i * 3] = hex_digits[data[i] >> 4];
+        out[i * 3 + 1] = hex_digits[data[i] & 0x0F];
+        out[i * 3 + 2] = ' ';
+    }
+    return length * 3;
+}
+
+static int rx_format(struct rx_line_s* line, struct at86rf212_rx_frame_s* frame, int parsed,
+                     struct at86rf212_mac_frame_s* mac)
+{
+    char* out = line->text;
+    uint8_t length = (frame->length > AT86RF212_CRC_LEN) ? frame->length - AT86RF212_CRC_LEN : 0;
+
+    out += snprintf(out, 96, "RX: %10u lqi %3u ed %3u ", frame->timestamp, frame->lqi, frame->ed);
+    if (parsed == AT86RF212_RES_OK) {
+        out += snprintf(out, 64, "type %u seq %3u pan %.4x len %3u: ",
+                        mac->type, mac->seq, mac->dest_pan, length);
+    } else {
+        out += snprintf(out, 64, "malformed len %3u: ", length);
+    }
+    out += rx_format_hex(out, length, frame->payload);
+    out[0] = '\r';
+    out[1] = '\n';
+    out += 2;
+
+    return out - line->text;
+}
+
+static void rx_decode_stage(struct rx_pipeline_s* p)
 {
+    struct at86rf212_rx_frame_s* frame;
+    struct at86rf212_mac_frame_s mac;
     int res;
-    uint8_t len_in;
-    uint8_t data_in[128];
+
+    while (1) {
+        frame = at86rf212_ring_get(&p->ring);
+        if (frame == NULL) {
+            if (p->io_done.load(std::memory_order_acquire) && (at86rf212_ring_count(&p->ring) == 0)) {
+                break;
+            }
+            usleep(RX_IDLE_US);
+            continue;
+        }
+
+        if (p->filtered && (at86rf212_filter_match(&p->filter, frame->length, frame->payload) == 0)) {
+            p->filtered_out ++;
+            at86rf212_ring_release(&p->ring, frame);
+            continue;
+        }
+
+        uint32_t tail = p->lines.tail.load(std::memory_order_relaxed);
+        uint32_t queued = tail - p->lines.head.load(std::memory_order_acquire);
+        if (queued >= RX_LINE_SLOTS) {
+            // Output is behind, drop here rather than stall the ring
+            p->line_drops ++;
+            at86rf212_ring_release(&p->ring, frame);
+            continue;
+        }
+
+        res = AT86RF212_ERROR_LEN;
+        if (frame->length > AT86RF212_CRC_LEN) {
+            res = at86rf212_mac_parse(&mac, frame->length - AT86RF212_CRC_LEN, frame->payload);
+        }
+        if (res != AT86RF212_RES_OK) {
+            p->malformed ++;
+        }
+
+        struct rx_line_s* line = &p->lines.lines[tail & (RX_LINE_SLOTS - 1)];
+        line->length = rx_format(line, frame, res, &mac);
+        at86rf212_ring_release(&p->ring, frame);
+
+        p->lines.tail.store(tail + 1, std::memory_order_release);
+        p->decoded ++;
+        if (queued + 1 > p->line_high_watermark.load(std::memory_order_relaxed)) {
+            p->line_high_watermark.store(queued + 1, std::memory_order_relaxed);
+        }
+    }
+
+    p->decode_done.store(true, std::memory_order_release);
+}
+
+static void rx_output_stage(struct rx_pipeline_s* p)
+{
+    static char buffer[RX_OUTPUT_BUFFER];
+    uint32_t used = 0;
+
+    while (1) {
+        uint32_t head = p->lines.head.load(std::memory_order_relaxed);
+        uint32_t tail = p->lines.tail.load(std::memory_order_acquire);
+
+        // Gather every queued line that fits, then write them in one call
+        while ((head != tail) && (used + RX_LINE_LEN <= sizeof(buffer))) {
+            struct rx_line_s* line = &p->lines.lines[head & (RX_LINE_SLOTS - 1)];
+            memcpy(buffer + used, line->text, line->length);
+            used += line->length;
+            head ++;
+        }
+        p->lines.head.store(head, std::memory_order_release);
+
+        if (used > 0) {
+            fwrite(buffer, 1, used, stdout);
+            fflush(stdout);
+            p->writes ++;
+            p->bytes_written += used;
+            used = 0;
+            continue;
+        }
+
+        if (p->decode_done.load(std::memory_order_acquire)
+            && (p->lines.tail.load(std::memory_order_acquire) == head)) {
+            break;
+        }
+        usleep(RX_IDLE_US);
+    }
+}
+
+static void rx_print_stats(struct rx_pipeline_s* p)
+{
+    struct at86rf212_ring_stats_s* ring = &p->ring.stats;
+    uint32_t lines = p->lines.tail.load() - p->lines.head.load();
+
+    fprintf(stderr, "io: rx %u crc %u drop %u ring %u/%u (max %u) | "
+            "decode: %u filtered %u malformed %u drop %u lines %u/%u (max %u) | "
+            "output: %u writes %u bytes\r\n",
+            ring->received, ring->rejected, ring->dropped,
+            at86rf212_ring_count(&p->ring), AT86RF212_RING_SLOTS, ring->high_watermark,
+            p->decoded.load(), p->filtered_out.load(), p->malformed.load(), p->line_drops.load(),
+            lines, RX_LINE_SLOTS, p->line_high_watermark.load(),
+            p->writes.load(), p->bytes_written.load());
+}
+
+void run_rx(AT86RF212::At86rf212* radio, struct config_s* config)
+{
+    struct rx_pipeline_s* p = new rx_pipeline_s();
+    struct timespec now, report;
+    int res;
+
+    at86rf212_ring_init(&p->ring);
+    p->io_done = false;
+    p->decode_done = false;
+
+    if (config->filter_pan >= 0) {
+        struct at86rf212_filter_spec_s spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.match_dest_pan = 1;
+        spec.dest_pan = config->filter_pan;
+        res = at86rf212_filter_compile(&p->filter, &spec);
+        if (res < 0) {
+            printf("Error %d compiling filter\r\n", res);
+            delete p;
+            return;
+        }
+        p->filtered = true;
+    }
 
     res = radio->start_rx();
     if (res < 0) {
         printf("Error %d starting receive\r\n", res);
     }
 
+    std::thread decode(rx_decode_stage, p);
+    std::thread output(rx_output_stage, p);
+
+    clock_gettime(CLOCK_MONOTONIC, &report);
+
+    // I/O stage, the radio stays in RX_ON after each frame so draining is all that is required
     while (running) {
         res = radio->check_rx();
-
         if (res < 0) {
-            printf("Error %d checking receive\r\n", res);
+            fprintf(stderr, "Error %d checking receive\r\n", res);
             break;
-        } else if (res > 0) {
-
-            res = radio->get_rx(&len_in, data_in);
+        } else if (res == AT86RF212_RES_DONE) {
+            // Frames rejected for a bad CRC or a full ring are counted by the ring
+            res = at86rf212_ring_drain(radio->c_device(), &p->ring);
             if (res < 0) {
-                printf("Error %d fetching received packet\r\n", res);
+                fprintf(stderr, "Error %d fetching received packet\r\n", res);
             }
+        }
 
-            printf("RX: ");
-            for (int i = 0; i < len_in; i++) {
-                printf("%.2x ", data_in[i]);
+        if (config->stats_interval > 0) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (now.tv_sec - report.tv_sec >= config->stats_interval) {
+                rx_print_stats(p);
+                report = now;
             }
-            printf("\r\n");
-
-            radio->start_rx();
         }
     }
+
+    p->io_done.store(true, std::memory_order_release);
+    decode.join();
+    output.join();
+
+    rx_print_stats(p);
+    delete p;
 }
 
 int build_header(uint8_t seq, uint16_t pan, uint16_t dest_addr, uint16_t src_addr, uint8_t* packet)
 {
-    uint8_t header[9];
-
-    header[0] = 0x61;
-    header[1] = 0x88;
-    header[2] = seq;
-    header[3] = pan & 0xFF;
-    header[4] = (pan >> 8) & 0xFF;
-    header[5] = dest_addr & 0xFF;
-    header[6] = (dest_addr >> 8) & 0xFF;
-    header[7] = src_addr & 0xFF;
-    header[8] = (src_addr >> 8) & 0xFF;
-
-    for (int i = 0; i < sizeof(header); i++) {
-        packet[i] = header[i];
-    }
-
-    return sizeof(header);
+    return AT86RF212::MacDataShortAck::build(packet, seq, pan, dest_addr, pan, src_addr);
 }
 
 int add_data(int len, uint8_t* data_in, uint8_t* packet)
@@ -196,6 +397,7 @@ int main(int argc, char** argv)
 
     // at86rf212 driver object
     struct at86rf212_driver_s at86rf212_driver;
+    memset(&at86rf212_driver, 0, sizeof(at86rf212_driver));
     at86rf212_driver.spi_transfer = spi_transfer;
     at86rf212_driver.set_reset = set_reset;
     at86rf212_driver.set_slp_tr = set_slp_tr;
@@ -280,7 +482,7 @@ int main(int argc, char** argv)
     // Run mode specific main loops
     switch (config.mode) {
     case MODE_RX:
-        run_rx(&radio);
+        run_rx(&radio, &config);
         break;
     case MODE_TX:
         run_tx(&radio);
@@ -309,6 +511,7 @@ int print_help (int argc, char **argv)
 {
     printf("at86rf212b-util (%s)\r\n", LIBAT86RF212_VERSION_STRING);
     printf("Usage: %s --mode=[rx|tx] [--channel=N --verbose]\r\n", argv[0]);
+    printf("Receive options: [--filter-pan=N --stats=SECONDS]\r\n");
 
     printf("\r\n");
     return 0;
@@ -323,6 +526,8 @@ int parse_args (int argc, char **argv, struct config_s *config)
     config->channel = 1;
     config->pan_id = 0;
     config->address = 0;
+    config->filter_pan = -1;
+    config->stats_interval = 0;
 
     static struct option long_options[] = {
         /* These options set a flag. */
@@ -330,6 +535,8 @@ int parse_args (int argc, char **argv, struct config_s *config)
         {"channel", required_argument,  0,              'c'},
         {"address", required_argument,  0,              'a'},
         {"pan",     required_argument,  0,              'p'},
+        {"filter-pan", required_argument, 0,            'f'},
+        {"stats",   required_argument,  0,              's'},
         {"help",    no_argument,        0,              'h'},
         {"version", no_argument,        0,              'v'},
         {0,         0,                  0,              0}
@@ -373,6 +580,14 @@ int parse_args (int argc, char **argv, struct config_s *config)
             config->pan_id = atoi(optarg);
             break;
 
+        case 'f':
+            config->filter_pan = strtol(optarg, NULL, 0);
+            break;
+
+        case 's':
+            config->stats_interval = atoi(optarg);
+            break;
+
         case 'v':
             printf("%s\r\n", LIBAT86RF212_VERSION_STRING);
             return -1;